@@ -0,0 +1,106 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/MappedFile.h"
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif // _WIN32
+
+namespace carla {
+
+#ifdef _WIN32
+
+  std::shared_ptr<MappedFile> MappedFile::Open(const std::string &path) {
+    std::shared_ptr<MappedFile> result(new MappedFile);
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return nullptr;
+    }
+    result->_file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      return nullptr;
+    }
+    result->_size = static_cast<size_t>(size.QuadPart);
+    if (result->_size == 0u) {
+      return result;
+    }
+    result->_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (result->_mapping == nullptr) {
+      return nullptr;
+    }
+    result->_data = static_cast<const uint8_t *>(
+        MapViewOfFile(result->_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (result->_data == nullptr) {
+      return nullptr;
+    }
+    return result;
+  }
+
+  MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+      UnmapViewOfFile(_data);
+    }
+    if (_mapping != nullptr) {
+      CloseHandle(_mapping);
+    }
+    if (_file != nullptr) {
+      CloseHandle(_file);
+    }
+  }
+
+#else
+
+  std::shared_ptr<MappedFile> MappedFile::Open(const std::string &path) {
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+      return nullptr;
+    }
+    std::shared_ptr<MappedFile> result(new MappedFile);
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+      close(file);
+      return nullptr;
+    }
+    result->_size = static_cast<size_t>(status.st_size);
+    if (result->_size > 0u) {
+      void *data = mmap(nullptr, result->_size, PROT_READ, MAP_SHARED, file, 0);
+      if (data == MAP_FAILED) {
+        close(file);
+        return nullptr;
+      }
+      result->_data = static_cast<const uint8_t *>(data);
+    }
+    // The mapping stays valid after closing the descriptor.
+    close(file);
+    return result;
+  }
+
+  MappedFile::~MappedFile() {
+    if (_data != nullptr) {
+      munmap(const_cast<uint8_t *>(_data), _size);
+    }
+  }
+
+#endif // _WIN32
+
+} // namespace carla
@@ -0,0 +1,55 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/NonCopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace carla {
+
+  /// Read-only memory mapping of a whole file. Processes mapping the same
+  /// file share its pages instead of holding a copy each.
+  class MappedFile : private NonCopyable {
+  public:
+
+    /// Map the file at @a path, return nullptr if it cannot be opened.
+    static std::shared_ptr<MappedFile> Open(const std::string &path);
+
+    ~MappedFile();
+
+    const uint8_t *data() const {
+      return _data;
+    }
+
+    size_t size() const {
+      return _size;
+    }
+
+    bool empty() const {
+      return _size == 0u;
+    }
+
+  private:
+
+    MappedFile() = default;
+
+    const uint8_t *_data = nullptr;
+
+    size_t _size = 0u;
+
+#ifdef _WIN32
+    void *_file = nullptr;
+
+    void *_mapping = nullptr;
+#endif // _WIN32
+  };
+
+} // namespace carla
@@ -0,0 +1,68 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace carla {
+
+  /// Calls @a functor(i) for every i in [0, count), distributing the indices
+  /// among @a worker_threads threads (all the hardware concurrency available
+  /// if zero). The calling thread is one of the workers. Blocks until every
+  /// call has finished.
+  ///
+  /// If any call throws, the exception is rethrown once all the workers are
+  /// done.
+  template <typename FunctorT>
+  void ParallelFor(size_t count, FunctorT &&functor, size_t worker_threads = 0u) {
+    if (worker_threads == 0u) {
+      worker_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    worker_threads = std::min(worker_threads, count);
+    if (worker_threads <= 1u) {
+      for (size_t i = 0u; i < count; ++i) {
+        functor(i);
+      }
+      return;
+    }
+
+    std::atomic_size_t next{0u};
+    auto work = [&]() {
+      for (size_t i = next++; i < count; i = next++) {
+        functor(i);
+      }
+    };
+
+    ThreadPool pool;
+    std::vector<std::future<void>> results;
+    results.reserve(worker_threads);
+    for (size_t i = 1u; i < worker_threads; ++i) {
+      results.emplace_back(pool.Post(work));
+    }
+    pool.AsyncRun(worker_threads - 1u);
+
+    std::packaged_task<void()> task(work);
+    results.emplace_back(task.get_future());
+    task();
+
+    // The workers reference this stack frame, wait for all of them before
+    // rethrowing.
+    for (auto &result : results) {
+      result.wait();
+    }
+    for (auto &result : results) {
+      result.get();
+    }
+  }
+
+} // namespace carla
@@ -7,9 +7,16 @@
 #include "FileTransfer.h"
 #include "carla/Version.h"
 
+#include <boost/filesystem/operations.hpp>
+
+#include <cinttypes>
+#include <cstdio>
+
 namespace carla {
 namespace client {
 
+  namespace fs = boost::filesystem;
+
   #ifdef _WIN32
         std::string FileTransfer::_filesBaseFolder = std::string(getenv("USERPROFILE")) + "/carlaCache/";
   #else
@@ -31,24 +38,31 @@ namespace client {
     return _filesBaseFolder;
   }
 
-  bool FileTransfer::FileExists(std::string file) {
-    // Check if the file exists or not
-    struct stat buffer;
+  std::string FileTransfer::GetFullPath(const std::string &path) {
     std::string fullpath = _filesBaseFolder;
     fullpath += "/";
     fullpath += ::carla::version();
     fullpath += "/";
-    fullpath += file;
+    fullpath += path;
+    return fullpath;
+  }
+
+  std::string FileTransfer::GetObjectPath(const rpc::FileInfo &info) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 "_%" PRIu64, info.hash, info.size);
+    return GetFullPath(std::string("objects/") + name);
+  }
+
+  bool FileTransfer::FileExists(std::string file) {
+    // Check if the file exists or not
+    struct stat buffer;
+    std::string fullpath = GetFullPath(file);
 
     return (stat(fullpath.c_str(), &buffer) == 0);
   }
 
   bool FileTransfer::WriteFile(std::string path, std::vector<uint8_t> content) {
-    std::string writePath = _filesBaseFolder;
-    writePath += "/";
-    writePath += ::carla::version();
-    writePath += "/";
-    writePath += path;
+    std::string writePath = GetFullPath(path);
 
     // Validate and create the file path
     carla::FileSystem::ValidateFilePath(writePath);
@@ -58,24 +72,80 @@ namespace client {
     if(!out.good()) return false;
 
     // Write the content on and close it
-    for(auto file : content) {
-          out << file;
-    }
+    out.write(reinterpret_cast<const char *>(content.data()), static_cast<std::streamsize>(content.size()));
     out.close();
 
-    return true;
+    return out.good();
   }
 
   std::vector<uint8_t> FileTransfer::ReadFile(std::string path) {
-    std::string fullpath = _filesBaseFolder;
-    fullpath += "/";
-    fullpath += ::carla::version();
-    fullpath += "/";
-    fullpath += path;
     // Read the binary file from the base folder
-    std::ifstream file(fullpath, std::ios::binary);
-    std::vector<uint8_t> content(std::istreambuf_iterator<char>(file), {});
-    return content;
+    auto file = MappedFile::Open(GetFullPath(path));
+    if (file == nullptr) {
+      return {};
+    }
+    return {file->data(), file->data() + file->size()};
+  }
+
+  bool FileTransfer::HasObject(const rpc::FileInfo &info) {
+    boost::system::error_code ec;
+    const auto size = fs::file_size(GetObjectPath(info), ec);
+    return !ec && (size == info.size);
+  }
+
+  bool FileTransfer::WriteObject(const rpc::FileInfo &info, const std::vector<uint8_t> &content) {
+    if ((content.size() != info.size) ||
+        (rpc::FileInfo::Hash(content.data(), content.size()) != info.hash)) {
+      return false;
+    }
+    std::string path = GetObjectPath(info);
+    carla::FileSystem::ValidateFilePath(path);
+
+    // Write to a unique temporary file and rename it, so other processes
+    // never see a partially written object.
+    const auto temp = fs::unique_path(path + ".%%%%-%%%%-%%%%.tmp");
+    {
+      std::ofstream out(temp.string(), std::ios::trunc | std::ios::binary);
+      out.write(reinterpret_cast<const char *>(content.data()), static_cast<std::streamsize>(content.size()));
+      if (!out.good()) {
+        boost::system::error_code ec;
+        fs::remove(temp, ec);
+        return false;
+      }
+    }
+    boost::system::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+      fs::remove(temp, ec);
+      // Another process may have stored the same object meanwhile.
+      return HasObject(info);
+    }
+    return true;
+  }
+
+  std::shared_ptr<MappedFile> FileTransfer::MapObject(const rpc::FileInfo &info) {
+    auto file = MappedFile::Open(GetObjectPath(info));
+    if ((file == nullptr) || (file->size() != info.size)) {
+      return nullptr;
+    }
+    return file;
+  }
+
+  bool FileTransfer::LinkObject(const rpc::FileInfo &info, const std::string &path) {
+    const fs::path object = GetObjectPath(info);
+    std::string link = GetFullPath(path);
+    carla::FileSystem::ValidateFilePath(link);
+    boost::system::error_code ec;
+    if (fs::equivalent(object, link, ec) && !ec) {
+      return true;
+    }
+    fs::remove(link, ec);
+    fs::create_hard_link(object, link, ec);
+    if (ec) {
+      // Hard links not supported by the file system, copy it instead.
+      fs::copy_file(object, link, fs::copy_option::overwrite_if_exists, ec);
+    }
+    return !ec;
   }
 
 } // namespace client
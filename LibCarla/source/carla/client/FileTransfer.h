@@ -7,11 +7,15 @@
 #pragma once
 
 #include "carla/FileSystem.h"
+#include "carla/MappedFile.h"
+#include "carla/rpc/FileInfo.h"
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <sys/stat.h>
+#include <vector>
 
 namespace carla {
 namespace client {
@@ -32,8 +36,35 @@ namespace client {
 
     static std::vector<uint8_t> ReadFile(std::string path);
 
+    /// @name Content-addressed cache
+    ///
+    /// Downloaded files are stored once per content under the cache folder,
+    /// keyed by their rpc::FileInfo. Several processes on the same machine
+    /// share them, and the file at the requested path is a link to them.
+    /// @{
+
+    /// Whether the content described by @a info is in the cache.
+    static bool HasObject(const rpc::FileInfo &info);
+
+    /// Store @a content in the cache if its size and hash match @a info.
+    /// Safe to call from several processes at the same time.
+    static bool WriteObject(const rpc::FileInfo &info, const std::vector<uint8_t> &content);
+
+    /// Map the cached content described by @a info, nullptr if missing.
+    static std::shared_ptr<MappedFile> MapObject(const rpc::FileInfo &info);
+
+    /// Make the file at @a path (relative to the cache folder) refer to the
+    /// cached content described by @a info.
+    static bool LinkObject(const rpc::FileInfo &info, const std::string &path);
+
+    /// @}
+
   private:
 
+    static std::string GetFullPath(const std::string &path);
+
+    static std::string GetObjectPath(const rpc::FileInfo &info);
+
     static std::string _filesBaseFolder;
 
   };
@@ -11,16 +11,15 @@
 #include "carla/opendrive/OpenDriveParser.h"
 #include "carla/road/Map.h"
 #include "carla/road/RoadTypes.h"
+#include "carla/road/RoutingGraph.h"
 #include "carla/trafficmanager/InMemoryMap.h"
 
-#include <sstream>
 
 namespace carla {
 namespace client {
 
   static auto MakeMap(const std::string &opendrive_contents) {
-    auto stream = std::istringstream(opendrive_contents);
-    auto map = opendrive::OpenDriveParser::Load(stream.str());
+    auto map = opendrive::OpenDriveParser::Load(opendrive_contents);
     if (!map.has_value()) {
       throw_exception(std::runtime_error("failed to generate map"));
     }
@@ -188,5 +187,31 @@ namespace client {
     traffic_manager::InMemoryMap::Cook(shared_from_this(), path);
   }
 
+  void Map::BuildRoutingGraph(road::RoutingParameters parameters) const {
+    auto graph = MakeShared<road::RoutingGraph>(_map, std::move(parameters));
+    std::lock_guard<std::mutex> lock(_routing_mutex);
+    _routing_graph = std::move(graph);
+  }
+
+  SharedPtr<const road::RoutingGraph> Map::GetRoutingGraph() const {
+    std::lock_guard<std::mutex> lock(_routing_mutex);
+    if (_routing_graph == nullptr) {
+      _routing_graph = MakeShared<road::RoutingGraph>(_map);
+    }
+    return _routing_graph;
+  }
+
+  std::vector<SharedPtr<Waypoint>> Map::ComputeRoute(
+      const Waypoint &origin,
+      const Waypoint &destination) const {
+    const auto route = GetRoutingGraph()->ComputeRoute(origin._waypoint, destination._waypoint);
+    std::vector<SharedPtr<Waypoint>> result;
+    result.reserve(route.waypoints.size());
+    for (const auto &waypoint : route.waypoints) {
+      result.emplace_back(SharedPtr<Waypoint>(new Waypoint{shared_from_this(), waypoint}));
+    }
+    return result;
+  }
+
 } // namespace client
 } // namespace carla
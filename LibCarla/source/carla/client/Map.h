@@ -12,9 +12,11 @@
 #include "carla/road/Lane.h"
 #include "carla/road/Map.h"
 #include "carla/road/RoadTypes.h"
+#include "carla/road/RoutingGraph.h"
 #include "carla/rpc/MapInfo.h"
 #include "Landmark.h"
 
+#include <mutex>
 #include <string>
 
 namespace carla {
@@ -97,13 +99,32 @@ namespace client {
     /// Cooks InMemoryMap used by the traffic manager
     void CookInMemoryMap(const std::string& path) const;
 
+    /// Compiles the lane-level routing graph used by ComputeRoute, replacing
+    /// the current one. Otherwise it is built with the default parameters on
+    /// the first query.
+    void BuildRoutingGraph(road::RoutingParameters parameters) const;
+
+    /// Returns the cheapest lane-level route from @a origin to @a
+    /// destination: the origin, a waypoint at the entrance of each lane
+    /// traversed and the destination. Empty if the destination cannot be
+    /// reached.
+    std::vector<SharedPtr<Waypoint>> ComputeRoute(
+        const Waypoint &origin,
+        const Waypoint &destination) const;
+
   private:
 
+    SharedPtr<const road::RoutingGraph> GetRoutingGraph() const;
+
     std::string open_drive_file;
 
     const rpc::MapInfo _description;
 
     const road::Map _map;
+
+    mutable std::mutex _routing_mutex;
+
+    mutable SharedPtr<const road::RoutingGraph> _routing_graph;
   };
 
 } // namespace client
@@ -123,6 +123,12 @@ namespace client {
     return _episode.Lock()->SpawnActor(blueprint, transform, parent_actor, attachment_type);
   }
 
+  detail::CallFuture<SharedPtr<Actor>> World::SpawnActorAsync(
+      const ActorBlueprint &blueprint,
+      const geom::Transform &transform) {
+    return _episode.Lock()->SpawnActorAsync(blueprint, transform);
+  }
+
   SharedPtr<Actor> World::TrySpawnActor(
       const ActorBlueprint &blueprint,
       const geom::Transform &transform,
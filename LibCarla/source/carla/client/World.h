@@ -15,6 +15,7 @@
 #include "carla/client/LightManager.h"
 #include "carla/client/Timestamp.h"
 #include "carla/client/WorldSnapshot.h"
+#include "carla/client/detail/CallFuture.h"
 #include "carla/client/detail/EpisodeProxy.h"
 #include "carla/geom/Transform.h"
 #include "carla/rpc/Actor.h"
@@ -122,6 +123,18 @@ namespace client {
         Actor *parent = nullptr,
         rpc::AttachmentType attachment_type = rpc::AttachmentType::Rigid) noexcept;
 
+    /// Same as SpawnActor but returns without waiting for the server, use
+    /// the future's Get to retrieve the actor. Spawning many actors this way
+    /// takes a single round trip.
+    ///
+    /// The actor is registered in the episode (and garbage collected) only
+    /// when Get returns it. If the future is destroyed before that, including
+    /// after Get timed out, the actor is destroyed in the simulator once the
+    /// response arrives.
+    detail::CallFuture<SharedPtr<Actor>> SpawnActorAsync(
+        const ActorBlueprint &blueprint,
+        const geom::Transform &transform);
+
     /// Block calling thread until a world tick is received.
     WorldSnapshot WaitForTick(time_duration timeout) const;
 
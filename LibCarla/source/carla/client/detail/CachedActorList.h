@@ -6,14 +6,18 @@
 
 #pragma once
 
+#include "carla/AtomicSharedPtr.h"
 #include "carla/NonCopyable.h"
 #include "carla/rpc/Actor.h"
 
-#include <boost/iterator/transform_iterator.hpp>
+#include <boost/optional.hpp>
 
 #include <algorithm>
-#include <iterator>
+#include <array>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace carla {
 namespace client {
@@ -26,10 +30,16 @@ namespace detail {
   /// Keeps a list of actor descriptions to avoid requesting each time the
   /// descriptions to the server.
   ///
+  /// The actors are split in shards, each an immutable map swapped atomically
+  /// on insertion (copy-on-write). Readers never wait for the writers, and a
+  /// writer only copies the shards it modifies.
+  ///
   /// @todo Dead actors are never removed from the list.
   class CachedActorList : private MovableNonCopyable {
   public:
 
+    CachedActorList();
+
     /// Inserts an actor into the list.
     void Insert(rpc::Actor actor);
 
@@ -54,50 +64,92 @@ namespace detail {
 
   private:
 
-    mutable std::mutex _mutex;
+    static constexpr size_t NUMBER_OF_SHARDS = 16u;
+
+    using ActorMap = std::unordered_map<ActorId, std::shared_ptr<const rpc::Actor>>;
+
+    using Snapshot = std::array<std::shared_ptr<const ActorMap>, NUMBER_OF_SHARDS>;
+
+    static size_t GetShardIndex(ActorId id) {
+      return id % NUMBER_OF_SHARDS;
+    }
+
+    /// Current version of every shard, so a whole range is looked up with a
+    /// single atomic load per shard.
+    Snapshot Load() const;
 
-    std::unordered_map<ActorId, rpc::Actor> _actors;
+    /// Serializes the writers only.
+    std::mutex _mutex;
+
+    std::array<AtomicSharedPtr<const ActorMap>, NUMBER_OF_SHARDS> _shards;
   };
 
   // ===========================================================================
   // -- CachedActorList implementation -----------------------------------------
   // ===========================================================================
 
+  inline CachedActorList::CachedActorList() {
+    for (auto &shard : _shards) {
+      shard.store(std::make_shared<const ActorMap>());
+    }
+  }
+
+  inline CachedActorList::Snapshot CachedActorList::Load() const {
+    Snapshot snapshot;
+    for (auto i = 0u; i < NUMBER_OF_SHARDS; ++i) {
+      snapshot[i] = _shards[i].load();
+    }
+    return snapshot;
+  }
+
   inline void CachedActorList::Insert(rpc::Actor actor) {
+    const auto id = actor.id;
+    auto &shard = _shards[GetShardIndex(id)];
     std::lock_guard<std::mutex> lock(_mutex);
-    auto id = actor.id;
-    _actors.emplace(id, std::move(actor));
+    auto actors = std::make_shared<ActorMap>(*shard.load());
+    actors->emplace(id, std::make_shared<const rpc::Actor>(std::move(actor)));
+    shard.store(std::move(actors));
   }
 
   template <typename RangeT>
   inline void CachedActorList::InsertRange(RangeT range) {
-    auto make_a_pair = [](rpc::Actor actor) {
-      auto id = actor.id;
-      return std::make_pair(id, std::move(actor));
-    };
-    auto make_iterator = [&make_a_pair](auto it) {
-      return boost::make_transform_iterator(std::make_move_iterator(it), make_a_pair);
-    };
+    std::array<std::shared_ptr<ActorMap>, NUMBER_OF_SHARDS> modified;
     std::lock_guard<std::mutex> lock(_mutex);
-    _actors.insert(make_iterator(std::begin(range)), make_iterator(std::end(range)));
+    for (auto &&item : range) {
+      rpc::Actor actor = std::move(item);
+      const auto id = actor.id;
+      const auto index = GetShardIndex(id);
+      if (modified[index] == nullptr) {
+        modified[index] = std::make_shared<ActorMap>(*_shards[index].load());
+      }
+      modified[index]->emplace(id, std::make_shared<const rpc::Actor>(std::move(actor)));
+    }
+    for (auto i = 0u; i < NUMBER_OF_SHARDS; ++i) {
+      if (modified[i] != nullptr) {
+        _shards[i].store(std::move(modified[i]));
+      }
+    }
   }
 
   template <typename RangeT>
   inline std::vector<ActorId> CachedActorList::GetMissingIds(const RangeT &range) const {
     std::vector<ActorId> result;
     result.reserve(range.size());
-    std::lock_guard<std::mutex> lock(_mutex);
-    std::copy_if(std::begin(range), std::end(range), std::back_inserter(result), [this](auto id) {
-      return _actors.find(id) == _actors.end();
-    });
+    const auto snapshot = Load();
+    for (auto &&id : range) {
+      const auto &actors = *snapshot[GetShardIndex(id)];
+      if (actors.find(id) == actors.end()) {
+        result.emplace_back(id);
+      }
+    }
     return result;
   }
 
   inline boost::optional<rpc::Actor> CachedActorList::GetActorById(ActorId id) const {
-    std::lock_guard<std::mutex> lock(_mutex);
-    auto it = _actors.find(id);
-    if (it != _actors.end()) {
-      return it->second;
+    const auto actors = _shards[GetShardIndex(id)].load();
+    auto it = actors->find(id);
+    if (it != actors->end()) {
+      return *it->second;
     }
     return boost::none;
   }
@@ -106,11 +158,12 @@ namespace detail {
   inline std::vector<rpc::Actor> CachedActorList::GetActorsById(const RangeT &range) const {
     std::vector<rpc::Actor> result;
     result.reserve(range.size());
-    std::lock_guard<std::mutex> lock(_mutex);
+    const auto snapshot = Load();
     for (auto &&id : range) {
-      auto it = _actors.find(id);
-      if (it != _actors.end()) {
-        result.emplace_back(it->second);
+      const auto &actors = *snapshot[GetShardIndex(id)];
+      auto it = actors.find(id);
+      if (it != actors.end()) {
+        result.emplace_back(*it->second);
       }
     }
     return result;
@@ -118,7 +171,9 @@ namespace detail {
 
   inline void CachedActorList::Clear() {
     std::lock_guard<std::mutex> lock(_mutex);
-    _actors.clear();
+    for (auto &shard : _shards) {
+      shard.store(std::make_shared<const ActorMap>());
+    }
   }
 
 } // namespace detail
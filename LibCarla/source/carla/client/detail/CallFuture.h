@@ -0,0 +1,151 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/Debug.h"
+#include "carla/Exception.h"
+#include "carla/Logging.h"
+#include "carla/MsgPack.h"
+#include "carla/NonCopyable.h"
+#include "carla/Time.h"
+#include "carla/client/TimeoutException.h"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace carla {
+namespace client {
+namespace detail {
+
+  /// Response of a call sent without waiting for the server. Many calls can
+  /// be in flight on the same connection; the response is only decoded when
+  /// Get is called.
+  template <typename T>
+  class CallFuture : private MovableNonCopyable {
+  public:
+
+    using ObjectHandle = ::clmdep_msgpack::object_handle;
+
+    using Converter = std::function<T(ObjectHandle &)>;
+
+    CallFuture(
+        std::future<ObjectHandle> future,
+        Converter converter,
+        std::string endpoint,
+        time_duration timeout)
+      : _future(std::move(future)),
+        _converter(std::move(converter)),
+        _endpoint(std::move(endpoint)),
+        _timeout(timeout) {}
+
+    CallFuture(CallFuture &&) = default;
+
+    CallFuture &operator=(CallFuture &&rhs) {
+      Abandon();
+      _future = std::move(rhs._future);
+      _converter = std::move(rhs._converter);
+      _abandon = std::move(rhs._abandon);
+      _endpoint = std::move(rhs._endpoint);
+      _timeout = rhs._timeout;
+      return *this;
+    }
+
+    ~CallFuture() {
+      Abandon();
+    }
+
+    /// Whether the response arrived, so Get won't block.
+    bool IsReady() const {
+      return
+          _future.valid() &&
+          (_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    }
+
+    /// Wait for the response and return its value. Throws if the call failed
+    /// or if no response arrives within the client's timeout.
+    ///
+    /// @pre Can only be called once.
+    T Get() {
+      DEBUG_ASSERT(_future.valid());
+      if (_future.wait_for(_timeout.to_chrono()) != std::future_status::ready) {
+        throw_exception(TimeoutException(_endpoint, _timeout));
+      }
+      auto object = _future.get();
+      return _converter(object);
+    }
+
+    /// Call @a handler with the value of this future if it is destroyed
+    /// before the value is taken with Get, including after Get timed out.
+    /// The handler runs in a detached thread once the response arrives, so
+    /// it can release what the call created on the server. It is kept by
+    /// the futures returned by Then.
+    template <typename HandlerT>
+    CallFuture OnAbandon(HandlerT &&handler) && {
+      _abandon = [converter=_converter, handler=std::forward<HandlerT>(handler)](
+          ObjectHandle &object) {
+        handler(converter(object));
+      };
+      return std::move(*this);
+    }
+
+    /// Return a future of @a functor applied to the value of this one.
+    /// @a functor runs in the thread that calls Get.
+    template <typename FunctorT>
+    auto Then(FunctorT &&functor) && {
+      using R = decltype(functor(std::declval<T>()));
+      auto converter = [converter=std::move(_converter), functor=std::forward<FunctorT>(functor)](
+          ObjectHandle &object) {
+        return functor(converter(object));
+      };
+      CallFuture<R> result(
+          std::move(_future),
+          std::move(converter),
+          std::move(_endpoint),
+          _timeout);
+      result._abandon = std::move(_abandon);
+      return result;
+    }
+
+  private:
+
+    template <typename>
+    friend class CallFuture;
+
+    void Abandon() {
+      if (!_future.valid() || !_abandon) {
+        return;
+      }
+      std::thread([future=std::move(_future), abandon=std::move(_abandon), timeout=_timeout]() mutable {
+        try {
+          if (future.wait_for(timeout.to_chrono()) == std::future_status::ready) {
+            auto object = future.get();
+            abandon(object);
+          }
+        } catch (const std::exception &e) {
+          log_warning("abandoned call:", e.what());
+        }
+      }).detach();
+    }
+
+    std::future<ObjectHandle> _future;
+
+    Converter _converter;
+
+    std::function<void(ObjectHandle &)> _abandon;
+
+    std::string _endpoint;
+
+    time_duration _timeout;
+  };
+
+} // namespace detail
+} // namespace client
+} // namespace carla
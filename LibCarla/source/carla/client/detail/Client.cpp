@@ -7,13 +7,16 @@
 #include "carla/client/detail/Client.h"
 
 #include "carla/Exception.h"
+#include "carla/Logging.h"
 #include "carla/Version.h"
 #include "carla/client/FileTransfer.h"
 #include "carla/client/TimeoutException.h"
 #include "carla/rpc/ActorDescription.h"
 #include "carla/rpc/BoneTransformDataIn.h"
 #include "carla/rpc/Client.h"
+#include "carla/rpc/CommandBatch.h"
 #include "carla/rpc/DebugShape.h"
+#include "carla/rpc/FileInfo.h"
 #include "carla/rpc/Response.h"
 #include "carla/rpc/VehicleControl.h"
 #include "carla/rpc/VehicleLightState.h"
@@ -24,6 +27,10 @@
 
 #include <rpc/rpc_error.h>
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <thread>
 
 namespace carla {
@@ -75,12 +82,37 @@ namespace detail {
       return Get(response);
     }
 
+    template <typename T, typename ... Args>
+    auto CallAsync(const std::string &function, Args && ... args) {
+      using R = typename carla::rpc::Response<T>;
+      using ResultT = decltype(Get(std::declval<R &>()));
+      return CallFuture<ResultT>(
+          rpc_client.future_call(function, std::forward<Args>(args) ...),
+          [](auto &object) -> ResultT {
+            auto response = object.template as<R>();
+            if (response.HasError()) {
+              throw_exception(std::runtime_error(response.GetError().What()));
+            }
+            return Get(response);
+          },
+          endpoint,
+          GetTimeout());
+    }
+
     template <typename ... Args>
     void AsyncCall(const std::string &function, Args && ... args) {
       // Discard returned future.
       rpc_client.async_call(function, std::forward<Args>(args) ...);
     }
 
+    /// Make sure the file @a name described by @a info is in the cache,
+    /// downloading it otherwise.
+    bool StoreFile(const std::string &name, const rpc::FileInfo &info);
+
+    /// Whether the server binds apply_command_batch, servers older than
+    /// the client only bind apply_batch. Asked once with an empty batch.
+    bool HasCommandBatch();
+
     time_duration GetTimeout() const {
       auto timeout = rpc_client.get_timeout();
       DEBUG_ASSERT(timeout.has_value());
@@ -92,8 +124,70 @@ namespace detail {
     rpc::Client rpc_client;
 
     streaming::Client streaming_client;
+
+  private:
+
+    std::once_flag _command_batch_checked;
+
+    bool _has_command_batch = false;
   };
 
+  bool Client::Pimpl::HasCommandBatch() {
+    // If the call times out the exception propagates and the next batch asks
+    // again.
+    std::call_once(_command_batch_checked, [this]() {
+      try {
+        RawCall("apply_command_batch", rpc::CommandBatch{}, false);
+        _has_command_batch = true;
+      } catch (const ::rpc::rpc_error &e) {
+        log_warning("server does not support apply_command_batch, using apply_batch:", e.what());
+      }
+    });
+    return _has_command_batch;
+  }
+
+  // ===========================================================================
+  // -- Client::Pimpl file transfer --------------------------------------------
+  // ===========================================================================
+
+  /// Size of the pieces a file is downloaded in.
+  static constexpr uint64_t FileChunkSize = 4u * 1024u * 1024u;
+
+  /// Maximum number of pieces requested and not received yet.
+  static constexpr size_t MaxChunksInFlight = 8u;
+
+  bool Client::Pimpl::StoreFile(const std::string &name, const rpc::FileInfo &info) {
+    if (!FileTransfer::HasObject(info)) {
+      // Request several pieces at once, the server reads them in parallel
+      // while we copy the ones already received.
+      std::vector<uint8_t> content(info.size);
+      std::deque<std::pair<uint64_t, CallFuture<std::vector<uint8_t>>>> requests;
+      uint64_t next = 0u;
+      while ((next < info.size) || !requests.empty()) {
+        while ((next < info.size) && (requests.size() < MaxChunksInFlight)) {
+          const auto size = std::min(FileChunkSize, info.size - next);
+          requests.emplace_back(
+              next,
+              CallAsync<std::vector<uint8_t>>("request_file_chunk", name, next, size));
+          next += size;
+        }
+        const auto offset = requests.front().first;
+        const auto chunk = requests.front().second.Get();
+        requests.pop_front();
+        if (chunk.size() != std::min(FileChunkSize, info.size - offset)) {
+          log_warning("file", name, "changed on the server while downloading it");
+          return false;
+        }
+        std::memcpy(content.data() + offset, chunk.data(), chunk.size());
+      }
+      if (!FileTransfer::WriteObject(info, content)) {
+        log_warning("failed to store downloaded file", name, "in the cache");
+        return false;
+      }
+    }
+    return FileTransfer::LinkObject(info, name);
+  }
+
   // ===========================================================================
   // -- Client -----------------------------------------------------------------
   // ===========================================================================
@@ -206,14 +300,22 @@ namespace detail {
 
     if (download) {
 
-      // For each required file, check if it exists and request it otherwise
-      for (auto requiredFile : requiredFiles) {
-        if (!FileTransfer::FileExists(requiredFile)) {
-          RequestFile(requiredFile);
-          log_info("Could not find the required file in cache, downloading... ", requiredFile);
+      // Ask for the size and hash of every file at once
+      std::vector<CallFuture<rpc::FileInfo>> infos;
+      infos.reserve(requiredFiles.size());
+      for (auto &requiredFile : requiredFiles) {
+        infos.emplace_back(_pimpl->CallAsync<rpc::FileInfo>("get_file_info", requiredFile));
+      }
+
+      // For each required file, check if its content is cached and request it otherwise
+      for (auto i = 0u; i < requiredFiles.size(); ++i) {
+        const auto info = infos[i].Get();
+        if (FileTransfer::HasObject(info)) {
+          log_info("Found the required file in cache! ", requiredFiles[i]);
         } else {
-          log_info("Found the required file in cache! ", requiredFile);
+          log_info("Could not find the required file in cache, downloading... ", requiredFiles[i]);
         }
+        _pimpl->StoreFile(requiredFiles[i], info);
       }
     }
     return requiredFiles;
@@ -221,8 +323,8 @@ namespace detail {
 
   void Client::RequestFile(const std::string &name) const {
     // Download the binary content of the file from the server and write it on the client
-    auto content = _pimpl->CallAndWait<std::vector<uint8_t>>("request_file", name);
-    FileTransfer::WriteFile(name, content);
+    const auto info = _pimpl->CallAndWait<rpc::FileInfo>("get_file_info", name);
+    _pimpl->StoreFile(name, info);
   }
 
   std::vector<uint8_t> Client::GetCacheFile(const std::string &name, const bool request_otherwise) const {
@@ -237,6 +339,19 @@ namespace detail {
     return file;
   }
 
+  std::shared_ptr<MappedFile> Client::MapCacheFile(const std::string &name, const bool request_otherwise) const {
+    const auto info = _pimpl->CallAndWait<rpc::FileInfo>("get_file_info", name);
+    if (info.size == 0u) {
+      return nullptr;
+    }
+    if (!FileTransfer::HasObject(info)) {
+      if (!request_otherwise || !_pimpl->StoreFile(name, info)) {
+        return nullptr;
+      }
+    }
+    return FileTransfer::MapObject(info);
+  }
+
   std::vector<std::string> Client::GetAvailableMaps() {
     return _pimpl->CallAndWait<std::vector<std::string>>("get_available_maps");
   }
@@ -265,6 +380,10 @@ namespace detail {
     _pimpl->AsyncCall("set_weather_parameters", weather);
   }
 
+  void Client::RequestEpisodeKeyframe() {
+    _pimpl->AsyncCall("request_episode_keyframe");
+  }
+
   std::vector<rpc::Actor> Client::GetActorsById(
       const std::vector<ActorId> &ids) {
     using return_t = std::vector<rpc::Actor>;
@@ -324,6 +443,12 @@ namespace detail {
     return _pimpl->CallAndWait<rpc::Actor>("spawn_actor", description, transform);
   }
 
+  CallFuture<rpc::Actor> Client::SpawnActorAsync(
+      const rpc::ActorDescription &description,
+      const geom::Transform &transform) {
+    return _pimpl->CallAsync<rpc::Actor>("spawn_actor", description, transform);
+  }
+
   rpc::Actor Client::SpawnActorWithParent(
       const rpc::ActorDescription &description,
       const geom::Transform &transform,
@@ -572,16 +697,26 @@ namespace detail {
   }
 
   void Client::ApplyBatch(std::vector<rpc::Command> commands, bool do_tick_cue) {
-    _pimpl->AsyncCall("apply_batch", std::move(commands), do_tick_cue);
+    if (_pimpl->HasCommandBatch()) {
+      _pimpl->AsyncCall("apply_command_batch", rpc::CommandBatch(commands), do_tick_cue);
+    } else {
+      _pimpl->AsyncCall("apply_batch", std::move(commands), do_tick_cue);
+    }
   }
 
   std::vector<rpc::CommandResponse> Client::ApplyBatchSync(
       std::vector<rpc::Command> commands,
       bool do_tick_cue) {
-    auto result = _pimpl->RawCall("apply_batch", std::move(commands), do_tick_cue);
+    auto result = _pimpl->HasCommandBatch() ?
+        _pimpl->RawCall("apply_command_batch", rpc::CommandBatch(commands), do_tick_cue) :
+        _pimpl->RawCall("apply_batch", std::move(commands), do_tick_cue);
     return result.as<std::vector<rpc::CommandResponse>>();
   }
 
+  void Client::ApplyWalkerStates(rpc::WalkerStateList states) {
+    _pimpl->AsyncCall("apply_walker_states", std::move(states));
+  }
+
   uint64_t Client::SendTickCue() {
     return _pimpl->CallAndWait<uint64_t>("tick_cue");
   }
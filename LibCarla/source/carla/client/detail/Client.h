@@ -6,9 +6,11 @@
 
 #pragma once
 
+#include "carla/MappedFile.h"
 #include "carla/Memory.h"
 #include "carla/NonCopyable.h"
 #include "carla/Time.h"
+#include "carla/client/detail/CallFuture.h"
 #include "carla/geom/Transform.h"
 #include "carla/geom/Location.h"
 #include "carla/rpc/Actor.h"
@@ -27,6 +29,7 @@
 #include "carla/rpc/TrafficLightState.h"
 #include "carla/rpc/VehicleDoor.h"
 #include "carla/rpc/VehicleLightStateList.h"
+#include "carla/rpc/WalkerStateList.h"
 #include "carla/rpc/VehicleLightState.h"
 #include "carla/rpc/VehiclePhysicsControl.h"
 #include "carla/rpc/VehicleWheels.h"
@@ -133,6 +136,11 @@ namespace detail {
 
     std::vector<uint8_t> GetCacheFile(const std::string &name, const bool request_otherwise = true) const;
 
+    /// Map the cached copy of the file @a name, verified against the server's
+    /// copy; nullptr if the server doesn't have it or it is not cached and
+    /// @a request_otherwise is false.
+    std::shared_ptr<MappedFile> MapCacheFile(const std::string &name, const bool request_otherwise = true) const;
+
     std::vector<std::string> GetAvailableMaps();
 
     std::vector<rpc::ActorDefinition> GetActorDefinitions();
@@ -147,6 +155,10 @@ namespace detail {
 
     void SetWeatherParameters(const rpc::WeatherParameters &weather);
 
+    /// Ask the server to send the next episode state as a keyframe. Does not
+    /// wait for the response.
+    void RequestEpisodeKeyframe();
+
     std::vector<rpc::Actor> GetActorsById(const std::vector<ActorId> &ids);
 
     rpc::VehiclePhysicsControl GetVehiclePhysicsControl(rpc::ActorId vehicle) const;
@@ -173,6 +185,12 @@ namespace detail {
         const rpc::ActorDescription &description,
         const geom::Transform &transform);
 
+    /// Same as SpawnActor but returns without waiting for the server, so
+    /// many actors can be spawned in a single round trip.
+    CallFuture<rpc::Actor> SpawnActorAsync(
+        const rpc::ActorDescription &description,
+        const geom::Transform &transform);
+
     rpc::Actor SpawnActorWithParent(
         const rpc::ActorDescription &description,
         const geom::Transform &transform,
@@ -368,6 +386,10 @@ namespace detail {
         std::vector<rpc::Command> commands,
         bool do_tick_cue);
 
+    /// Same as applying a batch of Command::ApplyWalkerState, walkers that
+    /// no longer exist are skipped.
+    void ApplyWalkerStates(rpc::WalkerStateList states);
+
     uint64_t SendTickCue();
 
     std::vector<rpc::LightState> QueryLightsStateToServer() const;
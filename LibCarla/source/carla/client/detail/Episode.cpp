@@ -20,9 +20,9 @@ namespace detail {
 
 using namespace std::chrono_literals;
 
-  static auto &CastData(const sensor::SensorData &data) {
+  static auto CastData(SharedPtr<sensor::SensorData> data) {
     using target_t = const sensor::data::RawEpisodeState;
-    return static_cast<target_t &>(data);
+    return boost::static_pointer_cast<target_t>(std::move(data));
   }
 
   template <typename RangeT>
@@ -56,9 +56,28 @@ using namespace std::chrono_literals;
       auto self = weak.lock();
       if (self != nullptr) {
 
-        auto data = sensor::Deserializer::Deserialize(std::move(buffer));
-        auto next = std::make_shared<const EpisodeState>(CastData(*data));
+        auto data = CastData(sensor::Deserializer::Deserialize(std::move(buffer)));
         auto prev = self->GetState();
+        std::shared_ptr<const EpisodeState> next;
+        if (!data->IsDeltaFrame()) {
+          self->_keyframe_requested = false;
+          next = std::make_shared<const EpisodeState>(std::move(data));
+        } else if (prev->IsBaseOf(*data)) {
+          next = std::make_shared<const EpisodeState>(*data, *prev);
+        } else {
+          // Missed the frame this delta applies to (or just subscribed), ask
+          // for a keyframe instead of waiting for the next periodic one.
+          log_debug("episode state: dropping delta frame", data->GetFrame());
+          if (!self->_keyframe_requested.exchange(true)) {
+            try {
+              self->_client.RequestEpisodeKeyframe();
+            } catch (const std::exception &e) {
+              self->_keyframe_requested = false;
+              log_error("exception requesting an episode keyframe:", e.what());
+            }
+          }
+          return;
+        }
 
         // TODO: Update how the map change is detected
         bool HasMapChanged = next->HasMapChanged();
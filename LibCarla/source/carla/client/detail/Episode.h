@@ -17,6 +17,7 @@
 #include "carla/client/detail/WalkerNavigation.h"
 #include "carla/rpc/EpisodeInfo.h"
 
+#include <atomic>
 #include <vector>
 
 namespace carla {
@@ -145,6 +146,9 @@ namespace detail {
     bool _pending_exceptions = false;
 
     bool _should_update_map = true;
+
+    /// Set while waiting for the keyframe requested after dropping a delta.
+    std::atomic_bool _keyframe_requested{false};
   };
 
 } // namespace detail
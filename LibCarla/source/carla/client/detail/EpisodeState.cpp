@@ -6,33 +6,102 @@
 
 #include "carla/client/detail/EpisodeState.h"
 
+#include <limits>
+
 namespace carla {
 namespace client {
 namespace detail {
 
-  EpisodeState::EpisodeState(const sensor::data::RawEpisodeState &state)
-    : _episode_id(state.GetEpisodeId()),
-      _timestamp(
-          state.GetFrame(),
-          state.GetGameTimeStamp(),
-          state.GetDeltaSeconds(),
-          state.GetPlatformTimeStamp()),
-      _map_origin(state.GetMapOrigin()),
-      _simulation_state(state.GetSimulationState()) {
-    _actors.reserve(state.size());
-    for (auto &&actor : state) {
-      DEBUG_ONLY(auto result = )
-      _actors.emplace(
-          actor.id,
-          ActorSnapshot{
-              actor.id,
-              actor.actor_state,
-              actor.transform,
-              actor.velocity,
-              actor.angular_velocity,
-              actor.acceleration,
-              actor.state});
-      DEBUG_ASSERT(result.second);
+  /// Below this number of actors a linear search is faster than building the
+  /// index.
+  static constexpr size_t LINEAR_SEARCH_THRESHOLD = 16u;
+
+  static constexpr uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+  static size_t HashActorId(ActorId id, size_t mask) {
+    // Fibonacci hashing, actor ids are mostly consecutive.
+    return (static_cast<size_t>(id) * 0x9E3779B97F4A7C15ull >> 32u) & mask;
+  }
+
+  static Timestamp MakeTimestamp(const sensor::data::RawEpisodeState &state) {
+    return {
+        state.GetFrame(),
+        state.GetGameTimeStamp(),
+        state.GetDeltaSeconds(),
+        state.GetPlatformTimeStamp()};
+  }
+
+  EpisodeState::EpisodeState(SharedPtr<const sensor::data::RawEpisodeState> state)
+    : _episode_id(state->GetEpisodeId()),
+      _timestamp(MakeTimestamp(*state)),
+      _map_origin(state->GetMapOrigin()),
+      _simulation_state(state->GetSimulationState()),
+      _data(std::move(state)),
+      _begin(_data->begin()),
+      _end(_data->end()) {
+    DEBUG_ASSERT(!_data->IsDeltaFrame());
+  }
+
+  EpisodeState::EpisodeState(
+      const sensor::data::RawEpisodeState &delta,
+      const EpisodeState &previous)
+    : _episode_id(delta.GetEpisodeId()),
+      _timestamp(MakeTimestamp(delta)),
+      _map_origin(delta.GetMapOrigin()),
+      _simulation_state(delta.GetSimulationState()),
+      _actors(previous._begin, previous._end) {
+    DEBUG_ASSERT(previous.IsBaseOf(delta));
+    sensor::s11n::EpisodeStateSerializer::ApplyDelta(
+        _actors,
+        [&previous](ActorId id) -> size_t {
+          auto *actor = previous.FindActor(id);
+          return actor != nullptr ? static_cast<size_t>(actor - previous._begin) : previous.size();
+        },
+        delta.GetRemovedActorIds(),
+        delta);
+    _begin = _actors.data();
+    _end = _actors.data() + _actors.size();
+  }
+
+  const EpisodeState::ActorDynamicState *EpisodeState::FindActor(ActorId id) const {
+    if (size() <= LINEAR_SEARCH_THRESHOLD) {
+      for (auto *actor = _begin; actor != _end; ++actor) {
+        if (actor->id == id) {
+          return actor;
+        }
+      }
+      return nullptr;
+    }
+    std::call_once(_index_flag, [this]() { BuildIndex(); });
+    const size_t mask = _index.size() - 1u;
+    for (auto i = HashActorId(id, mask);; i = (i + 1u) & mask) {
+      const auto &slot = _index[i];
+      if (slot.position == EMPTY_SLOT) {
+        return nullptr;
+      } else if (slot.id == id) {
+        return _begin + slot.position;
+      }
+    }
+  }
+
+  void EpisodeState::BuildIndex() const {
+    size_t capacity = 1u;
+    while (capacity < 2u * size()) {
+      capacity <<= 1u;
+    }
+    _index.assign(capacity, IndexSlot{0u, EMPTY_SLOT});
+    const size_t mask = capacity - 1u;
+    for (auto *actor = _begin; actor != _end; ++actor) {
+      const ActorId id = actor->id;
+      auto i = HashActorId(id, mask);
+      while (_index[i].position != EMPTY_SLOT && _index[i].id != id) {
+        i = (i + 1u) & mask;
+      }
+      // Keep the first occurrence if an id is repeated.
+      DEBUG_ASSERT(_index[i].position == EMPTY_SLOT);
+      if (_index[i].position == EMPTY_SLOT) {
+        _index[i] = IndexSlot{id, static_cast<uint32_t>(actor - _begin)};
+      }
     }
   }
 
@@ -8,6 +8,7 @@
 
 #include "carla/Iterator.h"
 #include "carla/ListView.h"
+#include "carla/Memory.h"
 #include "carla/NonCopyable.h"
 #include "carla/client/ActorSnapshot.h"
 #include "carla/client/Timestamp.h"
@@ -16,25 +17,53 @@
 
 #include <boost/optional.hpp>
 
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
+#include <vector>
 
 namespace carla {
 namespace client {
 namespace detail {
 
   /// Represents the state of all the actors of an episode at a given frame.
+  ///
+  /// The state keeps alive the buffer received from the simulator and reads
+  /// the actors directly from it, ActorSnapshot objects are only created on
+  /// demand. The index for looking up actors by id is built the first time
+  /// it is needed.
+  ///
+  /// Delta frames are applied over the state of the previous frame, in which
+  /// case the actors are copied.
   class EpisodeState
     : public std::enable_shared_from_this<EpisodeState>,
       private NonCopyable {
 
       using SimulationState = sensor::s11n::EpisodeStateSerializer::SimulationState;
 
+      using ActorDynamicState = sensor::data::ActorDynamicState;
+
   public:
 
-    explicit EpisodeState(uint64_t episode_id) : _episode_id(episode_id) {}
+    explicit EpisodeState(uint64_t episode_id)
+      : _episode_id(episode_id),
+        _simulation_state(SimulationState::None) {}
+
+    explicit EpisodeState(SharedPtr<const sensor::data::RawEpisodeState> state);
 
-    explicit EpisodeState(const sensor::data::RawEpisodeState &state);
+    /// Rebuild the state of a delta frame.
+    /// @pre previous.IsBaseOf(*delta).
+    EpisodeState(
+        const sensor::data::RawEpisodeState &delta,
+        const EpisodeState &previous);
+
+    /// Whether @a state is a delta frame that applies over this state.
+    bool IsBaseOf(const sensor::data::RawEpisodeState &state) const {
+      return
+          state.IsDeltaFrame() &&
+          (state.GetEpisodeId() == _episode_id) &&
+          (state.GetBaseFrame() == _timestamp.frame);
+    }
 
     auto GetEpisodeId() const {
       return _episode_id;
@@ -61,49 +90,64 @@ namespace detail {
     }
 
     bool ContainsActorSnapshot(ActorId actor_id) const {
-      return _actors.find(actor_id) != _actors.end();
+      return FindActor(actor_id) != nullptr;
     }
 
     ActorSnapshot GetActorSnapshot(ActorId id) const {
-      ActorSnapshot state;
-      CopyActorSnapshotIfPresent(id, state);
-      return state;
+      auto *actor = FindActor(id);
+      return actor != nullptr ? MakeActorSnapshot(*actor) : ActorSnapshot{};
     }
 
     boost::optional<ActorSnapshot> GetActorSnapshotIfPresent(ActorId id) const {
       boost::optional<ActorSnapshot> state;
-      CopyActorSnapshotIfPresent(id, state);
+      auto *actor = FindActor(id);
+      if (actor != nullptr) {
+        state = MakeActorSnapshot(*actor);
+      }
       return state;
     }
 
     auto GetActorIds() const {
+      auto get_id = [](const ActorDynamicState &actor) -> ActorId { return actor.id; };
       return MakeListView(
-          iterator::make_map_keys_const_iterator(_actors.begin()),
-          iterator::make_map_keys_const_iterator(_actors.end()));
+          boost::make_transform_iterator(_begin, get_id),
+          boost::make_transform_iterator(_end, get_id));
     }
 
     size_t size() const {
-      return _actors.size();
+      return static_cast<size_t>(_end - _begin);
     }
 
     auto begin() const {
-      return iterator::make_map_values_const_iterator(_actors.begin());
+      return boost::make_transform_iterator(_begin, &MakeActorSnapshot);
     }
 
     auto end() const {
-      return iterator::make_map_values_const_iterator(_actors.end());
+      return boost::make_transform_iterator(_end, &MakeActorSnapshot);
     }
 
   private:
 
-    template <typename T>
-    void CopyActorSnapshotIfPresent(ActorId id, T &value) const {
-      auto it = _actors.find(id);
-      if (it != _actors.end()) {
-        value = it->second;
-      }
+    static ActorSnapshot MakeActorSnapshot(const ActorDynamicState &actor) {
+      return ActorSnapshot{
+          actor.id,
+          actor.actor_state,
+          actor.transform,
+          actor.velocity,
+          actor.angular_velocity,
+          actor.acceleration,
+          actor.state};
     }
 
+    const ActorDynamicState *FindActor(ActorId id) const;
+
+    void BuildIndex() const;
+
+    struct IndexSlot {
+      ActorId id;
+      uint32_t position;
+    };
+
     const uint64_t _episode_id;
 
     const Timestamp _timestamp;
@@ -112,7 +156,26 @@ namespace detail {
 
     SimulationState _simulation_state;
 
-    std::unordered_map<ActorId, ActorSnapshot> _actors;
+    /// Keeps alive the memory the actors are read from.
+    SharedPtr<const sensor::data::RawEpisodeState> _data;
+
+    /// Actors rebuilt from a delta frame.
+    std::vector<ActorDynamicState> _actors;
+
+    const ActorDynamicState *_begin = nullptr;
+
+    const ActorDynamicState *_end = nullptr;
+
+    /// @name Lookup index
+    /// @{
+
+    /// Open addressing table with linear probing, its size is a power of two
+    /// at least twice the number of actors.
+    mutable std::vector<IndexSlot> _index;
+
+    mutable std::once_flag _index_flag;
+
+    /// @}
   };
 
 } // namespace detail
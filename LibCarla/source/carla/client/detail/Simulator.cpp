@@ -11,7 +11,6 @@
 #include "carla/Logging.h"
 #include "carla/RecurrentSharedFuture.h"
 #include "carla/client/BlueprintLibrary.h"
-#include "carla/client/FileTransfer.h"
 #include "carla/client/Map.h"
 #include "carla/client/Sensor.h"
 #include "carla/client/TimeoutException.h"
@@ -168,8 +167,14 @@ namespace detail {
       std::reverse(map_name.begin(), map_name.end());
       std::reverse(map_base_path.begin(), map_base_path.end());
       std::string XODRFolder = map_base_path + "/OpenDrive/" + map_name + ".xodr";
-      if (FileTransfer::FileExists(XODRFolder) == false) _client.GetRequiredFiles();
-      _open_drive_file = _client.GetMapData();
+      // Read the OpenDRIVE from the cache if the server has it as a file,
+      // processes on the same machine download it only once.
+      auto xodr = _client.MapCacheFile(XODRFolder);
+      if (xodr != nullptr) {
+        _open_drive_file.assign(reinterpret_cast<const char *>(xodr->data()), xodr->size());
+      } else {
+        _open_drive_file = _client.GetMapData();
+      }
       _cached_map = MakeShared<Map>(map_info, _open_drive_file);
     }
 
@@ -349,6 +354,37 @@ namespace detail {
     return result;
   }
 
+  CallFuture<SharedPtr<Actor>> Simulator::SpawnActorAsync(
+      const ActorBlueprint &blueprint,
+      const geom::Transform &transform,
+      GarbageCollectionPolicy gc) {
+    const auto gca = (gc == GarbageCollectionPolicy::Inherit ? _gc_policy : gc);
+    auto episode = GetCurrentEpisode();
+    return _client.SpawnActorAsync(blueprint.MakeActorDescription(), transform).OnAbandon(
+        [episode](rpc::Actor actor) {
+          // Nobody took the actor, so it was never registered nor garbage
+          // collected. Lock throws if the simulator is gone.
+          auto simulator = episode.Lock();
+          if (!simulator->_client.DestroyActor(actor.id)) {
+            log_warning("failed to destroy abandoned actor", actor.id);
+          }
+        }).Then(
+        [episode, gca](rpc::Actor actor) -> SharedPtr<Actor> {
+          // The simulator may have been destroyed while the call was in
+          // flight, Lock throws in that case.
+          auto simulator = episode.Lock();
+          DEBUG_ASSERT(simulator->_episode != nullptr);
+          simulator->_episode->RegisterActor(actor);
+          auto result = ActorFactory::MakeActor(episode, actor, gca);
+          log_debug(
+              result->GetDisplayId(),
+              "created",
+              gca == GarbageCollectionPolicy::Enabled ? "with" : "without",
+              "garbage collection");
+          return result;
+        });
+  }
+
   bool Simulator::DestroyActor(Actor &actor) {
     bool success = true;
     success = _client.DestroyActor(actor.GetId());
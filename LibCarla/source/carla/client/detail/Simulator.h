@@ -345,6 +345,13 @@ namespace detail {
         rpc::AttachmentType attachment_type = rpc::AttachmentType::Rigid,
         GarbageCollectionPolicy gc = GarbageCollectionPolicy::Inherit);
 
+    /// Same as SpawnActor but returns without waiting for the server. The
+    /// actor is registered when the future's Get is called.
+    CallFuture<SharedPtr<Actor>> SpawnActorAsync(
+        const ActorBlueprint &blueprint,
+        const geom::Transform &transform,
+        GarbageCollectionPolicy gc = GarbageCollectionPolicy::Inherit);
+
     bool DestroyActor(Actor &actor);
 
     ActorSnapshot GetActorSnapshot(ActorId actor_id) const {
@@ -10,9 +10,9 @@
 #include "carla/client/detail/Episode.h"
 #include "carla/client/detail/EpisodeState.h"
 #include "carla/nav/Navigation.h"
-#include "carla/rpc/Command.h"
 #include "carla/rpc/DebugShape.h"
 #include "carla/rpc/WalkerControl.h"
+#include "carla/rpc/WalkerStateList.h"
 
 #include <sstream>
 
@@ -24,7 +24,10 @@ namespace detail {
     // Here call the server to retrieve the navmesh data.
     auto files = _client.GetRequiredFiles("Nav");
     if (!files.empty()) {
-      _nav.Load(_client.GetCacheFile(files[0]));
+      auto file = _client.MapCacheFile(files[0]);
+      if (file != nullptr) {
+        _nav.Load(file->data(), file->size());
+      }
     }
   }
 
@@ -46,19 +49,19 @@ namespace detail {
     // update crowd in navigation module
     _nav.UpdateCrowd(*state);
 
+    // send the state of all walkers packed in a single message
     carla::geom::Transform trans;
-    using Cmd = rpc::Command;
-    std::vector<Cmd> commands;
-    commands.reserve(walkers->size());
+    rpc::WalkerStateList states;
+    states.reserve(walkers->size());
     for (auto handle : *walkers) {
       // get the transform of the walker
       if (_nav.GetWalkerTransform(handle.walker, trans)) {
         float speed = _nav.GetWalkerSpeed(handle.walker);
-        commands.emplace_back(Cmd::ApplyWalkerState{ handle.walker, trans, speed });
+        states.emplace_back(handle.walker, trans, speed);
       }
     }
 
-    _client.ApplyBatch(std::move(commands), false);
+    _client.ApplyWalkerStates(std::move(states));
   }
 
   void WalkerNavigation::CheckIfWalkerExist(std::vector<WalkerHandle> walkers, const EpisodeState &state) {
@@ -6,6 +6,7 @@
 
 #include <carla/geom/Mesh.h>
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <ios>
@@ -89,7 +90,7 @@ namespace geom {
   }
 
   void Mesh::AddVertices(const std::vector<Mesh::vertex_type> &vertices) {
-    std::copy(vertices.begin(), vertices.end(), std::back_inserter(_vertices));
+    _vertices.insert(_vertices.end(), vertices.begin(), vertices.end());
   }
 
   void Mesh::AddNormal(normal_type normal) {
@@ -137,6 +138,12 @@ namespace geom {
     _materials.back().index_end = close_index;
   }
 
+  void Mesh::Reserve(size_t vertices_num, size_t indexes_num, size_t materials_num) {
+    _vertices.reserve(_vertices.size() + vertices_num);
+    _indexes.reserve(_indexes.size() + indexes_num);
+    _materials.reserve(_materials.size() + materials_num);
+  }
+
   std::string Mesh::GenerateOBJ() const {
     if (!IsValid()) {
       return "";
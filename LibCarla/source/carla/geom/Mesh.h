@@ -99,6 +99,11 @@ namespace geom {
     /// Stops applying the material to the new added triangles.
     void EndMaterial();
 
+    /// Reserves space for at least @a vertices_num more vertices and
+    /// @a indexes_num more indexes, avoiding reallocations when the final
+    /// size of the mesh can be estimated beforehand.
+    void Reserve(size_t vertices_num, size_t indexes_num, size_t materials_num = 0u);
+
     // =========================================================================
     // -- Export methods -------------------------------------------------------
     // =========================================================================
@@ -91,6 +91,16 @@ namespace nav {
 
   // load navigation data from memory
   bool Navigation::Load(std::vector<uint8_t> content) {
+    if (!Load(content.data(), content.size())) {
+      return false;
+    }
+    // copy
+    _binary_mesh = std::move(content);
+    return true;
+  }
+
+  // load navigation data from a buffer
+  bool Navigation::Load(const uint8_t *content, size_t size) {
     const int NAVMESHSET_MAGIC = 'M' << 24 | 'S' << 16 | 'E' << 8 | 'T'; // 'MSET';
     const int NAVMESHSET_VERSION = 1;
 #pragma pack(push, 1)
@@ -108,14 +118,14 @@ namespace nav {
 #pragma pack(pop)
 
     // check size for header
-    if (content.size() < sizeof(header)) {
+    if (size < sizeof(header)) {
       logging::log("Nav: failed loading binary");
       return false;
     }
 
     // read the file header
     unsigned long pos = 0;
-    memcpy(&header, &content[pos], sizeof(header));
+    memcpy(&header, content + pos, sizeof(header));
     pos += sizeof(header);
 
     // check file magic and version
@@ -140,12 +150,12 @@ namespace nav {
       NavMeshTileHeader tile_header;
 
       // read the tile header
-      memcpy(&tile_header, &content[pos], sizeof(tile_header));
-      pos += sizeof(tile_header);
-      if (pos >= content.size()) {
+      if (pos + sizeof(tile_header) >= size) {
         dtFreeNavMesh(mesh);
         return false;
       }
+      memcpy(&tile_header, content + pos, sizeof(tile_header));
+      pos += sizeof(tile_header);
 
       // check for valid tile
       if (!tile_header.tile_ref || !tile_header.data_size) {
@@ -158,14 +168,15 @@ namespace nav {
         break;
       }
 
-      // read the tile
-      memcpy(data, &content[pos], static_cast<size_t>(tile_header.data_size));
-      pos += static_cast<unsigned long>(tile_header.data_size);
-      if (pos > content.size()) {
+      // read the tile, checking the size first since a mapped file can't be
+      // read past its end
+      if (pos + static_cast<unsigned long>(tile_header.data_size) > size) {
         dtFree(data);
         dtFreeNavMesh(mesh);
         return false;
       }
+      memcpy(data, content + pos, static_cast<size_t>(tile_header.data_size));
+      pos += static_cast<unsigned long>(tile_header.data_size);
 
       // add the tile data
       mesh->addTile(reinterpret_cast<unsigned char *>(data), tile_header.data_size, DT_TILE_FREE_DATA,
@@ -181,8 +192,7 @@ namespace nav {
     _nav_query = dtAllocNavMeshQuery();
     _nav_query->init(_nav_mesh, MAX_QUERY_SEARCH_NODES);
 
-    // copy
-    _binary_mesh = std::move(content);
+    _binary_mesh.clear();
     _ready = true;
 
     // create and init the crowd manager
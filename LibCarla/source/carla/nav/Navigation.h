@@ -65,6 +65,9 @@ namespace nav {
     bool Load(const std::string &filename);
     /// load navigation data from memory
     bool Load(std::vector<uint8_t> content);
+    /// load navigation data from a buffer, e.g. a mapped file, it is not
+    /// needed after the call
+    bool Load(const uint8_t *data, size_t size);
     /// return the path points to go from one position to another
     bool GetPath(carla::geom::Location from, carla::geom::Location to, dtQueryFilter * filter,
     std::vector<carla::geom::Location> &path, std::vector<unsigned char> &area);
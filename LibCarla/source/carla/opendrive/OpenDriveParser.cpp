@@ -8,6 +8,7 @@
 
 #include "carla/Logging.h"
 #include "carla/opendrive/parser/ControllerParser.h"
+#include "carla/opendrive/parser/ElementStream.h"
 #include "carla/opendrive/parser/GeoReferenceParser.h"
 #include "carla/opendrive/parser/GeometryParser.h"
 #include "carla/opendrive/parser/JunctionParser.h"
@@ -21,30 +22,82 @@
 
 #include <pugixml/pugixml.hpp>
 
+#include <streambuf>
+
 namespace carla {
 namespace opendrive {
 
-  boost::optional<road::Map> OpenDriveParser::Load(const std::string &opendrive) {
-    pugi::xml_document xml;
-    pugi::xml_parse_result parse_result = xml.load_string(opendrive.c_str());
+  /// Read-only stream buffer over a string, avoids copying it into a
+  /// std::istringstream.
+  class StringViewBuffer : public std::streambuf {
+  public:
 
-    if (parse_result == false) {
-      log_error("unable to parse the OpenDRIVE XML string");
-      return {};
+    explicit StringViewBuffer(const std::string &str) {
+      auto *data = const_cast<char *>(str.data());
+      setg(data, data, data + str.size());
     }
+  };
 
+  /// Run the parsers on a document holding a single top-level element.
+  static void ParseElement(
+      const std::string &name,
+      const pugi::xml_document &xml,
+      road::MapBuilder &map_builder) {
+    if (name == "header") {
+      parser::GeoReferenceParser::Parse(xml, map_builder);
+    } else if (name == "road") {
+      // Same order as parsing the whole document, the parsers of a road only
+      // depend on the road itself.
+      parser::RoadParser::Parse(xml, map_builder);
+      parser::GeometryParser::Parse(xml, map_builder);
+      parser::LaneParser::Parse(xml, map_builder);
+      parser::ProfilesParser::Parse(xml, map_builder);
+      parser::SignalParser::Parse(xml, map_builder);
+      parser::ObjectParser::Parse(xml, map_builder);
+    } else if (name == "junction") {
+      parser::JunctionParser::Parse(xml, map_builder);
+    } else if (name == "controller") {
+      parser::ControllerParser::Parse(xml, map_builder);
+    } else if (name == "userData") {
+      parser::TrafficGroupParser::Parse(xml, map_builder);
+    }
+  }
+
+  boost::optional<road::Map> OpenDriveParser::Load(const std::string &opendrive) {
+    StringViewBuffer buffer(opendrive);
+    std::istream stream(&buffer);
+    return Load(stream);
+  }
+
+  boost::optional<road::Map> OpenDriveParser::Load(std::istream &opendrive) {
     carla::road::MapBuilder map_builder;
 
-    parser::GeoReferenceParser::Parse(xml, map_builder);
-    parser::RoadParser::Parse(xml, map_builder);
-    parser::JunctionParser::Parse(xml, map_builder);
-    parser::GeometryParser::Parse(xml, map_builder);
-    parser::LaneParser::Parse(xml, map_builder);
-    parser::ProfilesParser::Parse(xml, map_builder);
-    parser::TrafficGroupParser::Parse(xml, map_builder);
-    parser::SignalParser::Parse(xml, map_builder);
-    parser::ObjectParser::Parse(xml, map_builder);
-    parser::ControllerParser::Parse(xml, map_builder);
+    parser::ElementStream elements(opendrive);
+    std::string element;
+    pugi::xml_document xml;
+    bool has_header = false;
+    while (elements.Next(element)) {
+      pugi::xml_parse_result parse_result = xml.load_buffer_inplace(
+          &element[0],
+          element.size(),
+          pugi::parse_default,
+          pugi::encoding_utf8);
+      if (parse_result == false) {
+        log_error("unable to parse the OpenDRIVE XML string");
+        return {};
+      }
+      const auto &name = elements.GetElementName();
+      has_header = has_header || name == "header";
+      ParseElement(name, xml, map_builder);
+    }
+    if (elements.HasError()) {
+      log_error("unable to parse the OpenDRIVE XML string");
+      return {};
+    }
+    if (!has_header) {
+      // Fall back to the default geo reference, as with an empty header.
+      parser::GeoReferenceParser::Parse(pugi::xml_document(), map_builder);
+    }
 
     return map_builder.Build();
   }
@@ -10,6 +10,7 @@
 
 #include <boost/optional.hpp>
 
+#include <istream>
 #include <string>
 
 namespace carla {
@@ -19,6 +20,11 @@ namespace opendrive {
   public:
 
     static boost::optional<road::Map> Load(const std::string &opendrive);
+
+    /// Parse the OpenDRIVE document read from @a opendrive. The document is
+    /// streamed one top-level element at a time, so neither the whole text
+    /// nor its DOM are ever held in memory.
+    static boost::optional<road::Map> Load(std::istream &opendrive);
   };
 
 } // namespace opendrive
@@ -0,0 +1,161 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/opendrive/parser/ElementStream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace carla {
+namespace opendrive {
+namespace parser {
+
+  static constexpr size_t npos = std::string::npos;
+
+  static bool StartsWith(const std::string &buffer, size_t position, const char *prefix) {
+    return buffer.compare(position, std::strlen(prefix), prefix) == 0;
+  }
+
+  bool ElementStream::Refill() {
+    if (!_input) {
+      return false;
+    }
+    const auto size = _buffer.size();
+    _buffer.resize(size + _chunk_size);
+    _input.read(&_buffer[size], static_cast<std::streamsize>(_chunk_size));
+    const auto read = static_cast<size_t>(_input.gcount());
+    _buffer.resize(size + read);
+    return read > 0u;
+  }
+
+  size_t ElementStream::Find(const char *pattern, size_t from) {
+    const auto length = std::strlen(pattern);
+    while (true) {
+      const auto position = _buffer.find(pattern, from);
+      if (position != npos) {
+        return position;
+      }
+      // The pattern may straddle the end of the buffer.
+      from = std::max(from, _buffer.size() >= length ? _buffer.size() - length + 1u : 0u);
+      if (!Refill()) {
+        return npos;
+      }
+    }
+  }
+
+  size_t ElementStream::FindTagEnd(size_t from) {
+    char quote = '\0';
+    for (auto i = from;; ++i) {
+      if (i >= _buffer.size() && !Refill()) {
+        return npos;
+      }
+      const char c = _buffer[i];
+      if (quote != '\0') {
+        quote = c == quote ? '\0' : quote;
+      } else if (c == '"' || c == '\'') {
+        quote = c;
+      } else if (c == '>') {
+        return i;
+      }
+    }
+  }
+
+  void ElementStream::Discard(size_t position) {
+    _buffer.erase(0u, position);
+    _cursor -= position;
+  }
+
+  bool ElementStream::Next(std::string &element) {
+    size_t element_start = npos;
+    while (true) {
+      // Positions are only stable within an iteration, drop the consumed text
+      // here once it is worth the copy.
+      const auto consumed = element_start != npos ? element_start : _cursor;
+      if (consumed >= _chunk_size) {
+        Discard(consumed);
+        if (element_start != npos) {
+          element_start = 0u;
+        }
+      }
+
+      const auto open = Find("<", _cursor);
+      if (open == npos) {
+        _error = _error || element_start != npos || _depth > 0u;
+        return false;
+      }
+      // Enough look-ahead to tell the markup apart.
+      while (_buffer.size() < open + 9u && Refill()) {}
+
+      enum class Markup { Skip, StartTag, EndTag } markup = Markup::Skip;
+      size_t end = npos;
+      size_t tail = 1u;
+      if (StartsWith(_buffer, open, "<!--")) {
+        end = Find("-->", open + 4u);
+        tail = 3u;
+      } else if (StartsWith(_buffer, open, "<![CDATA[")) {
+        end = Find("]]>", open + 9u);
+        tail = 3u;
+      } else if (StartsWith(_buffer, open, "<?")) {
+        end = Find("?>", open + 2u);
+        tail = 2u;
+      } else if (StartsWith(_buffer, open, "<!")) {
+        // Declaration, possibly with an internal subset between brackets.
+        end = FindTagEnd(open + 2u);
+        const auto bracket = _buffer.find('[', open);
+        if (end != npos && bracket < end) {
+          end = Find("]", bracket);
+          end = end != npos ? Find(">", end) : npos;
+        }
+      } else if (StartsWith(_buffer, open, "</")) {
+        end = Find(">", open + 2u);
+        markup = Markup::EndTag;
+      } else {
+        end = FindTagEnd(open + 1u);
+        markup = Markup::StartTag;
+      }
+      if (end == npos) {
+        // The input ended inside a markup construct.
+        _error = true;
+        return false;
+      }
+      _cursor = end + tail;
+
+      if (markup == Markup::EndTag) {
+        if (_depth > 0u) {
+          --_depth;
+        }
+        if (element_start != npos && _depth == 1u) {
+          break;
+        }
+      } else if (markup == Markup::StartTag) {
+        const bool self_closing = _buffer[end - 1u] == '/';
+        const auto name_end = _buffer.find_first_of(" \t\r\n/>", open + 1u);
+        std::string name = _buffer.substr(open + 1u, name_end - open - 1u);
+        if (_depth == 0u) {
+          _root = std::move(name);
+        } else if (_depth == 1u && element_start == npos) {
+          element_start = open;
+          _name = std::move(name);
+        }
+        if (!self_closing) {
+          ++_depth;
+        } else if (element_start == open) {
+          break;
+        }
+      }
+    }
+
+    element.clear();
+    element.reserve(_cursor - element_start + 2u * _root.size() + 5u);
+    element.append("<").append(_root).append(">");
+    element.append(_buffer, element_start, _cursor - element_start);
+    element.append("</").append(_root).append(">");
+    return true;
+  }
+
+} // namespace parser
+} // namespace opendrive
+} // namespace carla
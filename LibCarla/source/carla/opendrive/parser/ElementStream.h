@@ -0,0 +1,83 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/NonCopyable.h"
+
+#include <istream>
+#include <string>
+
+namespace carla {
+namespace opendrive {
+namespace parser {
+
+  /// Splits an XML document read from a stream into the top-level elements
+  /// under its root (header, road, junction, controller...), one at a time.
+  ///
+  /// Only the text of the element being extracted and one read chunk are
+  /// kept in memory, so each element can be parsed into a small DOM and
+  /// discarded before the next one is read.
+  class ElementStream : private NonCopyable {
+  public:
+
+    static constexpr size_t ChunkSize = 64u * 1024u;
+
+    explicit ElementStream(std::istream &input, size_t chunk_size = ChunkSize)
+      : _input(input),
+        _chunk_size(chunk_size) {}
+
+    /// Extract the next top-level element into @a element, wrapped in an
+    /// empty copy of the root element so it can be parsed as a standalone
+    /// document. Returns false at the end of the document, or on error.
+    bool Next(std::string &element);
+
+    /// Name of the element last returned by Next.
+    const std::string &GetElementName() const {
+      return _name;
+    }
+
+    /// Whether the input ended in the middle of a markup construct.
+    bool HasError() const {
+      return _error;
+    }
+
+  private:
+
+    /// Read one more chunk. Returns false at the end of the input.
+    bool Refill();
+
+    /// Position of @a pattern at or after @a from, reading more input as
+    /// needed. Returns npos if the input ends first.
+    size_t Find(const char *pattern, size_t from);
+
+    /// Position of the '>' closing the tag starting at @a from, skipping
+    /// quoted attribute values.
+    size_t FindTagEnd(size_t from);
+
+    /// Drop the text before @a position.
+    void Discard(size_t position);
+
+    std::istream &_input;
+
+    const size_t _chunk_size;
+
+    std::string _buffer;
+
+    size_t _cursor = 0u;
+
+    size_t _depth = 0u;
+
+    std::string _root;
+
+    std::string _name;
+
+    bool _error = false;
+  };
+
+} // namespace parser
+} // namespace opendrive
+} // namespace carla
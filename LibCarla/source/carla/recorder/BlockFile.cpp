@@ -0,0 +1,297 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/recorder/BlockFile.h"
+
+#include "carla/recorder/Lz4.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace carla {
+namespace recorder {
+
+  template <typename T>
+  static void WriteValue(std::ostream &out, const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  static bool ReadValue(std::istream &in, T &value) {
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return static_cast<bool>(in);
+  }
+
+  // ===========================================================================
+  // -- BlockFileWriter --------------------------------------------------------
+  // ===========================================================================
+
+  BlockFileWriter::BlockFileWriter(std::ostream &out, uint32_t block_size)
+    : _out(out),
+      _block_size(std::max(block_size, 1024u)) {
+    const uint64_t magic = BlockFile::Magic;
+    const uint32_t version = BlockFile::Version;
+    WriteValue(_out, magic);
+    WriteValue(_out, version);
+    WriteValue(_out, _block_size);
+    _file_offset = sizeof(magic) + sizeof(version) + sizeof(_block_size);
+    _raw.reserve(_block_size);
+    _compressed.resize(lz4::CompressBound(_block_size));
+  }
+
+  void BlockFileWriter::Write(const char *data, size_t size) {
+    while (size > 0u) {
+      const size_t count = std::min(size, _block_size - _raw.size());
+      _raw.insert(_raw.end(), data, data + count);
+      data += count;
+      size -= count;
+      if (_raw.size() == _block_size) {
+        WriteBlock();
+      }
+    }
+  }
+
+  void BlockFileWriter::Finish() {
+    WriteBlock();
+    const uint64_t index_offset = _file_offset;
+    const uint32_t count = static_cast<uint32_t>(_index.size());
+    const uint64_t magic = BlockFile::Magic;
+    WriteValue(_out, count);
+    _out.write(
+        reinterpret_cast<const char *>(_index.data()),
+        static_cast<std::streamsize>(_index.size() * sizeof(BlockIndexEntry)));
+    WriteValue(_out, index_offset);
+    WriteValue(_out, magic);
+    _out.flush();
+  }
+
+  void BlockFileWriter::WriteBlock() {
+    if (_raw.empty()) {
+      return;
+    }
+    const size_t compressed_size = lz4::Compress(
+        reinterpret_cast<const uint8_t *>(_raw.data()),
+        _raw.size(),
+        _compressed.data(),
+        _compressed.size());
+    BlockIndexEntry entry;
+    entry.raw_offset = _raw_offset;
+    entry.file_offset = _file_offset;
+    entry.raw_size = static_cast<uint32_t>(_raw.size());
+    // blocks that do not compress are stored as they are.
+    if ((compressed_size > 0u) && (compressed_size < _raw.size())) {
+      entry.compressed_size = static_cast<uint32_t>(compressed_size);
+      _out.write(reinterpret_cast<const char *>(_compressed.data()), static_cast<std::streamsize>(compressed_size));
+    } else {
+      entry.compressed_size = entry.raw_size;
+      _out.write(_raw.data(), static_cast<std::streamsize>(_raw.size()));
+    }
+    _index.emplace_back(entry);
+    _raw_offset += entry.raw_size;
+    _file_offset += entry.compressed_size;
+    _raw.clear();
+  }
+
+  // ===========================================================================
+  // -- BlockFileReader --------------------------------------------------------
+  // ===========================================================================
+
+  bool BlockFileReader::Open(const std::string &path) {
+    Close();
+    _file.open(path, std::ios::binary);
+    if (!_file.is_open()) {
+      return false;
+    }
+    uint64_t magic = 0u;
+    uint32_t version = 0u;
+    uint32_t block_size = 0u;
+    if (!ReadValue(_file, magic) ||
+        !ReadValue(_file, version) ||
+        !ReadValue(_file, block_size) ||
+        (magic != BlockFile::Magic) ||
+        (version != BlockFile::Version)) {
+      Close();
+      return false;
+    }
+
+    // the index, from the end of the file.
+    uint64_t index_offset = 0u;
+    _file.seekg(0, std::ios::end);
+    _file_size = static_cast<uint64_t>(_file.tellg());
+    if (_file_size < sizeof(index_offset) + sizeof(magic)) {
+      Close();
+      return false;
+    }
+    _file.seekg(static_cast<std::streamoff>(_file_size - sizeof(index_offset) - sizeof(magic)), std::ios::beg);
+    uint32_t count = 0u;
+    if (!ReadValue(_file, index_offset) ||
+        !ReadValue(_file, magic) ||
+        (magic != BlockFile::Magic) ||
+        (index_offset >= _file_size)) {
+      Close();
+      return false;
+    }
+    _file.seekg(static_cast<std::streamoff>(index_offset), std::ios::beg);
+    if (!ReadValue(_file, count) ||
+        (index_offset + sizeof(count) + uint64_t(count) * sizeof(BlockIndexEntry) +
+            sizeof(index_offset) + sizeof(magic) != _file_size)) {
+      Close();
+      return false;
+    }
+    _index.resize(count);
+    _file.read(
+        reinterpret_cast<char *>(_index.data()),
+        static_cast<std::streamsize>(_index.size() * sizeof(BlockIndexEntry)));
+    if (!_file) {
+      Close();
+      return false;
+    }
+    uint64_t raw_offset = 0u;
+    for (auto &entry : _index) {
+      if ((entry.raw_offset != raw_offset) ||
+          (entry.file_offset + entry.compressed_size > index_offset) ||
+          (entry.compressed_size > entry.raw_size)) {
+        Close();
+        return false;
+      }
+      raw_offset += entry.raw_size;
+    }
+    _raw_size = raw_offset;
+    _current = _index.size();
+    setg(nullptr, nullptr, nullptr);
+    return true;
+  }
+
+  void BlockFileReader::Close() {
+    _file.close();
+    _file.clear();
+    _index.clear();
+    _current = 0u;
+    _raw_size = 0u;
+    _file_size = 0u;
+    setg(nullptr, nullptr, nullptr);
+  }
+
+  bool BlockFileReader::LoadBlock(size_t i) {
+    if (i == _current) {
+      return true;
+    }
+    if (i >= _index.size()) {
+      return false;
+    }
+    const auto &entry = _index[i];
+    // the get area points to the block being replaced.
+    _current = _index.size();
+    setg(nullptr, nullptr, nullptr);
+    _block.resize(entry.raw_size);
+    _file.clear();
+    _file.seekg(static_cast<std::streamoff>(entry.file_offset), std::ios::beg);
+    if (entry.compressed_size == entry.raw_size) {
+      _file.read(_block.data(), static_cast<std::streamsize>(entry.raw_size));
+      if (!_file) {
+        return false;
+      }
+    } else {
+      _compressed.resize(entry.compressed_size);
+      _file.read(_compressed.data(), static_cast<std::streamsize>(entry.compressed_size));
+      if (!_file || !lz4::Decompress(
+            reinterpret_cast<const uint8_t *>(_compressed.data()),
+            _compressed.size(),
+            reinterpret_cast<uint8_t *>(_block.data()),
+            _block.size())) {
+        return false;
+      }
+    }
+    _current = i;
+    setg(_block.data(), _block.data(), _block.data() + _block.size());
+    return true;
+  }
+
+  BlockFileReader::int_type BlockFileReader::underflow() {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+    const size_t next = (_current < _index.size()) ? _current + 1u : 0u;
+    if (!LoadBlock(next)) {
+      return traits_type::eof();
+    }
+    return traits_type::to_int_type(*gptr());
+  }
+
+  BlockFileReader::pos_type BlockFileReader::seekoff(
+      off_type offset,
+      std::ios_base::seekdir direction,
+      std::ios_base::openmode which) {
+    const pos_type invalid(off_type(-1));
+    if (((which & std::ios_base::in) == 0) || !IsOpen()) {
+      return invalid;
+    }
+    off_type base = 0;
+    switch (direction) {
+      case std::ios_base::beg:
+        base = 0;
+        break;
+      case std::ios_base::cur:
+        base = (_current < _index.size()) ?
+            static_cast<off_type>(_index[_current].raw_offset) + (gptr() - eback()) :
+            0;
+        break;
+      case std::ios_base::end:
+        base = static_cast<off_type>(_raw_size);
+        break;
+      default:
+        return invalid;
+    }
+    const off_type target = base + offset;
+    if ((target < 0) || (target > static_cast<off_type>(_raw_size))) {
+      return invalid;
+    }
+    if (target == static_cast<off_type>(_raw_size)) {
+      // the end: leave the get area empty after the last block.
+      if (!_index.empty() && !LoadBlock(_index.size() - 1u)) {
+        return invalid;
+      }
+      setg(eback(), egptr(), egptr());
+      return pos_type(target);
+    }
+    // last block starting at or before the target.
+    auto it = std::upper_bound(
+        _index.begin(),
+        _index.end(),
+        static_cast<uint64_t>(target),
+        [](uint64_t value, const BlockIndexEntry &entry) { return value < entry.raw_offset; });
+    const size_t i = static_cast<size_t>(it - _index.begin()) - 1u;
+    if (!LoadBlock(i)) {
+      return invalid;
+    }
+    setg(eback(), eback() + (static_cast<uint64_t>(target) - _index[i].raw_offset), egptr());
+    return pos_type(target);
+  }
+
+  BlockFileReader::pos_type BlockFileReader::seekpos(
+      pos_type position,
+      std::ios_base::openmode which) {
+    return seekoff(off_type(position), std::ios_base::beg, which);
+  }
+
+  // ===========================================================================
+  // -- OpenRecorderContent ----------------------------------------------------
+  // ===========================================================================
+
+  std::unique_ptr<std::streambuf> OpenRecorderContent(const std::string &path) {
+    auto blocks = std::make_unique<BlockFileReader>();
+    if (blocks->Open(path)) {
+      return std::unique_ptr<std::streambuf>(std::move(blocks));
+    }
+    auto file = std::make_unique<std::filebuf>();
+    if (file->open(path, std::ios::in | std::ios::binary) == nullptr) {
+      return nullptr;
+    }
+    return std::unique_ptr<std::streambuf>(std::move(file));
+  }
+
+} // namespace recorder
+} // namespace carla
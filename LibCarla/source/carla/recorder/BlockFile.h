@@ -0,0 +1,152 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/NonCopyable.h"
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace carla {
+namespace recorder {
+
+#pragma pack(push, 1)
+  /// Position of a block in a block compressed file.
+  struct BlockIndexEntry {
+    /// Offset of the block's first byte in the uncompressed content.
+    uint64_t raw_offset;
+    /// Offset of the block in the file.
+    uint64_t file_offset;
+    /// Size of the block in the file; equal to raw_size if stored as is.
+    uint32_t compressed_size;
+    uint32_t raw_size;
+  };
+#pragma pack(pop)
+
+  /// Container for recorder files where the content is split in blocks
+  /// compressed independently with LZ4, followed by an index of the blocks:
+  ///
+  ///   magic, version, block size
+  ///   blocks
+  ///   number of blocks, index entries
+  ///   offset of the index, magic
+  ///
+  /// The content is a regular recorder file, so readers work on the
+  /// uncompressed stream and only the blocks they touch are decompressed.
+  struct BlockFile {
+    /// "CRBLKLZ4" read as a little-endian integer.
+    static constexpr uint64_t Magic = 0x345A4C4B4C425243ull;
+
+    static constexpr uint32_t Version = 1u;
+
+    static constexpr uint32_t DefaultBlockSize = 64u * 1024u;
+  };
+
+  /// Writes a block compressed file to a stream.
+  class BlockFileWriter : private NonCopyable {
+  public:
+
+    /// Write the header to @a out.
+    explicit BlockFileWriter(std::ostream &out, uint32_t block_size = BlockFile::DefaultBlockSize);
+
+    /// Append @a size bytes of content.
+    void Write(const char *data, size_t size);
+
+    /// Write the last block and the index.
+    void Finish();
+
+    uint64_t GetRawSize() const {
+      return _raw_offset + _raw.size();
+    }
+
+  private:
+
+    void WriteBlock();
+
+    std::ostream &_out;
+
+    const uint32_t _block_size;
+
+    std::vector<char> _raw;
+
+    std::vector<uint8_t> _compressed;
+
+    std::vector<BlockIndexEntry> _index;
+
+    uint64_t _raw_offset = 0u;
+
+    uint64_t _file_offset = 0u;
+  };
+
+  /// Stream buffer reading the uncompressed content of a block compressed
+  /// file. Keeps one block decompressed, seeking within it is free and
+  /// seeking anywhere else decompresses a single block.
+  class BlockFileReader : public std::streambuf, private NonCopyable {
+  public:
+
+    /// Open @a path, return false if it is not a block compressed file.
+    bool Open(const std::string &path);
+
+    void Close();
+
+    bool IsOpen() const {
+      return _file.is_open();
+    }
+
+    /// Size of the uncompressed content.
+    uint64_t GetRawSize() const {
+      return _raw_size;
+    }
+
+    /// Size of the file.
+    uint64_t GetFileSize() const {
+      return _file_size;
+    }
+
+  protected:
+
+    int_type underflow() override;
+
+    pos_type seekoff(
+        off_type offset,
+        std::ios_base::seekdir direction,
+        std::ios_base::openmode which) override;
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+  private:
+
+    bool LoadBlock(size_t i);
+
+    std::ifstream _file;
+
+    std::vector<BlockIndexEntry> _index;
+
+    /// Block currently in the get area, _index.size() if none.
+    size_t _current = 0u;
+
+    std::vector<char> _block;
+
+    std::vector<char> _compressed;
+
+    uint64_t _raw_size = 0u;
+
+    uint64_t _file_size = 0u;
+  };
+
+  /// Open the uncompressed content of the recorder file at @a path, through
+  /// a BlockFileReader if it is block compressed. Returns nullptr if it
+  /// cannot be opened.
+  std::unique_ptr<std::streambuf> OpenRecorderContent(const std::string &path);
+
+} // namespace recorder
+} // namespace carla
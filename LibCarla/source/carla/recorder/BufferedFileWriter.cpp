@@ -0,0 +1,217 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/recorder/BufferedFileWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace carla {
+namespace recorder {
+
+  /// Size of the chunks written to disk; small flushes are gathered until
+  /// they fill one.
+  static constexpr size_t FileBufferSize = 4u * 1024u * 1024u;
+
+  BufferedFileWriter::BufferedFileWriter(size_t max_queued_flushes)
+    : _pool(std::make_shared<BufferPool>()),
+      _max_queued_flushes(std::max<size_t>(1u, max_queued_flushes)) {}
+
+  BufferedFileWriter::~BufferedFileWriter() {
+    Close();
+  }
+
+  bool BufferedFileWriter::Open(const std::string &path, bool compressed) {
+    Close();
+    _file_buffer.resize(FileBufferSize);
+    _file.rdbuf()->pubsetbuf(_file_buffer.data(), static_cast<std::streamsize>(_file_buffer.size()));
+    _file.open(path, std::ios::binary | std::ios::trunc);
+    if (!_file.is_open()) {
+      return false;
+    }
+    if (compressed) {
+      _blocks = std::make_unique<BlockFileWriter>(_file);
+    }
+    _put = 0u;
+    _end = 0u;
+    _flushed = 0u;
+    _done = false;
+    _failed = false;
+    _bytes_written = 0u;
+    _max_queue_size = 0u;
+    _blocked_us = 0u;
+    _is_open = true;
+    _thread = std::thread([this]() { Run(); });
+    return true;
+  }
+
+  void BufferedFileWriter::Flush(uint64_t position) {
+    if (!_is_open || (position <= _flushed)) {
+      return;
+    }
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(position - _flushed, _end));
+    const size_t kept = _end - count;
+    Buffer next = _pool->Pop();
+    std::swap(next, _pending);
+    _pending.reset(_pending.capacity());
+    _end = 0u;
+    if (kept > 0u) {
+      Reserve(kept);
+      std::memcpy(_pending.data(), next.data() + count, kept);
+    }
+    next.reset(static_cast<Buffer::size_type>(count));
+    _flushed += count;
+    _put = (_put > count) ? (_put - count) : 0u;
+    _end = kept;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_queue.size() >= _max_queued_flushes) {
+      const auto start = std::chrono::steady_clock::now();
+      _queue_not_full.wait(lock, [this]() { return _queue.size() < _max_queued_flushes; });
+      _blocked_us += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start).count());
+    }
+    _queue.emplace_back(std::move(next));
+    _max_queue_size = std::max(_max_queue_size, _queue.size());
+    lock.unlock();
+    _queue_not_empty.notify_one();
+  }
+
+  bool BufferedFileWriter::Close() {
+    if (!_is_open) {
+      return true;
+    }
+    Flush();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _done = true;
+    }
+    _queue_not_empty.notify_one();
+    _thread.join();
+    _blocks.reset();
+    _file.close();
+    _is_open = false;
+    return !_failed;
+  }
+
+  std::streamsize BufferedFileWriter::xsputn(const char_type *data, std::streamsize count) {
+    if (count <= 0) {
+      return 0;
+    }
+    const auto size = static_cast<size_t>(count);
+    Reserve(_put + size);
+    std::memcpy(_pending.data() + _put, data, size);
+    _put += size;
+    _end = std::max(_end, _put);
+    return count;
+  }
+
+  BufferedFileWriter::int_type BufferedFileWriter::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+      return traits_type::not_eof(ch);
+    }
+    const char_type value = traits_type::to_char_type(ch);
+    xsputn(&value, 1);
+    return ch;
+  }
+
+  BufferedFileWriter::pos_type BufferedFileWriter::seekoff(
+      off_type offset,
+      std::ios_base::seekdir direction,
+      std::ios_base::openmode which) {
+    const pos_type invalid(off_type(-1));
+    if ((which & std::ios_base::out) == 0) {
+      return invalid;
+    }
+    off_type base = 0;
+    switch (direction) {
+      case std::ios_base::beg:
+        base = 0;
+        break;
+      case std::ios_base::cur:
+        base = static_cast<off_type>(_flushed + _put);
+        break;
+      case std::ios_base::end:
+        base = static_cast<off_type>(_flushed + _end);
+        break;
+      default:
+        return invalid;
+    }
+    const off_type target = base + offset;
+    // only what has not been flushed yet can be rewritten.
+    if ((target < static_cast<off_type>(_flushed)) ||
+        (target > static_cast<off_type>(_flushed + _end))) {
+      return invalid;
+    }
+    _put = static_cast<size_t>(static_cast<uint64_t>(target) - _flushed);
+    return pos_type(target);
+  }
+
+  BufferedFileWriter::pos_type BufferedFileWriter::seekpos(
+      pos_type position,
+      std::ios_base::openmode which) {
+    return seekoff(off_type(position), std::ios_base::beg, which);
+  }
+
+  int BufferedFileWriter::sync() {
+    Flush();
+    return _failed ? -1 : 0;
+  }
+
+  void BufferedFileWriter::Reserve(size_t size) {
+    if (_pending.size() >= size) {
+      return;
+    }
+    Buffer grown = _pool->Pop();
+    const size_t capacity = std::max({size, 2u * size_t(_pending.size()), size_t(grown.capacity())});
+    grown.reset(static_cast<Buffer::size_type>(capacity));
+    if (_end > 0u) {
+      std::memcpy(grown.data(), _pending.data(), _end);
+    }
+    // the old one goes back to the pool.
+    std::swap(grown, _pending);
+  }
+
+  void BufferedFileWriter::Run() {
+    std::deque<Buffer> batch;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _queue_not_empty.wait(lock, [this]() { return _done || !_queue.empty(); });
+        if (_queue.empty()) {
+          break;
+        }
+        std::swap(batch, _queue);
+      }
+      _queue_not_full.notify_one();
+      for (auto &buffer : batch) {
+        if (_blocks != nullptr) {
+          _blocks->Write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+        } else {
+          _file.write(
+              reinterpret_cast<const char *>(buffer.data()),
+              static_cast<std::streamsize>(buffer.size()));
+        }
+        _bytes_written += buffer.size();
+      }
+      if (!_file) {
+        _failed = true;
+      }
+      // buffers return to the pool.
+      batch.clear();
+    }
+    if (_blocks != nullptr) {
+      _blocks->Finish();
+    }
+    _file.flush();
+    if (!_file) {
+      _failed = true;
+    }
+  }
+
+} // namespace recorder
+} // namespace carla
@@ -0,0 +1,168 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/Buffer.h"
+#include "carla/BufferPool.h"
+#include "carla/NonCopyable.h"
+#include "carla/recorder/BlockFile.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace carla {
+namespace recorder {
+
+  /// Stream buffer that keeps in memory what is written to it and hands it,
+  /// on each Flush, to a background thread that appends it to a file.
+  ///
+  /// The caller's writes never touch the disk, they only block if the disk
+  /// falls behind by more than the given number of flushes. Positions are
+  /// absolute in the file and seeking is allowed back to the last flush, so
+  /// the usual "write a dummy value and patch it later" works as with a file
+  /// as long as the patched bytes have not been flushed yet.
+  class BufferedFileWriter : public std::streambuf, private NonCopyable {
+  public:
+
+    explicit BufferedFileWriter(size_t max_queued_flushes = 256u);
+
+    ~BufferedFileWriter();
+
+    /// Create the file at @a path and start the writer thread. If
+    /// @a compressed, the file is written as a BlockFile; compression runs
+    /// in the writer thread too.
+    bool Open(const std::string &path, bool compressed = false);
+
+    bool IsOpen() const {
+      return _is_open;
+    }
+
+    /// Queue everything written since the last flush to be written to disk.
+    void Flush() {
+      Flush(_flushed + _end);
+    }
+
+    /// Queue what was written before the file position @a position; the rest
+    /// stays in memory and can still be rewritten.
+    void Flush(uint64_t position);
+
+    /// Flush, wait until everything is on disk and close the file. Returns
+    /// false if any write failed.
+    bool Close();
+
+    /// @name Statistics of the current file
+    /// @{
+
+    /// Bytes of content written, before compression.
+    uint64_t GetBytesWritten() const {
+      return _bytes_written;
+    }
+
+    /// Largest number of flushes waiting to be written at the same time.
+    size_t GetMaxQueueSize() const {
+      return _max_queue_size;
+    }
+
+    /// Time Flush spent waiting for room in the queue, in microseconds.
+    uint64_t GetBlockedMicroseconds() const {
+      return _blocked_us;
+    }
+
+    /// @}
+
+  protected:
+
+    std::streamsize xsputn(const char_type *data, std::streamsize count) override;
+
+    int_type overflow(int_type ch) override;
+
+    pos_type seekoff(
+        off_type offset,
+        std::ios_base::seekdir direction,
+        std::ios_base::openmode which) override;
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+    int sync() override;
+
+  private:
+
+    void Reserve(size_t size);
+
+    void Run();
+
+    /// @name Used by the caller's thread
+    /// @{
+
+    std::shared_ptr<BufferPool> _pool;
+
+    /// Bytes written since the last flush, its size is the capacity.
+    Buffer _pending;
+
+    /// Position of the next write in _pending.
+    size_t _put = 0u;
+
+    /// Bytes in use of _pending.
+    size_t _end = 0u;
+
+    /// Bytes handed to the writer thread so far.
+    uint64_t _flushed = 0u;
+
+    bool _is_open = false;
+
+    /// @}
+
+    /// @name Shared with the writer thread
+    /// @{
+
+    const size_t _max_queued_flushes;
+
+    std::mutex _mutex;
+
+    std::condition_variable _queue_not_empty;
+
+    std::condition_variable _queue_not_full;
+
+    std::deque<Buffer> _queue;
+
+    bool _done = false;
+
+    std::atomic_bool _failed{false};
+
+    std::atomic<uint64_t> _bytes_written{0u};
+
+    size_t _max_queue_size = 0u;
+
+    uint64_t _blocked_us = 0u;
+
+    /// @}
+
+    /// @name Used by the writer thread
+    /// @{
+
+    std::ofstream _file;
+
+    std::vector<char> _file_buffer;
+
+    std::unique_ptr<BlockFileWriter> _blocks;
+
+    /// @}
+
+    std::thread _thread;
+  };
+
+} // namespace recorder
+} // namespace carla
@@ -0,0 +1,186 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace carla {
+namespace recorder {
+
+#pragma pack(push, 1)
+  /// Position and time of a frame in a recorder file.
+  struct FrameIndexEntry {
+    /// Time of the frame since the start of the recording, in seconds.
+    double elapsed;
+    /// Offset of the frame start packet from the beginning of the file.
+    uint64_t offset;
+    /// Whether the frame holds a key frame packet with the whole state.
+    uint8_t keyframe;
+  };
+#pragma pack(pop)
+
+  /// Index of the frames of a recorder file, written as the last packet of
+  /// the file. The packet ends with its own offset and a magic number so it
+  /// can be found reading backwards from the end of the file; readers not
+  /// aware of it skip it as any unknown packet.
+  class FrameIndex {
+  public:
+
+    /// Id of the recorder packet holding the index.
+    static constexpr char PacketId = 20;
+
+    /// "CRFIDX01" read as a little-endian integer.
+    static constexpr uint64_t FooterMagic = 0x3130584449465243ull;
+
+    void Add(double elapsed, uint64_t offset, bool keyframe) {
+      if (keyframe) {
+        _keyframes.emplace_back(_entries.size());
+      }
+      _entries.emplace_back(FrameIndexEntry{elapsed, offset, static_cast<uint8_t>(keyframe)});
+    }
+
+    void clear() {
+      _entries.clear();
+      _keyframes.clear();
+    }
+
+    bool empty() const {
+      return _entries.empty();
+    }
+
+    size_t size() const {
+      return _entries.size();
+    }
+
+    const FrameIndexEntry &operator[](size_t i) const {
+      return _entries[i];
+    }
+
+    const FrameIndexEntry &back() const {
+      return _entries.back();
+    }
+
+    size_t GetNumberOfKeyFrames() const {
+      return _keyframes.size();
+    }
+
+    /// Position of the last frame starting at or before @a time, size() if
+    /// none does.
+    size_t FindFrame(double time) const {
+      auto it = std::upper_bound(
+          _entries.begin(),
+          _entries.end(),
+          time,
+          [](double value, const FrameIndexEntry &entry) { return value < entry.elapsed; });
+      return it == _entries.begin() ? size() : static_cast<size_t>(it - _entries.begin()) - 1u;
+    }
+
+    /// Position of the last key frame starting at or before @a time, size()
+    /// if none does.
+    size_t FindKeyFrame(double time) const {
+      auto it = std::upper_bound(
+          _keyframes.begin(),
+          _keyframes.end(),
+          time,
+          [this](double value, size_t i) { return value < _entries[i].elapsed; });
+      return it == _keyframes.begin() ? size() : *(it - 1);
+    }
+
+    /// Append the index packet at the current position of @a out.
+    void Write(std::ostream &out) const {
+      const uint64_t start = static_cast<uint64_t>(out.tellp());
+      const uint32_t count = static_cast<uint32_t>(_entries.size());
+      const uint32_t packet_size = static_cast<uint32_t>(
+          sizeof(count) + count * sizeof(FrameIndexEntry) + sizeof(start) + sizeof(FooterMagic));
+      const char id = PacketId;
+      const uint64_t magic = FooterMagic;
+      WriteValue(out, id);
+      WriteValue(out, packet_size);
+      WriteValue(out, count);
+      out.write(
+          reinterpret_cast<const char *>(_entries.data()),
+          static_cast<std::streamsize>(count * sizeof(FrameIndexEntry)));
+      WriteValue(out, start);
+      WriteValue(out, magic);
+    }
+
+    /// Load the index at the end of @a in, return false if the file has
+    /// none. Changes the position of @a in.
+    bool Read(std::istream &in) {
+      clear();
+      in.clear();
+      in.seekg(0, std::ios::end);
+      const auto file_size = static_cast<uint64_t>(in.tellg());
+      uint64_t start = 0u;
+      uint64_t magic = 0u;
+      if (file_size < sizeof(start) + sizeof(magic)) {
+        return false;
+      }
+      in.seekg(static_cast<std::streamoff>(file_size - sizeof(start) - sizeof(magic)), std::ios::beg);
+      ReadValue(in, start);
+      ReadValue(in, magic);
+      if (!in || (magic != FooterMagic) || (start >= file_size)) {
+        in.clear();
+        return false;
+      }
+      char id = 0;
+      uint32_t packet_size = 0u;
+      uint32_t count = 0u;
+      in.seekg(static_cast<std::streamoff>(start), std::ios::beg);
+      ReadValue(in, id);
+      ReadValue(in, packet_size);
+      ReadValue(in, count);
+      const uint64_t expected_size =
+          sizeof(count) + uint64_t(count) * sizeof(FrameIndexEntry) + sizeof(start) + sizeof(magic);
+      if (!in ||
+          (id != PacketId) ||
+          (packet_size != expected_size) ||
+          (start + sizeof(id) + sizeof(packet_size) + packet_size != file_size)) {
+        in.clear();
+        return false;
+      }
+      _entries.resize(count);
+      in.read(
+          reinterpret_cast<char *>(_entries.data()),
+          static_cast<std::streamsize>(count * sizeof(FrameIndexEntry)));
+      if (!in) {
+        in.clear();
+        clear();
+        return false;
+      }
+      for (auto i = 0u; i < _entries.size(); ++i) {
+        if (_entries[i].keyframe != 0u) {
+          _keyframes.emplace_back(i);
+        }
+      }
+      return true;
+    }
+
+  private:
+
+    template <typename T>
+    static void WriteValue(std::ostream &out, const T &value) {
+      out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static void ReadValue(std::istream &in, T &value) {
+      in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    }
+
+    std::vector<FrameIndexEntry> _entries;
+
+    /// Positions in _entries of the key frames.
+    std::vector<size_t> _keyframes;
+  };
+
+} // namespace recorder
+} // namespace carla
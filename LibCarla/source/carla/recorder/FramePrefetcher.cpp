@@ -0,0 +1,333 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/recorder/FramePrefetcher.h"
+
+#include "carla/recorder/BlockFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace carla {
+namespace recorder {
+
+  /// Packet header: char id and uint32 size.
+  static constexpr size_t PacketHeaderSize = 5u;
+
+  /// Id of the packet starting each frame, as in CarlaRecorderPacketId.
+  static constexpr char FrameStartPacketId = 0;
+
+  /// Frames are cut at this size too, so that content that is not split in
+  /// frames (the info header, a position that is not at a packet) is still
+  /// prefetched in pieces.
+  static constexpr size_t MaxFrameSize = 1024u * 1024u;
+
+  /// Seeking forward up to this distance past the current frame consumes the
+  /// prefetched frames instead of restarting.
+  static constexpr uint64_t MaxSkipAhead = 1024u * 1024u;
+
+  /// Times the reader yields before sleeping while waiting for a frame.
+  static constexpr int WaitSpins = 256;
+
+  FramePrefetcher::FramePrefetcher(size_t frames_ahead)
+    : _ring(std::max<size_t>(1u, frames_ahead) + 1u) {}
+
+  FramePrefetcher::~FramePrefetcher() {
+    Close();
+  }
+
+  bool FramePrefetcher::Open(const std::string &path) {
+    return Open(OpenRecorderContent(path));
+  }
+
+  bool FramePrefetcher::Open(std::unique_ptr<std::streambuf> content) {
+    Close();
+    if (content == nullptr) {
+      return false;
+    }
+    const auto end = content->pubseekoff(0, std::ios_base::end, std::ios_base::in);
+    if (end == pos_type(off_type(-1))) {
+      return false;
+    }
+    _size = static_cast<uint64_t>(off_type(end));
+    _content = std::move(content);
+    _frame.clear();
+    _frame_offset = 0u;
+    _generation = 0u;
+    _at_end = false;
+    _frames_read = 0u;
+    _wait_us = 0u;
+    _restarts = 0u;
+    _head = 0u;
+    _tail = 0u;
+    _requested_generation = 0u;
+    _done = false;
+    _is_open = true;
+    _thread = std::thread([this]() { Run(); });
+    Restart(0u);
+    // the first request is not a restart.
+    _restarts = 0u;
+    return true;
+  }
+
+  void FramePrefetcher::Close() {
+    if (!_is_open) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _done = true;
+    }
+    _request_changed.notify_one();
+    _thread.join();
+    _content.reset();
+    for (auto &slot : _ring) {
+      slot.data.clear();
+    }
+    _frame.clear();
+    setg(nullptr, nullptr, nullptr);
+    _is_open = false;
+  }
+
+  FramePrefetcher::int_type FramePrefetcher::underflow() {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+    while (NextFrame()) {
+      if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+      }
+    }
+    return traits_type::eof();
+  }
+
+  FramePrefetcher::pos_type FramePrefetcher::seekoff(
+      off_type offset,
+      std::ios_base::seekdir direction,
+      std::ios_base::openmode which) {
+    const pos_type invalid(off_type(-1));
+    if (!_is_open || ((which & std::ios_base::in) == 0)) {
+      return invalid;
+    }
+    off_type base = 0;
+    switch (direction) {
+      case std::ios_base::beg:
+        base = 0;
+        break;
+      case std::ios_base::cur:
+        base = static_cast<off_type>(Tell());
+        if (offset == 0) {
+          // tellg.
+          return pos_type(base);
+        }
+        break;
+      case std::ios_base::end:
+        base = static_cast<off_type>(_size);
+        break;
+      default:
+        return invalid;
+    }
+    const off_type target = base + offset;
+    if ((target < 0) || (target > static_cast<off_type>(_size))) {
+      return invalid;
+    }
+    const auto position = static_cast<uint64_t>(target);
+    const uint64_t frame_end = _frame_offset + _frame.size();
+    if ((position >= _frame_offset) && (position <= frame_end + MaxSkipAhead)) {
+      while (position > _frame_offset + _frame.size()) {
+        if (!NextFrame()) {
+          break;
+        }
+      }
+      if ((position >= _frame_offset) && (position <= _frame_offset + _frame.size())) {
+        const auto begin = _frame.data();
+        setg(
+            begin,
+            begin + static_cast<std::ptrdiff_t>(position - _frame_offset),
+            begin + static_cast<std::ptrdiff_t>(_frame.size()));
+        return pos_type(target);
+      }
+    }
+    Restart(position);
+    return pos_type(target);
+  }
+
+  FramePrefetcher::pos_type FramePrefetcher::seekpos(
+      pos_type position,
+      std::ios_base::openmode which) {
+    return seekoff(off_type(position), std::ios_base::beg, which);
+  }
+
+  bool FramePrefetcher::NextFrame() {
+    if (_at_end) {
+      return false;
+    }
+    int spins = 0;
+    std::chrono::steady_clock::time_point start;
+    for (;;) {
+      const size_t tail = _tail.load(std::memory_order_relaxed);
+      while (tail == _head.load(std::memory_order_acquire)) {
+        if (spins == 0) {
+          start = std::chrono::steady_clock::now();
+        }
+        if (++spins < WaitSpins) {
+          std::this_thread::yield();
+        } else {
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+      }
+      Slot &slot = _ring[tail];
+      const bool current = (slot.generation == _generation);
+      if (current) {
+        if (slot.end) {
+          _at_end = true;
+        } else {
+          // the previous frame goes back to the ring to be reused.
+          _frame.swap(slot.data);
+          _frame_offset = slot.offset;
+          ++_frames_read;
+        }
+      }
+      _tail.store((tail + 1u) % _ring.size(), std::memory_order_release);
+      if (current) {
+        break;
+      }
+    }
+    if (spins > 0) {
+      _wait_us += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start).count());
+    }
+    if (_at_end) {
+      // leave the last frame in the get area, it can still be seeked into.
+      return false;
+    }
+    const auto begin = _frame.data();
+    setg(begin, begin, begin + static_cast<std::ptrdiff_t>(_frame.size()));
+    return true;
+  }
+
+  void FramePrefetcher::Restart(uint64_t offset) {
+    ++_generation;
+    ++_restarts;
+    _frame.clear();
+    _frame_offset = offset;
+    _at_end = false;
+    setg(nullptr, nullptr, nullptr);
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _requested_offset = offset;
+      _requested_generation = _generation;
+    }
+    _request_changed.notify_one();
+  }
+
+  bool FramePrefetcher::IsInterrupted(uint64_t generation) const {
+    return _done || (_requested_generation != generation);
+  }
+
+  bool FramePrefetcher::Push(
+      uint64_t generation,
+      uint64_t offset,
+      std::vector<char> &data,
+      bool end) {
+    const size_t head = _head.load(std::memory_order_relaxed);
+    const size_t next = (head + 1u) % _ring.size();
+    while (next == _tail.load(std::memory_order_acquire)) {
+      if (IsInterrupted(generation)) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    Slot &slot = _ring[head];
+    slot.generation = generation;
+    slot.offset = offset;
+    slot.end = end;
+    // take the frame the reader left in the slot in exchange.
+    slot.data.swap(data);
+    data.clear();
+    _head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  void FramePrefetcher::Run() {
+    uint64_t generation = 0u;
+    std::vector<char> data;
+    for (;;) {
+      uint64_t position = 0u;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _request_changed.wait(lock, [&]() {
+          return _done || (_requested_generation != generation);
+        });
+        if (_done) {
+          break;
+        }
+        generation = _requested_generation;
+        position = _requested_offset;
+      }
+      const auto target = pos_type(static_cast<off_type>(position));
+      bool end = (_content->pubseekpos(target, std::ios_base::in) != target);
+      bool interrupted = false;
+      uint64_t frame_offset = position;
+      uint64_t payload_left = 0u;
+      data.clear();
+      while (!end) {
+        if (payload_left == 0u) {
+          char header[PacketHeaderSize];
+          const auto count = static_cast<size_t>(
+              _content->sgetn(header, static_cast<std::streamsize>(PacketHeaderSize)));
+          if ((count == PacketHeaderSize) && (header[0] == FrameStartPacketId) && !data.empty()) {
+            if (!Push(generation, frame_offset, data, false)) {
+              interrupted = true;
+              break;
+            }
+            frame_offset = position;
+          }
+          data.insert(data.end(), header, header + count);
+          position += count;
+          if (count < PacketHeaderSize) {
+            end = true;
+            break;
+          }
+          uint32_t size;
+          std::memcpy(&size, header + 1u, sizeof(size));
+          payload_left = std::min<uint64_t>(size, _size - position);
+        } else {
+          const auto chunk = static_cast<size_t>(std::min<uint64_t>(payload_left, MaxFrameSize));
+          const size_t used = data.size();
+          data.resize(used + chunk);
+          const auto count = static_cast<size_t>(
+              _content->sgetn(data.data() + used, static_cast<std::streamsize>(chunk)));
+          data.resize(used + count);
+          position += count;
+          payload_left -= count;
+          end = (count < chunk);
+        }
+        if (data.size() >= MaxFrameSize) {
+          if (!Push(generation, frame_offset, data, false)) {
+            interrupted = true;
+            break;
+          }
+          frame_offset = position;
+        }
+        if (IsInterrupted(generation)) {
+          interrupted = true;
+          break;
+        }
+      }
+      if (interrupted) {
+        continue;
+      }
+      if (!data.empty() && !Push(generation, frame_offset, data, false)) {
+        continue;
+      }
+      Push(generation, position, data, true);
+    }
+  }
+
+} // namespace recorder
+} // namespace carla
@@ -0,0 +1,182 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/NonCopyable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace carla {
+namespace recorder {
+
+  /// Stream buffer reading a recorder file (plain or BlockFile) whose content
+  /// is read ahead by a background thread, a frame at a time.
+  ///
+  /// The thread splits the content at the FrameStart packets and keeps up to
+  /// the given number of frames in a single producer, single consumer ring;
+  /// the reader's thread only copies from memory unless it catches up with
+  /// the prefetching. Seeking within the current frame or a short distance
+  /// forward consumes what was prefetched, seeking anywhere else restarts the
+  /// prefetching at the new position.
+  ///
+  /// Only one thread may read from it.
+  class FramePrefetcher : public std::streambuf, private NonCopyable {
+  public:
+
+    explicit FramePrefetcher(size_t frames_ahead = 32u);
+
+    ~FramePrefetcher();
+
+    /// Open the recorder file at @a path and start prefetching from its
+    /// beginning.
+    bool Open(const std::string &path);
+
+    /// Prefetch from @a content instead, which is owned by the prefetch
+    /// thread from now on.
+    bool Open(std::unique_ptr<std::streambuf> content);
+
+    void Close();
+
+    bool IsOpen() const {
+      return _is_open;
+    }
+
+    /// Size of the content.
+    uint64_t GetSize() const {
+      return _size;
+    }
+
+    /// @name Statistics of the current file
+    /// @{
+
+    /// Frames handed from the prefetch thread to the reader.
+    uint64_t GetFramesRead() const {
+      return _frames_read;
+    }
+
+    /// Time the reader waited for the prefetch thread, in microseconds.
+    uint64_t GetWaitMicroseconds() const {
+      return _wait_us;
+    }
+
+    /// Times a seek restarted the prefetching.
+    uint64_t GetRestarts() const {
+      return _restarts;
+    }
+
+    /// @}
+
+  protected:
+
+    int_type underflow() override;
+
+    pos_type seekoff(
+        off_type offset,
+        std::ios_base::seekdir direction,
+        std::ios_base::openmode which) override;
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+
+  private:
+
+    struct Slot {
+      /// Prefetch request the frame belongs to.
+      uint64_t generation = 0u;
+      /// Position of the frame in the content.
+      uint64_t offset = 0u;
+      std::vector<char> data;
+      /// Set on the slot following the last frame of the content.
+      bool end = false;
+    };
+
+    /// Position of the next character to read.
+    uint64_t Tell() const {
+      return _frame_offset + static_cast<uint64_t>(gptr() - eback());
+    }
+
+    /// Move to the next prefetched frame, false at the end of the content.
+    bool NextFrame();
+
+    /// Drop what was prefetched and prefetch from @a offset.
+    void Restart(uint64_t offset);
+
+    void Run();
+
+    /// Push a slot to the ring, false if interrupted by a new request.
+    bool Push(uint64_t generation, uint64_t offset, std::vector<char> &data, bool end);
+
+    bool IsInterrupted(uint64_t generation) const;
+
+    /// @name Used by the reader's thread
+    /// @{
+
+    /// Frame in the get area.
+    std::vector<char> _frame;
+
+    uint64_t _frame_offset = 0u;
+
+    /// Prefetch request whose frames are being read.
+    uint64_t _generation = 0u;
+
+    /// Whether the end of the content follows the current frame.
+    bool _at_end = false;
+
+    bool _is_open = false;
+
+    uint64_t _size = 0u;
+
+    uint64_t _frames_read = 0u;
+
+    uint64_t _wait_us = 0u;
+
+    uint64_t _restarts = 0u;
+
+    /// @}
+
+    /// @name Shared with the prefetch thread
+    /// @{
+
+    std::vector<Slot> _ring;
+
+    /// Next slot to write, only moved by the prefetch thread.
+    std::atomic<size_t> _head{0u};
+
+    /// Next slot to read, only moved by the reader.
+    std::atomic<size_t> _tail{0u};
+
+    std::mutex _mutex;
+
+    std::condition_variable _request_changed;
+
+    std::atomic<uint64_t> _requested_generation{0u};
+
+    uint64_t _requested_offset = 0u;
+
+    std::atomic_bool _done{false};
+
+    /// @}
+
+    /// @name Used by the prefetch thread
+    /// @{
+
+    std::unique_ptr<std::streambuf> _content;
+
+    /// @}
+
+    std::thread _thread;
+  };
+
+} // namespace recorder
+} // namespace carla
@@ -0,0 +1,168 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace carla {
+namespace recorder {
+
+  /// Frames of a recording already read, kept decoded to play them again in
+  /// either direction without going back to the file.
+  ///
+  /// Frames are kept by their start time; they do not need to be added in
+  /// order and the window may have gaps. The memory used is bounded: when
+  /// over budget, frames are dropped starting by those farthest from the
+  /// time of the last lookup.
+  template <typename T>
+  class FrameWindow {
+  public:
+
+    struct Frame {
+      double elapsed = 0.0;
+      double duration = 0.0;
+      /// Whether the frame adds, removes or attaches actors or changes the
+      /// weather, which cannot be undone from the window.
+      bool has_events = false;
+      /// Decoded per-actor state, e.g. positions.
+      std::vector<T> items;
+      /// Other packets of the frame, as recorded.
+      std::vector<char> packets;
+
+      size_t GetBytes() const {
+        return sizeof(Frame) + items.capacity() * sizeof(T) + packets.capacity();
+      }
+    };
+
+    explicit FrameWindow(size_t max_bytes = 0u)
+      : _max_bytes(max_bytes) {}
+
+    /// Budget of memory, zero disables the window.
+    void SetMaxBytes(size_t max_bytes) {
+      _max_bytes = max_bytes;
+      Shrink();
+    }
+
+    size_t GetMaxBytes() const {
+      return _max_bytes;
+    }
+
+    size_t GetBytes() const {
+      return _bytes;
+    }
+
+    size_t size() const {
+      return _frames.size();
+    }
+
+    bool empty() const {
+      return _frames.empty();
+    }
+
+    void Clear() {
+      _frames.clear();
+      _bytes = 0u;
+    }
+
+    /// Add a frame read from the recording, replacing the one starting at
+    /// the same time if any. Frames larger than the budget are not kept.
+    void Add(Frame frame) {
+      const size_t bytes = frame.GetBytes();
+      if (bytes > _max_bytes) {
+        return;
+      }
+      auto result = _frames.emplace(frame.elapsed, Frame{});
+      if (!result.second) {
+        _bytes -= result.first->second.GetBytes();
+      }
+      result.first->second = std::move(frame);
+      _bytes += bytes;
+      Shrink();
+    }
+
+    /// The frame containing @a time, nullptr if it is not in the window.
+    const Frame *Find(double time) {
+      _cursor = time;
+      auto it = _frames.upper_bound(time);
+      if (it == _frames.begin()) {
+        return nullptr;
+      }
+      --it;
+      return (time < it->second.elapsed + it->second.duration) ? &it->second : nullptr;
+    }
+
+    /// The frame recorded right before @a frame, nullptr if it is not in the
+    /// window.
+    const Frame *GetPrevious(const Frame &frame) const {
+      auto it = _frames.find(frame.elapsed);
+      if ((it == _frames.end()) || (it == _frames.begin())) {
+        return nullptr;
+      }
+      --it;
+      return AreConsecutive(it->second, frame) ? &it->second : nullptr;
+    }
+
+    /// Whether the window can take the replay from @a from to @a to, in
+    /// either direction: all the frames in between are in the window and
+    /// none after the first one has events.
+    bool CanPlay(double from, double to) const {
+      const double begin = std::min(from, to);
+      const double end = std::max(from, to);
+      auto it = _frames.upper_bound(begin);
+      if (it == _frames.begin()) {
+        return false;
+      }
+      --it;
+      const Frame *previous = &it->second;
+      if (begin >= previous->elapsed + previous->duration) {
+        return false;
+      }
+      for (++it; (it != _frames.end()) && (it->second.elapsed <= end); ++it) {
+        const Frame &frame = it->second;
+        if (frame.has_events || !AreConsecutive(*previous, frame)) {
+          return false;
+        }
+        previous = &frame;
+      }
+      return end < previous->elapsed + previous->duration;
+    }
+
+  private:
+
+    static bool AreConsecutive(const Frame &first, const Frame &second) {
+      // frame times are accumulated in the recording, allow for rounding.
+      const double gap = second.elapsed - (first.elapsed + first.duration);
+      return std::abs(gap) <= 0.01 * first.duration;
+    }
+
+    void Shrink() {
+      while ((_bytes > _max_bytes) && !_frames.empty()) {
+        auto first = _frames.begin();
+        auto last = std::prev(_frames.end());
+        auto dropped = ((_cursor - first->first) > (last->first - _cursor)) ? first : last;
+        _bytes -= dropped->second.GetBytes();
+        _frames.erase(dropped);
+      }
+    }
+
+    std::map<double, Frame> _frames;
+
+    size_t _max_bytes;
+
+    size_t _bytes = 0u;
+
+    /// Time of the last lookup.
+    double _cursor = 0.0;
+  };
+
+} // namespace recorder
+} // namespace carla
@@ -0,0 +1,183 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/recorder/Lz4.h"
+
+#include <array>
+#include <cstring>
+
+namespace carla {
+namespace recorder {
+namespace lz4 {
+
+  // Constants of the LZ4 block format.
+  static constexpr size_t MinMatch = 4u;
+  static constexpr size_t LastLiterals = 5u;
+  static constexpr size_t MatchFindLimit = 12u;
+  static constexpr size_t MaxDistance = 65535u;
+  static constexpr uint8_t RunMask = 15u;
+
+  static constexpr uint32_t HashLog = 12u;
+
+  static uint32_t Read32(const uint8_t *data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  static uint32_t Hash(uint32_t value) {
+    return (value * 2654435761u) >> (32u - HashLog);
+  }
+
+  static uint8_t *WriteLength(uint8_t *out, size_t length) {
+    for (; length >= 255u; length -= 255u) {
+      *out++ = 255u;
+    }
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+  }
+
+  static uint8_t *WriteLiterals(uint8_t *out, const uint8_t *literals, size_t count, uint8_t match_length) {
+    uint8_t *token = out++;
+    if (count >= RunMask) {
+      *token = static_cast<uint8_t>(RunMask << 4u);
+      out = WriteLength(out, count - RunMask);
+    } else {
+      *token = static_cast<uint8_t>(count << 4u);
+    }
+    *token = static_cast<uint8_t>(*token | match_length);
+    std::memcpy(out, literals, count);
+    return out + count;
+  }
+
+  size_t Compress(const uint8_t *source, size_t size, uint8_t *destination, size_t capacity) {
+    if (capacity < CompressBound(size)) {
+      return 0u;
+    }
+    std::array<uint32_t, (1u << HashLog)> table;
+    table.fill(0u);
+
+    uint8_t *out = destination;
+    size_t anchor = 0u;
+    size_t i = 1u;
+    if (size >= MatchFindLimit + 1u) {
+      table[Hash(Read32(source))] = 0u;
+      const size_t match_limit = size - LastLiterals;
+      while (i + MatchFindLimit <= size) {
+        const uint32_t sequence = Read32(source + i);
+        const uint32_t hash = Hash(sequence);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i);
+        if ((candidate >= i) || (i - candidate > MaxDistance) || (Read32(source + candidate) != sequence)) {
+          // skip faster through data that does not compress.
+          i += 1u + ((i - anchor) >> 6u);
+          continue;
+        }
+        size_t match = i;
+        while ((match > anchor) && (candidate > 0u) && (source[match - 1u] == source[candidate - 1u])) {
+          --match;
+          --candidate;
+        }
+        size_t length = MinMatch;
+        while ((i + length < match_limit) && (source[candidate + (i - match) + length] == source[i + length])) {
+          ++length;
+        }
+        length += i - match;
+
+        const size_t extra = length - MinMatch;
+        out = WriteLiterals(
+            out,
+            source + anchor,
+            match - anchor,
+            static_cast<uint8_t>(extra >= RunMask ? RunMask : extra));
+        const size_t offset = match - candidate;
+        *out++ = static_cast<uint8_t>(offset & 0xFFu);
+        *out++ = static_cast<uint8_t>(offset >> 8u);
+        if (extra >= RunMask) {
+          out = WriteLength(out, extra - RunMask);
+        }
+
+        i = match + length;
+        anchor = i;
+        if (i + MatchFindLimit <= size) {
+          table[Hash(Read32(source + i - 2u))] = static_cast<uint32_t>(i - 2u);
+        }
+      }
+    }
+    out = WriteLiterals(out, source + anchor, size - anchor, 0u);
+    return static_cast<size_t>(out - destination);
+  }
+
+  static bool ReadLength(const uint8_t *&in, const uint8_t *end, size_t &length) {
+    uint8_t value;
+    do {
+      if (in >= end) {
+        return false;
+      }
+      value = *in++;
+      length += value;
+    } while (value == 255u);
+    return true;
+  }
+
+  bool Decompress(
+      const uint8_t *source,
+      size_t size,
+      uint8_t *destination,
+      size_t destination_size) {
+    const uint8_t *in = source;
+    const uint8_t *in_end = source + size;
+    size_t out = 0u;
+    while (in < in_end) {
+      const uint8_t token = *in++;
+
+      size_t literals = token >> 4u;
+      if ((literals == RunMask) && !ReadLength(in, in_end, literals)) {
+        return false;
+      }
+      if ((literals > static_cast<size_t>(in_end - in)) || (literals > destination_size - out)) {
+        return false;
+      }
+      std::memcpy(destination + out, in, literals);
+      in += literals;
+      out += literals;
+      if (in == in_end) {
+        // the last sequence has no match.
+        break;
+      }
+
+      if (in_end - in < 2) {
+        return false;
+      }
+      const size_t offset = static_cast<size_t>(in[0u]) | (static_cast<size_t>(in[1u]) << 8u);
+      in += 2;
+      if ((offset == 0u) || (offset > out)) {
+        return false;
+      }
+      size_t length = token & RunMask;
+      if ((length == RunMask) && !ReadLength(in, in_end, length)) {
+        return false;
+      }
+      length += MinMatch;
+      if (length > destination_size - out) {
+        return false;
+      }
+      if (offset >= length) {
+        std::memcpy(destination + out, destination + out - offset, length);
+      } else {
+        // overlapping copy, repeats the last offset bytes.
+        for (size_t j = 0u; j < length; ++j) {
+          destination[out + j] = destination[out - offset + j];
+        }
+      }
+      out += length;
+    }
+    return out == destination_size;
+  }
+
+} // namespace lz4
+} // namespace recorder
+} // namespace carla
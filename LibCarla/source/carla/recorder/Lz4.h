@@ -0,0 +1,36 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace carla {
+namespace recorder {
+namespace lz4 {
+
+  /// Largest size Compress may produce for @a size bytes of input.
+  constexpr size_t CompressBound(size_t size) {
+    return size + size / 255u + 16u;
+  }
+
+  /// Compress @a size bytes of @a source into @a destination using the LZ4
+  /// block format. Returns the compressed size, or 0 if @a capacity is less
+  /// than CompressBound(size).
+  size_t Compress(const uint8_t *source, size_t size, uint8_t *destination, size_t capacity);
+
+  /// Decompress a LZ4 block of @a size bytes that expands to exactly
+  /// @a destination_size bytes. Returns false if the block is malformed.
+  bool Decompress(
+      const uint8_t *source,
+      size_t size,
+      uint8_t *destination,
+      size_t destination_size);
+
+} // namespace lz4
+} // namespace recorder
+} // namespace carla
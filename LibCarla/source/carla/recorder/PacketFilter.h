@@ -0,0 +1,106 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <istream>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+namespace carla {
+namespace recorder {
+
+  /// Packets and actors a reader of a recording is interested in.
+  ///
+  /// Packets not wanted are skipped using the size in their header, without
+  /// decoding them. In packets made of a record per actor, each starting with
+  /// the id of the actor, only the records of the wanted actors are decoded.
+  /// By default everything is wanted.
+  class PacketFilter {
+  public:
+
+    /// Ids of the frame start and end packets, as in CarlaRecorderPacketId;
+    /// they are always wanted to keep track of the frames.
+    static constexpr uint8_t FrameStartId = 0u;
+    static constexpr uint8_t FrameEndId = 1u;
+
+    PacketFilter() {
+      _packets.set();
+    }
+
+    /// Want only the packets with the given ids.
+    void SetPackets(std::initializer_list<uint8_t> ids) {
+      _packets.reset();
+      for (auto id : ids) {
+        _packets.set(id);
+      }
+    }
+
+    void SetPacket(uint8_t id, bool wanted = true) {
+      _packets.set(id, wanted);
+    }
+
+    bool IsPacketWanted(char id) const {
+      const auto index = static_cast<uint8_t>(id);
+      return (index == FrameStartId) || (index == FrameEndId) || _packets.test(index);
+    }
+
+    /// Want only the actors with the given ids, all of them if empty.
+    void SetActors(const std::vector<uint32_t> &ids) {
+      _actors = std::unordered_set<uint32_t>(ids.begin(), ids.end());
+    }
+
+    bool HasActorFilter() const {
+      return !_actors.empty();
+    }
+
+    bool IsActorWanted(uint32_t id) const {
+      return _actors.empty() || (_actors.count(id) > 0u);
+    }
+
+    /// Read a packet of @a count records laid out as @a Record, each
+    /// starting with the uint32 id of its actor, and call @a decode with the
+    /// records of the wanted actors. The records are read at once into
+    /// @a buffer and only the wanted ones are copied out of it. Returns false
+    /// if the read failed.
+    template <typename Record, typename Functor>
+    bool ForEachWantedRecord(
+        std::istream &in,
+        uint16_t count,
+        std::vector<char> &buffer,
+        Functor &&decode) const {
+      static_assert(std::is_trivially_copyable<Record>::value, "Records are copied from the file.");
+      const size_t size = count * sizeof(Record);
+      buffer.resize(size);
+      if (!in.read(buffer.data(), static_cast<std::streamsize>(size))) {
+        return false;
+      }
+      Record record;
+      for (size_t offset = 0u; offset < size; offset += sizeof(Record)) {
+        uint32_t id;
+        std::memcpy(&id, buffer.data() + offset, sizeof(id));
+        if (IsActorWanted(id)) {
+          std::memcpy(&record, buffer.data() + offset, sizeof(Record));
+          decode(record);
+        }
+      }
+      return true;
+    }
+
+  private:
+
+    std::bitset<256u> _packets;
+
+    std::unordered_set<uint32_t> _actors;
+  };
+
+} // namespace recorder
+} // namespace carla
@@ -0,0 +1,578 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/recorder/RecordingExporter.h"
+
+#include "carla/Exception.h"
+#include "carla/FileSystem.h"
+#include "carla/MappedFile.h"
+#include "carla/ParallelFor.h"
+#include "carla/recorder/BlockFile.h"
+#include "carla/recorder/FrameIndex.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace carla {
+namespace recorder {
+
+  // ===========================================================================
+  // -- Recorder packets -------------------------------------------------------
+  // ===========================================================================
+
+  /// Ids of the packets exported, as in CarlaRecorderPacketId.
+  enum class ExportedPacket : uint8_t {
+    FrameStart = 0u,
+    Position = 6u,
+    AnimVehicle = 8u,
+    DReyeVR = 139u,
+    DReyeVRCustomActor = 140u
+  };
+
+  /// Packet header: char id and uint32 size.
+  static constexpr size_t PacketHeaderSize = 5u;
+
+  /// uint64 id, double duration, double elapsed.
+  static constexpr size_t FrameStartSize = 24u;
+
+  /// uint32 id, float location[3], float rotation[3] (roll, pitch, yaw).
+  static constexpr size_t PositionSize = 28u;
+
+  /// uint32 id, float steering, throttle, brake, bool hand brake, int32 gear.
+  static constexpr size_t AnimVehicleSize = 21u;
+
+  // ===========================================================================
+  // -- Columns ----------------------------------------------------------------
+  // ===========================================================================
+
+  enum Column : size_t {
+    FrameId,
+    FrameElapsed,
+    FrameDuration,
+    FrameOffset,
+    PositionFrame,
+    PositionActor,
+    PositionX,
+    PositionY,
+    PositionZ,
+    PositionRoll,
+    PositionPitch,
+    PositionYaw,
+    ControlFrame,
+    ControlActor,
+    ControlSteering,
+    ControlThrottle,
+    ControlBrake,
+    ControlHandBrake,
+    ControlGear,
+    DReyeVRFrame,
+    DReyeVROffset,
+    DReyeVRSize,
+    DReyeVRPayload,
+    CustomActorFrame,
+    CustomActorOffset,
+    CustomActorSize,
+    CustomActorPayload,
+    NumberOfColumns
+  };
+
+  struct ColumnInfo {
+    const char *table;
+    const char *name;
+    const char *dtype;
+    size_t size;
+  };
+
+  static const ColumnInfo Columns[NumberOfColumns] = {
+    {"frames", "id", "<u8", 8u},
+    {"frames", "elapsed", "<f8", 8u},
+    {"frames", "duration", "<f8", 8u},
+    {"frames", "offset", "<u8", 8u},
+    {"positions", "frame", "<u8", 8u},
+    {"positions", "actor", "<u4", 4u},
+    {"positions", "x", "<f4", 4u},
+    {"positions", "y", "<f4", 4u},
+    {"positions", "z", "<f4", 4u},
+    {"positions", "roll", "<f4", 4u},
+    {"positions", "pitch", "<f4", 4u},
+    {"positions", "yaw", "<f4", 4u},
+    {"vehicle_controls", "frame", "<u8", 8u},
+    {"vehicle_controls", "actor", "<u4", 4u},
+    {"vehicle_controls", "steering", "<f4", 4u},
+    {"vehicle_controls", "throttle", "<f4", 4u},
+    {"vehicle_controls", "brake", "<f4", 4u},
+    {"vehicle_controls", "hand_brake", "|u1", 1u},
+    {"vehicle_controls", "gear", "<i4", 4u},
+    {"dreyevr", "frame", "<u8", 8u},
+    {"dreyevr", "offset", "<u8", 8u},
+    {"dreyevr", "size", "<u4", 4u},
+    {"dreyevr", "payload", "|u1", 1u},
+    {"dreyevr_custom_actors", "frame", "<u8", 8u},
+    {"dreyevr_custom_actors", "offset", "<u8", 8u},
+    {"dreyevr_custom_actors", "size", "<u4", 4u},
+    {"dreyevr_custom_actors", "payload", "|u1", 1u}
+  };
+
+  using ColumnData = std::array<std::vector<uint8_t>, NumberOfColumns>;
+
+  /// Range of whole frames of the file, parsed by one task.
+  struct ExportChunk {
+    uint64_t begin;
+    uint64_t end;
+    ColumnData columns;
+  };
+
+  /// Approximate size of the ranges of the file parsed in parallel.
+  static constexpr uint64_t ChunkSize = 8u * 1024u * 1024u;
+
+  static void AppendBytes(std::vector<uint8_t> &column, const uint8_t *data, size_t size) {
+    column.insert(column.end(), data, data + size);
+  }
+
+  template <typename T>
+  static void Append(std::vector<uint8_t> &column, const T &value) {
+    AppendBytes(column, reinterpret_cast<const uint8_t *>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  static T Load(const uint8_t *data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  static void ThrowMalformed(const std::string &path, uint64_t offset) {
+    throw_exception(std::runtime_error(
+        path + ": malformed recorder file at offset " + std::to_string(offset)));
+  }
+
+  // ===========================================================================
+  // -- Sources ----------------------------------------------------------------
+  // ===========================================================================
+
+  /// Uncompressed content of a recorder file, readable from several threads.
+  class ExportSource {
+  public:
+
+    virtual ~ExportSource() = default;
+
+    virtual uint64_t size() const = 0;
+
+    /// Bytes [offset, offset + count) of the content, either in place or
+    /// copied to @a scratch. Returns nullptr if out of range.
+    virtual const uint8_t *Read(uint64_t offset, size_t count, std::vector<uint8_t> &scratch) = 0;
+
+    /// Load the frame index of the file, if it has one.
+    virtual bool ReadIndex(FrameIndex &index) = 0;
+  };
+
+  /// Plain files are mapped, every thread reads them in place.
+  class MappedExportSource final : public ExportSource {
+  public:
+
+    MappedExportSource(std::string path, std::shared_ptr<MappedFile> file)
+      : _path(std::move(path)),
+        _file(std::move(file)) {}
+
+    uint64_t size() const override {
+      return _file->size();
+    }
+
+    const uint8_t *Read(uint64_t offset, size_t count, std::vector<uint8_t> &) override {
+      if ((offset > _file->size()) || (count > _file->size() - offset)) {
+        return nullptr;
+      }
+      return _file->data() + offset;
+    }
+
+    bool ReadIndex(FrameIndex &index) override {
+      std::ifstream in(_path, std::ios::binary);
+      return in.is_open() && index.Read(in);
+    }
+
+  private:
+
+    const std::string _path;
+
+    std::shared_ptr<MappedFile> _file;
+  };
+
+  /// Block compressed files are read through one reader per thread, so each
+  /// decompresses only the blocks of its own range.
+  class BlockExportSource final : public ExportSource {
+  public:
+
+    BlockExportSource(std::string path, std::unique_ptr<BlockFileReader> reader)
+      : _path(std::move(path)),
+        _size(reader->GetRawSize()) {
+      _readers.emplace_back(std::move(reader));
+    }
+
+    uint64_t size() const override {
+      return _size;
+    }
+
+    const uint8_t *Read(uint64_t offset, size_t count, std::vector<uint8_t> &scratch) override {
+      if ((offset > _size) || (count > _size - offset)) {
+        return nullptr;
+      }
+      auto reader = Pop();
+      scratch.resize(count);
+      const auto position = reader->pubseekpos(static_cast<std::streamoff>(offset), std::ios_base::in);
+      const bool ok =
+          (position == std::streampos(static_cast<std::streamoff>(offset))) &&
+          (reader->sgetn(reinterpret_cast<char *>(scratch.data()), static_cast<std::streamsize>(count)) ==
+              static_cast<std::streamsize>(count));
+      Push(std::move(reader));
+      return ok ? scratch.data() : nullptr;
+    }
+
+    bool ReadIndex(FrameIndex &index) override {
+      auto reader = Pop();
+      std::istream in(reader.get());
+      const bool found = index.Read(in);
+      Push(std::move(reader));
+      return found;
+    }
+
+  private:
+
+    std::unique_ptr<BlockFileReader> Pop() {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_readers.empty()) {
+          auto reader = std::move(_readers.back());
+          _readers.pop_back();
+          return reader;
+        }
+      }
+      auto reader = std::make_unique<BlockFileReader>();
+      if (!reader->Open(_path)) {
+        throw_exception(std::runtime_error(_path + ": cannot open file"));
+      }
+      return reader;
+    }
+
+    void Push(std::unique_ptr<BlockFileReader> reader) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _readers.emplace_back(std::move(reader));
+    }
+
+    const std::string _path;
+
+    const uint64_t _size;
+
+    std::mutex _mutex;
+
+    std::vector<std::unique_ptr<BlockFileReader>> _readers;
+  };
+
+  static std::unique_ptr<ExportSource> OpenSource(const std::string &path) {
+    auto reader = std::make_unique<BlockFileReader>();
+    if (reader->Open(path)) {
+      return std::make_unique<BlockExportSource>(path, std::move(reader));
+    }
+    auto file = MappedFile::Open(path);
+    if (file == nullptr) {
+      throw_exception(std::runtime_error(path + ": cannot open file"));
+    }
+    return std::make_unique<MappedExportSource>(path, std::move(file));
+  }
+
+  // ===========================================================================
+  // -- Parsing ----------------------------------------------------------------
+  // ===========================================================================
+
+  /// Parse the info header, return the map name and set @a end to the offset
+  /// of the first packet.
+  static std::string ReadHeader(ExportSource &source, const std::string &path, uint64_t &end) {
+    std::vector<uint8_t> scratch;
+    uint64_t offset = 0u;
+    auto read = [&](size_t count) {
+      const uint8_t *data = source.Read(offset, count, scratch);
+      if (data == nullptr) {
+        ThrowMalformed(path, offset);
+      }
+      offset += count;
+      return data;
+    };
+    auto read_string = [&]() {
+      const auto length = Load<uint16_t>(read(sizeof(uint16_t)));
+      const uint8_t *data = read(length);
+      return std::string(reinterpret_cast<const char *>(data), length);
+    };
+    read(sizeof(uint16_t)); // version
+    if (read_string() != "CARLA_RECORDER") {
+      throw_exception(std::runtime_error(path + ": not a recorder file"));
+    }
+    read(sizeof(int64_t)); // date
+    std::string map = read_string();
+    end = offset;
+    return map;
+  }
+
+  /// Offsets of the frames found scanning the packet headers from @a offset.
+  static std::vector<uint64_t> ScanFrames(ExportSource &source, const std::string &path, uint64_t offset) {
+    std::vector<uint64_t> frames;
+    std::vector<uint8_t> scratch;
+    while (offset < source.size()) {
+      const uint8_t *header = source.Read(offset, PacketHeaderSize, scratch);
+      if (header == nullptr) {
+        ThrowMalformed(path, offset);
+      }
+      const uint8_t id = header[0];
+      if (id == static_cast<uint8_t>(FrameIndex::PacketId)) {
+        break;
+      }
+      if (id == static_cast<uint8_t>(ExportedPacket::FrameStart)) {
+        frames.emplace_back(offset);
+      }
+      offset += PacketHeaderSize + Load<uint32_t>(header + 1u);
+    }
+    return frames;
+  }
+
+  static void ParseDReyeVR(
+      ColumnData &columns,
+      Column first,
+      uint64_t frame,
+      const uint8_t *payload,
+      uint32_t size) {
+    auto &data = columns[first + 3u];
+    Append(columns[first], frame);
+    Append(columns[first + 1u], static_cast<uint64_t>(data.size()));
+    Append(columns[first + 2u], size);
+    AppendBytes(data, payload, size);
+  }
+
+  /// Parse the packets of @a chunk. Offsets in the payload columns are
+  /// relative to the chunk until fixed by the caller.
+  static void ParseChunk(ExportSource &source, const std::string &path, ExportChunk &chunk) {
+    std::vector<uint8_t> scratch;
+    const size_t size = static_cast<size_t>(chunk.end - chunk.begin);
+    const uint8_t *data = source.Read(chunk.begin, size, scratch);
+    if (data == nullptr) {
+      ThrowMalformed(path, chunk.begin);
+    }
+    auto &columns = chunk.columns;
+    uint64_t frame = 0u;
+    size_t position = 0u;
+    while (position + PacketHeaderSize <= size) {
+      const uint8_t id = data[position];
+      const uint32_t packet_size = Load<uint32_t>(data + position + 1u);
+      const uint8_t *payload = data + position + PacketHeaderSize;
+      if (packet_size > size - position - PacketHeaderSize) {
+        ThrowMalformed(path, chunk.begin + position);
+      }
+      if (id == static_cast<uint8_t>(FrameIndex::PacketId)) {
+        break;
+      }
+      switch (static_cast<ExportedPacket>(id)) {
+        case ExportedPacket::FrameStart: {
+          if (packet_size < FrameStartSize) {
+            ThrowMalformed(path, chunk.begin + position);
+          }
+          frame = Load<uint64_t>(payload);
+          Append(columns[FrameId], frame);
+          Append(columns[FrameDuration], Load<double>(payload + 8u));
+          Append(columns[FrameElapsed], Load<double>(payload + 16u));
+          Append(columns[FrameOffset], chunk.begin + position);
+          break;
+        }
+        case ExportedPacket::Position: {
+          const size_t count = (packet_size < sizeof(uint16_t)) ? 0u : Load<uint16_t>(payload);
+          if (sizeof(uint16_t) + count * PositionSize > packet_size) {
+            ThrowMalformed(path, chunk.begin + position);
+          }
+          for (size_t i = 0u; i < count; ++i) {
+            const uint8_t *record = payload + sizeof(uint16_t) + i * PositionSize;
+            Append(columns[PositionFrame], frame);
+            AppendBytes(columns[PositionActor], record, 4u);
+            for (size_t j = 0u; j < 6u; ++j) {
+              AppendBytes(columns[PositionX + j], record + 4u + 4u * j, 4u);
+            }
+          }
+          break;
+        }
+        case ExportedPacket::AnimVehicle: {
+          const size_t count = (packet_size < sizeof(uint16_t)) ? 0u : Load<uint16_t>(payload);
+          if (sizeof(uint16_t) + count * AnimVehicleSize > packet_size) {
+            ThrowMalformed(path, chunk.begin + position);
+          }
+          for (size_t i = 0u; i < count; ++i) {
+            const uint8_t *record = payload + sizeof(uint16_t) + i * AnimVehicleSize;
+            Append(columns[ControlFrame], frame);
+            AppendBytes(columns[ControlActor], record, 4u);
+            AppendBytes(columns[ControlSteering], record + 4u, 4u);
+            AppendBytes(columns[ControlThrottle], record + 8u, 4u);
+            AppendBytes(columns[ControlBrake], record + 12u, 4u);
+            AppendBytes(columns[ControlHandBrake], record + 16u, 1u);
+            AppendBytes(columns[ControlGear], record + 17u, 4u);
+          }
+          break;
+        }
+        case ExportedPacket::DReyeVR:
+          ParseDReyeVR(columns, DReyeVRFrame, frame, payload, packet_size);
+          break;
+        case ExportedPacket::DReyeVRCustomActor:
+          ParseDReyeVR(columns, CustomActorFrame, frame, payload, packet_size);
+          break;
+        default:
+          break;
+      }
+      position += PacketHeaderSize + packet_size;
+    }
+  }
+
+  /// Make the payload offsets of every chunk relative to the whole column.
+  static void FixPayloadOffsets(std::vector<ExportChunk> &chunks, Column offsets, Column payload) {
+    uint64_t base = 0u;
+    for (auto &chunk : chunks) {
+      auto &column = chunk.columns[offsets];
+      for (size_t i = 0u; i < column.size(); i += sizeof(uint64_t)) {
+        const uint64_t value = Load<uint64_t>(column.data() + i) + base;
+        std::memcpy(column.data() + i, &value, sizeof(value));
+      }
+      base += chunk.columns[payload].size();
+    }
+  }
+
+  // ===========================================================================
+  // -- Output -----------------------------------------------------------------
+  // ===========================================================================
+
+  static std::string ColumnPath(const std::string &directory, const ColumnInfo &info) {
+    return directory + "/" + info.table + "/" + info.name + ".bin";
+  }
+
+  static std::string EscapeJson(const std::string &str) {
+    std::string result;
+    for (char c : str) {
+      if ((c == '"') || (c == '\\')) {
+        result += '\\';
+        result += c;
+      } else if (static_cast<unsigned char>(c) < 0x20u) {
+        result += ' ';
+      } else {
+        result += c;
+      }
+    }
+    return result;
+  }
+
+  static void WriteSchema(const std::string &directory, const ExportedRecording &recording) {
+    std::ostringstream out;
+    out << "{\n";
+    out << "  \"map\": \"" << EscapeJson(recording.map) << "\",\n";
+    out << "  \"frames\": " << recording.frames << ",\n";
+    out << "  \"columns\": [\n";
+    for (size_t i = 0u; i < recording.columns.size(); ++i) {
+      const auto &column = recording.columns[i];
+      out << "    {\"table\": \"" << column.table
+          << "\", \"name\": \"" << column.name
+          << "\", \"dtype\": \"" << column.dtype
+          << "\", \"rows\": " << column.rows
+          << ", \"path\": \"" << column.table << '/' << column.name << ".bin\"}"
+          << ((i + 1u < recording.columns.size()) ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+    std::ofstream file(directory + "/schema.json", std::ios::trunc);
+    file << out.str();
+    if (!file) {
+      throw_exception(std::runtime_error(directory + "/schema.json: cannot write file"));
+    }
+  }
+
+  // ===========================================================================
+  // -- ExportRecording --------------------------------------------------------
+  // ===========================================================================
+
+  ExportedRecording ExportRecording(
+      const std::string &path,
+      const std::string &directory,
+      size_t worker_threads) {
+    auto source = OpenSource(path);
+
+    ExportedRecording recording;
+    uint64_t first_packet = 0u;
+    recording.map = ReadHeader(*source, path, first_packet);
+
+    std::vector<uint64_t> frames;
+    FrameIndex index;
+    if (source->ReadIndex(index)) {
+      frames.reserve(index.size());
+      for (size_t i = 0u; i < index.size(); ++i) {
+        frames.emplace_back(index[i].offset);
+      }
+    } else {
+      frames = ScanFrames(*source, path, first_packet);
+    }
+
+    // Group the frames in chunks; the last one runs to the end of the content
+    // and its parse stops at the index packet.
+    std::vector<ExportChunk> chunks;
+    for (size_t i = 0u; i < frames.size(); ++i) {
+      if (chunks.empty() || (frames[i] - chunks.back().begin >= ChunkSize)) {
+        if (!chunks.empty()) {
+          chunks.back().end = frames[i];
+        }
+        chunks.emplace_back();
+        chunks.back().begin = frames[i];
+      }
+    }
+    if (!chunks.empty()) {
+      chunks.back().end = source->size();
+    }
+    for (auto &chunk : chunks) {
+      if ((chunk.begin < first_packet) || (chunk.end < chunk.begin)) {
+        ThrowMalformed(path, chunk.begin);
+      }
+      recording.bytes += chunk.end - chunk.begin;
+    }
+
+    ParallelFor(chunks.size(), [&](size_t i) {
+      ParseChunk(*source, path, chunks[i]);
+    }, worker_threads);
+
+    FixPayloadOffsets(chunks, DReyeVROffset, DReyeVRPayload);
+    FixPayloadOffsets(chunks, CustomActorOffset, CustomActorPayload);
+
+    // Create the folders first, the files are written in parallel.
+    for (const auto &info : Columns) {
+      std::string file_path = ColumnPath(directory, info);
+      FileSystem::ValidateFilePath(file_path);
+    }
+
+    recording.columns.resize(NumberOfColumns);
+    ParallelFor(NumberOfColumns, [&](size_t i) {
+      const auto &info = Columns[i];
+      const auto file_path = ColumnPath(directory, info);
+      std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+      uint64_t bytes = 0u;
+      for (const auto &chunk : chunks) {
+        const auto &data = chunk.columns[i];
+        file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        bytes += data.size();
+      }
+      if (!file) {
+        throw_exception(std::runtime_error(file_path + ": cannot write file"));
+      }
+      recording.columns[i] = ExportedColumn{info.table, info.name, info.dtype, bytes / info.size};
+    }, worker_threads);
+
+    recording.frames = recording.columns[FrameId].rows;
+    WriteSchema(directory, recording);
+    return recording;
+  }
+
+} // namespace recorder
+} // namespace carla
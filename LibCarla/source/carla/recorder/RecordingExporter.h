@@ -0,0 +1,59 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace carla {
+namespace recorder {
+
+  /// A column written by ExportRecording.
+  struct ExportedColumn {
+    std::string table;
+    std::string name;
+    /// Type as a numpy dtype string, e.g. "<f4".
+    std::string dtype;
+    uint64_t rows;
+  };
+
+  struct ExportedRecording {
+    std::string map;
+    uint64_t frames = 0u;
+    /// Bytes of recorder content parsed (uncompressed).
+    uint64_t bytes = 0u;
+    std::vector<ExportedColumn> columns;
+  };
+
+  /// Read the recorder file at @a path (plain or BlockFile) without the
+  /// simulator and write its streams to @a directory as columnar files, one
+  /// raw little-endian array per field that numpy can memory map:
+  ///
+  ///   frames/{id,elapsed,duration,offset}.bin
+  ///   positions/{frame,actor,x,y,z,roll,pitch,yaw}.bin
+  ///   vehicle_controls/{frame,actor,steering,throttle,brake,hand_brake,gear}.bin
+  ///   dreyevr/{frame,offset,size}.bin and dreyevr/payload.bin
+  ///   dreyevr_custom_actors/{frame,offset,size}.bin and .../payload.bin
+  ///
+  /// "frame" columns hold the frame id. DReyeVR packets are exported as they
+  /// were recorded, the size and offset of each in payload.bin; their layout
+  /// is owned by the simulator plugin.
+  ///
+  /// The file is split in ranges of frames (using its frame index, or a scan
+  /// of the packet headers if it has none) parsed on @a worker_threads
+  /// threads, all the hardware concurrency if zero. A schema.json describing
+  /// the columns is written too.
+  ///
+  /// @throw std::runtime_error if the file cannot be read or is malformed.
+  ExportedRecording ExportRecording(
+      const std::string &path,
+      const std::string &directory,
+      size_t worker_threads = 0u);
+
+} // namespace recorder
+} // namespace carla
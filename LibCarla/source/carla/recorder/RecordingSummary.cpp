@@ -0,0 +1,715 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/recorder/RecordingSummary.h"
+
+#include "carla/ParallelFor.h"
+#include "carla/recorder/BlockFile.h"
+#include "carla/recorder/FrameIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace carla {
+namespace recorder {
+
+  template <typename T>
+  static void WriteValue(std::ostream &out, const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  static bool ReadValue(std::istream &in, T &value) {
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return static_cast<bool>(in);
+  }
+
+  template <typename T>
+  static void WriteArray(std::ostream &out, const std::vector<T> &values) {
+    WriteValue(out, static_cast<uint32_t>(values.size()));
+    out.write(
+        reinterpret_cast<const char *>(values.data()),
+        static_cast<std::streamsize>(values.size() * sizeof(T)));
+  }
+
+  template <typename T>
+  static bool ReadArray(std::istream &in, uint64_t max_size, std::vector<T> &values) {
+    uint32_t count = 0u;
+    if (!ReadValue(in, count) || (uint64_t(count) * sizeof(T) > max_size)) {
+      return false;
+    }
+    values.resize(count);
+    in.read(
+        reinterpret_cast<char *>(values.data()),
+        static_cast<std::streamsize>(values.size() * sizeof(T)));
+    return static_cast<bool>(in);
+  }
+
+  static float Distance(const float (&a)[3], const float (&b)[3]) {
+    const float x = a[0] - b[0];
+    const float y = a[1] - b[1];
+    const float z = a[2] - b[2];
+    return std::sqrt(x * x + y * y + z * z);
+  }
+
+  // ===========================================================================
+  // -- RecordingSummary -------------------------------------------------------
+  // ===========================================================================
+
+  const SummaryActor *RecordingSummary::FindActor(uint32_t id, double elapsed) const {
+    auto first = std::lower_bound(
+        _actors.begin(),
+        _actors.end(),
+        id,
+        [](const SummaryActor &actor, uint32_t value) { return actor.id < value; });
+    if ((first == _actors.end()) || (first->id != id)) {
+      return nullptr;
+    }
+    auto result = first;
+    for (auto it = first; (it != _actors.end()) && (it->id == id) && (it->begin <= elapsed); ++it) {
+      result = it;
+    }
+    return &*result;
+  }
+
+  std::vector<SummaryBlockedActor> RecordingSummary::FindBlocked(
+      double min_time,
+      double min_distance) const {
+    std::vector<SummaryBlockedActor> result;
+    const double interval = TrajectoryInterval;
+    size_t i = 0u;
+    while (i < _points.size()) {
+      // the samples of one actor during one lifetime.
+      const SummaryPoint &first = _points[i];
+      const SummaryActor *actor = FindActor(first.actor, first.elapsed);
+      size_t end = i + 1u;
+      while ((end < _points.size()) &&
+             (_points[end].actor == first.actor) &&
+             (FindActor(first.actor, _points[end].elapsed) == actor)) {
+        ++end;
+      }
+      const double lifetime_end = (actor != nullptr) ? actor->end : _duration;
+
+      const SummaryPoint *anchor = &first;
+      double begin = first.elapsed;
+      double duration = 0.0;
+      auto stopped = [&](double from, double to) {
+        if (to > from) {
+          if (duration == 0.0) {
+            begin = from;
+          }
+          duration += to - from;
+        }
+      };
+      auto report = [&]() {
+        if ((duration > 0.0) && (duration >= min_time)) {
+          result.emplace_back(SummaryBlockedActor{first.actor, begin, duration});
+        }
+        duration = 0.0;
+      };
+      for (size_t k = i + 1u; k < end; ++k) {
+        const auto &previous = _points[k - 1u];
+        const auto &point = _points[k];
+        // no samples in between: the actor stayed at the previous one.
+        if (point.elapsed - previous.elapsed > 1.5 * interval) {
+          stopped(previous.elapsed, point.elapsed - interval);
+        }
+        const double from = std::max(previous.elapsed, point.elapsed - interval);
+        if (Distance(anchor->location, point.location) < min_distance) {
+          stopped(from, point.elapsed);
+        } else {
+          report();
+          anchor = &point;
+        }
+      }
+      stopped(_points[end - 1u].elapsed, lifetime_end);
+      report();
+      i = end;
+    }
+    std::stable_sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
+      return a.duration > b.duration;
+    });
+    return result;
+  }
+
+  void RecordingSummary::Write(std::ostream &out) const {
+    const uint64_t start = static_cast<uint64_t>(out.tellp());
+    uint64_t size = sizeof(_last_frame) + sizeof(_duration) + 3u * sizeof(uint32_t) +
+        _collisions.size() * sizeof(SummaryCollision) +
+        _points.size() * sizeof(SummaryPoint) +
+        sizeof(start) + sizeof(FooterMagic);
+    for (auto &actor : _actors) {
+      size += sizeof(actor.id) + sizeof(actor.type) + sizeof(actor.begin) + sizeof(actor.end) +
+          sizeof(uint16_t) + std::min<size_t>(actor.description.size(), 0xFFFFu);
+    }
+    const char id = PacketId;
+    const uint64_t magic = FooterMagic;
+    WriteValue(out, id);
+    WriteValue(out, static_cast<uint32_t>(size));
+    WriteValue(out, _last_frame);
+    WriteValue(out, _duration);
+    WriteValue(out, static_cast<uint32_t>(_actors.size()));
+    for (auto &actor : _actors) {
+      const auto length = static_cast<uint16_t>(std::min<size_t>(actor.description.size(), 0xFFFFu));
+      WriteValue(out, actor.id);
+      WriteValue(out, actor.type);
+      WriteValue(out, actor.begin);
+      WriteValue(out, actor.end);
+      WriteValue(out, length);
+      out.write(actor.description.data(), length);
+    }
+    WriteArray(out, _collisions);
+    WriteArray(out, _points);
+    WriteValue(out, start);
+    WriteValue(out, magic);
+  }
+
+  bool RecordingSummary::Read(std::istream &in) {
+    *this = RecordingSummary{};
+    in.clear();
+    in.seekg(0, std::ios::end);
+    const auto file_size = static_cast<uint64_t>(in.tellg());
+    uint64_t offset = 0u;
+    uint64_t magic = 0u;
+    constexpr uint64_t footer_size = sizeof(offset) + sizeof(magic);
+
+    // the summary goes right before the frame index, which ends the file.
+    uint64_t index_start = 0u;
+    if (file_size < 2u * footer_size) {
+      return false;
+    }
+    in.seekg(static_cast<std::streamoff>(file_size - footer_size), std::ios::beg);
+    if (!ReadValue(in, index_start) ||
+        !ReadValue(in, magic) ||
+        (magic != FrameIndex::FooterMagic) ||
+        (index_start < footer_size) ||
+        (index_start > file_size)) {
+      in.clear();
+      return false;
+    }
+    in.seekg(static_cast<std::streamoff>(index_start - footer_size), std::ios::beg);
+    if (!ReadValue(in, offset) ||
+        !ReadValue(in, magic) ||
+        (magic != FooterMagic) ||
+        (offset >= index_start)) {
+      in.clear();
+      return false;
+    }
+
+    constexpr uint64_t min_actor_size =
+        sizeof(uint32_t) + sizeof(uint8_t) + 2u * sizeof(double) + sizeof(uint16_t);
+    char id = 0;
+    uint32_t size = 0u;
+    uint32_t count = 0u;
+    in.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    bool ok =
+        ReadValue(in, id) &&
+        ReadValue(in, size) &&
+        (id == PacketId) &&
+        (offset + sizeof(id) + sizeof(size) + size == index_start) &&
+        ReadValue(in, _last_frame) &&
+        ReadValue(in, _duration) &&
+        ReadValue(in, count) &&
+        (uint64_t(count) * min_actor_size <= size);
+    for (auto i = 0u; ok && (i < count); ++i) {
+      SummaryActor actor;
+      uint16_t length = 0u;
+      ok = ReadValue(in, actor.id) &&
+          ReadValue(in, actor.type) &&
+          ReadValue(in, actor.begin) &&
+          ReadValue(in, actor.end) &&
+          ReadValue(in, length);
+      if (ok) {
+        actor.description.resize(length);
+        in.read(&actor.description[0], length);
+        ok = static_cast<bool>(in);
+        _actors.emplace_back(std::move(actor));
+      }
+    }
+    ok = ok && ReadArray(in, size, _collisions) && ReadArray(in, size, _points);
+    if (!ok) {
+      in.clear();
+      *this = RecordingSummary{};
+      return false;
+    }
+    return true;
+  }
+
+  void RecordingSummary::Sort() {
+    std::stable_sort(_actors.begin(), _actors.end(), [](const auto &a, const auto &b) {
+      return (a.id < b.id) || ((a.id == b.id) && (a.begin < b.begin));
+    });
+    std::stable_sort(_collisions.begin(), _collisions.end(), [](const auto &a, const auto &b) {
+      return a.elapsed < b.elapsed;
+    });
+    std::stable_sort(_points.begin(), _points.end(), [](const auto &a, const auto &b) {
+      return (a.actor < b.actor) || ((a.actor == b.actor) && (a.elapsed < b.elapsed));
+    });
+  }
+
+  // ===========================================================================
+  // -- RecordingSummaryBuilder ------------------------------------------------
+  // ===========================================================================
+
+  void RecordingSummaryBuilder::Clear() {
+    *this = RecordingSummaryBuilder{};
+  }
+
+  void RecordingSummaryBuilder::AddActor(uint32_t id, uint8_t type, std::string description) {
+    _added.emplace_back(PendingActor{id, type, std::move(description)});
+  }
+
+  void RecordingSummaryBuilder::RemoveActor(uint32_t id) {
+    _removed.emplace_back(id);
+  }
+
+  void RecordingSummaryBuilder::AddCollision(
+      uint32_t actor1,
+      uint32_t actor2,
+      bool is_actor1_hero,
+      bool is_actor2_hero) {
+    _collisions.emplace_back(SummaryCollision{
+        0.0,
+        actor1,
+        actor2,
+        static_cast<uint8_t>(is_actor1_hero),
+        static_cast<uint8_t>(is_actor2_hero)});
+  }
+
+  void RecordingSummaryBuilder::AddPosition(uint32_t id, float x, float y, float z) {
+    _positions.emplace_back(SummaryPoint{id, 0.0, {x, y, z}});
+  }
+
+  void RecordingSummaryBuilder::FinishFrame(uint64_t frame, double elapsed) {
+    auto &actors = _summary._actors;
+    for (auto &added : _added) {
+      auto it = _alive.find(added.id);
+      if (it != _alive.end()) {
+        actors[it->second].end = elapsed;
+      }
+      _alive[added.id] = actors.size();
+      actors.emplace_back(SummaryActor{added.id, added.type, elapsed, elapsed, std::move(added.description)});
+    }
+    for (auto id : _removed) {
+      auto it = _alive.find(id);
+      if (it != _alive.end()) {
+        actors[it->second].end = elapsed;
+        _alive.erase(it);
+      }
+      _trajectories.erase(id);
+    }
+
+    // only the first frame of each collision, the recorder writes it again
+    // every frame the actors keep touching.
+    _current_collisions.clear();
+    for (auto &collision : _collisions) {
+      const auto pair = std::make_pair(collision.actor1, collision.actor2);
+      if (_current_collisions.insert(pair).second && (_previous_collisions.count(pair) == 0u)) {
+        collision.elapsed = elapsed;
+        _summary._collisions.emplace_back(collision);
+      }
+    }
+    std::swap(_previous_collisions, _current_collisions);
+
+    const double interval_length = RecordingSummary::TrajectoryInterval;
+    const float resolution = RecordingSummary::TrajectoryResolution;
+    const auto interval = static_cast<int64_t>(std::floor(elapsed / interval_length));
+    for (auto &position : _positions) {
+      auto result = _trajectories.emplace(position.actor, Trajectory{});
+      auto &trajectory = result.first->second;
+      if (!result.second) {
+        if (trajectory.last_interval == interval) {
+          continue;
+        }
+        trajectory.last_interval = interval;
+        if (Distance(trajectory.last_sample, position.location) < resolution) {
+          continue;
+        }
+      }
+      trajectory.last_interval = interval;
+      std::memcpy(trajectory.last_sample, position.location, sizeof(trajectory.last_sample));
+      position.elapsed = elapsed;
+      _summary._points.emplace_back(position);
+    }
+
+    _summary._last_frame = frame;
+    _summary._duration = elapsed;
+    _added.clear();
+    _removed.clear();
+    _collisions.clear();
+    _positions.clear();
+  }
+
+  RecordingSummary RecordingSummaryBuilder::Build() const {
+    RecordingSummary summary = _summary;
+    for (auto &alive : _alive) {
+      summary._actors[alive.second].end = summary._duration;
+    }
+    summary.Sort();
+    return summary;
+  }
+
+  // ===========================================================================
+  // -- ScanRecordingSummary ---------------------------------------------------
+  // ===========================================================================
+
+  /// Ids of the packets scanned, as in CarlaRecorderPacketId.
+  enum class ScannedPacket : uint8_t {
+    FrameStart = 0u,
+    EventAdd = 2u,
+    EventDel = 3u,
+    Collision = 5u,
+    Position = 6u
+  };
+
+  /// Approximate size of the ranges of the file parsed in parallel.
+  static constexpr uint64_t ScanChunkSize = 8u * 1024u * 1024u;
+
+  /// Size of the reads done looking for the frames.
+  static constexpr size_t ScanWindowSize = 1024u * 1024u;
+
+  /// Bounds checked reads from a packet.
+  class PacketReader {
+  public:
+
+    PacketReader(const uint8_t *data, size_t size) : _data(data), _size(size) {}
+
+    bool ok() const {
+      return _ok;
+    }
+
+    template <typename T>
+    T Read() {
+      T value{};
+      if (Check(sizeof(T))) {
+        std::memcpy(&value, _data + _position, sizeof(T));
+        _position += sizeof(T);
+      }
+      return value;
+    }
+
+    void Skip(size_t count) {
+      if (Check(count)) {
+        _position += count;
+      }
+    }
+
+    std::string ReadString() {
+      const size_t length = Read<uint16_t>();
+      std::string value;
+      if (Check(length)) {
+        value.assign(reinterpret_cast<const char *>(_data + _position), length);
+        _position += length;
+      }
+      return value;
+    }
+
+    void SkipString() {
+      Skip(Read<uint16_t>());
+    }
+
+  private:
+
+    bool Check(size_t count) {
+      _ok = _ok && (count <= _size - _position);
+      return _ok;
+    }
+
+    const uint8_t *_data;
+
+    size_t _size;
+
+    size_t _position = 0u;
+
+    bool _ok = true;
+  };
+
+  /// Packets of a range of frames, in the order they have to be given to the
+  /// builder.
+  struct ScanChunk {
+    struct Frame {
+      uint64_t id;
+      double elapsed;
+      /// First element of each list in this frame.
+      size_t added;
+      size_t removed;
+      size_t collisions;
+      size_t positions;
+    };
+
+    uint64_t begin = 0u;
+    uint64_t end = 0u;
+    bool ok = false;
+    std::vector<Frame> frames;
+    std::vector<SummaryActor> added;
+    std::vector<uint32_t> removed;
+    std::vector<SummaryCollision> collisions;
+    std::vector<SummaryPoint> positions;
+    /// Last interval in which each actor got a sample.
+    std::unordered_map<uint32_t, int64_t> intervals;
+  };
+
+  /// Skip the info header, return the offset of the first packet or zero if
+  /// it is not a recorder file.
+  static uint64_t SkipInfo(std::istream &in) {
+    uint16_t version = 0u;
+    uint16_t length = 0u;
+    int64_t date = 0;
+    std::string magic;
+    if (!ReadValue(in, version) || !ReadValue(in, length)) {
+      return 0u;
+    }
+    magic.resize(length);
+    in.read(&magic[0], length);
+    if (!in || (magic != "CARLA_RECORDER") || !ReadValue(in, date) || !ReadValue(in, length)) {
+      return 0u;
+    }
+    in.seekg(length, std::ios::cur);
+    return in ? static_cast<uint64_t>(in.tellg()) : 0u;
+  }
+
+  /// Offsets of the frames found walking the packet headers from @a offset.
+  static bool ScanFrames(std::istream &in, uint64_t offset, uint64_t size, std::vector<uint64_t> &frames) {
+    std::vector<char> window(ScanWindowSize);
+    uint64_t window_begin = 0u;
+    uint64_t window_size = 0u;
+    while (offset < size) {
+      if ((offset < window_begin) || (offset + 5u > window_begin + window_size)) {
+        in.clear();
+        in.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+        in.read(window.data(), static_cast<std::streamsize>(window.size()));
+        window_begin = offset;
+        window_size = static_cast<uint64_t>(in.gcount());
+        if (window_size < 5u) {
+          return false;
+        }
+      }
+      const char *header = window.data() + (offset - window_begin);
+      const auto id = static_cast<uint8_t>(header[0]);
+      uint32_t packet_size = 0u;
+      std::memcpy(&packet_size, header + 1u, sizeof(packet_size));
+      if ((id == static_cast<uint8_t>(FrameIndex::PacketId)) ||
+          (id == static_cast<uint8_t>(RecordingSummary::PacketId))) {
+        break;
+      }
+      if (id == static_cast<uint8_t>(ScannedPacket::FrameStart)) {
+        frames.emplace_back(offset);
+      }
+      offset += 5u + packet_size;
+    }
+    return true;
+  }
+
+  static bool ParsePacket(ScanChunk &chunk, uint8_t id, PacketReader &packet, double elapsed) {
+    const double interval_length = RecordingSummary::TrajectoryInterval;
+    switch (static_cast<ScannedPacket>(id)) {
+      case ScannedPacket::FrameStart: {
+        ScanChunk::Frame frame;
+        frame.id = packet.Read<uint64_t>();
+        packet.Skip(sizeof(double)); // duration
+        frame.elapsed = packet.Read<double>();
+        frame.added = chunk.added.size();
+        frame.removed = chunk.removed.size();
+        frame.collisions = chunk.collisions.size();
+        frame.positions = chunk.positions.size();
+        chunk.frames.emplace_back(frame);
+        break;
+      }
+      case ScannedPacket::EventAdd: {
+        const auto total = packet.Read<uint16_t>();
+        for (auto i = 0u; packet.ok() && (i < total); ++i) {
+          SummaryActor actor{};
+          actor.id = packet.Read<uint32_t>();
+          actor.type = packet.Read<uint8_t>();
+          packet.Skip(6u * sizeof(float) + sizeof(uint32_t)); // transform, uid
+          actor.description = packet.ReadString();
+          const auto attributes = packet.Read<uint16_t>();
+          for (auto j = 0u; packet.ok() && (j < attributes); ++j) {
+            packet.Skip(sizeof(uint8_t));
+            packet.SkipString();
+            packet.SkipString();
+          }
+          chunk.added.emplace_back(std::move(actor));
+        }
+        break;
+      }
+      case ScannedPacket::EventDel: {
+        const auto total = packet.Read<uint16_t>();
+        for (auto i = 0u; packet.ok() && (i < total); ++i) {
+          chunk.removed.emplace_back(packet.Read<uint32_t>());
+          chunk.intervals.erase(chunk.removed.back());
+        }
+        break;
+      }
+      case ScannedPacket::Collision: {
+        const auto total = packet.Read<uint16_t>();
+        for (auto i = 0u; packet.ok() && (i < total); ++i) {
+          SummaryCollision collision{};
+          packet.Skip(sizeof(uint32_t)); // collision id
+          collision.actor1 = packet.Read<uint32_t>();
+          collision.actor2 = packet.Read<uint32_t>();
+          collision.is_actor1_hero = packet.Read<uint8_t>();
+          collision.is_actor2_hero = packet.Read<uint8_t>();
+          chunk.collisions.emplace_back(collision);
+        }
+        break;
+      }
+      case ScannedPacket::Position: {
+        // the builder keeps one sample per interval, give it only the first.
+        const auto interval = static_cast<int64_t>(std::floor(elapsed / interval_length));
+        const auto total = packet.Read<uint16_t>();
+        for (auto i = 0u; packet.ok() && (i < total); ++i) {
+          SummaryPoint point{};
+          point.actor = packet.Read<uint32_t>();
+          point.location[0] = packet.Read<float>();
+          point.location[1] = packet.Read<float>();
+          point.location[2] = packet.Read<float>();
+          packet.Skip(3u * sizeof(float)); // rotation
+          auto result = chunk.intervals.emplace(point.actor, interval);
+          if (result.second || (result.first->second != interval)) {
+            result.first->second = interval;
+            chunk.positions.emplace_back(point);
+          }
+        }
+        break;
+      }
+      default:
+        break;
+    }
+    return packet.ok();
+  }
+
+  static void ParseChunk(const std::string &path, ScanChunk &chunk) {
+    auto content = OpenRecorderContent(path);
+    if (content == nullptr) {
+      return;
+    }
+    std::vector<uint8_t> data(static_cast<size_t>(chunk.end - chunk.begin));
+    if ((content->pubseekpos(static_cast<std::streamoff>(chunk.begin), std::ios_base::in) !=
+            std::streampos(static_cast<std::streamoff>(chunk.begin))) ||
+        (content->sgetn(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size())) !=
+            static_cast<std::streamsize>(data.size()))) {
+      return;
+    }
+    size_t position = 0u;
+    while (position + 5u <= data.size()) {
+      const uint8_t id = data[position];
+      uint32_t size = 0u;
+      std::memcpy(&size, data.data() + position + 1u, sizeof(size));
+      if ((id == static_cast<uint8_t>(FrameIndex::PacketId)) ||
+          (id == static_cast<uint8_t>(RecordingSummary::PacketId))) {
+        break;
+      }
+      if (size > data.size() - position - 5u) {
+        return;
+      }
+      PacketReader packet(data.data() + position + 5u, size);
+      const double elapsed = chunk.frames.empty() ? 0.0 : chunk.frames.back().elapsed;
+      if (!ParsePacket(chunk, id, packet, elapsed)) {
+        return;
+      }
+      position += 5u + size;
+    }
+    chunk.ok = true;
+  }
+
+  bool ScanRecordingSummary(
+      const std::string &path,
+      RecordingSummary &summary,
+      size_t worker_threads) {
+    std::vector<uint64_t> frames;
+    uint64_t size = 0u;
+    {
+      auto content = OpenRecorderContent(path);
+      if (content == nullptr) {
+        return false;
+      }
+      std::istream in(content.get());
+      const uint64_t first_packet = SkipInfo(in);
+      if (first_packet == 0u) {
+        return false;
+      }
+      FrameIndex index;
+      if (index.Read(in)) {
+        for (size_t i = 0u; i < index.size(); ++i) {
+          frames.emplace_back(index[i].offset);
+        }
+      }
+      in.clear();
+      in.seekg(0, std::ios::end);
+      size = static_cast<uint64_t>(in.tellg());
+      if (index.empty() && !ScanFrames(in, first_packet, size, frames)) {
+        return false;
+      }
+    }
+
+    // split at frame boundaries.
+    std::vector<ScanChunk> chunks;
+    for (auto offset : frames) {
+      if (offset >= size) {
+        return false;
+      }
+      if (chunks.empty() || (offset - chunks.back().begin >= ScanChunkSize)) {
+        if (!chunks.empty()) {
+          chunks.back().end = offset;
+        }
+        chunks.emplace_back();
+        chunks.back().begin = offset;
+      }
+    }
+    if (!chunks.empty()) {
+      chunks.back().end = size;
+    }
+
+    ParallelFor(chunks.size(), [&](size_t i) {
+      ParseChunk(path, chunks[i]);
+    }, worker_threads);
+
+    // the builder needs the frames in order, but only gets the packets that
+    // matter.
+    RecordingSummaryBuilder builder;
+    for (auto &chunk : chunks) {
+      if (!chunk.ok) {
+        return false;
+      }
+      for (size_t i = 0u; i < chunk.frames.size(); ++i) {
+        const auto &frame = chunk.frames[i];
+        const bool last = (i + 1u == chunk.frames.size());
+        const size_t added = last ? chunk.added.size() : chunk.frames[i + 1u].added;
+        const size_t removed = last ? chunk.removed.size() : chunk.frames[i + 1u].removed;
+        const size_t collisions = last ? chunk.collisions.size() : chunk.frames[i + 1u].collisions;
+        const size_t positions = last ? chunk.positions.size() : chunk.frames[i + 1u].positions;
+        for (size_t j = frame.added; j < added; ++j) {
+          builder.AddActor(chunk.added[j].id, chunk.added[j].type, std::move(chunk.added[j].description));
+        }
+        for (size_t j = frame.removed; j < removed; ++j) {
+          builder.RemoveActor(chunk.removed[j]);
+        }
+        for (size_t j = frame.collisions; j < collisions; ++j) {
+          const auto &collision = chunk.collisions[j];
+          builder.AddCollision(
+              collision.actor1,
+              collision.actor2,
+              collision.is_actor1_hero != 0u,
+              collision.is_actor2_hero != 0u);
+        }
+        for (size_t j = frame.positions; j < positions; ++j) {
+          const auto &point = chunk.positions[j];
+          builder.AddPosition(point.actor, point.location[0], point.location[1], point.location[2]);
+        }
+        builder.FinishFrame(frame.id, frame.elapsed);
+      }
+      chunk = ScanChunk{};
+    }
+    summary = builder.Build();
+    return true;
+  }
+
+} // namespace recorder
+} // namespace carla
@@ -0,0 +1,217 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace carla {
+namespace recorder {
+
+  /// Lifetime of an actor in a recording.
+  struct SummaryActor {
+    uint32_t id;
+    /// Type as recorded in the actor's add event.
+    uint8_t type;
+    /// Time the actor was added and removed (or the recording ended).
+    double begin;
+    double end;
+    /// Id of the blueprint, e.g. "vehicle.tesla.model3".
+    std::string description;
+  };
+
+#pragma pack(push, 1)
+  /// First frame of a collision between two actors.
+  struct SummaryCollision {
+    double elapsed;
+    uint32_t actor1;
+    uint32_t actor2;
+    uint8_t is_actor1_hero;
+    uint8_t is_actor2_hero;
+  };
+
+  /// Sample of the trajectory of an actor.
+  struct SummaryPoint {
+    uint32_t actor;
+    double elapsed;
+    float location[3];
+  };
+#pragma pack(pop)
+
+  /// Time an actor stayed within some distance of the same place.
+  struct SummaryBlockedActor {
+    uint32_t id;
+    double begin;
+    double duration;
+  };
+
+  /// Summary of a recording written by the recorder as the packet before the
+  /// frame index: actor lifetimes, collisions and coarse trajectories. Lets
+  /// the collision and blocked-actor queries answer without parsing the
+  /// frames.
+  ///
+  /// Trajectories keep at most one sample per actor every
+  /// TrajectoryInterval seconds, and only if the actor moved more than
+  /// TrajectoryResolution since the previous one; an actor without samples
+  /// for a while stayed put.
+  class RecordingSummary {
+  public:
+
+    /// Id of the recorder packet holding the summary.
+    static constexpr char PacketId = 21;
+
+    /// "CRSUMM01" read as a little-endian integer.
+    static constexpr uint64_t FooterMagic = 0x31304D4D55535243ull;
+
+    /// Seconds between trajectory samples.
+    static constexpr double TrajectoryInterval = 1.0;
+
+    /// Distance an actor moves before a new sample is taken, in the units of
+    /// the recording (centimeters).
+    static constexpr float TrajectoryResolution = 1.0f;
+
+    uint64_t GetLastFrame() const {
+      return _last_frame;
+    }
+
+    double GetDuration() const {
+      return _duration;
+    }
+
+    /// Sorted by id and time added.
+    const std::vector<SummaryActor> &GetActors() const {
+      return _actors;
+    }
+
+    /// Sorted by time.
+    const std::vector<SummaryCollision> &GetCollisions() const {
+      return _collisions;
+    }
+
+    /// Sorted by actor and time.
+    const std::vector<SummaryPoint> &GetTrajectories() const {
+      return _points;
+    }
+
+    /// The actor with @a id alive at @a elapsed (or the last one before),
+    /// nullptr if none was added.
+    const SummaryActor *FindActor(uint32_t id, double elapsed) const;
+
+    /// Actors that stayed within @a min_distance of the same place for at
+    /// least @a min_time seconds, longest first. Durations are accurate to
+    /// TrajectoryInterval.
+    std::vector<SummaryBlockedActor> FindBlocked(double min_time, double min_distance) const;
+
+    /// Append the summary packet at the current position of @a out.
+    void Write(std::ostream &out) const;
+
+    /// Load the summary from a file ending with a frame index, return false
+    /// if it has none. Changes the position of @a in.
+    bool Read(std::istream &in);
+
+  private:
+
+    friend class RecordingSummaryBuilder;
+
+    /// Sort the tables as documented above.
+    void Sort();
+
+    uint64_t _last_frame = 0u;
+
+    double _duration = 0.0;
+
+    std::vector<SummaryActor> _actors;
+
+    std::vector<SummaryCollision> _collisions;
+
+    std::vector<SummaryPoint> _points;
+  };
+
+  /// Builds the summary of a recording frame by frame. What is added between
+  /// two calls to FinishFrame belongs to the frame given to the second.
+  class RecordingSummaryBuilder {
+  public:
+
+    void Clear();
+
+    void AddActor(uint32_t id, uint8_t type, std::string description);
+
+    void RemoveActor(uint32_t id);
+
+    void AddCollision(uint32_t actor1, uint32_t actor2, bool is_actor1_hero, bool is_actor2_hero);
+
+    void AddPosition(uint32_t id, float x, float y, float z);
+
+    void FinishFrame(uint64_t frame, double elapsed);
+
+    /// Summary of the frames finished so far.
+    RecordingSummary Build() const;
+
+  private:
+
+    struct PairHash {
+      size_t operator()(const std::pair<uint32_t, uint32_t> &pair) const {
+        return (size_t(pair.first) << 32u) ^ size_t(pair.second);
+      }
+    };
+
+    using CollisionSet = std::unordered_set<std::pair<uint32_t, uint32_t>, PairHash>;
+
+    struct PendingActor {
+      uint32_t id;
+      uint8_t type;
+      std::string description;
+    };
+
+    struct Trajectory {
+      int64_t last_interval;
+      float last_sample[3];
+    };
+
+    RecordingSummary _summary;
+
+    /// Position in _summary._actors of the actors alive.
+    std::unordered_map<uint32_t, size_t> _alive;
+
+    std::unordered_map<uint32_t, Trajectory> _trajectories;
+
+    CollisionSet _previous_collisions;
+
+    CollisionSet _current_collisions;
+
+    /// @name Added since the last finished frame
+    /// @{
+
+    std::vector<PendingActor> _added;
+
+    std::vector<uint32_t> _removed;
+
+    std::vector<SummaryCollision> _collisions;
+
+    std::vector<SummaryPoint> _positions;
+
+    /// @}
+  };
+
+  /// Build the summary of the recorder file at @a path (plain or BlockFile)
+  /// from its frames, for files written without one. The file is split at
+  /// frame boundaries and parsed on @a worker_threads threads, all the
+  /// hardware concurrency if zero. Returns false if the file cannot be read
+  /// or is malformed.
+  bool ScanRecordingSummary(
+      const std::string &path,
+      RecordingSummary &summary,
+      size_t worker_threads = 0u);
+
+} // namespace recorder
+} // namespace carla
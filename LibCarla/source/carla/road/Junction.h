@@ -7,9 +7,12 @@
 #pragma once
 
 #include "carla/geom/BoundingBox.h"
+#include "carla/ListView.h"
 #include "carla/NonCopyable.h"
 #include "carla/road/RoadTypes.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -78,8 +81,13 @@ namespace road {
       return _road_conflicts.count(road_id) > 0;
     }
 
-    const std::unordered_set<RoadId> & GetConflictsOfRoad(RoadId road_id) const {
-      return _road_conflicts.at(road_id);
+    /// Roads of the junction passing closer than a lane width to @a road_id.
+    /// Precomputed when the map is built.
+    ListView<std::vector<RoadId>::const_iterator> GetConflictsOfRoad(RoadId road_id) const {
+      const auto &range = _road_conflicts.at(road_id);
+      return MakeListView(
+          _conflicting_roads.begin() + range.first,
+          _conflicting_roads.begin() + range.second);
     }
 
     const std::set<ContId>& GetControllers() const {
@@ -98,8 +106,35 @@ namespace road {
 
     std::set<ContId> _controllers;
 
-    std::unordered_map<RoadId, std::unordered_set<RoadId>>
-        _road_conflicts;
+    /// Packs the conflicts of each road into a single sorted array.
+    void SetRoadConflicts(
+        const std::unordered_map<RoadId, std::unordered_set<RoadId>> &conflicts) {
+      _road_conflicts.clear();
+      _conflicting_roads.clear();
+      std::vector<RoadId> roads;
+      size_t total = 0u;
+      for (const auto &pair : conflicts) {
+        roads.emplace_back(pair.first);
+        total += pair.second.size();
+      }
+      std::sort(roads.begin(), roads.end());
+      _road_conflicts.reserve(roads.size());
+      _conflicting_roads.reserve(total);
+      for (const auto road_id : roads) {
+        const auto &road_conflicts = conflicts.at(road_id);
+        const auto begin = static_cast<uint32_t>(_conflicting_roads.size());
+        _conflicting_roads.insert(_conflicting_roads.end(), road_conflicts.begin(), road_conflicts.end());
+        std::sort(_conflicting_roads.begin() + begin, _conflicting_roads.end());
+        _road_conflicts.emplace(
+            road_id,
+            std::make_pair(begin, static_cast<uint32_t>(_conflicting_roads.size())));
+      }
+    }
+
+    /// Range of _conflicting_roads holding the conflicts of each road.
+    std::unordered_map<RoadId, std::pair<uint32_t, uint32_t>> _road_conflicts;
+
+    std::vector<RoadId> _conflicting_roads;
 
     carla::geom::BoundingBox _bounding_box;
   };
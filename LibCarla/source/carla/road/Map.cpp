@@ -6,6 +6,7 @@
 
 #include "carla/road/Map.h"
 #include "carla/Exception.h"
+#include "carla/ParallelFor.h"
 #include "carla/geom/Math.h"
 #include "carla/road/MeshFactory.h"
 #include "carla/road/element/LaneCrossingCalculator.h"
@@ -765,42 +766,62 @@ namespace road {
         {max_corner.x, max_corner.y, max_corner.z});
     auto segments = _rtree.GetIntersections(box);
 
-    for (size_t i = 0; i < segments.size(); ++i){
-      auto &segment1 = segments[i];
-      auto waypoint1 = segment1.second.first;
-      JuncId junc_id1 = _data.GetRoad(waypoint1.road_id).GetJunctionId();
-      // only segments in the junction
-      if(junc_id1 != id){
+    // only segments in the junction
+    std::vector<std::pair<Segment2d, RoadId>> junction_segments;
+    junction_segments.reserve(segments.size());
+    for (auto &segment : segments) {
+      const auto &waypoint = segment.second.first;
+      if (_data.GetRoad(waypoint.road_id).GetJunctionId() != id) {
         continue;
       }
-      Segment2d seg1{{segment1.first.first.get<0>(), segment1.first.first.get<1>()},
-          {segment1.first.second.get<0>(), segment1.first.second.get<1>()}};
-      for (size_t j = i + 1; j < segments.size(); ++j){
-        auto &segment2 = segments[j];
-        auto waypoint2 = segment2.second.first;
-        JuncId junc_id2 = _data.GetRoad(waypoint2.road_id).GetJunctionId();
-        // only segments in the junction
-        if(junc_id2 != id){
+      junction_segments.emplace_back(
+          Segment2d{{segment.first.first.get<0>(), segment.first.first.get<1>()},
+              {segment.first.second.get<0>(), segment.first.second.get<1>()}},
+          waypoint.road_id);
+    }
+
+    // index the segments by their 2d envelope so each one is only compared
+    // against the segments closer than the conflict distance
+    const double conflict_distance = 2.0; // better to set distance to lanewidth
+    typedef boost::geometry::model::box<Point2d> Box2d;
+    typedef std::pair<Box2d, size_t> IndexedBox;
+    std::vector<IndexedBox> boxes;
+    boxes.reserve(junction_segments.size());
+    for (size_t i = 0; i < junction_segments.size(); ++i) {
+      Box2d envelope;
+      boost::geometry::envelope(junction_segments[i].first, envelope);
+      boxes.emplace_back(envelope, i);
+    }
+    const boost::geometry::index::rtree<IndexedBox, boost::geometry::index::quadratic<16>>
+        segment_index(boxes.begin(), boxes.end());
+
+    std::vector<IndexedBox> candidates;
+    for (size_t i = 0; i < junction_segments.size(); ++i) {
+      const auto &seg1 = junction_segments[i].first;
+      const auto road1 = junction_segments[i].second;
+      Box2d query = boxes[i].first;
+      query.min_corner().set<0>(query.min_corner().get<0>() - static_cast<float>(conflict_distance));
+      query.min_corner().set<1>(query.min_corner().get<1>() - static_cast<float>(conflict_distance));
+      query.max_corner().set<0>(query.max_corner().get<0>() + static_cast<float>(conflict_distance));
+      query.max_corner().set<1>(query.max_corner().get<1>() + static_cast<float>(conflict_distance));
+      candidates.clear();
+      segment_index.query(boost::geometry::index::intersects(query), std::back_inserter(candidates));
+      for (const auto &candidate : candidates) {
+        const size_t j = candidate.second;
+        const auto road2 = junction_segments[j].second;
+        // discard same road, and pairs already visited
+        if (j <= i || road1 == road2) {
           continue;
         }
-        // discard same road
-        if(waypoint1.road_id == waypoint2.road_id){
+        if (conflicts[road1].count(road2) > 0) {
           continue;
         }
-        Segment2d seg2{{segment2.first.first.get<0>(), segment2.first.first.get<1>()},
-            {segment2.first.second.get<0>(), segment2.first.second.get<1>()}};
-
-        double distance = boost::geometry::distance(seg1, seg2);
-        // better to set distance to lanewidth
-        if(distance > 2.0){
+        double distance = boost::geometry::distance(seg1, junction_segments[j].first);
+        if (distance > conflict_distance) {
           continue;
         }
-        if(conflicts[waypoint1.road_id].count(waypoint2.road_id) == 0){
-          conflicts[waypoint1.road_id].insert(waypoint2.road_id);
-        }
-        if(conflicts[waypoint2.road_id].count(waypoint1.road_id) == 0){
-          conflicts[waypoint2.road_id].insert(waypoint1.road_id);
-        }
+        conflicts[road1].insert(road2);
+        conflicts[road2].insert(road1);
       }
     }
     return conflicts;
@@ -1024,28 +1045,74 @@ namespace road {
     return out_mesh;
   }
 
+  /// Moves the meshes of @a mesh_lists into a single list keeping their
+  /// order.
+  static std::vector<std::unique_ptr<geom::Mesh>> FlattenMeshLists(
+      std::vector<std::vector<std::unique_ptr<geom::Mesh>>> &mesh_lists) {
+    size_t total = 0u;
+    for (auto &list : mesh_lists) {
+      total += list.size();
+    }
+    std::vector<std::unique_ptr<geom::Mesh>> result;
+    result.reserve(total);
+    for (auto &list : mesh_lists) {
+      result.insert(
+          result.end(),
+          std::make_move_iterator(list.begin()),
+          std::make_move_iterator(list.end()));
+    }
+    return result;
+  }
+
+  /// Appends @a meshes to @a out_mesh reserving the space once.
+  static void MergeMeshes(
+      geom::Mesh &out_mesh,
+      const std::vector<const geom::Mesh *> &meshes) {
+    size_t vertices_num = 0u;
+    size_t indexes_num = 0u;
+    size_t materials_num = 0u;
+    for (auto *mesh : meshes) {
+      vertices_num += mesh->GetVerticesNum();
+      indexes_num += mesh->GetIndexesNum();
+      materials_num += mesh->GetMaterials().size();
+    }
+    out_mesh.Reserve(vertices_num, indexes_num, materials_num);
+    for (auto *mesh : meshes) {
+      out_mesh += *mesh;
+    }
+  }
+
   std::vector<std::unique_ptr<geom::Mesh>> Map::GenerateChunkedMesh(
       const rpc::OpendriveGenerationParameters& params) const {
     geom::MeshFactory mesh_factory(params);
-    std::vector<std::unique_ptr<geom::Mesh>> out_mesh_list;
 
-    std::unordered_map<JuncId, geom::Mesh> junction_map;
+    // Every road, junction and chunk is generated independently by the worker
+    // threads into its own slot. Slots are merged in the same order the
+    // serial loops would produce, so the result does not depend on the
+    // scheduling.
+    std::vector<const Road *> roads;
     for (auto &&pair : _data.GetRoads()) {
       const auto &road = pair.second;
       if (!road.IsJunction()) {
-        std::vector<std::unique_ptr<geom::Mesh>> road_mesh_list =
-            mesh_factory.GenerateAllWithMaxLen(road);
-
-        out_mesh_list.insert(
-            out_mesh_list.end(),
-            std::make_move_iterator(road_mesh_list.begin()),
-            std::make_move_iterator(road_mesh_list.end()));
+        roads.emplace_back(&road);
       }
     }
+    std::vector<const Junction *> junctions;
+    for (auto &&pair : _data.GetJunctions()) {
+      junctions.emplace_back(&pair.second);
+    }
 
-    // Generate roads within junctions and smooth them
-    for (const auto &junc_pair : _data.GetJunctions()) {
-      const auto &junction = junc_pair.second;
+    std::vector<std::vector<std::unique_ptr<geom::Mesh>>> mesh_lists(
+        roads.size() + junctions.size());
+
+    ParallelFor(mesh_lists.size(), [&](size_t i) {
+      if (i < roads.size()) {
+        mesh_lists[i] = mesh_factory.GenerateAllWithMaxLen(*roads[i]);
+        return;
+      }
+
+      // Generate roads within junctions and smooth them
+      const auto &junction = *junctions[i - roads.size()];
       std::vector<std::unique_ptr<geom::Mesh>> lane_meshes;
       std::vector<std::unique_ptr<geom::Mesh>> sidewalk_lane_meshes;
       for(const auto &connection_pair : junction.GetConnections()) {
@@ -1062,23 +1129,27 @@ namespace road {
           }
         }
       }
+      std::vector<const geom::Mesh *> sidewalks;
+      for(auto& lane : sidewalk_lane_meshes) {
+        sidewalks.emplace_back(lane.get());
+      }
       if(params.smooth_junctions) {
         auto merged_mesh = mesh_factory.MergeAndSmooth(lane_meshes);
-        for(auto& lane : sidewalk_lane_meshes) {
-          *merged_mesh += *lane;
-        }
-        out_mesh_list.push_back(std::move(merged_mesh));
+        MergeMeshes(*merged_mesh, sidewalks);
+        mesh_lists[i].push_back(std::move(merged_mesh));
       } else {
-        std::unique_ptr<geom::Mesh> junction_mesh = std::make_unique<geom::Mesh>();
+        std::vector<const geom::Mesh *> lanes;
         for(auto& lane : lane_meshes) {
-          *junction_mesh += *lane;
-        }
-        for(auto& lane : sidewalk_lane_meshes) {
-          *junction_mesh += *lane;
+          lanes.emplace_back(lane.get());
         }
-        out_mesh_list.push_back(std::move(junction_mesh));
+        lanes.insert(lanes.end(), sidewalks.begin(), sidewalks.end());
+        std::unique_ptr<geom::Mesh> junction_mesh = std::make_unique<geom::Mesh>();
+        MergeMeshes(*junction_mesh, lanes);
+        mesh_lists[i].push_back(std::move(junction_mesh));
       }
-    }
+    });
+
+    const auto out_mesh_list = FlattenMeshLists(mesh_lists);
 
     auto min_pos = geom::Vector2D(
         out_mesh_list.front()->GetVertices().front().x,
@@ -1093,17 +1164,20 @@ namespace road {
     }
     size_t mesh_amount_x = static_cast<size_t>((max_pos.x - min_pos.x)/params.max_road_length) + 1;
     size_t mesh_amount_y = static_cast<size_t>((max_pos.y - min_pos.y)/params.max_road_length) + 1;
-    std::vector<std::unique_ptr<geom::Mesh>> result;
-    result.reserve(mesh_amount_x*mesh_amount_y);
-    for (size_t i = 0; i < mesh_amount_x*mesh_amount_y; ++i) {
-      result.emplace_back(std::make_unique<geom::Mesh>());
-    }
+
+    // Assign each mesh to its chunk first, then merge the chunks in parallel.
+    std::vector<std::vector<const geom::Mesh *>> chunks(mesh_amount_x*mesh_amount_y);
     for (auto & mesh : out_mesh_list) {
       auto vertex = mesh->GetVertices().front();
       size_t x_pos = static_cast<size_t>((vertex.x - min_pos.x) / params.max_road_length);
       size_t y_pos = static_cast<size_t>((vertex.y - min_pos.y) / params.max_road_length);
-      *(result[x_pos + mesh_amount_x*y_pos]) += *mesh;
+      chunks[x_pos + mesh_amount_x*y_pos].emplace_back(mesh.get());
     }
+    std::vector<std::unique_ptr<geom::Mesh>> result(chunks.size());
+    ParallelFor(chunks.size(), [&](size_t i) {
+      result[i] = std::make_unique<geom::Mesh>();
+      MergeMeshes(*result[i], chunks[i]);
+    });
 
     return result;
   }
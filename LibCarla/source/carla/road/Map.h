@@ -181,6 +181,7 @@ namespace road {
 private:
 
     friend MapBuilder;
+    friend class RoutingGraph;
     MapData _data;
 
     using Rtree = geom::SegmentCloudRtree<Waypoint>;
@@ -4,6 +4,7 @@
 // This work is licensed under the terms of the MIT license.
 // For a copy, see <https://opensource.org/licenses/MIT>.
 
+#include "carla/ParallelFor.h"
 #include "carla/StringUtil.h"
 #include "carla/road/MapBuilder.h"
 #include "carla/road/element/RoadInfoElevation.h"
@@ -932,10 +933,18 @@ void MapBuilder::CreateController(
 }
 
   void MapBuilder::ComputeJunctionRoadConflicts(Map &map) {
+    // Junctions are independent, each task only reads the map and writes
+    // the table of its own junction.
+    std::vector<Junction *> junctions;
+    junctions.reserve(map._data.GetJunctions().size());
     for (auto &junctionpair : map._data.GetJunctions()) {
-      auto& junction = junctionpair.second;
-      junction._road_conflicts = (map.ComputeJunctionConflicts(junction.GetId()));
+      junctions.emplace_back(&junctionpair.second);
     }
+    const Map &const_map = map;
+    ParallelFor(junctions.size(), [&](size_t i) {
+      auto &junction = *junctions[i];
+      junction.SetRoadConflicts(const_map.ComputeJunctionConflicts(junction.GetId()));
+    });
   }
 
   void MapBuilder::GenerateDefaultValiditiesForSignalReferences() {
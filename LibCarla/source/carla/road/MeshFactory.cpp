@@ -26,12 +26,35 @@ namespace geom {
   static constexpr double EPSILON = 10.0 * std::numeric_limits<double>::epsilon();
   static constexpr double MESH_EPSILON = 50.0 * std::numeric_limits<double>::epsilon();
 
+  /// Upper bound of the number of vertices of a strip generated along
+  /// [s_start, s_end], two per sample plus the closing pair.
+  static size_t EstimateStripVertices(
+      const road::Lane &lane,
+      const double s_start,
+      const double s_end,
+      const float resolution) {
+    if (lane.IsStraight()) {
+      return 4u;
+    }
+    return 2u * (static_cast<size_t>((s_end - s_start) / resolution) + 2u);
+  }
+
+  /// Reserves @a mesh and @a vertices for a single strip of
+  /// @a vertices_num vertices.
+  static void ReserveStrip(
+      Mesh &mesh,
+      std::vector<geom::Vector3D> &vertices,
+      const size_t vertices_num) {
+    vertices.reserve(vertices_num);
+    mesh.Reserve(vertices_num, 3u * vertices_num, 1u);
+  }
+
   std::unique_ptr<Mesh> MeshFactory::Generate(const road::Road &road) const {
     Mesh out_mesh;
     for (auto &&lane_section : road.GetLaneSections()) {
       out_mesh += *Generate(lane_section);
     }
-    return std::make_unique<Mesh>(out_mesh);
+    return std::make_unique<Mesh>(std::move(out_mesh));
   }
 
   std::unique_ptr<Mesh> MeshFactory::Generate(const road::LaneSection &lane_section) const {
@@ -39,7 +62,7 @@ namespace geom {
     for (auto &&lane_pair : lane_section.GetLanes()) {
       out_mesh += *Generate(lane_pair.second);
     }
-    return std::make_unique<Mesh>(out_mesh);
+    return std::make_unique<Mesh>(std::move(out_mesh));
   }
 
   std::unique_ptr<Mesh> MeshFactory::Generate(const road::Lane &lane) const {
@@ -58,11 +81,15 @@ namespace geom {
     // The lane with lane_id 0 have no physical representation in OpenDRIVE
     Mesh out_mesh;
     if (lane.GetId() == 0) {
-      return std::make_unique<Mesh>(out_mesh);
+      return std::make_unique<Mesh>(std::move(out_mesh));
     }
     double s_current = s_start;
 
     std::vector<geom::Vector3D> vertices;
+    ReserveStrip(
+        out_mesh,
+        vertices,
+        EstimateStripVertices(lane, s_start, s_end, road_param.resolution));
     if (lane.IsStraight()) {
       // Mesh optimization: If the lane is straight just add vertices at the
       // begining and at the end of it
@@ -95,7 +122,7 @@ namespace geom {
         lane.GetType() == road::Lane::LaneType::Sidewalk ? "sidewalk" : "road");
     out_mesh.AddTriangleStrip(vertices);
     out_mesh.EndMaterial();
-    return std::make_unique<Mesh>(out_mesh);
+    return std::make_unique<Mesh>(std::move(out_mesh));
   }
 
   std::unique_ptr<Mesh> MeshFactory::GenerateWalls(const road::LaneSection &lane_section) const {
@@ -117,7 +144,7 @@ namespace geom {
         out_mesh += *GenerateRightWall(lane, s_start, s_end);
       }
     }
-    return std::make_unique<Mesh>(out_mesh);
+    return std::make_unique<Mesh>(std::move(out_mesh));
   }
 
   std::unique_ptr<Mesh> MeshFactory::GenerateRightWall(
@@ -130,12 +157,16 @@ namespace geom {
     // The lane with lane_id 0 have no physical representation in OpenDRIVE
     Mesh out_mesh;
     if (lane.GetId() == 0) {
-      return std::make_unique<Mesh>(out_mesh);
+      return std::make_unique<Mesh>(std::move(out_mesh));
     }
     double s_current = s_start;
     const geom::Vector3D height_vector = geom::Vector3D(0.f, 0.f, road_param.wall_height);
 
     std::vector<geom::Vector3D> r_vertices;
+    ReserveStrip(
+        out_mesh,
+        r_vertices,
+        EstimateStripVertices(lane, s_start, s_end, road_param.resolution));
     if (lane.IsStraight()) {
       // Mesh optimization: If the lane is straight just add vertices at the
       // begining and at the end of it
@@ -168,7 +199,7 @@ namespace geom {
         lane.GetType() == road::Lane::LaneType::Sidewalk ? "sidewalk" : "road");
     out_mesh.AddTriangleStrip(r_vertices);
     out_mesh.EndMaterial();
-    return std::make_unique<Mesh>(out_mesh);
+    return std::make_unique<Mesh>(std::move(out_mesh));
   }
 
   std::unique_ptr<Mesh> MeshFactory::GenerateLeftWall(
@@ -181,12 +212,16 @@ namespace geom {
     // The lane with lane_id 0 have no physical representation in OpenDRIVE
     Mesh out_mesh;
     if (lane.GetId() == 0) {
-      return std::make_unique<Mesh>(out_mesh);
+      return std::make_unique<Mesh>(std::move(out_mesh));
     }
     double s_current = s_start;
     const geom::Vector3D height_vector = geom::Vector3D(0.f, 0.f, road_param.wall_height);
 
     std::vector<geom::Vector3D> l_vertices;
+    ReserveStrip(
+        out_mesh,
+        l_vertices,
+        EstimateStripVertices(lane, s_start, s_end, road_param.resolution));
     if (lane.IsStraight()) {
       // Mesh optimization: If the lane is straight just add vertices at the
       // begining and at the end of it
@@ -219,7 +254,7 @@ namespace geom {
         lane.GetType() == road::Lane::LaneType::Sidewalk ? "sidewalk" : "road");
     out_mesh.AddTriangleStrip(l_vertices);
     out_mesh.EndMaterial();
-    return std::make_unique<Mesh>(out_mesh);
+    return std::make_unique<Mesh>(std::move(out_mesh));
   }
 
   std::vector<std::unique_ptr<Mesh>> MeshFactory::GenerateWithMaxLen(
@@ -249,7 +284,7 @@ namespace geom {
         for (auto &&lane_pair : lane_section.GetLanes()) {
           lane_section_mesh += *Generate(lane_pair.second, s_current, s_until);
         }
-        mesh_uptr_list.emplace_back(std::make_unique<Mesh>(lane_section_mesh));
+        mesh_uptr_list.emplace_back(std::make_unique<Mesh>(std::move(lane_section_mesh)));
         s_current = s_until;
       }
       if (s_end - s_current > EPSILON) {
@@ -257,7 +292,7 @@ namespace geom {
         for (auto &&lane_pair : lane_section.GetLanes()) {
           lane_section_mesh += *Generate(lane_pair.second, s_current, s_end);
         }
-        mesh_uptr_list.emplace_back(std::make_unique<Mesh>(lane_section_mesh));
+        mesh_uptr_list.emplace_back(std::make_unique<Mesh>(std::move(lane_section_mesh)));
       }
     }
     return mesh_uptr_list;
@@ -302,7 +337,7 @@ namespace geom {
             lane_section_mesh += *GenerateRightWall(lane, s_current, s_until);
           }
         }
-        mesh_uptr_list.emplace_back(std::make_unique<Mesh>(lane_section_mesh));
+        mesh_uptr_list.emplace_back(std::make_unique<Mesh>(std::move(lane_section_mesh)));
         s_current = s_until;
       }
       if (s_end - s_current > EPSILON) {
@@ -316,7 +351,7 @@ namespace geom {
             lane_section_mesh += *GenerateRightWall(lane, s_current, s_end);
           }
         }
-        mesh_uptr_list.emplace_back(std::make_unique<Mesh>(lane_section_mesh));
+        mesh_uptr_list.emplace_back(std::make_unique<Mesh>(std::move(lane_section_mesh)));
       }
     }
     return mesh_uptr_list;
@@ -415,6 +450,7 @@ namespace geom {
 
     // Find neighbors for each vertex and compute their weight
     std::vector<VertexNeighbors> vertices_neighborhoods;
+    vertices_neighborhoods.reserve(rtree.GetTreeSize());
     for (size_t lane_mesh_idx = 0; lane_mesh_idx < lane_meshes.size(); ++lane_mesh_idx) {
       auto& mesh = lane_meshes[lane_mesh_idx];
       for(size_t i = 0; i < mesh->GetVerticesNum(); ++i) {
@@ -469,11 +505,20 @@ namespace geom {
       }
     }
 
+    size_t vertices_num = 0u;
+    size_t indexes_num = 0u;
+    size_t materials_num = 0u;
+    for(auto &mesh : lane_meshes) {
+      vertices_num += mesh->GetVerticesNum();
+      indexes_num += mesh->GetIndexesNum();
+      materials_num += mesh->GetMaterials().size();
+    }
+    out_mesh.Reserve(vertices_num, indexes_num, materials_num);
     for(auto &mesh : lane_meshes) {
       out_mesh += *mesh;
     }
 
-    return std::make_unique<Mesh>(out_mesh);
+    return std::make_unique<Mesh>(std::move(out_mesh));
   }
 
 } // namespace geom
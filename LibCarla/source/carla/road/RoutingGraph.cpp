@@ -0,0 +1,747 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/road/RoutingGraph.h"
+
+#include "carla/Debug.h"
+#include "carla/geom/Math.h"
+#include "carla/road/Map.h"
+#include "carla/road/element/RoadInfoMarkRecord.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace carla {
+namespace road {
+
+  using element::RoadInfoMarkRecord;
+  using NodeId = RoutingGraph::NodeId;
+
+  constexpr NodeId RoutingGraph::InvalidNode;
+
+  static constexpr double EPSILON = 10.0 * std::numeric_limits<double>::epsilon();
+
+  static constexpr double INF = std::numeric_limits<double>::infinity();
+
+  /// Maximum number of nodes settled by each witness search during the
+  /// contraction. Missing a witness only adds a redundant shortcut.
+  static constexpr size_t MAX_WITNESS_SETTLED = 500u;
+
+  static uint64_t MakeLaneKey(RoadId road_id, SectionId section_id, LaneId lane_id) {
+    return (static_cast<uint64_t>(road_id) << 32u) |
+        (static_cast<uint64_t>(section_id & 0xFFFFu) << 16u) |
+        static_cast<uint64_t>(static_cast<uint16_t>(lane_id));
+  }
+
+  static bool IsDrivable(const Lane &lane) {
+    return lane.GetId() != 0 &&
+        (static_cast<uint32_t>(lane.GetType()) & static_cast<uint32_t>(Lane::LaneType::Driving)) > 0;
+  }
+
+  /// Whether the road marks allow moving from @a from to the adjacent lane
+  /// @a to. The mark between two lanes belongs to the inner one.
+  static bool IsLaneChangeAllowed(const Lane &from, const Lane &to, double s) {
+    const Lane &inner = std::abs(from.GetId()) < std::abs(to.GetId()) ? from : to;
+    const auto *mark = inner.GetInfo<RoadInfoMarkRecord>(s);
+    if (mark == nullptr) {
+      return true;
+    }
+    const auto required = to.GetId() > from.GetId() ?
+        RoadInfoMarkRecord::LaneChange::Increase :
+        RoadInfoMarkRecord::LaneChange::Decrease;
+    return (static_cast<uint8_t>(mark->GetLaneChange()) & static_cast<uint8_t>(required)) > 0;
+  }
+
+  using QueueItem = std::pair<double, NodeId>;
+
+  using MinQueue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+  // ===========================================================================
+  // -- Search helpers ---------------------------------------------------------
+  // ===========================================================================
+
+  /// A node the search starts from. Searches leave the origin lane, or one of
+  /// the lanes reachable from it changing lanes at the origin, through one of
+  /// its successors.
+  struct RoutingGraph::Seed {
+    NodeId node;
+    double cost;
+    NodeId lane;
+  };
+
+  struct RoutingGraph::SearchResult {
+    double cost = INF;
+    /// Lane the route leaves the origin from.
+    NodeId lane = InvalidNode;
+    /// Nodes from the seed to the target.
+    std::vector<NodeId> path;
+  };
+
+  /// Lanes reachable from the origin changing lanes at the origin itself,
+  /// with their cost and the lane they were reached from.
+  struct LaneChangeClosure {
+    std::vector<NodeId> lanes;
+    std::vector<NodeId> parents;
+    std::vector<double> costs;
+
+    size_t Find(NodeId node) const {
+      const auto it = std::find(lanes.begin(), lanes.end(), node);
+      return static_cast<size_t>(it - lanes.begin());
+    }
+  };
+
+  // ===========================================================================
+  // -- Constructor ------------------------------------------------------------
+  // ===========================================================================
+
+  RoutingGraph::RoutingGraph(const Map &map, RoutingParameters parameters)
+    : _parameters(std::move(parameters)) {
+    Build(map);
+    if (_parameters.contraction_hierarchy) {
+      BuildContractionHierarchy();
+    }
+  }
+
+  boost::optional<NodeId> RoutingGraph::GetNode(const Waypoint &waypoint) const {
+    const auto it = _node_index.find(
+        MakeLaneKey(waypoint.road_id, waypoint.section_id, waypoint.lane_id));
+    if (it == _node_index.end()) {
+      return {};
+    }
+    return it->second;
+  }
+
+  double RoutingGraph::GetProgress(const Waypoint &waypoint) const {
+    const auto node = *GetNode(waypoint);
+    const double start = _lane_start[node];
+    const double length = _lane_length[node];
+    const double progress = waypoint.lane_id <= 0 ?
+        waypoint.s - start :
+        start + length - waypoint.s;
+    return std::min(std::max(progress, 0.0), length);
+  }
+
+  // ===========================================================================
+  // -- Graph construction -----------------------------------------------------
+  // ===========================================================================
+
+  void RoutingGraph::Build(const Map &map) {
+    // Visit the roads in id order so the node numbering does not depend on
+    // the hash map layout.
+    std::vector<const Road *> roads;
+    roads.reserve(map._data.GetRoads().size());
+    for (const auto &pair : map._data.GetRoads()) {
+      roads.emplace_back(&pair.second);
+    }
+    std::sort(roads.begin(), roads.end(), [](const Road *lhs, const Road *rhs) {
+      return lhs->GetId() < rhs->GetId();
+    });
+
+    std::vector<const Lane *> lanes;
+    for (const auto *road : roads) {
+      for (const auto &section : road->GetLaneSections()) {
+        for (const auto &pair : section.GetLanes()) {
+          const auto &lane = pair.second;
+          if (!IsDrivable(lane)) {
+            continue;
+          }
+          const auto node = static_cast<NodeId>(_nodes.size());
+          const double start = lane.GetDistance();
+          const double length = lane.GetLength();
+          Waypoint waypoint{
+              road->GetId(),
+              section.GetId(),
+              lane.GetId(),
+              lane.GetId() <= 0 ? start + 10.0 * EPSILON : start + length - 10.0 * EPSILON};
+          _nodes.emplace_back(waypoint);
+          _lane_start.emplace_back(start);
+          _lane_length.emplace_back(length);
+          _locations.emplace_back(map.ComputeTransform(waypoint).location);
+          _node_index.emplace(MakeLaneKey(road->GetId(), section.GetId(), lane.GetId()), node);
+          lanes.emplace_back(&lane);
+        }
+      }
+    }
+
+    auto find_node = [this](const Lane &lane) -> NodeId {
+      const auto it = _node_index.find(MakeLaneKey(
+          lane.GetRoad()->GetId(),
+          lane.GetLaneSection()->GetId(),
+          lane.GetId()));
+      return it != _node_index.end() ? it->second : InvalidNode;
+    };
+
+    _offsets.reserve(_nodes.size() + 1u);
+    _offsets.emplace_back(0u);
+    for (NodeId node = 0u; node < _nodes.size(); ++node) {
+      const Lane &lane = *lanes[node];
+      const auto begin = _targets.size();
+      auto add_edge = [&](NodeId target, double weight, bool lane_change) {
+        // Keep a single edge per target, the cheapest one.
+        for (auto i = begin; i < _targets.size(); ++i) {
+          if (_targets[i] == target) {
+            _weights[i] = std::min(_weights[i], static_cast<float>(weight));
+            return;
+          }
+        }
+        _targets.emplace_back(target);
+        _weights.emplace_back(static_cast<float>(weight));
+        _is_lane_change.emplace_back(lane_change ? 1u : 0u);
+      };
+
+      for (const auto *next_lane : lane.GetNextLanes()) {
+        DEBUG_ASSERT(next_lane != nullptr);
+        const auto target = find_node(*next_lane);
+        if (target != InvalidNode) {
+          add_edge(target, _lane_length[node], false);
+        }
+      }
+
+      // Lane changes to the neighbours driving in the same direction.
+      if (!lane.GetRoad()->IsJunction()) {
+        const auto id = lane.GetId();
+        const double middle_s = _lane_start[node] + 0.5 * _lane_length[node];
+        for (const auto neighbour_id : {id - 1, id + 1}) {
+          if (neighbour_id == 0 || (neighbour_id > 0) != (id > 0)) {
+            continue;
+          }
+          const auto *neighbour = lane.GetLaneSection()->GetLane(neighbour_id);
+          if (neighbour == nullptr || !IsDrivable(*neighbour) ||
+              !IsLaneChangeAllowed(lane, *neighbour, middle_s)) {
+            continue;
+          }
+          add_edge(find_node(*neighbour), _parameters.lane_change_cost, true);
+        }
+      }
+      _offsets.emplace_back(static_cast<uint32_t>(_targets.size()));
+    }
+
+    // Scale the euclidean heuristic so it never overestimates an edge, which
+    // keeps it consistent and A* optimal.
+    _heuristic_scale = 1.0;
+    for (NodeId node = 0u; node < _nodes.size(); ++node) {
+      for (auto i = _offsets[node]; i < _offsets[node + 1u]; ++i) {
+        const double distance = geom::Math::Distance(_locations[node], _locations[_targets[i]]);
+        if (distance > 0.0) {
+          _heuristic_scale = std::min(_heuristic_scale, _weights[i] / distance);
+        }
+      }
+    }
+    _heuristic_scale = std::max(0.0, _heuristic_scale * (1.0 - 1e-6));
+  }
+
+  // ===========================================================================
+  // -- Contraction hierarchy --------------------------------------------------
+  // ===========================================================================
+
+  namespace {
+
+    struct DynamicEdge {
+      NodeId node;
+      float weight;
+    };
+
+    class Contractor {
+    public:
+
+      Contractor(size_t size, std::unordered_map<uint64_t, NodeId> &shortcuts)
+        : _out(size),
+          _in(size),
+          _contracted(size, 0u),
+          _shortcuts(shortcuts) {}
+
+      /// Insert the edge or lower the weight of the existing one. @a middle
+      /// is the contracted node a shortcut bypasses.
+      void AddEdge(NodeId from, NodeId to, float weight, NodeId middle) {
+        auto &out = _out[from];
+        auto it = std::find_if(out.begin(), out.end(), [to](const DynamicEdge &edge) {
+          return edge.node == to;
+        });
+        if (it != out.end()) {
+          if (it->weight <= weight) {
+            return;
+          }
+          it->weight = weight;
+          for (auto &edge : _in[to]) {
+            if (edge.node == from) {
+              edge.weight = weight;
+            }
+          }
+        } else {
+          out.push_back({to, weight});
+          _in[to].push_back({from, weight});
+        }
+        const auto key = (static_cast<uint64_t>(from) << 32u) | to;
+        if (middle == RoutingGraph::InvalidNode) {
+          _shortcuts.erase(key);
+        } else {
+          _shortcuts[key] = middle;
+        }
+      }
+
+      /// Shortcuts required to contract @a node. If @a apply is false they are
+      /// only counted.
+      int Contract(NodeId node, bool apply) {
+        int count = 0;
+        for (const auto &in : _in[node]) {
+          if (_contracted[in.node] || in.node == node) {
+            continue;
+          }
+          double max_cost = 0.0;
+          for (const auto &out : _out[node]) {
+            if (!_contracted[out.node] && out.node != in.node) {
+              max_cost = std::max(max_cost, static_cast<double>(in.weight) + out.weight);
+            }
+          }
+          if (max_cost == 0.0) {
+            continue;
+          }
+          WitnessSearch(in.node, node, max_cost);
+          for (const auto &out : _out[node]) {
+            if (_contracted[out.node] || out.node == in.node || out.node == node) {
+              continue;
+            }
+            const float cost = in.weight + out.weight;
+            const auto it = _witness.find(out.node);
+            if (it != _witness.end() && it->second <= cost) {
+              continue;
+            }
+            ++count;
+            if (apply) {
+              AddEdge(in.node, out.node, cost, node);
+            }
+          }
+        }
+        if (apply) {
+          _contracted[node] = 1u;
+        }
+        return count;
+      }
+
+      int Priority(NodeId node, const std::vector<int> &contracted_neighbours) {
+        int degree = 0;
+        for (const auto &edge : _in[node]) {
+          degree += _contracted[edge.node] ? 0 : 1;
+        }
+        for (const auto &edge : _out[node]) {
+          degree += _contracted[edge.node] ? 0 : 1;
+        }
+        return 2 * Contract(node, false) - degree + contracted_neighbours[node];
+      }
+
+      const std::vector<std::vector<DynamicEdge>> &GetOutEdges() const {
+        return _out;
+      }
+
+      const std::vector<std::vector<DynamicEdge>> &GetInEdges() const {
+        return _in;
+      }
+
+    private:
+
+      /// Bounded Dijkstra from @a source skipping @a excluded and the
+      /// contracted nodes. Distances end up in _witness.
+      void WitnessSearch(NodeId source, NodeId excluded, double max_cost) {
+        _witness.clear();
+        MinQueue queue;
+        _witness[source] = 0.0f;
+        queue.emplace(0.0, source);
+        size_t settled = 0u;
+        while (!queue.empty() && settled < MAX_WITNESS_SETTLED) {
+          const auto top = queue.top();
+          queue.pop();
+          if (top.first > _witness[top.second]) {
+            continue;
+          }
+          if (top.first > max_cost) {
+            break;
+          }
+          ++settled;
+          for (const auto &edge : _out[top.second]) {
+            if (edge.node == excluded || _contracted[edge.node]) {
+              continue;
+            }
+            const float cost = static_cast<float>(top.first) + edge.weight;
+            auto it = _witness.find(edge.node);
+            if (it == _witness.end() || cost < it->second) {
+              _witness[edge.node] = cost;
+              queue.emplace(cost, edge.node);
+            }
+          }
+        }
+      }
+
+      std::vector<std::vector<DynamicEdge>> _out;
+
+      std::vector<std::vector<DynamicEdge>> _in;
+
+      std::vector<uint8_t> _contracted;
+
+      std::unordered_map<NodeId, float> _witness;
+
+      std::unordered_map<uint64_t, NodeId> &_shortcuts;
+    };
+
+  } // namespace
+
+  void RoutingGraph::BuildContractionHierarchy() {
+    const auto size = _nodes.size();
+    Contractor contractor(size, _shortcuts);
+    for (NodeId node = 0u; node < size; ++node) {
+      for (auto i = _offsets[node]; i < _offsets[node + 1u]; ++i) {
+        if (_targets[i] != node) {
+          contractor.AddEdge(node, _targets[i], _weights[i], InvalidNode);
+        }
+      }
+    }
+
+    // Contract in order of edge difference, plus the number of contracted
+    // neighbours and the depth to spread the contraction evenly. Neighbours
+    // are updated after each contraction, the rest lazily.
+    std::vector<int> contracted_neighbours(size, 0);
+    std::vector<int> priorities(size, 0);
+    using PriorityItem = std::pair<int, NodeId>;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem>> queue;
+    for (NodeId node = 0u; node < size; ++node) {
+      priorities[node] = contractor.Priority(node, contracted_neighbours);
+      queue.emplace(priorities[node], node);
+    }
+    std::vector<NodeId> rank(size, InvalidNode);
+    NodeId next_rank = 0u;
+    while (!queue.empty()) {
+      const auto top = queue.top();
+      queue.pop();
+      const auto node = top.second;
+      if (rank[node] != InvalidNode || top.first != priorities[node]) {
+        continue;
+      }
+      priorities[node] = contractor.Priority(node, contracted_neighbours);
+      if (!queue.empty() && priorities[node] > queue.top().first) {
+        queue.emplace(priorities[node], node);
+        continue;
+      }
+      contractor.Contract(node, true);
+      rank[node] = next_rank++;
+      std::vector<NodeId> neighbours;
+      for (const auto &edge : contractor.GetOutEdges()[node]) {
+        neighbours.emplace_back(edge.node);
+      }
+      for (const auto &edge : contractor.GetInEdges()[node]) {
+        neighbours.emplace_back(edge.node);
+      }
+      std::sort(neighbours.begin(), neighbours.end());
+      neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+      for (const auto neighbour : neighbours) {
+        if (rank[neighbour] == InvalidNode) {
+          contracted_neighbours[neighbour] = std::max(
+              contracted_neighbours[neighbour] + 1,
+              contracted_neighbours[node] + 1);
+          priorities[neighbour] = contractor.Priority(neighbour, contracted_neighbours);
+          queue.emplace(priorities[neighbour], neighbour);
+        }
+      }
+    }
+
+    // Flatten into upward and downward CSR arrays.
+    const auto &out_edges = contractor.GetOutEdges();
+    std::vector<uint32_t> down_count(size + 1u, 0u);
+    _up_offsets.reserve(size + 1u);
+    _up_offsets.emplace_back(0u);
+    for (NodeId node = 0u; node < size; ++node) {
+      for (const auto &edge : out_edges[node]) {
+        if (rank[edge.node] > rank[node]) {
+          _up_targets.emplace_back(edge.node);
+          _up_weights.emplace_back(edge.weight);
+        } else {
+          ++down_count[edge.node + 1u];
+        }
+      }
+      _up_offsets.emplace_back(static_cast<uint32_t>(_up_targets.size()));
+    }
+    for (size_t i = 1u; i <= size; ++i) {
+      down_count[i] += down_count[i - 1u];
+    }
+    _down_offsets = down_count;
+    _down_targets.resize(_down_offsets.back());
+    _down_weights.resize(_down_offsets.back());
+    for (NodeId node = 0u; node < size; ++node) {
+      for (const auto &edge : out_edges[node]) {
+        if (rank[edge.node] < rank[node]) {
+          const auto index = down_count[edge.node]++;
+          _down_targets[index] = node;
+          _down_weights[index] = edge.weight;
+        }
+      }
+    }
+  }
+
+  // ===========================================================================
+  // -- Queries ----------------------------------------------------------------
+  // ===========================================================================
+
+  RoutingGraph::SearchResult RoutingGraph::SearchAStar(
+      const std::vector<Seed> &seeds,
+      const NodeId target) const {
+    const auto size = _nodes.size();
+    std::vector<double> cost(size, INF);
+    std::vector<NodeId> parent(size, InvalidNode);
+    std::vector<uint8_t> closed(size, 0u);
+    std::unordered_map<NodeId, NodeId> seed_lanes;
+    const auto &goal = _locations[target];
+    auto heuristic = [&](NodeId node) {
+      return _heuristic_scale * geom::Math::Distance(_locations[node], goal);
+    };
+
+    MinQueue queue;
+    for (const auto &seed : seeds) {
+      if (seed.cost < cost[seed.node]) {
+        cost[seed.node] = seed.cost;
+        seed_lanes[seed.node] = seed.lane;
+        queue.emplace(seed.cost + heuristic(seed.node), seed.node);
+      }
+    }
+
+    SearchResult result;
+    while (!queue.empty()) {
+      const auto node = queue.top().second;
+      queue.pop();
+      if (closed[node]) {
+        continue;
+      }
+      closed[node] = 1u;
+      if (node == target) {
+        result.cost = cost[node];
+        break;
+      }
+      for (auto i = _offsets[node]; i < _offsets[node + 1u]; ++i) {
+        const auto next = _targets[i];
+        const double next_cost = cost[node] + _weights[i];
+        if (next_cost < cost[next]) {
+          cost[next] = next_cost;
+          parent[next] = node;
+          queue.emplace(next_cost + heuristic(next), next);
+        }
+      }
+    }
+    if (result.cost == INF) {
+      return result;
+    }
+    for (auto node = target; node != InvalidNode; node = parent[node]) {
+      result.path.emplace_back(node);
+      if (parent[node] == InvalidNode) {
+        result.lane = seed_lanes[node];
+      }
+    }
+    std::reverse(result.path.begin(), result.path.end());
+    return result;
+  }
+
+  RoutingGraph::SearchResult RoutingGraph::SearchContractionHierarchy(
+      const std::vector<Seed> &seeds,
+      const NodeId target,
+      const double target_progress) const {
+    const auto size = _nodes.size();
+    std::vector<double> forward(size, INF);
+    std::vector<double> backward(size, INF);
+    std::vector<NodeId> forward_parent(size, InvalidNode);
+    std::vector<NodeId> backward_parent(size, InvalidNode);
+    std::unordered_map<NodeId, NodeId> seed_lanes;
+    MinQueue forward_queue;
+    MinQueue backward_queue;
+
+    for (const auto &seed : seeds) {
+      if (seed.cost < forward[seed.node]) {
+        forward[seed.node] = seed.cost;
+        seed_lanes[seed.node] = seed.lane;
+        forward_queue.emplace(seed.cost, seed.node);
+      }
+    }
+    backward[target] = target_progress;
+    backward_queue.emplace(target_progress, target);
+
+    double best = INF;
+    NodeId meeting = InvalidNode;
+
+    // Settle the next node of one direction. Nodes reached cheaper through a
+    // higher ranked node of the opposite graph cannot be on a shortest path
+    // and are not expanded (stall-on-demand).
+    auto step = [&](MinQueue &queue,
+                    std::vector<double> &cost,
+                    std::vector<NodeId> &parent,
+                    const std::vector<double> &other,
+                    const std::vector<uint32_t> &offsets,
+                    const std::vector<NodeId> &targets,
+                    const std::vector<float> &weights,
+                    const std::vector<uint32_t> &stall_offsets,
+                    const std::vector<NodeId> &stall_targets,
+                    const std::vector<float> &stall_weights) {
+      const auto top = queue.top();
+      queue.pop();
+      const auto node = top.second;
+      if (top.first > cost[node]) {
+        return;
+      }
+      if (top.first + other[node] < best) {
+        best = top.first + other[node];
+        meeting = node;
+      }
+      for (auto i = stall_offsets[node]; i < stall_offsets[node + 1u]; ++i) {
+        if (cost[stall_targets[i]] + stall_weights[i] < top.first) {
+          return;
+        }
+      }
+      for (auto i = offsets[node]; i < offsets[node + 1u]; ++i) {
+        const auto next = targets[i];
+        const double next_cost = top.first + weights[i];
+        if (next_cost < cost[next]) {
+          cost[next] = next_cost;
+          parent[next] = node;
+          queue.emplace(next_cost, next);
+        }
+      }
+    };
+
+    while (true) {
+      const bool forward_done = forward_queue.empty() || forward_queue.top().first >= best;
+      const bool backward_done = backward_queue.empty() || backward_queue.top().first >= best;
+      if (forward_done && backward_done) {
+        break;
+      }
+      if (!forward_done &&
+          (backward_done || forward_queue.top().first <= backward_queue.top().first)) {
+        step(forward_queue, forward, forward_parent, backward,
+             _up_offsets, _up_targets, _up_weights,
+             _down_offsets, _down_targets, _down_weights);
+      } else {
+        step(backward_queue, backward, backward_parent, forward,
+             _down_offsets, _down_targets, _down_weights,
+             _up_offsets, _up_targets, _up_weights);
+      }
+    }
+
+    SearchResult result;
+    if (meeting == InvalidNode) {
+      return result;
+    }
+    result.cost = best - target_progress;
+
+    // Forward half, from the meeting node back to the seed.
+    std::vector<NodeId> chain;
+    for (auto node = meeting; node != InvalidNode; node = forward_parent[node]) {
+      chain.emplace_back(node);
+    }
+    std::reverse(chain.begin(), chain.end());
+    result.lane = seed_lanes[chain.front()];
+    result.path.emplace_back(chain.front());
+    for (size_t i = 1u; i < chain.size(); ++i) {
+      UnpackEdge(chain[i - 1u], chain[i], result.path);
+    }
+    // Backward half, from the meeting node to the target.
+    for (auto node = meeting; backward_parent[node] != InvalidNode; node = backward_parent[node]) {
+      UnpackEdge(node, backward_parent[node], result.path);
+    }
+    return result;
+  }
+
+  void RoutingGraph::UnpackEdge(NodeId from, NodeId to, std::vector<NodeId> &path) const {
+    std::vector<std::pair<NodeId, NodeId>> stack;
+    stack.emplace_back(from, to);
+    while (!stack.empty()) {
+      const auto edge = stack.back();
+      stack.pop_back();
+      const auto it = _shortcuts.find(MakeKey(edge.first, edge.second));
+      if (it == _shortcuts.end()) {
+        path.emplace_back(edge.second);
+      } else {
+        // Push the second half first so the first half is unpacked first.
+        stack.emplace_back(it->second, edge.second);
+        stack.emplace_back(edge.first, it->second);
+      }
+    }
+  }
+
+  RoutingGraph::Route RoutingGraph::ComputeRoute(
+      const Waypoint &origin,
+      const Waypoint &destination) const {
+    Route route;
+    const auto origin_node = GetNode(origin);
+    const auto target_node = GetNode(destination);
+    if (!origin_node || !target_node) {
+      return route;
+    }
+    const double origin_progress = GetProgress(origin);
+    const double target_progress = GetProgress(destination);
+
+    // Lanes reachable from the origin changing lanes right there.
+    LaneChangeClosure closure;
+    closure.lanes.emplace_back(*origin_node);
+    closure.parents.emplace_back(InvalidNode);
+    closure.costs.emplace_back(0.0);
+    for (size_t i = 0u; i < closure.lanes.size(); ++i) {
+      const auto lane = closure.lanes[i];
+      for (auto j = _offsets[lane]; j < _offsets[lane + 1u]; ++j) {
+        if (_is_lane_change[j] && closure.Find(_targets[j]) == closure.lanes.size()) {
+          closure.lanes.emplace_back(_targets[j]);
+          closure.parents.emplace_back(lane);
+          closure.costs.emplace_back(closure.costs[i] + _weights[j]);
+        }
+      }
+    }
+
+    // Leaving through the successors of each of those lanes.
+    std::vector<Seed> seeds;
+    for (size_t i = 0u; i < closure.lanes.size(); ++i) {
+      const auto lane = closure.lanes[i];
+      const double remaining = std::max(0.0, _lane_length[lane] - origin_progress);
+      for (auto j = _offsets[lane]; j < _offsets[lane + 1u]; ++j) {
+        if (!_is_lane_change[j]) {
+          seeds.push_back({_targets[j], closure.costs[i] + remaining, lane});
+        }
+      }
+    }
+
+    SearchResult result = HasContractionHierarchy() ?
+        SearchContractionHierarchy(seeds, *target_node, target_progress) :
+        SearchAStar(seeds, *target_node);
+    double cost = result.cost + target_progress;
+
+    // Driving straight to the destination without leaving the lane.
+    const auto direct = closure.Find(*target_node);
+    if (direct < closure.lanes.size() && target_progress >= origin_progress) {
+      const double direct_cost = closure.costs[direct] + target_progress - origin_progress;
+      if (direct_cost <= cost) {
+        cost = direct_cost;
+        result.path.clear();
+        result.lane = *target_node;
+      }
+    }
+    if (cost == INF) {
+      return route;
+    }
+
+    route.cost = cost;
+    route.waypoints.emplace_back(origin);
+    std::vector<NodeId> lane_changes;
+    for (auto i = closure.Find(result.lane); closure.parents[i] != InvalidNode; i = closure.Find(closure.parents[i])) {
+      lane_changes.emplace_back(closure.lanes[i]);
+    }
+    for (auto it = lane_changes.rbegin(); it != lane_changes.rend(); ++it) {
+      Waypoint waypoint = _nodes[*it];
+      waypoint.s = origin.s;
+      route.waypoints.emplace_back(waypoint);
+    }
+    for (const auto node : result.path) {
+      route.waypoints.emplace_back(_nodes[node]);
+    }
+    route.waypoints.emplace_back(destination);
+    return route;
+  }
+
+} // namespace road
+} // namespace carla
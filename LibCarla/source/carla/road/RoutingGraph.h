@@ -0,0 +1,185 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/NonCopyable.h"
+#include "carla/geom/Location.h"
+#include "carla/road/element/Waypoint.h"
+
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace carla {
+namespace road {
+
+  class Map;
+
+  struct RoutingParameters {
+    /// Cost, in meters, added each time the route changes to a neighbouring
+    /// lane.
+    double lane_change_cost = 10.0;
+
+    /// Preprocess a contraction hierarchy after building the graph. It takes
+    /// longer to build but point-to-point queries settle only a handful of
+    /// nodes.
+    bool contraction_hierarchy = false;
+  };
+
+  /// Lane-level routing graph compiled from a road::Map.
+  ///
+  /// Each drivable lane is a node placed at the entrance of the lane. Edges
+  /// go to every successor lane (weighted by the length of the lane) and to
+  /// the neighbouring lanes with the same driving direction when the road
+  /// marks allow the change (weighted by the lane change cost). Edges are
+  /// stored in compressed sparse row arrays. Queries run A* with an euclidean
+  /// heuristic, or a bidirectional search over the contraction hierarchy when
+  /// it has been built.
+  class RoutingGraph : private MovableNonCopyable {
+  public:
+
+    using Waypoint = element::Waypoint;
+
+    using NodeId = uint32_t;
+
+    static constexpr NodeId InvalidNode = std::numeric_limits<NodeId>::max();
+
+    struct Route {
+      /// The origin, the entrance of each lane traversed, and the destination.
+      std::vector<Waypoint> waypoints;
+
+      /// Driven distance plus lane change costs.
+      double cost = 0.0;
+
+      bool empty() const {
+        return waypoints.empty();
+      }
+    };
+
+    explicit RoutingGraph(const Map &map, RoutingParameters parameters = RoutingParameters());
+
+    const RoutingParameters &GetParameters() const {
+      return _parameters;
+    }
+
+    size_t GetNumberOfNodes() const {
+      return _nodes.size();
+    }
+
+    size_t GetNumberOfEdges() const {
+      return _targets.size();
+    }
+
+    size_t GetNumberOfShortcuts() const {
+      return _shortcuts.size();
+    }
+
+    bool HasContractionHierarchy() const {
+      return !_up_offsets.empty();
+    }
+
+    /// Return the node of the lane @a waypoint belongs to.
+    boost::optional<NodeId> GetNode(const Waypoint &waypoint) const;
+
+    /// Waypoint at the entrance of the lane of @a node.
+    const Waypoint &GetNodeWaypoint(NodeId node) const {
+      return _nodes[node];
+    }
+
+    /// Compute the cheapest route from @a origin to @a destination. Returns
+    /// an empty route if the destination is not reachable.
+    Route ComputeRoute(const Waypoint &origin, const Waypoint &destination) const;
+
+  private:
+
+    struct Seed;
+
+    struct SearchResult;
+
+    void Build(const Map &map);
+
+    void BuildContractionHierarchy();
+
+    /// Distance driven along the lane of @a waypoint from its entrance.
+    double GetProgress(const Waypoint &waypoint) const;
+
+    std::vector<Seed> MakeSeeds(NodeId origin, double progress) const;
+
+    SearchResult SearchAStar(const std::vector<Seed> &seeds, NodeId target) const;
+
+    SearchResult SearchContractionHierarchy(
+        const std::vector<Seed> &seeds,
+        NodeId target,
+        double target_progress) const;
+
+    void UnpackEdge(NodeId from, NodeId to, std::vector<NodeId> &path) const;
+
+    static uint64_t MakeKey(NodeId from, NodeId to) {
+      return (static_cast<uint64_t>(from) << 32u) | to;
+    }
+
+    RoutingParameters _parameters;
+
+    /// @name Nodes
+    /// @{
+
+    std::vector<Waypoint> _nodes;
+
+    std::vector<double> _lane_start;
+
+    std::vector<double> _lane_length;
+
+    std::vector<geom::Location> _locations;
+
+    std::unordered_map<uint64_t, NodeId> _node_index;
+
+    /// @}
+
+    /// @name Lane graph (CSR)
+    /// @{
+
+    std::vector<uint32_t> _offsets;
+
+    std::vector<NodeId> _targets;
+
+    std::vector<float> _weights;
+
+    std::vector<uint8_t> _is_lane_change;
+
+    /// Largest factor that keeps the euclidean heuristic consistent.
+    double _heuristic_scale = 1.0;
+
+    /// @}
+
+    /// @name Contraction hierarchy (CSR)
+    /// @{
+
+    /// Edges to higher ranked nodes.
+    std::vector<uint32_t> _up_offsets;
+
+    std::vector<NodeId> _up_targets;
+
+    std::vector<float> _up_weights;
+
+    /// Reversed edges coming from higher ranked nodes.
+    std::vector<uint32_t> _down_offsets;
+
+    std::vector<NodeId> _down_targets;
+
+    std::vector<float> _down_weights;
+
+    /// Middle node of each shortcut, keyed by MakeKey(from, to).
+    std::unordered_map<uint64_t, NodeId> _shortcuts;
+
+    /// @}
+  };
+
+} // namespace road
+} // namespace carla
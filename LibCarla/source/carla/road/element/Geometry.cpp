@@ -10,7 +10,6 @@
 #include "carla/Exception.h"
 #include "carla/geom/Location.h"
 #include "carla/geom/Math.h"
-#include "carla/geom/Vector2D.h"
 
 #include <boost/array.hpp>
 #include <boost/math/tools/rational.hpp>
@@ -19,6 +18,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <stdexcept>
 
 namespace carla {
@@ -57,25 +57,304 @@ namespace element {
     return p;
   }
 
-  // helper function for rotating points
-  geom::Vector2D RotatebyAngle(double angle, double x, double y) {
-    const double cos_a = std::cos(angle);
-    const double sin_a = std::sin(angle);
-    return geom::Vector2D(
-    static_cast<float>(x * cos_a - y * sin_a),
-    static_cast<float>(y * cos_a + x * sin_a));
+  // ===========================================================================
+  // -- ArcLengthTable ---------------------------------------------------------
+  // ===========================================================================
+
+  /// Longest segment allowed in the table, keeps the initial sampling dense
+  /// enough to not miss curvature changes between two midpoint tests.
+  static constexpr double ARC_LENGTH_TABLE_MAX_SEGMENT = 2.0;
+
+  /// Arc length covered by each entry of the lookup index [meters].
+  static constexpr double ARC_LENGTH_TABLE_INDEX_STEP = 1.0;
+
+  /// Maximum number of bisections of each initial segment.
+  static constexpr unsigned ARC_LENGTH_TABLE_MAX_DEPTH = 16u;
+
+  /// Integrates @a speed over [p0, p1] with a 5-point Gauss-Legendre rule.
+  static double IntegrateArcLength(
+      const ArcLengthTable::SpeedFunction &speed,
+      const double p0,
+      const double p1) {
+    static constexpr double nodes[] = {
+        0.0,
+        -0.5384693101056831,
+        0.5384693101056831,
+        -0.9061798459386640,
+        0.9061798459386640};
+    static constexpr double weights[] = {
+        0.5688888888888889,
+        0.4786286704993665,
+        0.4786286704993665,
+        0.2369268850561891,
+        0.2369268850561891};
+    const double half = 0.5 * (p1 - p0);
+    const double mid = 0.5 * (p1 + p0);
+    double result = 0.0;
+    for (auto i = 0u; i < 5u; ++i) {
+      result += weights[i] * speed(mid + half * nodes[i]);
+    }
+    return half * result;
   }
 
-  DirectedPoint GeometrySpiral::PosFromDist(double dist) const {
-    dist = geom::Math::Clamp(dist, 0.0, _length);
-    DEBUG_ASSERT(_length > 0.0);
-    DirectedPoint p(_start_position, _heading);
+  /// Difference between two angles wrapped to [-pi, pi].
+  static double AngleDifference(const double from, const double to) {
+    constexpr double pi = geom::Math::Pi<double>();
+    return std::remainder(to - from, 2.0 * pi);
+  }
+
+  /// Cubic Hermite interpolation between two samples at fraction @a t, the
+  /// end derivatives are the unit tangents scaled by the arc length between
+  /// the samples.
+  static void HermiteInterpolate(
+      const ArcLengthTable::Sample &a,
+      const ArcLengthTable::Sample &b,
+      const double t,
+      double &x,
+      double &y) {
+    const double ds = b.s - a.s;
+    const double t2 = t * t;
+    const double t3 = t2 * t;
+    const double h00 = 2.0 * t3 - 3.0 * t2 + 1.0;
+    const double h10 = (t3 - 2.0 * t2 + t) * ds;
+    const double h01 = -2.0 * t3 + 3.0 * t2;
+    const double h11 = (t3 - t2) * ds;
+    x = h00 * a.x + h10 * a.tx + h01 * b.x + h11 * b.tx;
+    y = h00 * a.y + h10 * a.ty + h01 * b.y + h11 * b.ty;
+  }
+
+  /// Evaluates @a curve at @a p and fills the cached fields of the sample.
+  static ArcLengthTable::Sample MakeSample(
+      const ArcLengthTable::CurveFunction &curve,
+      const double p,
+      const double s) {
+    auto sample = curve(p);
+    sample.p = p;
+    sample.s = s;
+    sample.tx = std::cos(sample.tangent);
+    sample.ty = std::sin(sample.tangent);
+    return sample;
+  }
+
+  static bool IsFinite(const ArcLengthTable::Sample &sample) {
+    return std::isfinite(sample.s) &&
+           std::isfinite(sample.x) &&
+           std::isfinite(sample.y) &&
+           std::isfinite(sample.tangent);
+  }
+
+  /// Appends the samples needed to cover [a, b] within the error bound,
+  /// excluding @a a which is expected to be already in @a samples. Returns
+  /// false as soon as the curve evaluates to a non-finite sample.
+  static bool SubdivideSegment(
+      const ArcLengthTable::CurveFunction &curve,
+      const ArcLengthTable::SpeedFunction &speed,
+      const ArcLengthTable::Sample &a,
+      const ArcLengthTable::Sample &b,
+      const unsigned depth,
+      std::vector<ArcLengthTable::Sample> &samples) {
+    const double p_mid = 0.5 * (a.p + b.p);
+    const auto mid = MakeSample(
+        curve,
+        p_mid,
+        a.s + IntegrateArcLength(speed, a.p, p_mid));
+    if (!IsFinite(mid)) {
+      return false;
+    }
+
+    const double ds = b.s - a.s;
+    const double t = ds > 0.0 ? (mid.s - a.s) / ds : 0.5;
+    double x, y;
+    HermiteInterpolate(a, b, t, x, y);
+    const double position_error = std::hypot(x - mid.x, y - mid.y);
+    const double parameter_error =
+        std::fabs(a.p + t * (b.p - a.p) - p_mid) * speed(p_mid);
+    const double heading_error = std::fabs(
+        AngleDifference(a.tangent + t * AngleDifference(a.tangent, b.tangent), mid.tangent));
+
+    const bool within_error =
+        (std::max(position_error, parameter_error) <= ArcLengthTable::MaxError) &&
+        (heading_error <= ArcLengthTable::MaxHeadingError);
+    if ((depth < ARC_LENGTH_TABLE_MAX_DEPTH) && !within_error) {
+      return
+          SubdivideSegment(curve, speed, a, mid, depth + 1u, samples) &&
+          SubdivideSegment(curve, speed, mid, b, depth + 1u, samples);
+    }
+    samples.emplace_back(b);
+    return true;
+  }
+
+  bool ArcLengthTable::Build(
+      const CurveFunction &curve,
+      const SpeedFunction &speed,
+      const double p_end) {
+    DEBUG_ASSERT(p_end > 0.0);
+    _samples.clear();
+    _index.clear();
+
+    const double approx_length = IntegrateArcLength(speed, 0.0, p_end);
+    if (!std::isfinite(approx_length)) {
+      return false;
+    }
+    const auto segments = std::max<size_t>(
+        1u,
+        static_cast<size_t>(std::ceil(approx_length / ARC_LENGTH_TABLE_MAX_SEGMENT)));
+
+    _samples.emplace_back(MakeSample(curve, 0.0, 0.0));
+    bool finite = IsFinite(_samples.back());
+
+    for (size_t i = 1u; finite && (i <= segments); ++i) {
+      const Sample a = _samples.back();
+      const double p_b = p_end * static_cast<double>(i) / static_cast<double>(segments);
+      const auto b = MakeSample(
+          curve,
+          p_b,
+          a.s + IntegrateArcLength(speed, a.p, p_b));
+      finite = IsFinite(b) && SubdivideSegment(curve, speed, a, b, 0u, _samples);
+    }
+    if (!finite) {
+      _samples.clear();
+      _samples.shrink_to_fit();
+      return false;
+    }
+    _samples.shrink_to_fit();
+
+    const auto buckets = static_cast<size_t>(GetLength() / ARC_LENGTH_TABLE_INDEX_STEP) + 1u;
+    _index.reserve(buckets);
+    size_t segment = 0u;
+    for (size_t i = 0u; i < buckets; ++i) {
+      const double s = static_cast<double>(i) * ARC_LENGTH_TABLE_INDEX_STEP;
+      while ((segment + 2u < _samples.size()) && (_samples[segment + 1u].s <= s)) {
+        ++segment;
+      }
+      _index.emplace_back(static_cast<uint32_t>(segment));
+    }
+    return true;
+  }
+
+  size_t ArcLengthTable::FindSegment(const double s) const {
+    DEBUG_ASSERT(_samples.size() > 1u);
+    const auto bucket = std::min(
+        static_cast<size_t>(s / ARC_LENGTH_TABLE_INDEX_STEP),
+        _index.size() - 1u);
+    size_t segment = _index[bucket];
+    while ((segment + 2u < _samples.size()) && (_samples[segment + 1u].s <= s)) {
+      ++segment;
+    }
+    return segment;
+  }
+
+  ArcLengthTable::Sample ArcLengthTable::Interpolate(const double s) const {
+    if (_samples.empty()) {
+      return Sample{};
+    }
+    if (_samples.size() == 1u) {
+      return _samples.front();
+    }
+    const double clamped_s = geom::Math::Clamp(s, 0.0, GetLength());
+    const auto segment = FindSegment(clamped_s);
+    const Sample &a = _samples[segment];
+    const Sample &b = _samples[segment + 1u];
+    const double ds = b.s - a.s;
+    const double t = ds > 0.0 ? (clamped_s - a.s) / ds : 0.0;
+
+    Sample result;
+    result.s = clamped_s;
+    result.p = a.p + t * (b.p - a.p);
+    result.tangent = a.tangent + t * AngleDifference(a.tangent, b.tangent);
+    HermiteInterpolate(a, b, t, result.x, result.y);
+    return result;
+  }
+
+  std::pair<double, double> ArcLengthTable::Project(
+      const double x,
+      const double y) const {
+    if (_samples.size() < 2u) {
+      return {0.0, std::hypot(x, y)};
+    }
+    // Start from the nearest sample.
+    auto nearest = std::min_element(
+        _samples.begin(),
+        _samples.end(),
+        [x, y](const Sample &lhs, const Sample &rhs) {
+          return geom::Math::Square(lhs.x - x) + geom::Math::Square(lhs.y - y) <
+                 geom::Math::Square(rhs.x - x) + geom::Math::Square(rhs.y - y);
+        });
+    double s = nearest->s;
+
+    // Newton iterations on f(s) = (q - c(s)) . T(s), whose derivative is
+    // -1 + k(s) * (q - c(s)) . N(s).
+    constexpr double tolerance = 1e-6;
+    constexpr unsigned max_iterations = 10u;
+    const double length = GetLength();
+    for (auto i = 0u; i < max_iterations; ++i) {
+      const auto current = Interpolate(s);
+      const double dx = x - current.x;
+      const double dy = y - current.y;
+      const double cos_t = std::cos(current.tangent);
+      const double sin_t = std::sin(current.tangent);
+      const double along = dx * cos_t + dy * sin_t;
+      const double lateral = dy * cos_t - dx * sin_t;
+
+      const auto segment = FindSegment(current.s);
+      const Sample &a = _samples[segment];
+      const Sample &b = _samples[segment + 1u];
+      const double curvature = b.s > a.s ?
+          AngleDifference(a.tangent, b.tangent) / (b.s - a.s) :
+          0.0;
+      const double denominator = 1.0 - curvature * lateral;
+      // Fall back to a Gauss-Newton step when past the center of curvature.
+      const double step = denominator > 0.1 ? along / denominator : along;
+
+      const double next_s = geom::Math::Clamp(s + step, 0.0, length);
+      const bool converged = std::fabs(next_s - s) < tolerance;
+      s = next_s;
+      if (converged) {
+        break;
+      }
+    }
 
-    const double curve_end = (_curve_end);
-    const double curve_start = (_curve_start);
-    const double curve_dot = (curve_end - curve_start) / (_length);
-    const double s_o = curve_start / curve_dot;
-    double s = s_o + dist;
+    const auto projection = Interpolate(s);
+    return {s, std::hypot(x - projection.x, y - projection.y)};
+  }
+
+  /// Distance from @a location to a geometry sampled in @a table, in the
+  /// format of Geometry::DistanceTo.
+  static std::pair<float, float> DistanceToTable(
+      const ArcLengthTable &table,
+      const geom::Location &start_position,
+      const geom::Location &location) {
+    const auto result = table.Project(
+        static_cast<double>(location.x) - static_cast<double>(start_position.x),
+        static_cast<double>(location.y) - static_cast<double>(start_position.y));
+    return {static_cast<float>(result.first), static_cast<float>(result.second)};
+  }
+
+  /// Builds a DirectedPoint from a sample of a geometry starting at @a start.
+  static DirectedPoint MakeDirectedPoint(
+      const geom::Location &start,
+      const ArcLengthTable::Sample &sample) {
+    DirectedPoint p(start, sample.tangent);
+    p.location.x += static_cast<float>(sample.x);
+    p.location.y += static_cast<float>(sample.y);
+    return p;
+  }
+
+  // ===========================================================================
+  // -- GeometrySpiral ---------------------------------------------------------
+  // ===========================================================================
+
+  /// Below this rate of change of curvature [1/m^2] a spiral is evaluated as
+  /// an arc of its mean curvature.
+  static constexpr double SPIRAL_MIN_CURVATURE_RATE = 1e-12;
+
+  /// Below this curvature [1/m] a constant-curvature spiral is a line.
+  static constexpr double SPIRAL_MIN_CURVATURE = 1e-15;
+
+  ArcLengthTable::Sample GeometrySpiral::EvaluateSpiral(const double dist) const {
+    const double curve_dot = (_curve_end - _curve_start) / (_length);
+    const double s_o = _curve_start / curve_dot;
+    const double s = s_o + dist;
 
     double x;
     double y;
@@ -87,158 +366,149 @@ namespace element {
     double t_o;
     odrSpiral(s_o, curve_dot, &x_o, &y_o, &t_o);
 
-    x = x - x_o;
-    y = y - y_o;
-    t = t - t_o;
-
-    geom::Vector2D pos = RotatebyAngle(_heading - t_o, x, y);
-    p.location.x += pos.x;
-    p.location.y += pos.y;
-    p.tangent = _heading + t;
+    const double cos_a = std::cos(_heading - t_o);
+    const double sin_a = std::sin(_heading - t_o);
+    ArcLengthTable::Sample sample;
+    sample.x = (x - x_o) * cos_a - (y - y_o) * sin_a;
+    sample.y = (y - y_o) * cos_a + (x - x_o) * sin_a;
+    sample.tangent = _heading + t - t_o;
+    return sample;
+  }
 
-    return p;
+  double GeometrySpiral::TangentAt(const double dist) const {
+    const double curve_dot = (_curve_end - _curve_start) / (_length);
+    return _heading + dist * (_curve_start + 0.5 * curve_dot * dist);
   }
 
-  /// @todo
-  std::pair<float, float> GeometrySpiral::DistanceTo(const geom::Location &location) const {
-    // Not analytic, discretize and find nearest point
-    // throw_exception(std::runtime_error("not implemented"));
-    return {location.x - _start_position.x, location.y - _start_position.y};
+  void GeometrySpiral::PreComputeSpiral() {
+    // With (nearly) constant curvature the Fresnel evaluation divides by
+    // zero, the element is then an arc or a line.
+    const double curve_dot = (_curve_end - _curve_start) / (_length);
+    if (std::fabs(curve_dot) > SPIRAL_MIN_CURVATURE_RATE) {
+      // A spiral is parametrized by its arc length.
+      const bool built = _table.Build(
+          [this](double dist) { return EvaluateSpiral(dist); },
+          [](double) { return 1.0; },
+          _length);
+      if (built) {
+        return;
+      }
+    }
+    const double curvature = 0.5 * (_curve_start + _curve_end);
+    if (std::fabs(curvature) > SPIRAL_MIN_CURVATURE) {
+      _constant_curvature = std::make_unique<GeometryArc>(
+          _start_position_offset, _length, _heading, _start_position, curvature);
+    } else {
+      _constant_curvature = std::make_unique<GeometryLine>(
+          _start_position_offset, _length, _heading, _start_position);
+    }
   }
 
-  DirectedPoint GeometryPoly3::PosFromDist(double dist) const {
-    auto result = _rtree.GetNearestNeighbours(
-        Rtree::BPoint(static_cast<float>(dist))).front();
+  DirectedPoint GeometrySpiral::PosFromDist(double dist) const {
+    if (_constant_curvature != nullptr) {
+      return _constant_curvature->PosFromDist(dist);
+    }
+    dist = geom::Math::Clamp(dist, 0.0, _length);
+    DEBUG_ASSERT(_length > 0.0);
+    auto sample = _table.Interpolate(dist);
+    sample.tangent = TangentAt(dist);
+    return MakeDirectedPoint(_start_position, sample);
+  }
 
-    auto &val1 = result.second.first;
-    auto &val2 = result.second.second;
+  std::pair<float, float> GeometrySpiral::DistanceTo(const geom::Location &location) const {
+    if (_constant_curvature != nullptr) {
+      return _constant_curvature->DistanceTo(location);
+    }
+    return DistanceToTable(_table, _start_position, location);
+  }
 
-    double rate = (val2.s - dist) / (val2.s - val1.s);
-    double u = rate * val1.u + (1.0 - rate) * val2.u;
-    double v = rate * val1.v + (1.0 - rate) * val2.v;
-    double tangent = atan((rate * val1.t + (1.0 - rate) * val2.t)); // ?
+  // ===========================================================================
+  // -- GeometryPoly3 ----------------------------------------------------------
+  // ===========================================================================
+
+  ArcLengthTable::Sample GeometryPoly3::Evaluate(const double u) const {
+    const double v = _poly.Evaluate(u);
+    ArcLengthTable::Sample sample;
+    sample.x = u * std::cos(_heading) - v * std::sin(_heading);
+    sample.y = v * std::cos(_heading) + u * std::sin(_heading);
+    sample.tangent = _heading + std::atan(_poly.Tangent(u));
+    return sample;
+  }
 
-    geom::Vector2D pos = RotatebyAngle(_heading, u, v);
-    DirectedPoint p(_start_position, _heading + tangent);
-    p.location.x += pos.x;
-    p.location.y += pos.y;
-    return p;
+  DirectedPoint GeometryPoly3::PosFromDist(double dist) const {
+    return MakeDirectedPoint(_start_position, _table.Interpolate(dist));
   }
 
-  std::pair<float, float> GeometryPoly3::DistanceTo(const geom::Location & /*p*/) const {
-    // No analytical expression (Newton-Raphson?/point search)
-    // throw_exception(std::runtime_error("not implemented"));
-    return {_start_position.x, _start_position.y};
+  std::pair<float, float> GeometryPoly3::DistanceTo(const geom::Location &location) const {
+    return DistanceToTable(_table, _start_position, location);
   }
 
   void GeometryPoly3::PreComputeSpline() {
-    // Roughly the interval size in m
-    constexpr double interval_size = 0.3;
-    const double delta_u = interval_size; // interval between values of u
-    double current_s = 0;
-    double current_u = 0;
-    double last_u = 0;
-    double last_v = _poly.Evaluate(current_u);
-    double last_s = 0;
-    RtreeValue last_val{last_u, last_v, last_s, _poly.Tangent(current_u)};
-    while (current_s < _length + delta_u) {
-      current_u += delta_u;
-      double current_v = _poly.Evaluate(current_u);
-      double du = current_u - last_u;
-      double dv = current_v - last_v;
-      double ds = sqrt(du * du + dv * dv);
-      current_s += ds;
-      double current_t = _poly.Tangent(current_u);
-      RtreeValue current_val{current_u, current_v, current_s, current_t};
-
-      Rtree::BPoint p1(static_cast<float>(last_s));
-      Rtree::BPoint p2(static_cast<float>(current_s));
-      _rtree.InsertElement(Rtree::BSegment(p1, p2), last_val, current_val);
-
-      last_u = current_u;
-      last_v = current_v;
-      last_s = current_s;
-      last_val = current_val;
-
+    const auto speed = [this](double u) {
+      return std::sqrt(1.0 + geom::Math::Square(_poly.Tangent(u)));
+    };
+    // The record does not bound u, find where the arc length reaches the
+    // length of the geometry. Since ds/du >= 1, u never exceeds the length.
+    constexpr double delta_u = 1.0;
+    double u_end = 0.0;
+    double s_end = 0.0;
+    while (u_end < _length) {
+      const double ds = IntegrateArcLength(speed, u_end, u_end + delta_u);
+      if (s_end + ds >= _length) {
+        break;
+      }
+      u_end += delta_u;
+      s_end += ds;
     }
+    // Newton refinement of the last step.
+    double u = u_end + (_length - s_end) / speed(u_end);
+    for (auto i = 0u; i < 8u; ++i) {
+      const double error = s_end + IntegrateArcLength(speed, u_end, u) - _length;
+      u -= error / speed(u);
+      if (std::fabs(error) < 1e-9) {
+        break;
+      }
+    }
+    _table.Build(
+        [this](double u_) { return Evaluate(u_); },
+        speed,
+        std::max(u, std::numeric_limits<double>::epsilon()));
+  }
+
+  // ===========================================================================
+  // -- GeometryParamPoly3 -----------------------------------------------------
+  // ===========================================================================
+
+  ArcLengthTable::Sample GeometryParamPoly3::Evaluate(const double p) const {
+    const double u = _polyU.Evaluate(p);
+    const double v = _polyV.Evaluate(p);
+    ArcLengthTable::Sample sample;
+    sample.x = u * std::cos(_heading) - v * std::sin(_heading);
+    sample.y = v * std::cos(_heading) + u * std::sin(_heading);
+    sample.tangent = _heading + std::atan2(_polyV.Tangent(p), _polyU.Tangent(p));
+    return sample;
   }
 
   DirectedPoint GeometryParamPoly3::PosFromDist(double dist) const {
-    auto result = _rtree.GetNearestNeighbours(
-        Rtree::BPoint(static_cast<float>(dist))).front();
-
-    auto &val1 = result.second.first;
-    auto &val2 = result.second.second;
-    double rate = (val2.s - dist) / (val2.s - val1.s);
-    double u = rate * val1.u + (1.0 - rate) * val2.u;
-    double v = rate * val1.v + (1.0 - rate) * val2.v;
-    double t_u = (rate * val1.t_u + (1.0 - rate) * val2.t_u);
-    double t_v = (rate * val1.t_v + (1.0 - rate) * val2.t_v);
-    double tangent = atan2(t_v, t_u); // ?
-
-    geom::Vector2D pos = RotatebyAngle(_heading, u, v);
-    DirectedPoint p(_start_position, _heading + tangent);
-    p.location.x += pos.x;
-    p.location.y += pos.y;
-    return p;
+    return MakeDirectedPoint(_start_position, _table.Interpolate(dist));
   }
-  std::pair<float, float> GeometryParamPoly3::DistanceTo(const geom::Location &) const {
-    // No analytical expression (Newton-Raphson?/point search)
-    // throw_exception(std::runtime_error("not implemented"));
-    return {_start_position.x, _start_position.y};
+
+  std::pair<float, float> GeometryParamPoly3::DistanceTo(const geom::Location &location) const {
+    return DistanceToTable(_table, _start_position, location);
   }
 
   void GeometryParamPoly3::PreComputeSpline() {
-    // Roughly the interval size in m
-    constexpr double interval_size = 0.5;
-    size_t number_intervals =
-        std::max(static_cast<size_t>(_length / interval_size), size_t(5));
-    double delta_p = 1.0 / number_intervals;
-    if (_arcLength) {
-        delta_p *= _length;
-    }
-    double param_p = 0;
-    double current_s = 0;
-    double last_u = _polyU.Evaluate(param_p);
-    double last_v = _polyV.Evaluate(param_p);
-    double last_s = 0;
-    RtreeValue last_val{
-        last_u,
-        last_v,
-        last_s,
-        _polyU.Tangent(param_p),
-        _polyV.Tangent(param_p) };
-    for(size_t i = 0; i < number_intervals; ++i) {
-      param_p += delta_p;
-      double current_u = _polyU.Evaluate(param_p);
-      double current_v = _polyV.Evaluate(param_p);
-      double du = current_u - last_u;
-      double dv = current_v - last_v;
-      double ds = sqrt(du * du + dv * dv);
-      current_s += ds;
-      double current_t_u = _polyU.Tangent(param_p);
-      double current_t_v = _polyV.Tangent(param_p);
-      RtreeValue current_val{
-          current_u,
-          current_v,
-          current_s,
-          current_t_u,
-          current_t_v };
-
-      Rtree::BPoint p1(static_cast<float>(last_s));
-      Rtree::BPoint p2(static_cast<float>(current_s));
-      _rtree.InsertElement(Rtree::BSegment(p1, p2), last_val, current_val);
-
-      last_u = current_u;
-      last_v = current_v;
-      last_s = current_s;
-      last_val = current_val;
-
-      if(current_s > _length){
-        break;
-      }
-    }
+    // With pRange "normalized" the parameter spans [0, 1], with "arcLength"
+    // it spans the length of the geometry.
+    const double p_end = _arcLength ? _length : 1.0;
+    _table.Build(
+        [this](double p) { return Evaluate(p); },
+        [this](double p) {
+          return std::hypot(_polyU.Tangent(p), _polyV.Tangent(p));
+        },
+        p_end);
   }
+
 } // namespace element
 } // namespace road
 } // namespace carla
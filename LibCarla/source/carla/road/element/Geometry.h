@@ -11,6 +11,11 @@
 #include "carla/geom/CubicPolynomial.h"
 #include "carla/geom/Rtree.h"
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
 namespace carla {
 namespace road {
 namespace element {
@@ -161,6 +166,81 @@ namespace element {
     double _curvature;
   };
 
+  /// Arc-length table of a curved geometry, built once when the geometry is
+  /// created. Samples are placed adaptively so that interpolating between
+  /// them stays within MaxError and MaxHeadingError of the exact curve.
+  ///
+  /// Positions are stored relative to the start position of the geometry and
+  /// tangents include its heading, so interpolated samples can be used as is.
+  class ArcLengthTable {
+  public:
+
+    /// Maximum deviation allowed between the interpolated and the exact
+    /// curve [meters].
+    static constexpr double MaxError = 1e-3;
+
+    /// Maximum deviation allowed between the interpolated and the exact
+    /// heading [radians].
+    static constexpr double MaxHeadingError = 5e-4;
+
+    struct Sample {
+      double s = 0.0;       // arc length from the start [meters]
+      double p = 0.0;       // curve parameter at s
+      double x = 0.0;       // position relative to the start [meters]
+      double y = 0.0;       // position relative to the start [meters]
+      double tangent = 0.0; // heading [radians]
+      double tx = 1.0;      // unit tangent, only cached in table samples
+      double ty = 0.0;      // unit tangent, only cached in table samples
+    };
+
+    /// Evaluates the curve at parameter p, the arc length of the returned
+    /// sample is ignored.
+    using CurveFunction = std::function<Sample(double p)>;
+
+    /// Evaluates |dC/dp| at parameter p.
+    using SpeedFunction = std::function<double(double p)>;
+
+    /// Samples the curve between parameters 0 and @a p_end. Returns false,
+    /// leaving the table empty, if the curve evaluates to a non-finite
+    /// value.
+    bool Build(
+        const CurveFunction &curve,
+        const SpeedFunction &speed,
+        double p_end);
+
+    /// Arc length covered by the table.
+    double GetLength() const {
+      return _samples.empty() ? 0.0 : _samples.back().s;
+    }
+
+    const std::vector<Sample> &GetSamples() const {
+      return _samples;
+    }
+
+    /// Interpolates the curve at arc length @a s (clamped to the table). The
+    /// position is a cubic Hermite interpolation of the neighbouring samples,
+    /// the parameter and the tangent are linearly interpolated.
+    Sample Interpolate(double s) const;
+
+    /// Returns a pair containing:
+    /// - @b first:  arc length of the point of the curve nearest to (x, y).
+    /// - @b second: Euclidean distance from that point to (x, y).
+    /// (x, y) is expected relative to the start of the geometry. The nearest
+    /// sample is refined with Newton iterations on the interpolated curve.
+    std::pair<double, double> Project(double x, double y) const;
+
+  private:
+
+    /// Index of the segment [i, i + 1] that contains @a s.
+    size_t FindSegment(double s) const;
+
+    std::vector<Sample> _samples;
+
+    /// Index of the first sample of each meter of arc length, avoids a
+    /// binary search on every lookup.
+    std::vector<uint32_t> _index;
+  };
+
   class GeometrySpiral final : public Geometry {
   public:
 
@@ -173,7 +253,9 @@ namespace element {
         double curv_e)
       : Geometry(GeometryType::SPIRAL, start_offset, length, heading, start_pos),
         _curve_start(curv_s),
-        _curve_end(curv_e) {}
+        _curve_end(curv_e) {
+      PreComputeSpiral();
+    }
 
     double GetCurveStart() {
       return _curve_start;
@@ -191,6 +273,19 @@ namespace element {
 
     double _curve_start;
     double _curve_end;
+
+    ArcLengthTable _table;
+
+    /// Set instead of the table when the curvature is constant.
+    std::unique_ptr<Geometry> _constant_curvature;
+
+    /// Exact evaluation through the Fresnel integrals.
+    ArcLengthTable::Sample EvaluateSpiral(double dist) const;
+
+    /// Heading at @a dist, the curvature is linear so this is exact.
+    double TangentAt(double dist) const;
+
+    void PreComputeSpiral();
   };
 
   class GeometryPoly3 final : public Geometry {
@@ -240,15 +335,10 @@ namespace element {
     double _c;
     double _d;
 
-    struct RtreeValue {
-      double u = 0;
-      double v = 0;
-      double s = 0;
-      double t = 0;
-    };
-    using Rtree = geom::SegmentCloudRtree<RtreeValue, 1>;
-    using TreeElement = Rtree::TreeElement;
-    Rtree _rtree;
+    ArcLengthTable _table;
+
+    ArcLengthTable::Sample Evaluate(double u) const;
+
     void PreComputeSpline();
   };
 
@@ -327,16 +417,10 @@ namespace element {
     double _dV;
     bool _arcLength;
 
-    struct RtreeValue {
-      double u = 0;
-      double v = 0;
-      double s = 0;
-      double t_u = 0;
-      double t_v = 0;
-    };
-    using Rtree = geom::SegmentCloudRtree<RtreeValue, 1>;
-    using TreeElement = Rtree::TreeElement;
-    Rtree _rtree;
+    ArcLengthTable _table;
+
+    ArcLengthTable::Sample Evaluate(double p) const;
+
     void PreComputeSpline();
   };
 
@@ -33,6 +33,13 @@ namespace rpc {
       return _client.call(function, Metadata::MakeSync(), std::forward<Args>(args)...);
     }
 
+    /// Same as call but does not wait for the response, the returned future
+    /// holds it. Many calls can be in flight on the same connection.
+    template <typename... Args>
+    auto future_call(const std::string &function, Args &&... args) {
+      return _client.async_call(function, Metadata::MakeSync(), std::forward<Args>(args)...);
+    }
+
     template <typename... Args>
     void async_call(const std::string &function, Args &&... args) {
       _client.async_call(function, Metadata::MakeAsync(), std::forward<Args>(args)...);
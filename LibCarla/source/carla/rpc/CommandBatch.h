@@ -0,0 +1,381 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/Logging.h"
+#include "carla/MsgPack.h"
+#include "carla/rpc/Command.h"
+#include "carla/rpc/WalkerStateList.h"
+
+#include <boost/mpl/at.hpp>
+#include <boost/mpl/begin_end.hpp>
+#include <boost/mpl/distance.hpp>
+#include <boost/mpl/find.hpp>
+#include <boost/mpl/size.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace carla {
+namespace rpc {
+namespace detail {
+
+  // Records in which plain data commands travel inside a CommandBatch. Each
+  // field is copied explicitly into a record without padding, so the bytes on
+  // the wire do not depend on how the compiler lays out the command structs.
+
+#pragma pack(push, 1)
+
+  struct PackedDestroyActor {
+    ActorId actor;
+
+    static PackedDestroyActor Make(const Command::DestroyActor &command) {
+      return {command.actor};
+    }
+
+    Command::DestroyActor Get() const {
+      return {actor};
+    }
+  };
+
+  struct PackedVehicleControl {
+    ActorId actor;
+    float throttle;
+    float steer;
+    float brake;
+    bool hand_brake;
+    bool reverse;
+    bool manual_gear_shift;
+    int32_t gear;
+
+    static PackedVehicleControl Make(const Command::ApplyVehicleControl &command) {
+      const auto &control = command.control;
+      return {
+          command.actor,
+          control.throttle,
+          control.steer,
+          control.brake,
+          control.hand_brake,
+          control.reverse,
+          control.manual_gear_shift,
+          control.gear};
+    }
+
+    Command::ApplyVehicleControl Get() const {
+      return {actor, VehicleControl{throttle, steer, brake, hand_brake, reverse, manual_gear_shift, gear}};
+    }
+  };
+
+  struct PackedWalkerControl {
+    ActorId actor;
+    geom::Vector3D direction;
+    float speed;
+    bool jump;
+
+    static PackedWalkerControl Make(const Command::ApplyWalkerControl &command) {
+      return {command.actor, command.control.direction, command.control.speed, command.control.jump};
+    }
+
+    Command::ApplyWalkerControl Get() const {
+      return {actor, WalkerControl{direction, speed, jump}};
+    }
+  };
+
+  struct PackedTransform {
+    ActorId actor;
+    geom::Transform transform;
+
+    static PackedTransform Make(const Command::ApplyTransform &command) {
+      return {command.actor, command.transform};
+    }
+
+    Command::ApplyTransform Get() const {
+      return {actor, transform};
+    }
+  };
+
+  struct PackedWalkerState {
+    WalkerState state;
+
+    static PackedWalkerState Make(const Command::ApplyWalkerState &command) {
+      return {{command.actor, command.transform, command.speed}};
+    }
+
+    Command::ApplyWalkerState Get() const {
+      return {state.actor, state.transform, state.speed};
+    }
+  };
+
+  /// Commands made of an actor and a vector, e.g. forces and velocities.
+  template <typename T, geom::Vector3D T::*Member>
+  struct PackedVectorCommand {
+    ActorId actor;
+    geom::Vector3D value;
+
+    static PackedVectorCommand Make(const T &command) {
+      return {command.actor, command.*Member};
+    }
+
+    T Get() const {
+      return {actor, value};
+    }
+  };
+
+  /// Commands made of an actor and a flag.
+  template <typename T>
+  struct PackedFlagCommand {
+    ActorId actor;
+    bool enabled;
+
+    static PackedFlagCommand Make(const T &command) {
+      return {command.actor, command.enabled};
+    }
+
+    T Get() const {
+      return {actor, enabled};
+    }
+  };
+
+#pragma pack(pop)
+
+  using PackedTargetVelocity = PackedVectorCommand<Command::ApplyTargetVelocity, &Command::ApplyTargetVelocity::velocity>;
+  using PackedTargetAngularVelocity = PackedVectorCommand<Command::ApplyTargetAngularVelocity, &Command::ApplyTargetAngularVelocity::angular_velocity>;
+  using PackedImpulse = PackedVectorCommand<Command::ApplyImpulse, &Command::ApplyImpulse::impulse>;
+  using PackedForce = PackedVectorCommand<Command::ApplyForce, &Command::ApplyForce::force>;
+  using PackedAngularImpulse = PackedVectorCommand<Command::ApplyAngularImpulse, &Command::ApplyAngularImpulse::impulse>;
+  using PackedTorque = PackedVectorCommand<Command::ApplyTorque, &Command::ApplyTorque::torque>;
+  using PackedSimulatePhysics = PackedFlagCommand<Command::SetSimulatePhysics>;
+  using PackedEnableGravity = PackedFlagCommand<Command::SetEnableGravity>;
+
+  static_assert(sizeof(PackedDestroyActor) == 4u, "PackedDestroyActor size missmatch");
+  static_assert(sizeof(PackedVehicleControl) == 4u + 3u * 4u + 3u + 4u, "PackedVehicleControl size missmatch");
+  static_assert(sizeof(PackedWalkerControl) == 4u + 3u * 4u + 4u + 1u, "PackedWalkerControl size missmatch");
+  static_assert(sizeof(PackedTransform) == 4u + 6u * 4u, "PackedTransform size missmatch");
+  static_assert(sizeof(PackedWalkerState) == sizeof(WalkerState), "PackedWalkerState size missmatch");
+  static_assert(sizeof(PackedForce) == 4u + 3u * 4u, "PackedVectorCommand size missmatch");
+  static_assert(sizeof(PackedSimulatePhysics) == 4u + 1u, "PackedFlagCommand size missmatch");
+
+  /// Record type in which commands of type @a T are packed, or void if they
+  /// are sent as regular commands.
+  template <typename T>
+  struct PackedCommand { using type = void; };
+
+  template <> struct PackedCommand<Command::DestroyActor> { using type = PackedDestroyActor; };
+  template <> struct PackedCommand<Command::ApplyVehicleControl> { using type = PackedVehicleControl; };
+  template <> struct PackedCommand<Command::ApplyWalkerControl> { using type = PackedWalkerControl; };
+  template <> struct PackedCommand<Command::ApplyTransform> { using type = PackedTransform; };
+  template <> struct PackedCommand<Command::ApplyWalkerState> { using type = PackedWalkerState; };
+  template <> struct PackedCommand<Command::ApplyTargetVelocity> { using type = PackedTargetVelocity; };
+  template <> struct PackedCommand<Command::ApplyTargetAngularVelocity> { using type = PackedTargetAngularVelocity; };
+  template <> struct PackedCommand<Command::ApplyImpulse> { using type = PackedImpulse; };
+  template <> struct PackedCommand<Command::ApplyForce> { using type = PackedForce; };
+  template <> struct PackedCommand<Command::ApplyAngularImpulse> { using type = PackedAngularImpulse; };
+  template <> struct PackedCommand<Command::ApplyTorque> { using type = PackedTorque; };
+  template <> struct PackedCommand<Command::SetSimulatePhysics> { using type = PackedSimulatePhysics; };
+  template <> struct PackedCommand<Command::SetEnableGravity> { using type = PackedEnableGravity; };
+
+} // namespace detail
+
+  /// List of commands encoded as runs of consecutive commands of the same
+  /// type. Runs of plain data commands (controls, transforms, forces...) are
+  /// stored as a contiguous array of packed records (see detail::PackedCommand),
+  /// serialized as a single binary blob; the rest are kept as regular commands.
+  ///
+  /// Visiting the batch dispatches on the type once per run instead of once
+  /// per command.
+  class CommandBatch {
+  public:
+
+    CommandBatch() = default;
+
+    explicit CommandBatch(const std::vector<Command> &commands) {
+      for (auto &command : commands) {
+        Add(command);
+      }
+    }
+
+    /// Append a command of type @a T, e.g. Command::ApplyVehicleControl.
+    template <typename T>
+    void Add(const T &command);
+
+    /// Append a command of any type.
+    void Add(const Command &command) {
+      boost::apply_visitor([this](const auto &value) { Add(value); }, command.command);
+    }
+
+    size_t size() const {
+      return _size;
+    }
+
+    bool empty() const {
+      return _size == 0u;
+    }
+
+    /// Call @a visitor with each command, in order, as its concrete type.
+    ///
+    /// Runs that cannot be decoded, because their type is unknown to this
+    /// build or their size does not match their count, are skipped and
+    /// @a on_invalid_run is called with the number of commands in the run
+    /// instead, so the caller can still account for every command.
+    template <typename VisitorT, typename InvalidRunT>
+    void ForEach(VisitorT &&visitor, InvalidRunT &&on_invalid_run) const;
+
+    /// Same as above, skipping the runs that cannot be decoded.
+    template <typename VisitorT>
+    void ForEach(VisitorT &&visitor) const {
+      ForEach(std::forward<VisitorT>(visitor), [](size_t) {});
+    }
+
+  private:
+
+    using Types = Command::CommandType::types;
+
+    template <typename T>
+    using IsPacked = std::integral_constant<
+        bool,
+        !std::is_void<typename detail::PackedCommand<T>::type>::value>;
+
+    template <typename T>
+    static constexpr uint8_t IndexOf() {
+      using Position = typename boost::mpl::find<Types, T>::type;
+      return static_cast<uint8_t>(
+          boost::mpl::distance<typename boost::mpl::begin<Types>::type, Position>::value);
+    }
+
+    struct Run {
+      uint8_t type = 0u;
+      uint32_t count = 0u;
+      /// Commands of a plain data type, as packed records.
+      std::vector<unsigned char> data;
+      /// Commands of any other type.
+      std::vector<Command> commands;
+
+      MSGPACK_DEFINE_ARRAY(type, count, data, commands);
+    };
+
+    template <typename T>
+    Run &GetRun();
+
+    template <typename T>
+    static void AddToRun(Run &run, const T &command, std::true_type /* packed */);
+
+    template <typename T>
+    static void AddToRun(Run &run, const T &command, std::false_type /* packed */);
+
+    template <typename T, typename VisitorT>
+    static bool VisitRun(const Run &run, VisitorT &visitor, std::true_type /* packed */);
+
+    template <typename T, typename VisitorT>
+    static bool VisitRun(const Run &run, VisitorT &visitor, std::false_type /* packed */);
+
+    template <size_t I, typename VisitorT>
+    static bool Dispatch(const Run &run, VisitorT &visitor, std::false_type /* end */);
+
+    template <size_t I, typename VisitorT>
+    static bool Dispatch(const Run &, VisitorT &, std::true_type /* end */) {
+      return false;
+    }
+
+    std::vector<Run> _runs;
+
+    size_t _size = 0u;
+
+  public:
+
+    MSGPACK_DEFINE_ARRAY(_runs, _size);
+  };
+
+  // ===========================================================================
+  // -- CommandBatch implementation --------------------------------------------
+  // ===========================================================================
+
+  template <typename T>
+  inline CommandBatch::Run &CommandBatch::GetRun() {
+    constexpr auto type = IndexOf<T>();
+    if (_runs.empty() || (_runs.back().type != type)) {
+      _runs.emplace_back();
+      _runs.back().type = type;
+    }
+    return _runs.back();
+  }
+
+  template <typename T>
+  inline void CommandBatch::AddToRun(Run &run, const T &command, std::true_type) {
+    using Record = typename detail::PackedCommand<T>::type;
+    const Record record = Record::Make(command);
+    const auto offset = run.data.size();
+    run.data.resize(offset + sizeof(Record));
+    std::memcpy(run.data.data() + offset, &record, sizeof(Record));
+  }
+
+  template <typename T>
+  inline void CommandBatch::AddToRun(Run &run, const T &command, std::false_type) {
+    run.commands.emplace_back(command);
+  }
+
+  template <typename T>
+  inline void CommandBatch::Add(const T &command) {
+    auto &run = GetRun<T>();
+    AddToRun(run, command, IsPacked<T>{});
+    ++run.count;
+    ++_size;
+  }
+
+  template <typename T, typename VisitorT>
+  inline bool CommandBatch::VisitRun(const Run &run, VisitorT &visitor, std::true_type) {
+    using Record = typename detail::PackedCommand<T>::type;
+    if (run.data.size() != run.count * sizeof(Record)) {
+      return false;
+    }
+    Record record;
+    for (auto i = 0u; i < run.count; ++i) {
+      std::memcpy(&record, run.data.data() + i * sizeof(Record), sizeof(Record));
+      visitor(record.Get());
+    }
+    return true;
+  }
+
+  template <typename T, typename VisitorT>
+  inline bool CommandBatch::VisitRun(const Run &run, VisitorT &visitor, std::false_type) {
+    if (run.commands.size() != run.count) {
+      return false;
+    }
+    for (auto &command : run.commands) {
+      boost::apply_visitor([&visitor](const auto &value) { visitor(value); }, command.command);
+    }
+    return true;
+  }
+
+  template <size_t I, typename VisitorT>
+  inline bool CommandBatch::Dispatch(const Run &run, VisitorT &visitor, std::false_type) {
+    if (run.type == I) {
+      using T = typename boost::mpl::at_c<Types, I>::type;
+      return VisitRun<T>(run, visitor, IsPacked<T>{});
+    }
+    constexpr auto next = I + 1u;
+    return Dispatch<next>(
+        run,
+        visitor,
+        std::integral_constant<bool, next == boost::mpl::size<Types>::value>{});
+  }
+
+  template <typename VisitorT, typename InvalidRunT>
+  inline void CommandBatch::ForEach(VisitorT &&visitor, InvalidRunT &&on_invalid_run) const {
+    for (auto &run : _runs) {
+      if (!Dispatch<0u>(run, visitor, std::false_type{})) {
+        log_error(
+            "command batch: cannot decode run of", run.count,
+            "commands of type", static_cast<unsigned>(run.type));
+        on_invalid_run(static_cast<size_t>(run.count));
+      }
+    }
+  }
+
+} // namespace rpc
+} // namespace carla
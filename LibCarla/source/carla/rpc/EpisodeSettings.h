@@ -45,9 +45,13 @@ namespace rpc {
 
     float actor_active_distance = 2000.f; // 2km
 
+    /// Stream the world snapshots as periodic keyframes and, in between, only
+    /// the actors that changed.
+    bool delta_snapshots = false;
+
     MSGPACK_DEFINE_ARRAY(synchronous_mode, no_rendering_mode, fixed_delta_seconds, substepping,
         max_substep_delta_time, max_substeps, max_culling_distance, deterministic_ragdolls,
-        tile_stream_distance, actor_active_distance);
+        tile_stream_distance, actor_active_distance, delta_snapshots);
 
     // =========================================================================
     // -- Constructors ---------------------------------------------------------
@@ -65,7 +69,8 @@ namespace rpc {
         float max_culling_distance = 0.0f,
         bool deterministic_ragdolls = true,
         float tile_stream_distance = 3000.f,
-        float actor_active_distance = 2000.f)
+        float actor_active_distance = 2000.f,
+        bool delta_snapshots = false)
       : synchronous_mode(synchronous_mode),
         no_rendering_mode(no_rendering_mode),
         fixed_delta_seconds(
@@ -76,7 +81,8 @@ namespace rpc {
         max_culling_distance(max_culling_distance),
         deterministic_ragdolls(deterministic_ragdolls),
         tile_stream_distance(tile_stream_distance),
-        actor_active_distance(actor_active_distance) {}
+        actor_active_distance(actor_active_distance),
+        delta_snapshots(delta_snapshots) {}
 
     // =========================================================================
     // -- Comparison operators -------------------------------------------------
@@ -93,7 +99,8 @@ namespace rpc {
           (max_culling_distance == rhs.max_culling_distance) &&
           (deterministic_ragdolls == rhs.deterministic_ragdolls) &&
           (tile_stream_distance == tile_stream_distance) &&
-          (actor_active_distance == actor_active_distance);
+          (actor_active_distance == actor_active_distance) &&
+          (delta_snapshots == rhs.delta_snapshots);
     }
 
     bool operator!=(const EpisodeSettings &rhs) const {
@@ -117,7 +124,8 @@ namespace rpc {
             Settings.MaxCullingDistance,
             Settings.bDeterministicRagdolls,
             Settings.TileStreamingDistance,
-            Settings.ActorActiveDistance) {
+            Settings.ActorActiveDistance,
+            Settings.bDeltaSnapshots) {
       constexpr float CMTOM = 1.f/100.f;
       tile_stream_distance = CMTOM * Settings.TileStreamingDistance;
       actor_active_distance = CMTOM * Settings.ActorActiveDistance;
@@ -138,6 +146,7 @@ namespace rpc {
       Settings.bDeterministicRagdolls = deterministic_ragdolls;
       Settings.TileStreamingDistance = MTOCM * tile_stream_distance;
       Settings.ActorActiveDistance = MTOCM * actor_active_distance;
+      Settings.bDeltaSnapshots = delta_snapshots;
 
       return Settings;
     }
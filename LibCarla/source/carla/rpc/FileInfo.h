@@ -0,0 +1,44 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/MsgPack.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace carla {
+namespace rpc {
+
+  /// Size and content hash of a file the server can send, used by the client
+  /// to look up and verify its cached copy.
+  class FileInfo {
+  public:
+
+    static constexpr uint64_t HashSeed = 14695981039346656037ull;
+
+    /// 64-bit FNV-1a hash of @a size bytes at @a data. Pass the result of a
+    /// previous call as @a hash to hash a file in several blocks.
+    static uint64_t Hash(const void *data, size_t size, uint64_t hash = HashSeed) {
+      const auto *bytes = static_cast<const unsigned char *>(data);
+      for (size_t i = 0u; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+      }
+      return hash;
+    }
+
+    /// Size in bytes, zero if the file does not exist on the server.
+    uint64_t size = 0u;
+
+    uint64_t hash = HashSeed;
+
+    MSGPACK_DEFINE_ARRAY(size, hash);
+  };
+
+} // namespace rpc
+} // namespace carla
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include "carla/AtomicSharedPtr.h"
+#include "carla/Debug.h"
 #include "carla/MoveHandler.h"
 #include "carla/Time.h"
 #include "carla/rpc/Metadata.h"
@@ -17,6 +19,9 @@
 #include <rpc/server.h>
 
 #include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace carla {
 namespace rpc {
@@ -34,6 +39,11 @@ namespace rpc {
   /// Functions that are bind using `BindAsync` will run asynchronously in the
   /// worker threads. Functions that are bind using `BindSync` will run within
   /// `SyncRunFor` function.
+  ///
+  /// Functions that are bind using `BindReadOnly` also run in the worker
+  /// threads, right away, against the last snapshot published with
+  /// `PublishSnapshot`. They don't wait for the game thread, and calls from
+  /// several clients run concurrently.
   class Server {
   public:
 
@@ -46,6 +56,23 @@ namespace rpc {
     template <typename FunctorT>
     void BindAsync(const std::string &name, FunctorT &&functor);
 
+    /// Bind a read-only @a functor whose first parameter is a const reference
+    /// to a snapshot type, e.g. `[](const State &state, int id) { ... }`. The
+    /// snapshot is a default constructed one until the first publication.
+    ///
+    /// @warning @a functor must not modify any state shared with the game
+    /// thread, it runs concurrently with it.
+    template <typename FunctorT>
+    void BindReadOnly(const std::string &name, FunctorT &&functor);
+
+    /// Make @a snapshot the one seen by the read-only functions from now on.
+    /// Calls in progress keep the previous one.
+    template <typename SnapshotT>
+    void PublishSnapshot(std::shared_ptr<const SnapshotT> snapshot) {
+      DEBUG_ASSERT(snapshot != nullptr);
+      GetSnapshotSlot<SnapshotT>()->store(std::move(snapshot));
+    }
+
     void AsyncRun(size_t worker_threads) {
       _server.async_run(worker_threads);
     }
@@ -65,9 +92,24 @@ namespace rpc {
 
   private:
 
+    /// Unique address per type, works without RTTI.
+    template <typename SnapshotT>
+    static const void *GetSnapshotKey() {
+      static const char key = 0;
+      return &key;
+    }
+
+    template <typename SnapshotT>
+    std::shared_ptr<AtomicSharedPtr<const SnapshotT>> GetSnapshotSlot();
+
     boost::asio::io_context _sync_io_context;
 
     ::rpc::server _server;
+
+    std::mutex _snapshots_mutex;
+
+    /// One AtomicSharedPtr per snapshot type.
+    std::unordered_map<const void *, std::shared_ptr<void>> _snapshots;
   };
 
   // ===========================================================================
@@ -76,6 +118,34 @@ namespace rpc {
 
 namespace detail {
 
+  template <typename R, typename... Args>
+  struct ReadOnlyFunctionWrapper;
+
+  template <typename R, typename SnapshotT, typename... Args>
+  struct ReadOnlyFunctionWrapper<R, const SnapshotT &, Args...> {
+
+    using Snapshot = SnapshotT;
+
+    /// Wraps @a functor into a function type with the signature of @a functor
+    /// minus the snapshot. When called, calls @a functor right away with the
+    /// snapshot currently stored in @a slot.
+    template <typename FuncT>
+    static auto WrapReadOnlyCall(
+        std::shared_ptr<AtomicSharedPtr<const SnapshotT>> slot,
+        FuncT &&functor) {
+      return [slot=std::move(slot), functor=std::forward<FuncT>(functor)](Metadata metadata, Args... args) -> R {
+        // Keep the snapshot alive even if a new one is published meanwhile.
+        const auto snapshot = slot->load();
+        if (metadata.IsResponseIgnored()) {
+          functor(*snapshot, args...);
+          return R();
+        } else {
+          return functor(*snapshot, args...);
+        }
+      };
+    }
+  };
+
   template <typename T>
   struct FunctionWrapper : FunctionWrapper<decltype(&T::operator())> {};
 
@@ -94,6 +164,8 @@ namespace detail {
   template <typename R, typename... Args>
   struct FunctionWrapper<R (*)(Args...)> {
 
+    using ReadOnly = ReadOnlyFunctionWrapper<R, Args...>;
+
     /// Wraps @a functor into a function type with equivalent signature. The
     /// wrap function returned. When called, posts @a functor into the
     /// io_context; if the client called this method synchronously, waits for
@@ -162,5 +234,25 @@ namespace detail {
         Wrapper::WrapAsyncCall(std::forward<FunctorT>(functor)));
   }
 
+  template <typename FunctorT>
+  inline void Server::BindReadOnly(const std::string &name, FunctorT &&functor) {
+    using Wrapper = typename detail::FunctionWrapper<FunctorT>::ReadOnly;
+    using SnapshotT = typename Wrapper::Snapshot;
+    _server.bind(
+        name,
+        Wrapper::WrapReadOnlyCall(GetSnapshotSlot<SnapshotT>(), std::forward<FunctorT>(functor)));
+  }
+
+  template <typename SnapshotT>
+  inline std::shared_ptr<AtomicSharedPtr<const SnapshotT>> Server::GetSnapshotSlot() {
+    using Slot = AtomicSharedPtr<const SnapshotT>;
+    std::lock_guard<std::mutex> lock(_snapshots_mutex);
+    auto &slot = _snapshots[GetSnapshotKey<SnapshotT>()];
+    if (slot == nullptr) {
+      slot = std::make_shared<Slot>(std::make_shared<const SnapshotT>());
+    }
+    return std::static_pointer_cast<Slot>(slot);
+  }
+
 } // namespace rpc
 } // namespace carla
@@ -0,0 +1,75 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/Debug.h"
+#include "carla/MsgPack.h"
+#include "carla/geom/Transform.h"
+#include "carla/rpc/ActorId.h"
+
+#include <cstring>
+#include <vector>
+
+namespace carla {
+namespace rpc {
+
+#pragma pack(push, 1)
+  /// Same as Command::ApplyWalkerState.
+  struct WalkerState {
+    ActorId actor;
+    geom::Transform transform;
+    float speed;
+  };
+#pragma pack(pop)
+
+  static_assert(sizeof(WalkerState) == 4u + 6u * 4u + 4u, "WalkerState size missmatch");
+
+  /// List of walker states packed in a single binary blob, so the whole crowd
+  /// is sent without encoding one command per walker.
+  class WalkerStateList {
+  public:
+
+    void reserve(size_t count) {
+      _data.reserve(count * sizeof(WalkerState));
+    }
+
+    void clear() {
+      _data.clear();
+    }
+
+    void emplace_back(ActorId actor, const geom::Transform &transform, float speed) {
+      const WalkerState state{actor, transform, speed};
+      const auto offset = _data.size();
+      _data.resize(offset + sizeof(WalkerState));
+      std::memcpy(_data.data() + offset, &state, sizeof(WalkerState));
+    }
+
+    size_t size() const {
+      return _data.size() / sizeof(WalkerState);
+    }
+
+    bool empty() const {
+      return size() == 0u;
+    }
+
+    WalkerState operator[](size_t index) const {
+      DEBUG_ASSERT(index < size());
+      WalkerState state;
+      std::memcpy(&state, _data.data() + index * sizeof(WalkerState), sizeof(WalkerState));
+      return state;
+    }
+
+    MSGPACK_DEFINE_ARRAY(_data);
+
+  private:
+
+    /// Sent as msgpack binary data.
+    std::vector<unsigned char> _data;
+  };
+
+} // namespace rpc
+} // namespace carla
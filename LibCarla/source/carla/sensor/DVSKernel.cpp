@@ -0,0 +1,202 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/sensor/DVSKernel.h"
+
+#include "carla/Debug.h"
+#include "carla/sensor/FastMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace carla {
+namespace sensor {
+
+  /// Intensity changes below this do not trigger events.
+  static constexpr float Tolerance = 1e-6f;
+
+  /// Lower bound of the contrast threshold once noise is added.
+  static constexpr float MinimumContrastThreshold = 0.01f;
+
+  DVSKernel::DVSKernel(const Config &config, uint32_t width, uint32_t height, uint64_t seed)
+    : _config(config),
+      _width(width),
+      _height(height),
+      _seed(seed),
+      _tiles((height + TileRows - 1u) / TileRows) {
+    const size_t size = static_cast<size_t>(width) * height;
+    _current.resize(size);
+    _previous.resize(size);
+    _reference.resize(size);
+    _last_event.resize(size, 0);
+    for (auto &tile : _tiles) {
+      tile.changed.resize(width);
+      tile.noise.resize(width);
+    }
+  }
+
+  bool DVSKernel::BeginFrame(const data::Color *image, size_t size, int64_t time_ns) {
+    _in_frame = (image != nullptr) && (size == _current.size());
+    _image = image;
+    _time = time_ns;
+    return _in_frame;
+  }
+
+  void DVSKernel::ProcessTile(size_t index) {
+    DEBUG_ASSERT(_in_frame);
+    DEBUG_ASSERT(index < _tiles.size());
+    Tile &tile = _tiles[index];
+    tile.events.clear();
+    const auto begin = static_cast<uint32_t>(index) * TileRows;
+    const auto end = std::min(begin + TileRows, _height);
+    for (uint32_t y = begin; y < end; ++y) {
+      const size_t offset = static_cast<size_t>(y) * _width;
+      ConvertRow(_image + offset, _current.data() + offset);
+      if (_frame == 0u) {
+        std::copy_n(_current.data() + offset, _width, _reference.data() + offset);
+      } else {
+        SimulateRow(y, tile);
+      }
+    }
+    // events come out in pixel order, keep it for equal timestamps.
+    std::stable_sort(tile.events.begin(), tile.events.end(), [](const data::DVSEvent &lhs, const data::DVSEvent &rhs) {
+      return lhs.t < rhs.t;
+    });
+  }
+
+  const std::vector<data::DVSEvent> &DVSKernel::EndFrame() {
+    _events.clear();
+    if (!_in_frame) {
+      return _events;
+    }
+    _in_frame = false;
+
+    size_t count = 0u;
+    for (const auto &tile : _tiles) {
+      count += tile.events.size();
+    }
+    _events.reserve(count);
+
+    // k-way merge of the sorted tiles, ties go to the first tile.
+    using Head = std::pair<int64_t, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    std::vector<size_t> next(_tiles.size(), 0u);
+    for (size_t i = 0u; i < _tiles.size(); ++i) {
+      if (!_tiles[i].events.empty()) {
+        heads.emplace(_tiles[i].events.front().t, i);
+      }
+    }
+    while (!heads.empty()) {
+      const size_t i = heads.top().second;
+      heads.pop();
+      const auto &events = _tiles[i].events;
+      _events.emplace_back(events[next[i]]);
+      if (++next[i] < events.size()) {
+        heads.emplace(events[next[i]].t, i);
+      }
+    }
+
+    std::swap(_previous, _current);
+    _previous_time = _time;
+    ++_frame;
+    return _events;
+  }
+
+  /// Noise of @a count pixels starting at @a first.
+  static void NormalRow(uint64_t key, uint32_t first, uint32_t count, float *noise) {
+    for (uint32_t i = 0u; i < count; ++i) {
+      noise[i] = FastMath::Normal(key, first + i);
+    }
+  }
+
+  void DVSKernel::ConvertRow(const data::Color *pixels, float *intensity) const {
+    const uint32_t width = _width;
+    for (uint32_t x = 0u; x < width; ++x) {
+      intensity[x] =
+          0.2989f * static_cast<float>(pixels[x].r) +
+          0.587f * static_cast<float>(pixels[x].g) +
+          0.114f * static_cast<float>(pixels[x].b);
+    }
+    if (_config.use_log) {
+      const float eps = _config.log_eps;
+      constexpr float scale = 1.0f / 255.0f;
+      for (uint32_t x = 0u; x < width; ++x) {
+        intensity[x] = FastMath::Log(eps + intensity[x] * scale);
+      }
+    }
+  }
+
+  void DVSKernel::SimulateRow(uint32_t y, Tile &tile) {
+    const size_t offset = static_cast<size_t>(y) * _width;
+    const float *current = _current.data() + offset;
+    const float *previous = _previous.data() + offset;
+    float *reference = _reference.data() + offset;
+    int64_t *last_event = _last_event.data() + offset;
+    uint8_t *changed = tile.changed.data();
+    float *noise = tile.noise.data();
+
+    const uint32_t width = _width;
+    uint32_t count = 0u;
+    for (uint32_t x = 0u; x < width; ++x) {
+      changed[x] = static_cast<uint8_t>(std::fabs(current[x] - previous[x]) > Tolerance);
+      count += changed[x];
+    }
+    if (count == 0u) {
+      return;
+    }
+    const bool has_noise =
+        (_config.sigma_positive_threshold > 0.0f) ||
+        (_config.sigma_negative_threshold > 0.0f);
+    if (has_noise) {
+      NormalRow(FastMath::MakeKey(_seed, _frame), static_cast<uint32_t>(offset), width, noise);
+    }
+
+    const float delta_time = static_cast<float>(_time - _previous_time);
+    for (uint32_t x = 0u; x < width; ++x) {
+      if (changed[x] == 0u) {
+        continue;
+      }
+      const float itdt = current[x];
+      const float it = previous[x];
+      const bool positive = (itdt >= it);
+      const float polarity = positive ? 1.0f : -1.0f;
+      float threshold = positive ? _config.positive_threshold : _config.negative_threshold;
+      const float sigma = positive ? _config.sigma_positive_threshold : _config.sigma_negative_threshold;
+      if (sigma > 0.0f) {
+        threshold += sigma * noise[x];
+        threshold = std::max(MinimumContrastThreshold, threshold);
+      }
+
+      float cross = reference[x];
+      for (;;) {
+        cross += polarity * threshold;
+        if (positive ? !((cross > it) && (cross <= itdt)) : !((cross < it) && (cross >= itdt))) {
+          break;
+        }
+        const auto edt = static_cast<uint64_t>((cross - it) * delta_time / (itdt - it));
+        const int64_t t = _previous_time + static_cast<int64_t>(edt);
+        // drop the event if the pixel is in its refractory period.
+        if (t >= last_event[x]) {
+          const auto dt = static_cast<uint64_t>(t - last_event[x]);
+          if ((last_event[x] == 0) || (dt >= _config.refractory_period_ns)) {
+            tile.events.emplace_back(
+                static_cast<uint16_t>(x),
+                static_cast<uint16_t>(y),
+                t,
+                positive);
+            last_event[x] = t;
+          }
+          reference[x] = cross;
+        }
+      }
+    }
+  }
+
+} // namespace sensor
+} // namespace carla
@@ -0,0 +1,151 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/NonCopyable.h"
+#include "carla/sensor/data/Color.h"
+#include "carla/sensor/data/DVSEvent.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace carla {
+namespace sensor {
+
+  /// Event simulation of the DVS camera, independent of the simulator.
+  ///
+  /// Every frame is converted to (log) intensity and compared with the
+  /// previous one. A pixel emits an event each time its intensity crosses
+  /// the contrast threshold from its last reference value, timestamped by
+  /// interpolating between both frames.
+  ///
+  /// The image is split in tiles of whole rows that can be processed in
+  /// parallel. Each tile keeps its own events, which are merged in timestamp
+  /// order when the frame ends. The threshold noise is drawn with FastMath
+  /// keyed by seed, frame and pixel, so the events do not depend on how the
+  /// tiles are scheduled.
+  class DVSKernel : private NonCopyable {
+  public:
+
+    struct Config {
+      float positive_threshold = 0.3f;
+      float negative_threshold = 0.3f;
+      float sigma_positive_threshold = 0.0f;
+      float sigma_negative_threshold = 0.0f;
+      uint64_t refractory_period_ns = 0u;
+      bool use_log = true;
+      float log_eps = 1e-3f;
+    };
+
+    /// Rows per tile.
+    static constexpr uint32_t TileRows = 16u;
+
+    DVSKernel(const Config &config, uint32_t width, uint32_t height, uint64_t seed = 0u);
+
+    const Config &GetConfig() const {
+      return _config;
+    }
+
+    uint32_t GetWidth() const {
+      return _width;
+    }
+
+    uint32_t GetHeight() const {
+      return _height;
+    }
+
+    size_t GetTileCount() const {
+      return _tiles.size();
+    }
+
+    /// Frames simulated so far.
+    uint64_t GetFrameCount() const {
+      return _frame;
+    }
+
+    /// Start the frame @a image, of @a size pixels, captured at @a time_ns.
+    /// The first frame only sets the reference intensity of every pixel.
+    /// Returns false if the size does not match the kernel's.
+    bool BeginFrame(const data::Color *image, size_t size, int64_t time_ns);
+
+    /// Convert and simulate the rows of @a tile. Different tiles may be
+    /// processed concurrently.
+    void ProcessTile(size_t tile);
+
+    /// Finish the frame and return its events sorted by timestamp; events
+    /// with the same timestamp are in pixel order. The array is reused by
+    /// the next frame.
+    const std::vector<data::DVSEvent> &EndFrame();
+
+    /// Simulate a whole frame, calling @a parallel_for(count, functor) to run
+    /// functor(tile) for every tile.
+    template <typename ParallelForT>
+    const std::vector<data::DVSEvent> &Simulate(
+        const data::Color *image,
+        size_t size,
+        int64_t time_ns,
+        ParallelForT &&parallel_for) {
+      if (BeginFrame(image, size, time_ns)) {
+        parallel_for(GetTileCount(), [this](size_t tile) { ProcessTile(tile); });
+      }
+      return EndFrame();
+    }
+
+  private:
+
+    struct Tile {
+      std::vector<data::DVSEvent> events;
+      /// Whether each pixel of the current row changed.
+      std::vector<uint8_t> changed;
+      /// Threshold noise of the current row.
+      std::vector<float> noise;
+    };
+
+    void ConvertRow(const data::Color *pixels, float *intensity) const;
+
+    void SimulateRow(uint32_t y, Tile &tile);
+
+    const Config _config;
+
+    const uint32_t _width;
+
+    const uint32_t _height;
+
+    const uint64_t _seed;
+
+    std::vector<Tile> _tiles;
+
+    /// @name Per pixel state
+    /// @{
+
+    std::vector<float> _current;
+
+    std::vector<float> _previous;
+
+    /// Intensity of the last threshold crossing.
+    std::vector<float> _reference;
+
+    /// Time of the last event in nanoseconds, zero if none.
+    std::vector<int64_t> _last_event;
+
+    /// @}
+
+    std::vector<data::DVSEvent> _events;
+
+    const data::Color *_image = nullptr;
+
+    int64_t _time = 0;
+
+    int64_t _previous_time = 0;
+
+    uint64_t _frame = 0u;
+
+    bool _in_frame = false;
+  };
+
+} // namespace sensor
+} // namespace carla
@@ -0,0 +1,151 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace carla {
+namespace sensor {
+
+  /// Math and random numbers for the per-pixel and per-point loops of the
+  /// sensors, in plain arithmetic so that the loops calling them vectorise.
+  /// The libm functions keep them scalar because of errno.
+  ///
+  /// Random numbers are counter based: a sample is a pure function of a key
+  /// and an index, so they can be drawn in any order and from any thread.
+  class FastMath {
+  public:
+
+    /// Natural logarithm, accurate to a few ulp for normal numbers; smaller
+    /// values are clamped to the smallest one.
+    static float Log(float x) {
+      // clamp on the bits, which sort like the floats for positive values, so
+      // that the compiler does not need to care about NaNs.
+      int32_t bits;
+      std::memcpy(&bits, &x, sizeof(bits));
+      bits = (bits > MinNormalBits) ? bits : MinNormalBits;
+      // x = m * 2^e with m in [sqrt(0.5), sqrt(2)).
+      const int32_t shifted = bits - SqrtHalfBits;
+      const int32_t e = shifted >> 23;
+      bits -= shifted & ~MantissaMask;
+      float m;
+      std::memcpy(&m, &bits, sizeof(m));
+      // log(m) = 2 atanh(s), with |s| < 0.172.
+      const float f = m - 1.0f;
+      const float s = f / (2.0f + f);
+      const float s2 = s * s;
+      const float series = 1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f + s2 * (1.0f / 9.0f))));
+      return static_cast<float>(e) * Ln2 + 2.0f * s * series;
+    }
+
+    /// Exponential of a non-positive @a x, accurate to a few ulp; values
+    /// below -87 are clamped to it.
+    static float Exp(float x) {
+      // clamp on the bits, which sort backwards for negative values.
+      uint32_t bits;
+      std::memcpy(&bits, &x, sizeof(bits));
+      bits = (bits < MinusEightySevenBits) ? bits : MinusEightySevenBits;
+      std::memcpy(&x, &bits, sizeof(x));
+      // e^x = 2^k * 2^f with f in (-0.5, 0.5].
+      const float t = x * Log2E;
+      const int32_t k = static_cast<int32_t>(t - 0.5f);
+      const float f = t - static_cast<float>(k);
+      const float p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f +
+          f * (0.00961812911f + f * (0.00133335581f + f * (1.54035304e-4f + f * 1.52527338e-5f))))));
+      const int32_t scale_bits = (k + 127) << 23;
+      float scale;
+      std::memcpy(&scale, &scale_bits, sizeof(scale));
+      return p * scale;
+    }
+
+    /// Square root of a non-negative @a x with Newton's method.
+    static float Sqrt(float x) {
+      int32_t bits;
+      std::memcpy(&bits, &x, sizeof(bits));
+      bits = 0x5f3759df - (bits >> 1);
+      float y;
+      std::memcpy(&y, &bits, sizeof(y));
+      for (int i = 0; i < 3; ++i) {
+        y *= 1.5f - 0.5f * x * y * y;
+      }
+      return x * y;
+    }
+
+    /// cos(2 pi u) for u in [0, 1), as -sin(2 pi (1/4 - |u - 1/2|)) which
+    /// only needs a polynomial on [-pi/2, pi/2].
+    static float CosTwoPi(float u) {
+      const float x = TwoPi * (0.25f - std::fabs(u - 0.5f));
+      const float x2 = x * x;
+      return -x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f +
+          x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+    }
+
+    /// splitmix64 finaliser.
+    static uint64_t Mix(uint64_t x) {
+      x += 0x9e3779b97f4a7c15u;
+      x = (x ^ (x >> 30u)) * 0xbf58476d1ce4e5b9u;
+      x = (x ^ (x >> 27u)) * 0x94d049bb133111ebu;
+      return x ^ (x >> 31u);
+    }
+
+    /// 32-bit integer hash (lowbias32), cheap enough to vectorise.
+    static uint32_t Hash(uint32_t x) {
+      x ^= x >> 16u;
+      x *= 0x7feb352du;
+      x ^= x >> 15u;
+      x *= 0x846ca68bu;
+      x ^= x >> 16u;
+      return x;
+    }
+
+    /// Key of the random numbers of @a seed for @a counter, e.g. a frame.
+    static uint64_t MakeKey(uint64_t seed, uint64_t counter) {
+      return Mix(seed ^ Mix(counter));
+    }
+
+    /// Uniform sample in [0, 1), with 24 bits.
+    static float Uniform(uint64_t key, uint32_t index) {
+      const uint32_t bits = Hash(Hash(index ^ static_cast<uint32_t>(key)) + static_cast<uint32_t>(key >> 32u));
+      return static_cast<float>(static_cast<int32_t>(bits >> 8u)) * UniformScale;
+    }
+
+    /// Standard normal sample, Box-Muller on two hashes of @a index.
+    static float Normal(uint64_t key, uint32_t index) {
+      const uint32_t first = Hash(index ^ static_cast<uint32_t>(key));
+      const uint32_t second = Hash(first + static_cast<uint32_t>(key >> 32u));
+      // 24 bits each, u1 in (0, 1] and u2 in [0, 1).
+      const float u1 = static_cast<float>(static_cast<int32_t>(first >> 8u) + 1) * UniformScale;
+      const float u2 = static_cast<float>(static_cast<int32_t>(second >> 8u)) * UniformScale;
+      return Sqrt(-2.0f * Log(u1)) * CosTwoPi(u2);
+    }
+
+  private:
+
+    /// Bit pattern of the smallest normal float.
+    static constexpr int32_t MinNormalBits = 0x00800000;
+
+    /// Bit pattern of sqrt(0.5), where the mantissa range of Log starts.
+    static constexpr int32_t SqrtHalfBits = 0x3f3504f3;
+
+    static constexpr int32_t MantissaMask = 0x007fffff;
+
+    /// Bit pattern of -87, the lower bound of Exp.
+    static constexpr uint32_t MinusEightySevenBits = 0xc2ae0000u;
+
+    static constexpr float Ln2 = 0.693147180559945f;
+
+    static constexpr float Log2E = 1.442695040888963f;
+
+    static constexpr float TwoPi = 6.283185307179586f;
+
+    static constexpr float UniformScale = 1.0f / 16777216.0f;
+  };
+
+} // namespace sensor
+} // namespace carla
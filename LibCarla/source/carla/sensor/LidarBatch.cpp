@@ -0,0 +1,143 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/sensor/LidarBatch.h"
+
+#include "carla/sensor/FastMath.h"
+
+#include <limits>
+
+namespace carla {
+namespace sensor {
+
+  /// Rates and deviations below this are disabled.
+  static constexpr float Epsilon = std::numeric_limits<float>::epsilon();
+
+  /// Added to the distances the noise is divided by.
+  static constexpr float MinimumDistance = 1e-30f;
+
+  void LidarBatch::SetConfig(const Config &config) {
+    _config = config;
+    _dropoff_alpha = config.dropoff_zero_intensity / config.dropoff_intensity_limit;
+    _dropoff_beta = 1.0f - config.dropoff_zero_intensity;
+  }
+
+  void LidarBatch::Reset(uint32_t channels, uint32_t points_per_channel, uint64_t seed) {
+    _channels.resize(channels);
+    for (auto &channel : _channels) {
+      channel.x.clear();
+      channel.y.clear();
+      channel.z.clear();
+      channel.x.reserve(points_per_channel);
+      channel.y.reserve(points_per_channel);
+      channel.z.reserve(points_per_channel);
+    }
+    _frame_key = FastMath::MakeKey(seed, _frame);
+    ++_frame;
+  }
+
+  uint64_t LidarBatch::GetKey(uint32_t channel, Stream stream) const {
+    return FastMath::MakeKey(_frame_key, static_cast<uint64_t>(channel) * Stream::SIZE + stream);
+  }
+
+  bool LidarBatch::IsRayKept(uint32_t channel, uint32_t index) const {
+    DEBUG_ASSERT(channel < _channels.size());
+    const float rate = _config.dropoff_general_rate;
+    return (rate <= Epsilon) || !(FastMath::Uniform(GetKey(channel, Stream::Rays), index) < rate);
+  }
+
+  void LidarBatch::ProcessChannel(uint32_t index, const Matrix &m) {
+    DEBUG_ASSERT(index < _channels.size());
+    auto &channel = _channels[index];
+    const auto count = static_cast<uint32_t>(channel.x.size());
+    channel.intensity.resize(count);
+    channel.kept.resize(count);
+    float *x = channel.x.data();
+    float *y = channel.y.data();
+    float *z = channel.z.data();
+    float *intensity = channel.intensity.data();
+    uint8_t *kept = channel.kept.data();
+
+    for (uint32_t i = 0u; i < count; ++i) {
+      const float wx = x[i];
+      const float wy = y[i];
+      const float wz = z[i];
+      x[i] = m[0u] * wx + m[1u] * wy + m[2u] * wz + m[3u];
+      y[i] = m[4u] * wx + m[5u] * wy + m[6u] * wz + m[7u];
+      z[i] = m[8u] * wx + m[9u] * wy + m[10u] * wz + m[11u];
+    }
+
+    // the intensity is attenuated over the distance before the noise.
+    const float rate = _config.atmosphere_attenuation_rate;
+    const float sigma = _config.noise_stddev;
+    if (sigma > Epsilon) {
+      const uint64_t key = GetKey(index, Stream::Noise);
+      for (uint32_t i = 0u; i < count; ++i) {
+        const float distance = FastMath::Sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        intensity[i] = FastMath::Exp(-rate * distance);
+        // move the point along its ray; a point at the sensor stays there.
+        const float noise = sigma * FastMath::Normal(key, i);
+        const float scale = 1.0f + noise / (distance + MinimumDistance);
+        x[i] *= scale;
+        y[i] *= scale;
+        z[i] *= scale;
+      }
+    } else {
+      for (uint32_t i = 0u; i < count; ++i) {
+        const float distance = FastMath::Sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        intensity[i] = FastMath::Exp(-rate * distance);
+      }
+    }
+
+    const float limit = _config.dropoff_intensity_limit;
+    const float alpha = _dropoff_alpha;
+    const float beta = _dropoff_beta;
+    const uint64_t key = GetKey(index, Stream::DropOff);
+    for (uint32_t i = 0u; i < count; ++i) {
+      const float sample = FastMath::Uniform(key, i);
+      kept[i] = static_cast<uint8_t>((intensity[i] > limit) | (sample < alpha * intensity[i] + beta));
+    }
+
+    uint32_t size = 0u;
+    for (uint32_t i = 0u; i < count; ++i) {
+      if (kept[i] != 0u) {
+        x[size] = x[i];
+        y[size] = y[i];
+        z[size] = z[i];
+        intensity[size] = intensity[i];
+        ++size;
+      }
+    }
+    channel.x.resize(size);
+    channel.y.resize(size);
+    channel.z.resize(size);
+    channel.intensity.resize(size);
+  }
+
+  size_t LidarBatch::GetTotalPointCount() const {
+    size_t total = 0u;
+    for (const auto &channel : _channels) {
+      total += channel.x.size();
+    }
+    return total;
+  }
+
+  void LidarBatch::WritePoints(float *output) const {
+    for (const auto &channel : _channels) {
+      const size_t count = channel.x.size();
+      DEBUG_ASSERT(channel.intensity.size() == count);
+      for (size_t i = 0u; i < count; ++i) {
+        output[4u * i + 0u] = channel.x[i];
+        output[4u * i + 1u] = channel.y[i];
+        output[4u * i + 2u] = channel.z[i];
+        output[4u * i + 3u] = channel.intensity[i];
+      }
+      output += 4u * count;
+    }
+  }
+
+} // namespace sensor
+} // namespace carla
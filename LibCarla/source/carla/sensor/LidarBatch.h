@@ -0,0 +1,149 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/Debug.h"
+#include "carla/NonCopyable.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace carla {
+namespace sensor {
+
+  /// Post-processing of the hits of the ray-cast lidar, independent of the
+  /// simulator.
+  ///
+  /// The hits of each channel are kept as separate x, y, z arrays that are
+  /// reused every frame. A channel is processed in a few plain loops over
+  /// these arrays: transform to sensor space, atmospheric attenuation, noise
+  /// along the ray and intensity drop-off, and then the dropped points are
+  /// compacted away. Different channels may be processed concurrently.
+  ///
+  /// Random numbers are drawn with FastMath keyed by seed, frame, channel and
+  /// ray or hit index, so the result does not depend on how the channels are
+  /// scheduled.
+  class LidarBatch : private NonCopyable {
+  public:
+
+    struct Config {
+      float atmosphere_attenuation_rate = 0.004f;
+      float noise_stddev = 0.0f;
+      float dropoff_general_rate = 0.45f;
+      float dropoff_intensity_limit = 0.8f;
+      float dropoff_zero_intensity = 0.4f;
+    };
+
+    /// Row-major 3x4 affine transform from world to sensor space, including
+    /// the change of units.
+    using Matrix = std::array<float, 12u>;
+
+    LidarBatch() {
+      SetConfig(Config{});
+    }
+
+    explicit LidarBatch(const Config &config) {
+      SetConfig(config);
+    }
+
+    void SetConfig(const Config &config);
+
+    const Config &GetConfig() const {
+      return _config;
+    }
+
+    /// Start a frame of @a channels channels with up to @a points_per_channel
+    /// rays each. Keeps the memory of the previous frames.
+    void Reset(uint32_t channels, uint32_t points_per_channel, uint64_t seed);
+
+    /// Frames started so far.
+    uint64_t GetFrameCount() const {
+      return _frame;
+    }
+
+    uint32_t GetChannelCount() const {
+      return static_cast<uint32_t>(_channels.size());
+    }
+
+    /// Whether the ray @a index of @a channel survives the general drop-off
+    /// and has to be traced.
+    bool IsRayKept(uint32_t channel, uint32_t index) const;
+
+    /// Record a hit of @a channel at world position (@a x, @a y, @a z). Hits
+    /// of different channels may be added concurrently.
+    void AddHit(uint32_t channel, float x, float y, float z) {
+      DEBUG_ASSERT(channel < _channels.size());
+      auto &hits = _channels[channel];
+      hits.x.emplace_back(x);
+      hits.y.emplace_back(y);
+      hits.z.emplace_back(z);
+    }
+
+    /// Compute the detections of the hits of @a channel, dropping those that
+    /// are lost.
+    void ProcessChannel(uint32_t channel, const Matrix &world_to_sensor);
+
+    /// Process every channel, calling @a parallel_for(count, functor) to run
+    /// functor(channel) for every channel.
+    template <typename ParallelForT>
+    void Process(const Matrix &world_to_sensor, ParallelForT &&parallel_for) {
+      parallel_for(_channels.size(), [this, &world_to_sensor](size_t channel) {
+        ProcessChannel(static_cast<uint32_t>(channel), world_to_sensor);
+      });
+    }
+
+    /// Points of @a channel, hits before it is processed.
+    uint32_t GetPointCount(uint32_t channel) const {
+      DEBUG_ASSERT(channel < _channels.size());
+      return static_cast<uint32_t>(_channels[channel].x.size());
+    }
+
+    size_t GetTotalPointCount() const;
+
+    /// Write the points of every channel in order as x, y, z, intensity.
+    /// @a output must have room for 4 * GetTotalPointCount() floats.
+    void WritePoints(float *output) const;
+
+  private:
+
+    struct Channel {
+      std::vector<float> x;
+      std::vector<float> y;
+      std::vector<float> z;
+      std::vector<float> intensity;
+      /// Whether each hit is kept.
+      std::vector<uint8_t> kept;
+    };
+
+    /// Random streams of a frame and channel.
+    enum Stream : uint32_t {
+      Rays,
+      Noise,
+      DropOff,
+      SIZE
+    };
+
+    uint64_t GetKey(uint32_t channel, Stream stream) const;
+
+    Config _config;
+
+    /// Probability of keeping a point is alpha * intensity + beta below the
+    /// intensity limit.
+    float _dropoff_alpha = 0.0f;
+
+    float _dropoff_beta = 0.0f;
+
+    std::vector<Channel> _channels;
+
+    uint64_t _frame_key = 0u;
+
+    uint64_t _frame = 0u;
+  };
+
+} // namespace sensor
+} // namespace carla
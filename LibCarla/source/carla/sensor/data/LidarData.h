@@ -80,7 +80,7 @@ namespace data {
     ~LidarData() = default;
 
     virtual void ResetMemory(std::vector<uint32_t> points_per_channel) {
-      DEBUG_ASSERT(GetChannelCount() > points_per_channel.size());
+      DEBUG_ASSERT(GetChannelCount() <= points_per_channel.size());
       std::memset(_header.data() + Index::SIZE, 0, sizeof(uint32_t) * GetChannelCount());
 
       uint32_t total_points = static_cast<uint32_t>(
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "carla/Debug.h"
+#include "carla/ListView.h"
 #include "carla/sensor/data/ActorDynamicState.h"
 #include "carla/sensor/data/Array.h"
 #include "carla/sensor/s11n/EpisodeStateSerializer.h"
@@ -25,7 +26,9 @@ namespace data {
     friend Serializer;
 
     explicit RawEpisodeState(RawData &&data)
-      : Super(Serializer::header_offset, std::move(data)) {}
+      : Super(std::move(data), [](const RawData &message) {
+          return Serializer::GetActorsOffset(message);
+        }) {}
 
   private:
 
@@ -66,6 +69,26 @@ namespace data {
       return GetHeader().simulation_state;
     }
 
+    /// Whether this frame only contains the actors that changed since
+    /// GetBaseFrame(), instead of every actor in the episode.
+    bool IsDeltaFrame() const {
+      return Serializer::IsDeltaFrame(GetHeader());
+    }
+
+    /// Frame the delta applies to.
+    /// @pre IsDeltaFrame().
+    uint64_t GetBaseFrame() const {
+      return Serializer::DeserializeDeltaHeader(Super::GetRawData()).base_frame;
+    }
+
+    /// Ids of the actors removed since the base frame.
+    /// @pre IsDeltaFrame().
+    auto GetRemovedActorIds() const {
+      const auto &delta = Serializer::DeserializeDeltaHeader(Super::GetRawData());
+      auto begin = reinterpret_cast<const ActorId *>(&delta + 1);
+      return MakeListView(begin, begin + delta.number_of_removed_actors);
+    }
+
   };
 
 } // namespace data
@@ -0,0 +1,188 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "carla/sensor/s11n/EpisodeStateDeltaEncoder.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace carla {
+namespace sensor {
+namespace s11n {
+
+  using SimulationState = EpisodeStateSerializer::SimulationState;
+
+  static bool IsBeyond(const geom::Vector3D &lhs, const geom::Vector3D &rhs, float threshold) {
+    return (lhs - rhs).SquaredLength() > threshold * threshold;
+  }
+
+  static bool IsBeyond(const geom::Rotation &lhs, const geom::Rotation &rhs, float threshold) {
+    return
+        std::abs(lhs.pitch - rhs.pitch) > threshold ||
+        std::abs(lhs.yaw - rhs.yaw) > threshold ||
+        std::abs(lhs.roll - rhs.roll) > threshold;
+  }
+
+  static SimulationState SetDeltaFrame(SimulationState state, bool delta) {
+    const auto flags = static_cast<uint32_t>(state) & ~static_cast<uint32_t>(SimulationState::DeltaFrame);
+    return static_cast<SimulationState>(delta ? flags | SimulationState::DeltaFrame : flags);
+  }
+
+  class BufferWriter {
+  public:
+
+    BufferWriter(Buffer &buffer, size_t size) : _buffer(buffer) {
+      _buffer.reset(size);
+    }
+
+    void Write(const void *data, size_t size) {
+      DEBUG_ASSERT(_size + size <= _buffer.size());
+      std::memcpy(_buffer.data() + _size, data, size);
+      _size += size;
+    }
+
+    template <typename T>
+    void Write(const T &value) {
+      Write(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void Write(const std::vector<T> &values) {
+      Write(values.data(), sizeof(T) * values.size());
+    }
+
+  private:
+
+    Buffer &_buffer;
+
+    size_t _size = 0u;
+  };
+
+  bool EpisodeStateDeltaEncoder::HasChanged(
+      const ActorDynamicState &sent,
+      const ActorDynamicState &current) const {
+    if (std::memcmp(&sent, &current, sizeof(ActorDynamicState)) == 0) {
+      return false;
+    }
+    // The type dependent state (controls, lights, traffic light state...) is
+    // always sent on change.
+    if ((sent.actor_state != current.actor_state) ||
+        (std::memcmp(&sent.state, &current.state, sizeof(sent.state)) != 0)) {
+      return true;
+    }
+    const geom::Transform sent_transform = sent.transform;
+    const geom::Transform current_transform = current.transform;
+    return
+        IsBeyond(sent_transform.location, current_transform.location, _parameters.location_threshold) ||
+        IsBeyond(sent_transform.rotation, current_transform.rotation, _parameters.rotation_threshold) ||
+        IsBeyond(sent.velocity, current.velocity, _parameters.velocity_threshold) ||
+        IsBeyond(sent.angular_velocity, current.angular_velocity, _parameters.velocity_threshold) ||
+        IsBeyond(sent.acceleration, current.acceleration, _parameters.acceleration_threshold);
+  }
+
+  Buffer EpisodeStateDeltaEncoder::Encode(
+      const uint64_t frame,
+      Header header,
+      const std::vector<ActorDynamicState> &actors,
+      Buffer &&buffer) {
+    const bool keyframe_requested =
+        _keyframe_requested.exchange(false, std::memory_order_acq_rel);
+    if (!_has_state ||
+        keyframe_requested ||
+        (header.episode_id != _episode_id) ||
+        (_frames_since_keyframe + 1u >= _parameters.keyframe_interval)) {
+      return EncodeKeyframe(frame, header, actors, std::move(buffer));
+    }
+
+    _changed.clear();
+    _removed.clear();
+    _seen.assign(_state.size(), 0u);
+    for (auto &actor : actors) {
+      const ActorId id = actor.id;
+      auto it = _index.find(id);
+      if (it == _index.end()) {
+        _changed.emplace_back(actor);
+      } else {
+        _seen[it->second] = 1u;
+        if (HasChanged(_state[it->second], actor)) {
+          _changed.emplace_back(actor);
+        }
+      }
+    }
+    for (auto i = 0u; i < _state.size(); ++i) {
+      if (_seen[i] == 0u) {
+        const ActorId id = _state[i].id;
+        _removed.emplace_back(id);
+      }
+    }
+
+    const size_t delta_size =
+        sizeof(EpisodeStateSerializer::DeltaHeader) +
+        sizeof(ActorId) * _removed.size() +
+        sizeof(ActorDynamicState) * _changed.size();
+    if (delta_size >= sizeof(ActorDynamicState) * actors.size()) {
+      // Nothing to gain.
+      return EncodeKeyframe(frame, header, actors, std::move(buffer));
+    }
+
+    header.simulation_state = SetDeltaFrame(header.simulation_state, true);
+    EpisodeStateSerializer::DeltaHeader delta;
+    delta.base_frame = _frame;
+    delta.number_of_removed_actors = static_cast<uint32_t>(_removed.size());
+    BufferWriter writer(buffer, sizeof(Header) + delta_size);
+    writer.Write(header);
+    writer.Write(delta);
+    writer.Write(_removed);
+    writer.Write(_changed);
+
+    const size_t base_size = _state.size();
+    EpisodeStateSerializer::ApplyDelta(
+        _state,
+        [this](ActorId id) -> size_t {
+          auto it = _index.find(id);
+          return it != _index.end() ? it->second : _state.size();
+        },
+        _removed,
+        _changed);
+    if (!_removed.empty() || (_state.size() != base_size)) {
+      RebuildIndex();
+    }
+    _frame = frame;
+    ++_frames_since_keyframe;
+    return std::move(buffer);
+  }
+
+  Buffer EpisodeStateDeltaEncoder::EncodeKeyframe(
+      const uint64_t frame,
+      Header header,
+      const std::vector<ActorDynamicState> &actors,
+      Buffer &&buffer) {
+    header.simulation_state = SetDeltaFrame(header.simulation_state, false);
+    BufferWriter writer(buffer, sizeof(Header) + sizeof(ActorDynamicState) * actors.size());
+    writer.Write(header);
+    writer.Write(actors);
+
+    _state = actors;
+    RebuildIndex();
+    _has_state = true;
+    _episode_id = header.episode_id;
+    _frame = frame;
+    _frames_since_keyframe = 0u;
+    return std::move(buffer);
+  }
+
+  void EpisodeStateDeltaEncoder::RebuildIndex() {
+    _index.clear();
+    _index.reserve(_state.size());
+    for (auto i = 0u; i < _state.size(); ++i) {
+      const ActorId id = _state[i].id;
+      _index.emplace(id, i);
+    }
+  }
+
+} // namespace s11n
+} // namespace sensor
+} // namespace carla
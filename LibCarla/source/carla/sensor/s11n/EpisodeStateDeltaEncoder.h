@@ -0,0 +1,140 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include "carla/Buffer.h"
+#include "carla/NonCopyable.h"
+#include "carla/sensor/data/ActorDynamicState.h"
+#include "carla/sensor/s11n/EpisodeStateSerializer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace carla {
+namespace sensor {
+namespace s11n {
+
+  struct EpisodeStateDeltaParameters {
+    /// Number of frames between keyframes. Clients that subscribe to the
+    /// stream or request a keyframe get one on the next frame regardless.
+    uint32_t keyframe_interval = 30u;
+
+    /// Meters.
+    float location_threshold = 1e-3f;
+
+    /// Degrees.
+    float rotation_threshold = 1e-2f;
+
+    /// Meters per second for the velocity, degrees per second for the
+    /// angular velocity.
+    float velocity_threshold = 1e-2f;
+
+    /// Meters per second squared.
+    float acceleration_threshold = 1e-1f;
+  };
+
+  /// Encodes the episode state stream as periodic keyframes with every actor,
+  /// and in between, deltas with only the actors whose state changed beyond
+  /// a threshold since it was last sent, plus the ids of the actors removed.
+  ///
+  /// The encoder keeps the state of the actors as the clients rebuild it, so
+  /// changes below the thresholds do not accumulate over time.
+  class EpisodeStateDeltaEncoder : private NonCopyable {
+  public:
+
+    using ActorDynamicState = data::ActorDynamicState;
+
+    using Header = EpisodeStateSerializer::Header;
+
+    using Parameters = EpisodeStateDeltaParameters;
+
+    explicit EpisodeStateDeltaEncoder(Parameters parameters = Parameters())
+      : _parameters(parameters) {}
+
+    /// Write @a header followed by the state of @a actors at @a frame into
+    /// @a buffer, either as a keyframe or as a delta over the previous frame
+    /// encoded.
+    Buffer Encode(
+        uint64_t frame,
+        Header header,
+        const std::vector<ActorDynamicState> &actors,
+        Buffer &&buffer);
+
+    /// Make the next frame a keyframe.
+    void Reset() {
+      _has_state = false;
+    }
+
+    /// Make the next frame a keyframe, e.g. for a client that missed the
+    /// base frame of a delta. Can be called from any thread.
+    void RequestKeyframe() {
+      _keyframe_requested.store(true, std::memory_order_release);
+    }
+
+    /// Make the next frame a keyframe if a client subscribed to the stream
+    /// since the last call. @a number_of_subscriptions is the number of
+    /// subscriptions to the stream so far.
+    void UpdateSubscriptions(uint64_t number_of_subscriptions) {
+      if (number_of_subscriptions != _number_of_subscriptions) {
+        _number_of_subscriptions = number_of_subscriptions;
+        _has_state = false;
+      }
+    }
+
+    /// State of the actors as the clients rebuild it from the frames encoded
+    /// so far.
+    const std::vector<ActorDynamicState> &GetEncodedState() const {
+      return _state;
+    }
+
+  private:
+
+    bool HasChanged(const ActorDynamicState &sent, const ActorDynamicState &current) const;
+
+    Buffer EncodeKeyframe(
+        uint64_t frame,
+        Header header,
+        const std::vector<ActorDynamicState> &actors,
+        Buffer &&buffer);
+
+    void RebuildIndex();
+
+    const Parameters _parameters;
+
+    bool _has_state = false;
+
+    uint64_t _episode_id = 0u;
+
+    uint64_t _frame = 0u;
+
+    uint32_t _frames_since_keyframe = 0u;
+
+    uint64_t _number_of_subscriptions = 0u;
+
+    std::atomic_bool _keyframe_requested{false};
+
+    std::vector<ActorDynamicState> _state;
+
+    std::unordered_map<ActorId, uint32_t> _index;
+
+    /// @name Reused between frames
+    /// @{
+
+    std::vector<ActorDynamicState> _changed;
+
+    std::vector<ActorId> _removed;
+
+    std::vector<uint8_t> _seen;
+
+    /// @}
+  };
+
+} // namespace s11n
+} // namespace sensor
+} // namespace carla
@@ -14,7 +14,9 @@
 #include "carla/sensor/RawData.h"
 #include "carla/sensor/data/ActorDynamicState.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 namespace carla {
 namespace sensor {
@@ -30,7 +32,10 @@ namespace s11n {
     enum SimulationState {
       None               = (0x0 << 0),
       MapChange          = (0x1 << 0),
-      PendingLightUpdate = (0x1 << 1)
+      PendingLightUpdate = (0x1 << 1),
+      /// The actors are only those that changed since the previous frame, see
+      /// DeltaHeader.
+      DeltaFrame         = (0x1 << 2)
     };
 
 #pragma pack(push, 1)
@@ -41,6 +46,14 @@ namespace s11n {
       geom::Vector3DInt map_origin;
       SimulationState simulation_state = SimulationState::None;
     };
+
+    /// Follows the Header in delta frames. The ids of the actors removed since
+    /// the base frame come right after it, followed by the state of the
+    /// actors that changed or were added.
+    struct DeltaHeader {
+      uint64_t base_frame;
+      uint32_t number_of_removed_actors;
+    };
 #pragma pack(pop)
 
     constexpr static auto header_offset = sizeof(Header);
@@ -49,6 +62,57 @@ namespace s11n {
       return *reinterpret_cast<const Header *>(message.begin());
     }
 
+    static bool IsDeltaFrame(const Header &header) {
+      return (header.simulation_state & SimulationState::DeltaFrame) != SimulationState::None;
+    }
+
+    /// @pre IsDeltaFrame(DeserializeHeader(message)).
+    static const DeltaHeader &DeserializeDeltaHeader(const RawData &message) {
+      return *reinterpret_cast<const DeltaHeader *>(message.begin() + header_offset);
+    }
+
+    /// Offset of the array of actors within the message.
+    static size_t GetActorsOffset(const RawData &message) {
+      if (!IsDeltaFrame(DeserializeHeader(message))) {
+        return header_offset;
+      }
+      return header_offset + sizeof(DeltaHeader) +
+          sizeof(ActorId) * DeserializeDeltaHeader(message).number_of_removed_actors;
+    }
+
+    /// Rebuild the actors of a delta frame. On input @a actors holds the
+    /// actors of the base frame, and @a find_position returns the position of
+    /// an actor within them (or any position past the end if missing).
+    ///
+    /// Both ends of the stream use this to apply the deltas so they agree on
+    /// the order of the actors.
+    template <typename FindT, typename RemovedRangeT, typename ChangedRangeT>
+    static void ApplyDelta(
+        std::vector<data::ActorDynamicState> &actors,
+        FindT &&find_position,
+        const RemovedRangeT &removed,
+        const ChangedRangeT &changed) {
+      const size_t base_size = actors.size();
+      for (auto &&actor : changed) {
+        const size_t position = find_position(actor.id);
+        if (position < base_size) {
+          actors[position] = actor;
+        } else {
+          actors.emplace_back(actor);
+        }
+      }
+      if (std::begin(removed) != std::end(removed)) {
+        std::vector<ActorId> sorted(std::begin(removed), std::end(removed));
+        std::sort(sorted.begin(), sorted.end());
+        actors.erase(
+            std::remove_if(actors.begin(), actors.end(), [&](const auto &actor) {
+              const ActorId id = actor.id;
+              return std::binary_search(sorted.begin(), sorted.end(), id);
+            }),
+            actors.end());
+      }
+    }
+
     template <typename SensorT>
     static Buffer Serialize(const SensorT &, Buffer &&buffer) {
       return std::move(buffer);
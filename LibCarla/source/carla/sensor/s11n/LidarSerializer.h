@@ -8,9 +8,12 @@
 
 #include "carla/Debug.h"
 #include "carla/Memory.h"
+#include "carla/sensor/LidarBatch.h"
 #include "carla/sensor/RawData.h"
 #include "carla/sensor/data/LidarData.h"
 
+#include <cstring>
+
 namespace carla {
 namespace sensor {
 
@@ -73,6 +76,15 @@ namespace s11n {
         const data::LidarData &data,
         Buffer &&output);
 
+    /// Serialize the header of @a data followed by the points of @a batch,
+    /// written straight into @a output.
+    template <typename Sensor>
+    static Buffer Serialize(
+        const Sensor &sensor,
+        const data::LidarData &data,
+        const LidarBatch &batch,
+        Buffer &&output);
+
     static SharedPtr<SensorData> Deserialize(RawData &&data);
   };
 
@@ -92,6 +104,20 @@ namespace s11n {
     return std::move(output);
   }
 
+  template <typename Sensor>
+  inline Buffer LidarSerializer::Serialize(
+      const Sensor &,
+      const data::LidarData &data,
+      const LidarBatch &batch,
+      Buffer &&output) {
+    const size_t header_size = sizeof(uint32_t) * data._header.size();
+    const size_t points_size = 4u * sizeof(float) * batch.GetTotalPointCount();
+    output.reset(header_size + points_size);
+    std::memcpy(output.data(), data._header.data(), header_size);
+    batch.WritePoints(reinterpret_cast<float *>(output.data() + header_size));
+    return std::move(output);
+  }
+
 } // namespace s11n
 } // namespace sensor
 } // namespace carla
@@ -54,12 +54,19 @@ namespace detail {
       }
     }
 
+    /// Number of sessions that have connected to this stream so far,
+    /// including the ones already disconnected.
+    uint64_t GetNumberOfSubscriptions() const {
+      return _number_of_subscriptions.load(std::memory_order_acquire);
+    }
+
   private:
 
     void ConnectSession(std::shared_ptr<Session> session) final {
       DEBUG_ASSERT(session != nullptr);
       std::lock_guard<std::mutex> lock(_mutex);
       _sessions.emplace_back(std::move(session));
+      _number_of_subscriptions.fetch_add(1u, std::memory_order_release);
       log_debug("Connecting multistream sessions:", _sessions.size());
       if (_sessions.size() == 1) {
         _session.store(_sessions[0]);
@@ -104,6 +111,8 @@ namespace detail {
     AtomicSharedPtr<Session> _session;
     // if there are more than one session, we use vector of sessions with mutex
     std::vector<std::shared_ptr<Session>> _sessions;
+
+    std::atomic<uint64_t> _number_of_subscriptions{0u};
   };
 
 } // namespace detail
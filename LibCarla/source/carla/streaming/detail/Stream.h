@@ -36,6 +36,11 @@ namespace detail {
       return _shared_state->token();
     }
 
+    /// Number of clients that have subscribed to this stream so far.
+    uint64_t GetNumberOfSubscriptions() const {
+      return _shared_state->GetNumberOfSubscriptions();
+    }
+
     /// Pull a buffer from the buffer pool associated to this stream. Discarded
     /// buffers are re-used to avoid memory allocations.
     ///
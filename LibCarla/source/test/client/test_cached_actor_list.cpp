@@ -0,0 +1,106 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "test.h"
+
+#include <carla/StopWatch.h>
+#include <carla/ThreadGroup.h>
+#include <carla/client/detail/CachedActorList.h>
+
+#include <atomic>
+#include <numeric>
+
+using carla::client::detail::CachedActorList;
+
+static carla::rpc::Actor MakeActor(carla::ActorId id) {
+  carla::rpc::Actor actor;
+  actor.id = id;
+  actor.description.id = "walker.pedestrian.0001";
+  return actor;
+}
+
+TEST(cached_actor_list, insert_and_find) {
+  CachedActorList list;
+  ASSERT_FALSE(list.GetActorById(1u).has_value());
+  list.Insert(MakeActor(1u));
+  std::vector<carla::rpc::Actor> actors;
+  for (auto id = 2u; id < 40u; ++id) {
+    actors.emplace_back(MakeActor(id));
+  }
+  list.InsertRange(actors);
+
+  auto actor = list.GetActorById(17u);
+  ASSERT_TRUE(actor.has_value());
+  ASSERT_EQ(actor->id, 17u);
+  ASSERT_EQ(actor->description.id, "walker.pedestrian.0001");
+
+  const std::vector<carla::ActorId> ids = {1u, 39u, 40u, 100u, 5u};
+  const auto missing = list.GetMissingIds(ids);
+  ASSERT_EQ(missing, (std::vector<carla::ActorId>{40u, 100u}));
+  const auto found = list.GetActorsById(ids);
+  ASSERT_EQ(found.size(), 3u);
+  ASSERT_EQ(found[0u].id, 1u);
+  ASSERT_EQ(found[1u].id, 39u);
+  ASSERT_EQ(found[2u].id, 5u);
+
+  list.Clear();
+  ASSERT_FALSE(list.GetActorById(1u).has_value());
+  ASSERT_EQ(list.GetMissingIds(ids).size(), ids.size());
+}
+
+TEST(cached_actor_list, contention_benchmark) {
+  constexpr auto number_of_actors = 1000u;
+  constexpr auto number_of_reads = 200u;
+
+  for (auto number_of_readers : {1u, 2u, 4u, 8u}) {
+    CachedActorList list;
+    std::vector<carla::rpc::Actor> actors;
+    for (auto id = 0u; id < number_of_actors; ++id) {
+      actors.emplace_back(MakeActor(id));
+    }
+    list.InsertRange(actors);
+    std::vector<carla::ActorId> ids(number_of_actors);
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    // One writer keeps adding actors while the readers query the whole list,
+    // as a client spawning actors while other threads call get_actors().
+    std::atomic_bool done{false};
+    std::atomic_size_t inserted{0u};
+    std::atomic_size_t failed{0u};
+    carla::StopWatch stop_watch;
+    {
+      carla::ThreadGroup threads;
+      threads.CreateThread([&]() {
+        for (auto id = number_of_actors; !done; ++id) {
+          list.Insert(MakeActor(id));
+          ++inserted;
+        }
+      });
+      carla::ThreadGroup readers;
+      for (auto i = 0u; i < number_of_readers; ++i) {
+        readers.CreateThread([&]() {
+          for (auto j = 0u; j < number_of_reads; ++j) {
+            if (list.GetActorsById(ids).size() != number_of_actors) {
+              ++failed;
+            }
+          }
+        });
+      }
+      readers.JoinAll();
+      stop_watch.Stop();
+      done = true;
+    }
+    ASSERT_EQ(failed, 0u);
+
+    const auto elapsed_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+    const auto total_reads = number_of_readers * number_of_reads;
+    carla::logging::log(
+        number_of_readers, "readers:",
+        elapsed_us > 0u ? 1e6 * total_reads / static_cast<double>(elapsed_us) : 0.0,
+        "lookups of", number_of_actors, "actors per second,",
+        inserted.load(), "actors inserted meanwhile");
+  }
+}
@@ -0,0 +1,481 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "test.h"
+#include "Random.h"
+
+#include <carla/StopWatch.h>
+#include <carla/client/detail/EpisodeState.h>
+#include <carla/sensor/Deserializer.h>
+#include <carla/sensor/SensorRegistry.h>
+#include <carla/sensor/s11n/EpisodeStateDeltaEncoder.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using carla::client::ActorSnapshot;
+using carla::client::detail::EpisodeState;
+using carla::sensor::data::ActorDynamicState;
+using carla::sensor::data::RawEpisodeState;
+using carla::sensor::s11n::EpisodeStateDeltaEncoder;
+using util::Random;
+
+namespace episode_state_util {
+
+  using EpisodeHeader = carla::sensor::s11n::EpisodeStateSerializer::Header;
+  using SensorHeader = carla::sensor::s11n::SensorHeaderSerializer::Header;
+
+  static ActorDynamicState MakeActor(carla::ActorId id) {
+    ActorDynamicState actor{};
+    actor.id = id;
+    actor.actor_state = carla::rpc::ActorState::Active;
+    actor.transform = carla::geom::Transform{
+        Random::Location(-100.0f, 100.0f),
+        carla::geom::Rotation{0.0f, static_cast<float>(Random::Uniform(-180.0, 180.0)), 0.0f}};
+    actor.velocity = Random::Location(-10.0f, 10.0f);
+    actor.angular_velocity = Random::Location(-1.0f, 1.0f);
+    actor.acceleration = Random::Location(-1.0f, 1.0f);
+    return actor;
+  }
+
+  /// Prepend the header the streaming adds to every sensor message.
+  static carla::Buffer AddSensorHeader(uint64_t frame, const carla::Buffer &payload) {
+    SensorHeader sensor_header{};
+    sensor_header.sensor_type =
+        carla::sensor::SensorRegistry::get<FWorldObserver *>::index;
+    sensor_header.frame = frame;
+    sensor_header.timestamp = 0.05 * static_cast<double>(frame);
+    carla::Buffer buffer(sizeof(sensor_header) + payload.size());
+    std::memcpy(buffer.data(), &sensor_header, sizeof(sensor_header));
+    std::memcpy(buffer.data() + sizeof(sensor_header), payload.data(), payload.size());
+    return buffer;
+  }
+
+  static EpisodeHeader MakeEpisodeHeader() {
+    EpisodeHeader episode_header{};
+    episode_header.episode_id = 42u;
+    episode_header.delta_seconds = 0.05f;
+    return episode_header;
+  }
+
+  /// Buffer as the simulator streams it.
+  static carla::Buffer MakeBuffer(uint64_t frame, const std::vector<ActorDynamicState> &actors) {
+    const auto episode_header = MakeEpisodeHeader();
+    const auto actors_size = sizeof(ActorDynamicState) * actors.size();
+    carla::Buffer payload(sizeof(episode_header) + actors_size);
+    std::memcpy(payload.data(), &episode_header, sizeof(episode_header));
+    std::memcpy(payload.data() + sizeof(episode_header), actors.data(), actors_size);
+    return AddSensorHeader(frame, payload);
+  }
+
+  static auto Deserialize(carla::Buffer buffer) {
+    auto data = carla::sensor::Deserializer::Deserialize(std::move(buffer));
+    return boost::static_pointer_cast<const RawEpisodeState>(std::move(data));
+  }
+
+  static auto MakeState(uint64_t frame, const std::vector<ActorDynamicState> &actors) {
+    return std::make_shared<const EpisodeState>(Deserialize(MakeBuffer(frame, actors)));
+  }
+
+  static std::vector<ActorDynamicState> MakeActors(size_t count) {
+    std::vector<carla::ActorId> ids(count);
+    // Sparse ids in random order, like after destroying and spawning actors.
+    for (auto i = 0u; i < count; ++i) {
+      ids[i] = 3u * i + 1u;
+    }
+    Random::Shuffle(ids);
+    std::vector<ActorDynamicState> actors;
+    actors.reserve(count);
+    for (auto id : ids) {
+      actors.emplace_back(MakeActor(id));
+    }
+    return actors;
+  }
+
+} // namespace episode_state_util
+
+using namespace episode_state_util;
+
+static void CheckSnapshot(const ActorDynamicState &expected, const ActorSnapshot &snapshot) {
+  ASSERT_EQ(snapshot.id, expected.id);
+  ASSERT_EQ(snapshot.transform, expected.transform);
+  ASSERT_EQ(snapshot.velocity, expected.velocity);
+  ASSERT_EQ(snapshot.angular_velocity, expected.angular_velocity);
+  ASSERT_EQ(snapshot.acceleration, expected.acceleration);
+}
+
+TEST(episode_state, lookup) {
+  for (auto count : {0u, 5u, 16u, 17u, 1000u}) {
+    const auto actors = MakeActors(count);
+    const auto state = MakeState(7u, actors);
+    ASSERT_EQ(state->GetEpisodeId(), 42u);
+    ASSERT_EQ(state->GetFrame(), 7u);
+    ASSERT_EQ(state->size(), count);
+
+    for (auto &actor : actors) {
+      ASSERT_TRUE(state->ContainsActorSnapshot(actor.id));
+      CheckSnapshot(actor, state->GetActorSnapshot(actor.id));
+      auto snapshot = state->GetActorSnapshotIfPresent(actor.id);
+      ASSERT_TRUE(snapshot.has_value());
+      CheckSnapshot(actor, *snapshot);
+    }
+    // Ids in between are not present.
+    for (auto id = 0u; id < 3u * count + 3u; id += 3u) {
+      ASSERT_FALSE(state->ContainsActorSnapshot(id));
+      ASSERT_FALSE(state->GetActorSnapshotIfPresent(id).has_value());
+    }
+
+    auto it = actors.begin();
+    for (auto snapshot : *state) {
+      ASSERT_NE(it, actors.end());
+      CheckSnapshot(*it, snapshot);
+      ++it;
+    }
+    ASSERT_EQ(it, actors.end());
+
+    const auto ids = state->GetActorIds();
+    ASSERT_EQ(ids.size(), count);
+    ASSERT_TRUE(std::equal(ids.begin(), ids.end(), actors.begin(), [](auto id, const auto &actor) {
+      return id == actor.id;
+    }));
+  }
+
+  EpisodeState empty(42u);
+  ASSERT_EQ(empty.size(), 0u);
+  ASSERT_EQ(empty.begin(), empty.end());
+  ASSERT_FALSE(empty.ContainsActorSnapshot(1u));
+}
+
+TEST(episode_state, concurrent_lookup) {
+  const auto actors = MakeActors(2000u);
+  const auto state = MakeState(1u, actors);
+  // The index is built lazily by whichever thread looks up first.
+  std::vector<std::thread> threads;
+  std::atomic_size_t found{0u};
+  for (auto i = 0u; i < 4u; ++i) {
+    threads.emplace_back([&]() {
+      for (auto &actor : actors) {
+        found += state->ContainsActorSnapshot(actor.id) ? 1u : 0u;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(found, 4u * actors.size());
+}
+
+TEST(episode_state, tick_benchmark) {
+  constexpr auto number_of_ticks = 200u;
+  for (auto count : {100u, 1000u, 10000u}) {
+    const auto actors = MakeActors(count);
+    std::vector<carla::Buffer> buffers;
+    buffers.reserve(number_of_ticks);
+    for (auto i = 0u; i < number_of_ticks; ++i) {
+      buffers.emplace_back(MakeBuffer(i, actors));
+    }
+
+    // Copy of every actor into a hash map, as the state used to be built.
+    std::vector<carla::Buffer> copies;
+    for (auto &buffer : buffers) {
+      copies.emplace_back(buffer.data(), buffer.size());
+    }
+    size_t checksum = 0u;
+    carla::StopWatch stop_watch;
+    for (auto &buffer : copies) {
+      auto data = carla::sensor::Deserializer::Deserialize(std::move(buffer));
+      auto &raw = static_cast<const RawEpisodeState &>(*data);
+      std::unordered_map<carla::ActorId, ActorSnapshot> map;
+      map.reserve(raw.size());
+      for (auto &actor : raw) {
+        map.emplace(actor.id, ActorSnapshot{
+            actor.id,
+            actor.actor_state,
+            actor.transform,
+            actor.velocity,
+            actor.angular_velocity,
+            actor.acceleration,
+            actor.state});
+      }
+      checksum += map.count(actors.front().id);
+    }
+    stop_watch.Stop();
+    const auto copy_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+
+    stop_watch.Restart();
+    for (auto &buffer : buffers) {
+      auto data = carla::sensor::Deserializer::Deserialize(std::move(buffer));
+      auto state = std::make_shared<const EpisodeState>(
+          boost::static_pointer_cast<const RawEpisodeState>(std::move(data)));
+      checksum += state->ContainsActorSnapshot(actors.front().id) ? 1u : 0u;
+    }
+    stop_watch.Stop();
+    const auto view_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+    ASSERT_EQ(checksum, 2u * number_of_ticks);
+
+    carla::logging::log(
+        count, "actors: per tick", copy_us / number_of_ticks, "us copying to a map,",
+        view_us / number_of_ticks, "us with the buffer view");
+  }
+}
+
+namespace episode_state_util {
+
+  /// A mostly static town: parked cars and props that jitter below the
+  /// thresholds, a few moving vehicles, and actors spawned and destroyed.
+  class TownSimulation {
+  public:
+
+    explicit TownSimulation(size_t count) : actors(MakeActors(count)), _next_id(static_cast<carla::ActorId>(3u * count + 1u)) {}
+
+    void Tick() {
+      for (auto i = 0u; i < actors.size(); ++i) {
+        auto &actor = actors[i];
+        carla::geom::Transform transform = actor.transform;
+        if (i % 10u == 0u) {
+          // Moving.
+          carla::geom::Vector3D velocity = actor.velocity;
+          transform.location += 0.05f * velocity;
+          actor.acceleration = Random::Location(-1.0f, 1.0f);
+        } else if (Random::Uniform(0.0, 1.0) < 0.1) {
+          // Physics jitter.
+          transform.location += Random::Location(-1e-5f, 1e-5f);
+        }
+        actor.transform = transform;
+        if (i % 50u == 1u && Random::Uniform(0.0, 1.0) < 0.05) {
+          // Type dependent state, e.g. a traffic light changing.
+          actor.state.traffic_light_data.state =
+              static_cast<carla::rpc::TrafficLightState>(static_cast<int>(Random::Uniform(0.0, 3.0)));
+        }
+      }
+      if (Random::Uniform(0.0, 1.0) < 0.3) {
+        actors.erase(actors.begin() + static_cast<long>(Random::Uniform(0.0, static_cast<double>(actors.size()))));
+      }
+      if (Random::Uniform(0.0, 1.0) < 0.3) {
+        actors.emplace_back(MakeActor(_next_id));
+        _next_id += 3u;
+      }
+    }
+
+    std::vector<ActorDynamicState> actors;
+
+  private:
+
+    carla::ActorId _next_id;
+  };
+
+} // namespace episode_state_util
+
+static void CheckDeltaReconstruction(EpisodeStateDeltaEncoder::Parameters parameters, bool exact) {
+  constexpr auto number_of_frames = 100u;
+  TownSimulation town(2000u);
+  EpisodeStateDeltaEncoder encoder(parameters);
+  std::shared_ptr<const EpisodeState> state;
+  size_t keyframes = 0u;
+  size_t delta_bytes = 0u;
+  size_t full_bytes = 0u;
+  for (auto frame = 1u; frame <= number_of_frames; ++frame) {
+    town.Tick();
+    auto payload = encoder.Encode(frame, MakeEpisodeHeader(), town.actors, carla::Buffer{});
+    delta_bytes += payload.size();
+    full_bytes += sizeof(EpisodeHeader) + sizeof(ActorDynamicState) * town.actors.size();
+    auto data = Deserialize(AddSensorHeader(frame, payload));
+    if (data->IsDeltaFrame()) {
+      ASSERT_NE(state, nullptr);
+      ASSERT_TRUE(state->IsBaseOf(*data));
+      state = std::make_shared<const EpisodeState>(*data, *state);
+    } else {
+      ++keyframes;
+      state = std::make_shared<const EpisodeState>(std::move(data));
+    }
+    ASSERT_EQ(state->GetFrame(), frame);
+
+    // Same actors, same order and same state than the encoder expects.
+    const auto &expected = encoder.GetEncodedState();
+    ASSERT_EQ(state->size(), expected.size());
+    ASSERT_EQ(state->size(), town.actors.size());
+    auto it = expected.begin();
+    for (auto snapshot : *state) {
+      ASSERT_EQ(snapshot.id, it->id);
+      ++it;
+    }
+    for (auto &actor : expected) {
+      auto snapshot = state->GetActorSnapshotIfPresent(actor.id);
+      ASSERT_TRUE(snapshot.has_value());
+      CheckSnapshot(actor, *snapshot);
+    }
+
+    // Within the thresholds of the actual state of the town.
+    for (auto &actor : town.actors) {
+      auto snapshot = state->GetActorSnapshotIfPresent(actor.id);
+      ASSERT_TRUE(snapshot.has_value());
+      if (exact) {
+        CheckSnapshot(actor, *snapshot);
+        ASSERT_EQ(std::memcmp(&snapshot->state, &actor.state, sizeof(actor.state)), 0);
+      } else {
+        const carla::geom::Transform transform = actor.transform;
+        ASSERT_LE(
+            carla::geom::Math::Distance(snapshot->transform.location, transform.location),
+            parameters.location_threshold);
+      }
+    }
+  }
+  ASSERT_EQ(keyframes, (number_of_frames + parameters.keyframe_interval - 1u) / parameters.keyframe_interval);
+  carla::logging::log(
+      "delta snapshots:", keyframes, "keyframes,", delta_bytes / 1024u, "KB sent instead of",
+      full_bytes / 1024u, "KB");
+}
+
+TEST(episode_state, delta_reconstruction) {
+  CheckDeltaReconstruction(EpisodeStateDeltaEncoder::Parameters{}, false);
+}
+
+TEST(episode_state, delta_reconstruction_exact) {
+  EpisodeStateDeltaEncoder::Parameters parameters;
+  parameters.keyframe_interval = 40u;
+  parameters.location_threshold = 0.0f;
+  parameters.rotation_threshold = 0.0f;
+  parameters.velocity_threshold = 0.0f;
+  parameters.acceleration_threshold = 0.0f;
+  CheckDeltaReconstruction(parameters, true);
+}
+
+TEST(episode_state, delta_missing_base_frame) {
+  TownSimulation town(100u);
+  EpisodeStateDeltaEncoder encoder;
+  auto keyframe = Deserialize(AddSensorHeader(1u, encoder.Encode(1u, MakeEpisodeHeader(), town.actors, carla::Buffer{})));
+  ASSERT_FALSE(keyframe->IsDeltaFrame());
+  const auto state = std::make_shared<const EpisodeState>(std::move(keyframe));
+  town.Tick();
+  encoder.Encode(2u, MakeEpisodeHeader(), town.actors, carla::Buffer{});
+  town.Tick();
+  auto delta = Deserialize(AddSensorHeader(3u, encoder.Encode(3u, MakeEpisodeHeader(), town.actors, carla::Buffer{})));
+  ASSERT_TRUE(delta->IsDeltaFrame());
+  ASSERT_EQ(delta->GetBaseFrame(), 2u);
+  ASSERT_FALSE(state->IsBaseOf(*delta));
+  // After a reset the encoder starts again with a keyframe.
+  encoder.Reset();
+  auto next = Deserialize(AddSensorHeader(4u, encoder.Encode(4u, MakeEpisodeHeader(), town.actors, carla::Buffer{})));
+  ASSERT_FALSE(next->IsDeltaFrame());
+}
+
+TEST(episode_state, delta_join_mid_sequence) {
+  TownSimulation town(200u);
+  EpisodeStateDeltaEncoder encoder;
+
+  /// A client as Episode::Listen handles the stream: it asks for a keyframe
+  /// when it cannot apply a delta.
+  struct Client {
+    std::shared_ptr<const EpisodeState> state = std::make_shared<const EpisodeState>(42u);
+    bool keyframe_requested = false;
+    size_t dropped = 0u;
+
+    void Receive(const carla::Buffer &buffer, EpisodeStateDeltaEncoder &server) {
+      auto data = Deserialize(carla::Buffer(buffer.data(), buffer.size()));
+      if (!data->IsDeltaFrame()) {
+        keyframe_requested = false;
+        state = std::make_shared<const EpisodeState>(std::move(data));
+      } else if (state->IsBaseOf(*data)) {
+        state = std::make_shared<const EpisodeState>(*data, *state);
+      } else {
+        ++dropped;
+        if (!keyframe_requested) {
+          keyframe_requested = true;
+          server.RequestKeyframe();
+        }
+      }
+    }
+  };
+
+  auto is_delta_frame = [](const carla::Buffer &buffer) {
+    return Deserialize(carla::Buffer(buffer.data(), buffer.size()))->IsDeltaFrame();
+  };
+
+  uint64_t subscriptions = 0u;
+  uint64_t frame = 0u;
+  auto encode = [&]() {
+    town.Tick();
+    ++frame;
+    encoder.UpdateSubscriptions(subscriptions);
+    auto payload = encoder.Encode(frame, MakeEpisodeHeader(), town.actors, carla::Buffer{});
+    return AddSensorHeader(frame, payload);
+  };
+  auto check = [&](const Client &client) {
+    ASSERT_EQ(client.state->GetFrame(), frame);
+    const auto &expected = encoder.GetEncodedState();
+    ASSERT_EQ(client.state->size(), expected.size());
+    for (auto &actor : expected) {
+      auto snapshot = client.state->GetActorSnapshotIfPresent(actor.id);
+      ASSERT_TRUE(snapshot.has_value());
+      CheckSnapshot(actor, *snapshot);
+    }
+  };
+
+  Client first;
+  subscriptions = 1u;
+  for (auto i = 0u; i < 10u; ++i) {
+    first.Receive(encode(), encoder);
+    check(first);
+  }
+  ASSERT_EQ(first.dropped, 0u);
+
+  // A second client subscribes in the middle of the delta sequence, the
+  // server answers with a keyframe on the next frame.
+  Client second;
+  subscriptions = 2u;
+  auto buffer = encode();
+  ASSERT_FALSE(is_delta_frame(buffer));
+  first.Receive(buffer, encoder);
+  second.Receive(buffer, encoder);
+  check(first);
+  check(second);
+  ASSERT_EQ(second.dropped, 0u);
+
+  // Back to deltas.
+  buffer = encode();
+  ASSERT_TRUE(is_delta_frame(buffer));
+  first.Receive(buffer, encoder);
+  second.Receive(buffer, encoder);
+  check(first);
+  check(second);
+
+  // A client that connects after the server encoded the keyframe, and then
+  // one that misses a frame, ask for a keyframe themselves.
+  Client third;
+  buffer = encode();
+  first.Receive(buffer, encoder);
+  third.Receive(buffer, encoder);
+  ASSERT_EQ(third.dropped, 1u);
+  ASSERT_TRUE(third.keyframe_requested);
+  buffer = encode();
+  ASSERT_FALSE(is_delta_frame(buffer));
+  first.Receive(buffer, encoder);
+  second.Receive(buffer, encoder);
+  third.Receive(buffer, encoder);
+  check(first);
+  check(second);
+  check(third);
+  ASSERT_FALSE(third.keyframe_requested);
+
+  encode(); // Missed by the second client.
+  buffer = encode();
+  ASSERT_TRUE(is_delta_frame(buffer));
+  second.Receive(buffer, encoder);
+  ASSERT_EQ(second.dropped, 1u);
+  buffer = encode();
+  ASSERT_FALSE(is_delta_frame(buffer));
+  second.Receive(buffer, encoder);
+  check(second);
+
+  // Only one keyframe per request.
+  buffer = encode();
+  ASSERT_TRUE(is_delta_frame(buffer));
+  second.Receive(buffer, encoder);
+  check(second);
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "test.h"
+
+#include <carla/MappedFile.h>
+#include <carla/client/FileTransfer.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <numeric>
+
+using carla::client::FileTransfer;
+using carla::rpc::FileInfo;
+
+static FileInfo MakeInfo(const std::vector<uint8_t> &content) {
+  FileInfo info;
+  info.size = content.size();
+  info.hash = FileInfo::Hash(content.data(), content.size());
+  return info;
+}
+
+TEST(file_transfer, hash) {
+  const std::string text = "Town01.xodr";
+  const auto hash = FileInfo::Hash(text.data(), text.size());
+  ASSERT_EQ(hash, FileInfo::Hash(text.data() + 4u, text.size() - 4u, FileInfo::Hash(text.data(), 4u)));
+  ASSERT_NE(hash, FileInfo::Hash(text.data(), text.size() - 1u));
+  const uint64_t seed = FileInfo::HashSeed;
+  ASSERT_EQ(FileInfo::Hash(nullptr, 0u), seed);
+}
+
+TEST(file_transfer, content_addressed_cache) {
+  const auto folder = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-test-%%%%-%%%%");
+  ASSERT_TRUE(FileTransfer::SetFilesBaseFolder(folder.string()));
+
+  std::vector<uint8_t> content(100000u);
+  std::iota(content.begin(), content.end(), uint8_t(0u));
+  const auto info = MakeInfo(content);
+  ASSERT_FALSE(FileTransfer::HasObject(info));
+  ASSERT_EQ(FileTransfer::MapObject(info), nullptr);
+
+  // Content not matching its description is rejected.
+  auto corrupted = content;
+  corrupted[500u] ^= 1u;
+  ASSERT_FALSE(FileTransfer::WriteObject(info, corrupted));
+  ASSERT_FALSE(FileTransfer::HasObject(info));
+
+  ASSERT_TRUE(FileTransfer::WriteObject(info, content));
+  ASSERT_TRUE(FileTransfer::HasObject(info));
+  auto file = FileTransfer::MapObject(info);
+  ASSERT_NE(file, nullptr);
+  ASSERT_EQ(file->size(), content.size());
+  ASSERT_TRUE(std::equal(content.begin(), content.end(), file->data()));
+
+  // The same content under two names is stored once.
+  ASSERT_TRUE(FileTransfer::LinkObject(info, "Carla/Maps/Nav/Town01.bin"));
+  ASSERT_TRUE(FileTransfer::LinkObject(info, "Carla/Maps/Nav/Town01_Opt.bin"));
+  ASSERT_TRUE(FileTransfer::LinkObject(info, "Carla/Maps/Nav/Town01.bin"));
+  ASSERT_TRUE(FileTransfer::FileExists("Carla/Maps/Nav/Town01_Opt.bin"));
+  ASSERT_EQ(FileTransfer::ReadFile("Carla/Maps/Nav/Town01.bin"), content);
+
+  boost::filesystem::remove_all(folder);
+}
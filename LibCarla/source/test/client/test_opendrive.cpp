@@ -13,15 +13,24 @@
 #include <carla/geom/Location.h>
 #include <carla/geom/Math.h>
 #include <carla/opendrive/OpenDriveParser.h>
+#include <carla/opendrive/parser/ElementStream.h>
 #include <carla/road/MapBuilder.h>
+#include <carla/road/RoutingGraph.h>
+#include <carla/rpc/OpendriveGenerationParameters.h>
+#include <carla/road/element/Geometry.h>
 #include <carla/road/element/RoadInfoElevation.h>
 #include <carla/road/element/RoadInfoGeometry.h>
 #include <carla/road/element/RoadInfoMarkRecord.h>
 #include <carla/road/element/RoadInfoVisitor.h>
 
+#include <odrSpiral/odrSpiral.h>
 #include <pugixml/pugixml.hpp>
 
+#include <array>
+#include <cmath>
 #include <fstream>
+#include <queue>
+#include <sstream>
 #include <string>
 
 using namespace carla::road;
@@ -424,3 +433,484 @@ TEST(road, get_waypoint) {
     result.get();
   }
 }
+
+TEST(road, generate_chunked_mesh) {
+  for (const auto& file : util::OpenDrive::GetAvailableFiles()) {
+    auto m = OpenDriveParser::Load(util::OpenDrive::Load(file));
+    ASSERT_TRUE(m.has_value());
+    auto &map = *m;
+    for (auto max_road_length : {25.0, 50.0, 100.0, 500.0}) {
+      carla::rpc::OpendriveGenerationParameters params;
+      params.max_road_length = max_road_length;
+
+      carla::StopWatch stop_watch;
+      const auto meshes = map.GenerateChunkedMesh(params);
+      stop_watch.Stop();
+      size_t vertices = 0u;
+      for (auto &mesh : meshes) {
+        ASSERT_NE(mesh, nullptr);
+        vertices += mesh->GetVerticesNum();
+      }
+      ASSERT_GT(vertices, 0u);
+      carla::logging::log(
+          file, "chunk size", max_road_length, "generated", meshes.size(),
+          "meshes,", vertices, "vertices in", stop_watch.GetElapsedTime(), "ms.");
+
+      // Chunks are generated in parallel but must be merged deterministically.
+      const auto again = map.GenerateChunkedMesh(params);
+      ASSERT_EQ(meshes.size(), again.size());
+      for (auto i = 0u; i < meshes.size(); ++i) {
+        ASSERT_EQ(meshes[i]->GetVertices(), again[i]->GetVertices());
+        ASSERT_EQ(meshes[i]->GetIndexes(), again[i]->GetIndexes());
+      }
+    }
+  }
+}
+
+// Exact position of a spiral through the Fresnel integrals, as computed before
+// the geometries were sampled into an arc-length table.
+static DirectedPoint spiral_reference(
+    const Location &start,
+    double heading,
+    double length,
+    double curve_start,
+    double curve_end,
+    double dist) {
+  const double curve_dot = (curve_end - curve_start) / length;
+  const double s_o = curve_start / curve_dot;
+  double x, y, t, x_o, y_o, t_o;
+  odrSpiral(s_o + dist, curve_dot, &x, &y, &t);
+  odrSpiral(s_o, curve_dot, &x_o, &y_o, &t_o);
+  const double angle = heading - t_o;
+  DirectedPoint p(start, heading + t - t_o);
+  p.location.x += static_cast<float>((x - x_o) * std::cos(angle) - (y - y_o) * std::sin(angle));
+  p.location.y += static_cast<float>((y - y_o) * std::cos(angle) + (x - x_o) * std::sin(angle));
+  return p;
+}
+
+// Position of a parametric cubic at arc length dist, integrating the arc
+// length with a fine trapezoidal rule.
+static DirectedPoint param_poly3_reference(
+    const Location &start,
+    double heading,
+    const CubicPolynomial &u,
+    const CubicPolynomial &v,
+    double dist) {
+  constexpr int steps = 50000;
+  const double dp = 1.0 / steps;
+  auto speed = [&](double p) { return std::hypot(u.Tangent(p), v.Tangent(p)); };
+  double s = 0.0;
+  double p = 0.0;
+  for (int i = 0; i < steps; ++i) {
+    const double ds = 0.5 * dp * (speed(p) + speed(p + dp));
+    if (s + ds >= dist) {
+      p += dp * (dist - s) / ds;
+      break;
+    }
+    s += ds;
+    p += dp;
+  }
+  const double cos_h = std::cos(heading);
+  const double sin_h = std::sin(heading);
+  DirectedPoint result(start, heading + std::atan2(v.Tangent(p), u.Tangent(p)));
+  result.location.x += static_cast<float>(u.Evaluate(p) * cos_h - v.Evaluate(p) * sin_h);
+  result.location.y += static_cast<float>(v.Evaluate(p) * cos_h + u.Evaluate(p) * sin_h);
+  return result;
+}
+
+static void check_distance_to(const Geometry &geometry, double lateral_offset) {
+  for (auto i = 1u; i < 20u; ++i) {
+    const double s = geometry.GetLength() * i / 20.0;
+    auto point = geometry.PosFromDist(s);
+    point.ApplyLateralOffset(static_cast<float>(lateral_offset));
+    const auto result = geometry.DistanceTo(point.location);
+    ASSERT_NEAR(result.first, s, 1e-2);
+    ASSERT_NEAR(result.second, std::fabs(lateral_offset), 1e-2);
+  }
+}
+
+TEST(road, geometry_arc_length_table) {
+  constexpr double max_error = ArcLengthTable::MaxError + 1e-4;
+  const Location start(12.0f, -7.0f, 0.0f);
+  const double heading = 0.4;
+
+  const std::vector<std::array<double, 3>> spirals = {
+      {0.0, 0.02, 80.0},
+      {0.01, -0.03, 120.0},
+      {-0.05, 0.0, 35.0},
+      {0.001, 0.002, 250.0}};
+  for (auto &&spiral : spirals) {
+    GeometrySpiral geometry(0.0, spiral[2], heading, start, spiral[0], spiral[1]);
+    for (auto i = 0u; i <= 1000u; ++i) {
+      const double dist = spiral[2] * i / 1000.0;
+      const auto expected = spiral_reference(start, heading, spiral[2], spiral[0], spiral[1], dist);
+      const auto actual = geometry.PosFromDist(dist);
+      ASSERT_LE(Math::Distance2D(expected.location, actual.location), max_error);
+      ASSERT_NEAR(expected.tangent, actual.tangent, 1e-6);
+    }
+    check_distance_to(geometry, 1.5);
+    check_distance_to(geometry, -2.0);
+  }
+
+  // Constant curvature, valid OpenDRIVE but the Fresnel evaluation divides
+  // by zero. Must match the equivalent arc or line.
+  for (const double curvature : {0.02, -0.01, 0.0}) {
+    carla::StopWatch stop_watch;
+    GeometrySpiral geometry(0.0, 100.0, heading, start, curvature, curvature);
+    stop_watch.Stop();
+    ASSERT_LT(stop_watch.GetElapsedTime(), 100u);
+    for (auto i = 0u; i <= 100u; ++i) {
+      const double dist = i;
+      const auto actual = geometry.PosFromDist(dist);
+      DirectedPoint expected = curvature != 0.0 ?
+          GeometryArc(0.0, 100.0, heading, start, curvature).PosFromDist(dist) :
+          GeometryLine(0.0, 100.0, heading, start).PosFromDist(dist);
+      ASSERT_TRUE(std::isfinite(actual.location.x));
+      ASSERT_TRUE(std::isfinite(actual.location.y));
+      ASSERT_LE(Math::Distance2D(expected.location, actual.location), max_error);
+      ASSERT_NEAR(expected.tangent, actual.tangent, 1e-6);
+    }
+    check_distance_to(geometry, 1.5);
+  }
+
+  struct ParamPoly3Params {
+    std::array<double, 8> coefficients;
+    double length;
+  };
+  const std::vector<ParamPoly3Params> param_poly3s = {
+      {{0.0, 50.0, 0.0, 0.0, 0.0, 0.0, 10.0, -4.0}, 50.42},
+      {{0.0, 30.0, -8.0, 2.0, 0.0, 0.0, 25.0, -10.0}, 29.11},
+      {{0.0, 120.0, 0.0, -3.0, 0.0, 0.0, 2.0, 1.0}, 117.05}};
+  for (auto &&params : param_poly3s) {
+    const auto &c = params.coefficients;
+    CubicPolynomial u(c[0], c[1], c[2], c[3]);
+    CubicPolynomial v(c[4], c[5], c[6], c[7]);
+    GeometryParamPoly3 geometry(
+        0.0, params.length, heading, start,
+        c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], false);
+    for (auto i = 0u; i <= 200u; ++i) {
+      const double dist = params.length * i / 200.0;
+      const auto expected = param_poly3_reference(start, heading, u, v, dist);
+      const auto actual = geometry.PosFromDist(dist);
+      ASSERT_LE(Math::Distance2D(expected.location, actual.location), max_error);
+      ASSERT_NEAR(expected.tangent, actual.tangent, 1e-3);
+    }
+    check_distance_to(geometry, 1.5);
+    check_distance_to(geometry, -1.5);
+  }
+
+  GeometryPoly3 poly3(0.0, 60.0, heading, start, 0.0, 0.0, 0.01, -0.0002);
+  for (auto i = 0u; i <= 200u; ++i) {
+    const double dist = 60.0 * i / 200.0;
+    const auto point = poly3.PosFromDist(dist);
+    const double u = std::cos(heading) * (point.location.x - start.x) +
+                     std::sin(heading) * (point.location.y - start.y);
+    const double v = std::cos(heading) * (point.location.y - start.y) -
+                     std::sin(heading) * (point.location.x - start.x);
+    ASSERT_NEAR(v, 0.01 * u * u - 0.0002 * u * u * u, max_error);
+  }
+  ASSERT_LE(Math::Distance2D(poly3.PosFromDist(60.0).location, poly3.PosFromDist(70.0).location), 1e-6);
+  check_distance_to(poly3, 1.0);
+}
+
+TEST(road, geometry_pos_from_dist_benchmark) {
+  constexpr auto number_of_queries = 200'000u;
+  const Location start(0.0f, 0.0f, 0.0f);
+  std::vector<double> distances(number_of_queries);
+  for (auto &dist : distances) {
+    dist = Random::Uniform(0.0, 100.0);
+  }
+
+  auto benchmark = [&](const char *name, auto &&pos_from_dist) {
+    carla::StopWatch stop_watch;
+    float checksum = 0.0f;
+    for (auto dist : distances) {
+      checksum += pos_from_dist(dist).location.x;
+    }
+    stop_watch.Stop();
+    const double ns = 1e3 * static_cast<double>(
+        stop_watch.GetElapsedTime<std::chrono::microseconds>()) / number_of_queries;
+    carla::logging::log(name, "PosFromDist:", ns, "ns per query, checksum", checksum);
+  };
+
+  GeometrySpiral spiral(0.0, 100.0, 0.0, start, 0.0, 0.02);
+  GeometryPoly3 poly3(0.0, 100.0, 0.0, start, 0.0, 0.0, 0.002, -0.00002);
+  GeometryParamPoly3 param_poly3(
+      0.0, 100.0, 0.0, start, 0.0, 90.0, 0.0, 0.0, 0.0, 0.0, 30.0, -12.0, false);
+
+  benchmark("spiral (odrSpiral)", [&](double dist) {
+    return spiral_reference(start, 0.0, 100.0, 0.0, 0.02, dist);
+  });
+  benchmark("spiral", [&](double dist) { return spiral.PosFromDist(dist); });
+  benchmark("poly3", [&](double dist) { return poly3.PosFromDist(dist); });
+  benchmark("paramPoly3", [&](double dist) { return param_poly3.PosFromDist(dist); });
+
+  carla::StopWatch stop_watch;
+  float checksum = 0.0f;
+  constexpr auto number_of_projections = 10'000u;
+  for (auto i = 0u; i < number_of_projections; ++i) {
+    checksum += spiral.DistanceTo(Random::Location(-10.0f, 110.0f)).second;
+    checksum += param_poly3.DistanceTo(Random::Location(-10.0f, 110.0f)).second;
+  }
+  stop_watch.Stop();
+  const double ns = 1e3 * static_cast<double>(
+      stop_watch.GetElapsedTime<std::chrono::microseconds>()) / (2u * number_of_projections);
+  carla::logging::log("DistanceTo:", ns, "ns per query, checksum", checksum);
+}
+
+// Dijkstra over Map::GetSuccessors, lanes only joined by their successors.
+static double reference_route_cost(const Map &map, Waypoint origin, Waypoint destination) {
+  auto lane_key = [](const Waypoint &waypoint) {
+    return Waypoint{waypoint.road_id, waypoint.section_id, waypoint.lane_id, 0.0};
+  };
+  std::unordered_map<Waypoint, double> cost;
+  using Item = std::pair<double, Waypoint>;
+  auto compare = [](const Item &lhs, const Item &rhs) { return lhs.first > rhs.first; };
+  std::priority_queue<Item, std::vector<Item>, decltype(compare)> queue(compare);
+  const auto target = lane_key(destination);
+  for (auto &&successor : map.GetSuccessors(origin)) {
+    const double length = map.GetLane(origin).GetLength();
+    if (!cost.count(lane_key(successor)) || length < cost[lane_key(successor)]) {
+      cost[lane_key(successor)] = length;
+      queue.emplace(length, successor);
+    }
+  }
+  while (!queue.empty()) {
+    const auto item = queue.top();
+    queue.pop();
+    if (item.first > cost[lane_key(item.second)]) {
+      continue;
+    }
+    if (lane_key(item.second) == target) {
+      return item.first;
+    }
+    const double length = map.GetLane(item.second).GetLength();
+    for (auto &&successor : map.GetSuccessors(item.second)) {
+      if (map.GetLaneType(successor) != Lane::LaneType::Driving) {
+        continue;
+      }
+      auto it = cost.find(lane_key(successor));
+      if (it == cost.end() || item.first + length < it->second) {
+        cost[lane_key(successor)] = item.first + length;
+        queue.emplace(item.first + length, successor);
+      }
+    }
+  }
+  return std::numeric_limits<double>::infinity();
+}
+
+TEST(road, routing_graph) {
+  constexpr auto number_of_queries = 200u;
+  for (const auto &file : util::OpenDrive::GetAvailableFiles()) {
+    auto m = OpenDriveParser::Load(util::OpenDrive::Load(file));
+    ASSERT_TRUE(m.has_value());
+    auto &map = *m;
+
+    carla::StopWatch build_watch;
+    RoutingGraph graph(map);
+    build_watch.Stop();
+    RoutingParameters parameters;
+    parameters.contraction_hierarchy = true;
+    carla::StopWatch contraction_watch;
+    RoutingGraph hierarchy(map, parameters);
+    contraction_watch.Stop();
+    parameters.lane_change_cost = 1e6;
+    parameters.contraction_hierarchy = false;
+    RoutingGraph no_lane_changes(map, parameters);
+    ASSERT_TRUE(hierarchy.HasContractionHierarchy());
+    ASSERT_EQ(graph.GetNumberOfNodes(), hierarchy.GetNumberOfNodes());
+    carla::logging::log(
+        file, "routing graph:", graph.GetNumberOfNodes(), "nodes,",
+        graph.GetNumberOfEdges(), "edges in", build_watch.GetElapsedTime(), "ms; contraction",
+        hierarchy.GetNumberOfShortcuts(), "shortcuts in", contraction_watch.GetElapsedTime(), "ms.");
+    if (graph.GetNumberOfNodes() == 0u) {
+      continue;
+    }
+
+    auto random_waypoint = [&]() {
+      const auto node = static_cast<RoutingGraph::NodeId>(
+          Random::Uniform(0.0, static_cast<double>(graph.GetNumberOfNodes())));
+      auto waypoint = graph.GetNodeWaypoint(
+          std::min<RoutingGraph::NodeId>(node, static_cast<RoutingGraph::NodeId>(graph.GetNumberOfNodes() - 1u)));
+      const auto &lane = map.GetLane(waypoint);
+      waypoint.s = lane.GetDistance() + Random::Uniform(0.0, lane.GetLength());
+      return waypoint;
+    };
+
+    double a_star_time = 0.0;
+    double hierarchy_time = 0.0;
+    for (auto i = 0u; i < number_of_queries; ++i) {
+      const auto origin = random_waypoint();
+      const auto destination = random_waypoint();
+
+      carla::StopWatch a_star_watch;
+      const auto route = graph.ComputeRoute(origin, destination);
+      a_star_watch.Stop();
+      carla::StopWatch hierarchy_watch;
+      const auto fast_route = hierarchy.ComputeRoute(origin, destination);
+      hierarchy_watch.Stop();
+      a_star_time += static_cast<double>(a_star_watch.GetElapsedTime<std::chrono::microseconds>());
+      hierarchy_time += static_cast<double>(hierarchy_watch.GetElapsedTime<std::chrono::microseconds>());
+
+      ASSERT_EQ(route.empty(), fast_route.empty());
+      if (route.empty()) {
+        continue;
+      }
+      ASSERT_NEAR(route.cost, fast_route.cost, 1e-2 * (1.0 + route.cost));
+      ASSERT_EQ(route.waypoints.front(), origin);
+      ASSERT_EQ(route.waypoints.back(), destination);
+
+      // Consecutive lanes must be joined by a successor or a lane change.
+      for (auto j = 2u; j + 1u < route.waypoints.size(); ++j) {
+        const auto &from = route.waypoints[j - 1u];
+        const auto &to = route.waypoints[j];
+        const auto successors = map.GetSuccessors(from);
+        const bool is_successor = std::any_of(successors.begin(), successors.end(), [&](auto &&w) {
+          return w.road_id == to.road_id && w.section_id == to.section_id && w.lane_id == to.lane_id;
+        });
+        const bool is_neighbour =
+            from.road_id == to.road_id && from.section_id == to.section_id &&
+            std::abs(from.lane_id - to.lane_id) == 1;
+        ASSERT_TRUE(is_successor || is_neighbour);
+      }
+    }
+    carla::logging::log(
+        file, "A*", a_star_time / number_of_queries, "us per query, contraction hierarchy",
+        hierarchy_time / number_of_queries, "us per query.");
+
+    // Without lane changes the cost between lane entrances is the sum of the
+    // lengths of the lanes driven.
+    for (auto i = 0u; i < number_of_queries / 4u; ++i) {
+      auto origin = random_waypoint();
+      auto destination = random_waypoint();
+      origin = graph.GetNodeWaypoint(*graph.GetNode(origin));
+      destination = graph.GetNodeWaypoint(*graph.GetNode(destination));
+      const auto route = no_lane_changes.ComputeRoute(origin, destination);
+      const double expected = reference_route_cost(map, origin, destination);
+      if (route.empty() || route.cost >= parameters.lane_change_cost) {
+        ASSERT_TRUE(std::isinf(expected) || expected >= parameters.lane_change_cost - 1e-3);
+      } else if (origin != destination) {
+        ASSERT_NEAR(route.cost, expected, 1e-2 * (1.0 + expected));
+      }
+    }
+  }
+}
+
+TEST(road, junction_conflicts) {
+  for (const auto &file : util::OpenDrive::GetAvailableFiles()) {
+    auto m = OpenDriveParser::Load(util::OpenDrive::Load(file));
+    ASSERT_TRUE(m.has_value());
+    auto &map = *m;
+    const auto &junctions = map.GetMap().GetJunctions();
+
+    // The precomputed tables must match computing the conflicts on demand.
+    carla::StopWatch compute_watch;
+    size_t checksum = 0u;
+    for (const auto &pair : junctions) {
+      const auto &junction = pair.second;
+      const auto conflicts = map.ComputeJunctionConflicts(junction.GetId());
+      for (const auto &road_conflicts : conflicts) {
+        ASSERT_TRUE(junction.RoadHasConflicts(road_conflicts.first));
+        const auto table = junction.GetConflictsOfRoad(road_conflicts.first);
+        ASSERT_EQ(table.size(), road_conflicts.second.size());
+        for (auto road_id : table) {
+          ASSERT_EQ(road_conflicts.second.count(road_id), 1u);
+        }
+        checksum += road_conflicts.second.size();
+      }
+    }
+    compute_watch.Stop();
+
+    carla::StopWatch lookup_watch;
+    size_t lookup_checksum = 0u;
+    for (const auto &pair : junctions) {
+      const auto &junction = pair.second;
+      for (const auto &connection : junction.GetConnections()) {
+        const auto road_id = connection.second.connecting_road;
+        if (junction.RoadHasConflicts(road_id)) {
+          lookup_checksum += junction.GetConflictsOfRoad(road_id).size();
+        }
+      }
+    }
+    lookup_watch.Stop();
+    ASSERT_LE(lookup_checksum, checksum);
+    carla::logging::log(
+        file, junctions.size(), "junctions,", checksum, "conflicts: computing them took",
+        compute_watch.GetElapsedTime<std::chrono::microseconds>(), "us, looking them up",
+        lookup_watch.GetElapsedTime<std::chrono::microseconds>(), "us.");
+  }
+}
+
+TEST(road, parse_element_stream) {
+  const std::string document =
+      "<?xml version=\"1.0\" standalone=\"yes\"?>\n"
+      "<!DOCTYPE OpenDRIVE [ <!ELEMENT road ANY> ]>\n"
+      "<!-- <road id=\"commented\"/> -->\n"
+      "<OpenDRIVE>\n"
+      "  <header name=\"a > b\" revMajor='1'><geoReference><![CDATA[+proj=tmerc]]></geoReference></header>\n"
+      "  <!-- </OpenDRIVE> -->\n"
+      "  <road id=\"1\"><road id=\"nested\"/><planView/></road>\n"
+      "  <junction id=\"2\"/>\n"
+      "  <controller id=\"3\"><control signalId=\"4\"/></controller>\n"
+      "</OpenDRIVE>\n";
+  const std::vector<std::string> expected_names = {"header", "road", "junction", "controller"};
+
+  // Tiny chunks exercise the markup split across reads.
+  for (auto chunk_size : {1u, 2u, 3u, 7u, 64u, 4096u}) {
+    std::istringstream input(document);
+    parser::ElementStream elements(input, chunk_size);
+    std::string element;
+    std::vector<std::string> names;
+    while (elements.Next(element)) {
+      names.emplace_back(elements.GetElementName());
+      pugi::xml_document xml;
+      ASSERT_TRUE(xml.load_string(element.c_str())) << element;
+      ASSERT_TRUE(xml.child("OpenDRIVE").child(names.back().c_str()));
+      if (names.back() == "header") {
+        ASSERT_EQ(std::string(xml.child("OpenDRIVE").child("header").child_value("geoReference")), "+proj=tmerc");
+      } else if (names.back() == "road") {
+        ASSERT_EQ(std::string(xml.child("OpenDRIVE").child("road").attribute("id").value()), "1");
+      }
+    }
+    ASSERT_FALSE(elements.HasError());
+    ASSERT_EQ(names, expected_names);
+  }
+
+  std::istringstream truncated(document.substr(0u, document.find("<junction") + 5u));
+  parser::ElementStream elements(truncated);
+  std::string element;
+  while (elements.Next(element)) {}
+  ASSERT_TRUE(elements.HasError());
+  ASSERT_FALSE(OpenDriveParser::Load(document.substr(0u, document.find("</road>"))).has_value());
+}
+
+TEST(road, parse_streaming_benchmark) {
+  for (const auto &file : util::OpenDrive::GetAvailableFiles()) {
+    const auto content = util::OpenDrive::Load(file);
+
+    // Largest element held in memory at once, against the whole document.
+    std::istringstream input(content);
+    parser::ElementStream elements(input);
+    std::string element;
+    size_t largest_element = 0u;
+    while (elements.Next(element)) {
+      largest_element = std::max(largest_element, element.size());
+    }
+    ASSERT_FALSE(elements.HasError());
+
+    carla::StopWatch dom_watch;
+    pugi::xml_document xml;
+    ASSERT_TRUE(xml.load_string(content.c_str()));
+    dom_watch.Stop();
+
+    carla::StopWatch stream_watch;
+    auto map = OpenDriveParser::Load(content);
+    stream_watch.Stop();
+    ASSERT_TRUE(map.has_value());
+
+    carla::logging::log(
+        file, content.size(), "bytes, largest element", largest_element,
+        "bytes; streaming load", stream_watch.GetElapsedTime(), "ms (DOM parse alone",
+        dom_watch.GetElapsedTime(), "ms).");
+  }
+}
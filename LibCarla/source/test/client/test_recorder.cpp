@@ -0,0 +1,1395 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "test.h"
+
+#include <carla/StopWatch.h>
+#include <carla/recorder/BlockFile.h>
+#include <carla/recorder/BufferedFileWriter.h>
+#include <carla/recorder/FrameIndex.h>
+#include <carla/recorder/FramePrefetcher.h>
+#include <carla/recorder/FrameWindow.h>
+#include <carla/recorder/PacketFilter.h>
+#include <carla/recorder/Lz4.h>
+#include <carla/recorder/RecordingExporter.h>
+#include <carla/recorder/RecordingSummary.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using carla::recorder::BlockFileReader;
+using carla::recorder::BufferedFileWriter;
+using carla::recorder::FrameIndex;
+using carla::recorder::FramePrefetcher;
+
+// Same layout as the packets written by the recorder in the simulator.
+static constexpr char FRAME_START = 0;
+static constexpr char FRAME_END = 1;
+static constexpr char POSITION = 6;
+static constexpr char ANIM_VEHICLE = 8;
+static constexpr char KEY_FRAME = 19;
+
+#pragma pack(push, 1)
+struct Frame {
+  uint64_t id;
+  double duration;
+  double elapsed;
+};
+
+struct Position {
+  uint32_t id;
+  float location[3];
+  float rotation[3];
+};
+#pragma pack(pop)
+
+template <typename T>
+static void Write(std::ostream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static void Read(std::istream &in, T &value) {
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+static void WritePacket(std::ostream &out, char id, uint32_t size, bool sparse) {
+  Write(out, id);
+  Write(out, size);
+  if (sparse) {
+    // Leave the content as a hole, only its size matters here.
+    out.seekp(size, std::ios::cur);
+  } else {
+    const std::vector<char> content(size, '\0');
+    out.write(content.data(), size);
+  }
+}
+
+/// Write a recording of @a frames frames with a packet of @a payload bytes
+/// each, with a key frame every @a keyframe_interval frames.
+static FrameIndex WriteRecording(
+    std::ostream &out,
+    size_t frames,
+    uint32_t payload,
+    size_t keyframe_interval,
+    double delta,
+    bool sparse = false) {
+  FrameIndex index;
+  for (auto i = 0u; i < frames; ++i) {
+    const bool keyframe = (i % keyframe_interval) == 0u;
+    index.Add(i * delta, static_cast<uint64_t>(out.tellp()), keyframe);
+    Write(out, FRAME_START);
+    Write(out, static_cast<uint32_t>(sizeof(Frame)));
+    Write(out, Frame{i + 1u, delta, i * delta});
+    if (keyframe) {
+      WritePacket(out, KEY_FRAME, payload, sparse);
+    }
+    WritePacket(out, POSITION, payload, sparse);
+    WritePacket(out, FRAME_END, 0u, sparse);
+  }
+  return index;
+}
+
+/// Find the frame containing @a time reading the packets from the start, as
+/// a recording without index has to.
+static uint64_t ScanToTime(std::istream &in, double time) {
+  in.clear();
+  in.seekg(0, std::ios::beg);
+  uint64_t result = 0u;
+  char id;
+  uint32_t size;
+  while (in) {
+    const auto offset = static_cast<uint64_t>(in.tellg());
+    Read(in, id);
+    Read(in, size);
+    if (!in || (id == FrameIndex::PacketId)) {
+      break;
+    }
+    if (id == FRAME_START) {
+      Frame frame;
+      Read(in, frame);
+      if (frame.elapsed > time) {
+        break;
+      }
+      result = offset;
+    } else {
+      in.seekg(size, std::ios::cur);
+    }
+  }
+  return result;
+}
+
+TEST(recorder, frame_index) {
+  std::stringstream file;
+  const auto written = WriteRecording(file, 1000u, 64u, 100u, 0.05);
+
+  // Without the index packet there is nothing to load.
+  FrameIndex index;
+  ASSERT_FALSE(index.Read(file));
+
+  written.Write(file);
+  ASSERT_TRUE(index.Read(file));
+  ASSERT_EQ(index.size(), 1000u);
+  ASSERT_EQ(index.GetNumberOfKeyFrames(), 10u);
+  ASSERT_EQ(index.back().offset, written.back().offset);
+
+  ASSERT_EQ(index.FindFrame(-1.0), index.size());
+  ASSERT_EQ(index.FindFrame(0.0), 0u);
+  ASSERT_EQ(index.FindFrame(12.34), 246u);
+  ASSERT_EQ(index.FindFrame(1e6), 999u);
+  ASSERT_EQ(index.FindKeyFrame(12.34), 200u);
+  ASSERT_EQ(index.FindKeyFrame(4.99), 0u);
+  ASSERT_EQ(index[index.FindKeyFrame(1e6)].keyframe, 1u);
+  ASSERT_EQ(index.FindKeyFrame(1e6), 900u);
+
+  // The offsets point to the frame start packets.
+  for (auto time : {0.0, 3.3, 27.0, 49.95}) {
+    ASSERT_EQ(index[index.FindFrame(time)].offset, ScanToTime(file, time));
+  }
+}
+
+TEST(recorder, seek_benchmark) {
+  // A recording of about 2 GiB; the content of the packets is left as holes
+  // in the file, so it takes little space in disk.
+  constexpr size_t frames = 32768u;
+  constexpr uint32_t payload = 64u * 1024u;
+  constexpr double delta = 1.0 / 30.0;
+  const auto path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+  {
+    std::ofstream out(path.string(), std::ios::binary);
+    WriteRecording(out, frames, payload, 150u, delta, true).Write(out);
+  }
+  carla::logging::log(
+      "recording of", frames, "frames,",
+      boost::filesystem::file_size(path) / (1024u * 1024u), "MiB");
+
+  std::ifstream file(path.string(), std::ios::binary);
+  std::mt19937_64 rng(42u);
+  std::uniform_real_distribution<double> random_time(0.0, frames * delta);
+
+  constexpr auto scans = 20u;
+  carla::StopWatch scan_watch;
+  std::vector<std::pair<double, uint64_t>> expected;
+  for (auto i = 0u; i < scans; ++i) {
+    const auto time = random_time(rng);
+    expected.emplace_back(time, ScanToTime(file, time));
+  }
+  scan_watch.Stop();
+
+  carla::StopWatch load_watch;
+  FrameIndex index;
+  ASSERT_TRUE(index.Read(file));
+  load_watch.Stop();
+
+  constexpr auto seeks = 10000u;
+  carla::StopWatch seek_watch;
+  for (auto i = 0u; i < seeks; ++i) {
+    // Seek to the key frame and read the frame at the target time, as the
+    // replayer does.
+    const auto time = random_time(rng);
+    const auto &keyframe = index[index.FindKeyFrame(time)];
+    file.seekg(static_cast<std::streamoff>(keyframe.offset), std::ios::beg);
+    char id;
+    Read(file, id);
+    ASSERT_EQ(id, FRAME_START);
+    ASSERT_LE(keyframe.elapsed, time);
+    file.seekg(static_cast<std::streamoff>(index[index.FindFrame(time)].offset), std::ios::beg);
+  }
+  seek_watch.Stop();
+  for (auto &item : expected) {
+    ASSERT_EQ(index[index.FindFrame(item.first)].offset, item.second);
+  }
+
+  file.close();
+  boost::filesystem::remove(path);
+
+  carla::logging::log(
+      "scanning from the start:",
+      scan_watch.GetElapsedTime<std::chrono::microseconds>() / scans, "us per seek");
+  carla::logging::log(
+      "loading the index:",
+      load_watch.GetElapsedTime<std::chrono::microseconds>(), "us");
+  carla::logging::log(
+      "seeking with the index:",
+      static_cast<double>(seek_watch.GetElapsedTime<std::chrono::microseconds>()) / seeks, "us per seek");
+}
+
+/// Write a frame with @a actors actors the way the recorder does: the frame
+/// start patches the duration of the previous one, then a block of positions
+/// and a packet written field by field whose size is patched at the end.
+static void WriteActorsFrame(
+    std::ostream &out,
+    uint32_t frame,
+    uint16_t actors,
+    std::streampos &previous_duration) {
+  Write(out, FRAME_START);
+  Write(out, static_cast<uint32_t>(sizeof(Frame)));
+  Write(out, uint64_t(frame));
+  const auto duration = out.tellp();
+  Write(out, -1.0);
+  Write(out, frame / 90.0);
+  if (previous_duration > 0) {
+    const auto position = out.tellp();
+    out.seekp(previous_duration, std::ios::beg);
+    Write(out, 1.0 / 90.0);
+    out.seekp(position, std::ios::beg);
+  }
+  previous_duration = duration;
+
+  std::vector<Position> positions(actors);
+  for (auto i = 0u; i < actors; ++i) {
+    positions[i].id = i;
+    positions[i].location[0] = 10.0f * static_cast<float>(i) + 0.25f * static_cast<float>(frame);
+    positions[i].location[1] = -3.0f * static_cast<float>(i);
+    positions[i].location[2] = 0.5f;
+    positions[i].rotation[1] = static_cast<float>((i * 37u) % 360u);
+  }
+  Write(out, POSITION);
+  Write(out, static_cast<uint32_t>(sizeof(uint16_t) + actors * sizeof(Position)));
+  Write(out, actors);
+  out.write(
+      reinterpret_cast<const char *>(positions.data()),
+      static_cast<std::streamsize>(positions.size() * sizeof(Position)));
+
+  Write(out, ANIM_VEHICLE);
+  const auto size_position = out.tellp();
+  Write(out, uint32_t(0u));
+  Write(out, actors);
+  for (auto i = 0u; i < actors; ++i) {
+    Write(out, i);
+    Write(out, 0.1f * static_cast<float>(frame)); // steering
+    Write(out, 0.5f);  // throttle
+    Write(out, 0.0f);  // brake
+    Write(out, false); // hand brake
+    Write(out, 3);     // gear
+  }
+  const auto end = out.tellp();
+  out.seekp(size_position, std::ios::beg);
+  Write(out, static_cast<uint32_t>(end - size_position) - static_cast<uint32_t>(sizeof(uint32_t)));
+  out.seekp(end, std::ios::beg);
+
+  Write(out, FRAME_END);
+  Write(out, uint32_t(0u));
+}
+
+static std::string ReadFile(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+TEST(recorder, buffered_file_writer) {
+  const auto path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+
+  std::stringstream expected;
+  FrameIndex expected_index;
+  std::streampos previous_duration = 0;
+  for (auto i = 0u; i < 200u; ++i) {
+    expected_index.Add(i / 90.0, static_cast<uint64_t>(expected.tellp()), false);
+    WriteActorsFrame(expected, i, static_cast<uint16_t>(i % 50u), previous_duration);
+  }
+  expected_index.Write(expected);
+
+  // A short queue, so the writer blocks now and then.
+  BufferedFileWriter writer(2u);
+  ASSERT_TRUE(writer.Open(path.string()));
+  std::ostream out(&writer);
+  FrameIndex index;
+  previous_duration = 0;
+  for (auto i = 0u; i < 200u; ++i) {
+    const auto offset = out.tellp();
+    index.Add(i / 90.0, static_cast<uint64_t>(offset), false);
+    WriteActorsFrame(out, i, static_cast<uint16_t>(i % 50u), previous_duration);
+    // Keep the last frame, its duration is patched by the next one.
+    writer.Flush(static_cast<uint64_t>(offset));
+    // Already flushed data cannot be rewritten.
+    if (offset > 0) {
+      ASSERT_EQ(out.rdbuf()->pubseekpos(offset - std::streamoff(1), std::ios::out), std::streampos(-1));
+    }
+  }
+  index.Write(out);
+  ASSERT_TRUE(out.good());
+  ASSERT_TRUE(writer.Close());
+  ASSERT_EQ(writer.GetBytesWritten(), expected.str().size());
+
+  ASSERT_EQ(ReadFile(path.string()), expected.str());
+  std::ifstream file(path.string(), std::ios::binary);
+  FrameIndex read;
+  ASSERT_TRUE(read.Read(file));
+  ASSERT_EQ(read.size(), expected_index.size());
+  ASSERT_EQ(read.back().offset, expected_index.back().offset);
+  file.close();
+  boost::filesystem::remove(path);
+}
+
+TEST(recorder, writer_benchmark) {
+  // Time the recorder spends writing each frame in the simulation thread,
+  // writing straight to the file versus handing the frame to the writer.
+  constexpr auto frames = 300u;
+  constexpr double budget_ms = 1.0;
+  const auto path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+
+  for (auto count : {100u, 1000u, 5000u, 20000u}) {
+    const auto actors = static_cast<uint16_t>(count);
+    double direct_total = 0.0;
+    double direct_max = 0.0;
+    {
+      std::ofstream out(path.string(), std::ios::binary);
+      std::streampos previous_duration = 0;
+      for (auto i = 0u; i < frames; ++i) {
+        carla::StopWatch watch;
+        WriteActorsFrame(out, i, actors, previous_duration);
+        watch.Stop();
+        const auto ms = static_cast<double>(watch.GetElapsedTime<std::chrono::microseconds>()) / 1e3;
+        direct_total += ms;
+        direct_max = std::max(direct_max, ms);
+      }
+    }
+
+    double buffered_total = 0.0;
+    double buffered_max = 0.0;
+    BufferedFileWriter writer;
+    ASSERT_TRUE(writer.Open(path.string()));
+    {
+      std::ostream out(&writer);
+      std::streampos previous_duration = 0;
+      for (auto i = 0u; i < frames; ++i) {
+        carla::StopWatch watch;
+        const auto offset = out.tellp();
+        WriteActorsFrame(out, i, actors, previous_duration);
+        writer.Flush(static_cast<uint64_t>(offset));
+        watch.Stop();
+        const auto ms = static_cast<double>(watch.GetElapsedTime<std::chrono::microseconds>()) / 1e3;
+        buffered_total += ms;
+        buffered_max = std::max(buffered_max, ms);
+      }
+    }
+    ASSERT_TRUE(writer.Close());
+
+    const auto direct_mean = direct_total / frames;
+    const auto buffered_mean = buffered_total / frames;
+    carla::logging::log(
+        actors, "actors: direct", direct_mean, "ms per frame (max", direct_max,
+        "ms), buffered", buffered_mean, "ms per frame (max", buffered_max,
+        "ms, queue peak", writer.GetMaxQueueSize(),
+        "blocked", writer.GetBlockedMicroseconds(), "us)");
+    if (buffered_mean > 0.0) {
+      carla::logging::log(
+          "  actors recordable within", budget_ms, "ms per frame: direct",
+          static_cast<size_t>(actors * budget_ms / std::max(direct_mean, 1e-3)),
+          "buffered", static_cast<size_t>(actors * budget_ms / buffered_mean));
+    }
+  }
+  boost::filesystem::remove(path);
+}
+
+TEST(recorder, lz4) {
+  namespace lz4 = carla::recorder::lz4;
+  std::mt19937_64 rng(7u);
+  std::vector<std::vector<uint8_t>> inputs;
+  inputs.emplace_back();
+  inputs.emplace_back(1u, uint8_t(42u));
+  inputs.emplace_back(13u, uint8_t(0u));
+  inputs.emplace_back(100000u, uint8_t(0u));
+  {
+    std::vector<uint8_t> random(70000u);
+    for (auto &byte : random) {
+      byte = static_cast<uint8_t>(rng());
+    }
+    inputs.emplace_back(std::move(random));
+  }
+  {
+    // repeated patterns with some noise, like recorder packets.
+    std::vector<uint8_t> text;
+    for (auto i = 0u; text.size() < 300000u; ++i) {
+      const std::string line = "actor " + std::to_string(i % 97u) + " moved to " + std::to_string(i) + "\n";
+      text.insert(text.end(), line.begin(), line.end());
+    }
+    inputs.emplace_back(std::move(text));
+  }
+
+  for (auto &input : inputs) {
+    std::vector<uint8_t> compressed(lz4::CompressBound(input.size()));
+    const auto size = lz4::Compress(input.data(), input.size(), compressed.data(), compressed.size());
+    ASSERT_GT(size, 0u);
+    std::vector<uint8_t> output(input.size());
+    ASSERT_TRUE(lz4::Decompress(compressed.data(), size, output.data(), output.size()));
+    ASSERT_EQ(output, input);
+    if (input.size() > 1u) {
+      // wrong sizes and truncated blocks are rejected.
+      ASSERT_FALSE(lz4::Decompress(compressed.data(), size, output.data(), output.size() - 1u));
+      ASSERT_FALSE(lz4::Decompress(compressed.data(), size - 1u, output.data(), output.size()));
+    }
+  }
+  std::vector<uint8_t> too_small(4u);
+  ASSERT_EQ(lz4::Compress(inputs.back().data(), inputs.back().size(), too_small.data(), too_small.size()), 0u);
+}
+
+TEST(recorder, block_file) {
+  const auto plain_path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+  const auto compressed_path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec.lz4");
+
+  constexpr auto frames = 900u;
+  constexpr uint16_t actors = 500u;
+  for (auto compressed : {false, true}) {
+    BufferedFileWriter writer;
+    ASSERT_TRUE(writer.Open((compressed ? compressed_path : plain_path).string(), compressed));
+    std::ostream out(&writer);
+    FrameIndex index;
+    std::streampos previous_duration = 0;
+    for (auto i = 0u; i < frames; ++i) {
+      const auto offset = out.tellp();
+      index.Add(i / 90.0, static_cast<uint64_t>(offset), (i % 90u) == 0u);
+      WriteActorsFrame(out, i, actors, previous_duration);
+      writer.Flush(static_cast<uint64_t>(offset));
+    }
+    index.Write(out);
+    ASSERT_TRUE(writer.Close());
+  }
+  const auto expected = ReadFile(plain_path.string());
+
+  // A plain file is not a block file.
+  BlockFileReader reader;
+  ASSERT_FALSE(reader.Open(plain_path.string()));
+
+  ASSERT_TRUE(reader.Open(compressed_path.string()));
+  ASSERT_EQ(reader.GetRawSize(), expected.size());
+  std::istream in(&reader);
+
+  // sequential read.
+  carla::StopWatch read_watch;
+  const std::string content{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+  read_watch.Stop();
+  ASSERT_EQ(content, expected);
+
+  // the frame index is found through the uncompressed content.
+  in.clear();
+  FrameIndex index;
+  ASSERT_TRUE(index.Read(in));
+  ASSERT_EQ(index.size(), frames);
+
+  // random access as the replayer does: seek to a frame and read its header.
+  std::mt19937_64 rng(3u);
+  std::uniform_real_distribution<double> random_time(0.0, frames / 90.0);
+  constexpr auto seeks = 2000u;
+  carla::StopWatch seek_watch;
+  for (auto i = 0u; i < seeks; ++i) {
+    const auto &entry = index[index.FindFrame(random_time(rng))];
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(entry.offset), std::ios::beg);
+    ASSERT_EQ(static_cast<uint64_t>(in.tellg()), entry.offset);
+    char id;
+    uint32_t size;
+    Read(in, id);
+    Read(in, size);
+    ASSERT_EQ(id, FRAME_START);
+    ASSERT_EQ(size, sizeof(Frame));
+    Frame frame;
+    Read(in, frame);
+    ASSERT_DOUBLE_EQ(frame.elapsed, entry.elapsed);
+  }
+  seek_watch.Stop();
+  in.clear();
+  in.seekg(-3, std::ios::end);
+  ASSERT_EQ(static_cast<uint64_t>(in.tellg()), expected.size() - 3u);
+  ASSERT_EQ(in.get(), static_cast<unsigned char>(expected[expected.size() - 3u]));
+
+  carla::logging::log(
+      "recording of", frames, "frames with", actors, "actors:",
+      expected.size() / 1024u, "KiB plain,",
+      reader.GetFileSize() / 1024u, "KiB compressed");
+  carla::logging::log(
+      "reading compressed:",
+      static_cast<double>(expected.size()) / static_cast<double>(std::max<size_t>(1u, read_watch.GetElapsedTime<std::chrono::microseconds>())),
+      "MB/s,", static_cast<double>(seek_watch.GetElapsedTime<std::chrono::microseconds>()) / seeks, "us per seek");
+
+  reader.Close();
+  boost::filesystem::remove(plain_path);
+  boost::filesystem::remove(compressed_path);
+}
+
+static void WriteString(std::ostream &out, const std::string &str) {
+  Write(out, static_cast<uint16_t>(str.size()));
+  out.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+template <typename T>
+static std::vector<T> ReadColumn(const boost::filesystem::path &directory, const std::string &column) {
+  const auto content = ReadFile((directory / column).string());
+  std::vector<T> result(content.size() / sizeof(T));
+  std::memcpy(result.data(), content.data(), result.size() * sizeof(T));
+  return result;
+}
+
+TEST(recorder, recording_exporter) {
+  constexpr char DREYEVR = static_cast<char>(139);
+  constexpr auto frames = 900u;
+  constexpr uint16_t actors = 200u;
+
+  for (auto compressed : {false, true}) {
+    for (auto with_index : {false, true}) {
+      const auto path = boost::filesystem::temp_directory_path() /
+          boost::filesystem::unique_path(compressed ? "carla-recording-%%%%-%%%%.rec.lz4" : "carla-recording-%%%%-%%%%.rec");
+      const auto directory = boost::filesystem::temp_directory_path() /
+          boost::filesystem::unique_path("carla-export-%%%%-%%%%");
+      {
+        BufferedFileWriter writer;
+        ASSERT_TRUE(writer.Open(path.string(), compressed));
+        std::ostream out(&writer);
+        Write(out, uint16_t(1u));
+        WriteString(out, "CARLA_RECORDER");
+        Write(out, int64_t(0));
+        WriteString(out, "Town05");
+        FrameIndex index;
+        std::streampos previous_duration = 0;
+        for (auto i = 0u; i < frames; ++i) {
+          const auto offset = out.tellp();
+          index.Add(i / 90.0, static_cast<uint64_t>(offset), false);
+          WriteActorsFrame(out, i, actors, previous_duration);
+          // the DReyeVR data is exported as it is, its layout does not matter.
+          const std::string payload(i % 7u, static_cast<char>('a' + i % 26u));
+          Write(out, DREYEVR);
+          Write(out, static_cast<uint32_t>(payload.size()));
+          out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+          writer.Flush(static_cast<uint64_t>(offset));
+        }
+        if (with_index) {
+          index.Write(out);
+        }
+        ASSERT_TRUE(writer.Close());
+      }
+
+      carla::StopWatch single_watch;
+      carla::recorder::ExportRecording(path.string(), directory.string(), 1u);
+      single_watch.Stop();
+      carla::StopWatch parallel_watch;
+      const auto result = carla::recorder::ExportRecording(path.string(), directory.string());
+      parallel_watch.Stop();
+
+      ASSERT_EQ(result.map, "Town05");
+      ASSERT_EQ(result.frames, frames);
+      ASSERT_TRUE(boost::filesystem::exists(directory / "schema.json"));
+
+      const auto frame_ids = ReadColumn<uint64_t>(directory, "frames/id.bin");
+      const auto durations = ReadColumn<double>(directory, "frames/duration.bin");
+      const auto offsets = ReadColumn<uint64_t>(directory, "frames/offset.bin");
+      ASSERT_EQ(frame_ids.size(), frames);
+      ASSERT_EQ(offsets.size(), frames);
+      for (auto i = 0u; i < frames; ++i) {
+        ASSERT_EQ(frame_ids[i], i);
+        ASSERT_DOUBLE_EQ(durations[i], (i + 1u < frames) ? 1.0 / 90.0 : -1.0);
+      }
+      ASSERT_TRUE(std::is_sorted(offsets.begin(), offsets.end()));
+
+      const auto position_frames = ReadColumn<uint64_t>(directory, "positions/frame.bin");
+      const auto position_actors = ReadColumn<uint32_t>(directory, "positions/actor.bin");
+      const auto xs = ReadColumn<float>(directory, "positions/x.bin");
+      const auto pitches = ReadColumn<float>(directory, "positions/pitch.bin");
+      ASSERT_EQ(position_frames.size(), frames * actors);
+      ASSERT_EQ(xs.size(), frames * actors);
+      for (auto i = 0u; i < position_frames.size(); i += 97u) {
+        const auto frame = i / actors;
+        const auto actor = i % actors;
+        ASSERT_EQ(position_frames[i], frame);
+        ASSERT_EQ(position_actors[i], actor);
+        ASSERT_FLOAT_EQ(xs[i], 10.0f * static_cast<float>(actor) + 0.25f * static_cast<float>(frame));
+        ASSERT_FLOAT_EQ(pitches[i], static_cast<float>((actor * 37u) % 360u));
+      }
+
+      const auto steering = ReadColumn<float>(directory, "vehicle_controls/steering.bin");
+      const auto gears = ReadColumn<int32_t>(directory, "vehicle_controls/gear.bin");
+      ASSERT_EQ(steering.size(), frames * actors);
+      ASSERT_FLOAT_EQ(steering[5u * actors + 1u], 0.5f);
+      ASSERT_EQ(gears.back(), 3);
+
+      const auto dreyevr_frames = ReadColumn<uint64_t>(directory, "dreyevr/frame.bin");
+      const auto dreyevr_offsets = ReadColumn<uint64_t>(directory, "dreyevr/offset.bin");
+      const auto dreyevr_sizes = ReadColumn<uint32_t>(directory, "dreyevr/size.bin");
+      const auto dreyevr_payload = ReadFile((directory / "dreyevr/payload.bin").string());
+      ASSERT_EQ(dreyevr_frames.size(), frames);
+      for (auto i = 0u; i < frames; ++i) {
+        ASSERT_EQ(dreyevr_frames[i], i);
+        ASSERT_EQ(dreyevr_sizes[i], i % 7u);
+        ASSERT_EQ(
+            dreyevr_payload.substr(dreyevr_offsets[i], dreyevr_sizes[i]),
+            std::string(i % 7u, static_cast<char>('a' + i % 26u)));
+      }
+      ASSERT_EQ(ReadColumn<uint64_t>(directory, "dreyevr_custom_actors/frame.bin").size(), 0u);
+
+      carla::logging::log(
+          "exporting", compressed ? "compressed" : "plain", with_index ? "indexed" : "unindexed",
+          "recording of", result.bytes / 1024u, "KiB:",
+          static_cast<double>(result.bytes) / static_cast<double>(std::max<size_t>(1u, single_watch.GetElapsedTime<std::chrono::microseconds>())),
+          "MB/s on one thread,",
+          static_cast<double>(result.bytes) / static_cast<double>(std::max<size_t>(1u, parallel_watch.GetElapsedTime<std::chrono::microseconds>())),
+          "MB/s on", std::thread::hardware_concurrency(), "threads");
+
+      boost::filesystem::remove(path);
+      boost::filesystem::remove_all(directory);
+    }
+  }
+
+  // not a recorder file.
+  const auto path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+  {
+    std::ofstream out(path.string(), std::ios::binary);
+    out << "not a recording";
+  }
+  ASSERT_THROW(carla::recorder::ExportRecording(path.string(), path.string() + ".export"), std::runtime_error);
+  boost::filesystem::remove(path);
+}
+
+struct SummaryFrameEvents {
+  std::vector<std::pair<uint32_t, std::string>> added;
+  std::vector<uint32_t> removed;
+  std::vector<std::pair<uint32_t, uint32_t>> collisions;
+  std::vector<Position> positions;
+};
+
+/// Write a frame with the packets the summary is built from, and give the
+/// same data to @a builder as the recorder does.
+static void WriteSummaryFrame(
+    std::ostream &out,
+    carla::recorder::RecordingSummaryBuilder &builder,
+    uint64_t frame,
+    double elapsed,
+    const SummaryFrameEvents &events) {
+  constexpr char EVENT_ADD = 2;
+  constexpr char EVENT_DEL = 3;
+  constexpr char COLLISION = 5;
+  Write(out, FRAME_START);
+  Write(out, static_cast<uint32_t>(sizeof(Frame)));
+  Write(out, Frame{frame, 0.05, elapsed});
+
+  std::stringstream packet;
+  Write(packet, static_cast<uint16_t>(events.added.size()));
+  for (auto &added : events.added) {
+    const uint8_t type = (added.second[0] == 'w') ? 2u : 1u;
+    Write(packet, added.first);
+    Write(packet, type);
+    for (auto i = 0u; i < 6u; ++i) {
+      Write(packet, 0.0f);
+    }
+    Write(packet, uint32_t(7u));
+    WriteString(packet, added.second);
+    Write(packet, uint16_t(1u));
+    Write(packet, uint8_t(0u));
+    WriteString(packet, "role_name");
+    WriteString(packet, "autopilot");
+    builder.AddActor(added.first, type, added.second);
+  }
+  Write(out, EVENT_ADD);
+  Write(out, static_cast<uint32_t>(packet.str().size()));
+  out << packet.str();
+
+  Write(out, EVENT_DEL);
+  Write(out, static_cast<uint32_t>(sizeof(uint16_t) + events.removed.size() * sizeof(uint32_t)));
+  Write(out, static_cast<uint16_t>(events.removed.size()));
+  for (auto id : events.removed) {
+    Write(out, id);
+    builder.RemoveActor(id);
+  }
+
+  Write(out, COLLISION);
+  Write(out, static_cast<uint32_t>(sizeof(uint16_t) + events.collisions.size() * 14u));
+  Write(out, static_cast<uint16_t>(events.collisions.size()));
+  for (auto &collision : events.collisions) {
+    Write(out, uint32_t(0u));
+    Write(out, collision.first);
+    Write(out, collision.second);
+    Write(out, false);
+    Write(out, collision.first == 1u);
+    builder.AddCollision(collision.first, collision.second, false, collision.first == 1u);
+  }
+
+  Write(out, POSITION);
+  Write(out, static_cast<uint32_t>(sizeof(uint16_t) + events.positions.size() * sizeof(Position)));
+  Write(out, static_cast<uint16_t>(events.positions.size()));
+  for (auto &position : events.positions) {
+    Write(out, position);
+    builder.AddPosition(position.id, position.location[0], position.location[1], position.location[2]);
+  }
+
+  Write(out, FRAME_END);
+  Write(out, uint32_t(0u));
+  builder.FinishFrame(frame, elapsed);
+}
+
+/// A recording at 20 FPS where actor 1 drives at 1 m/s but stops from 30 to
+/// 75 s, actor 2 is parked until removed at 100 s and actor 3 walks from
+/// 10 s on; 1 and 2 touch for a while at 20 s and again at 50 s. Another
+/// @a parked actors just stay put.
+static carla::recorder::RecordingSummary WriteSummaryRecording(
+    std::ostream &out,
+    size_t frames,
+    bool summary,
+    uint32_t parked = 0u) {
+  carla::recorder::RecordingSummaryBuilder builder;
+  Write(out, uint16_t(1u));
+  WriteString(out, "CARLA_RECORDER");
+  Write(out, int64_t(0));
+  WriteString(out, "Town05");
+  FrameIndex index;
+  for (auto i = 0u; i < frames; ++i) {
+    const double elapsed = i * 0.05;
+    index.Add(elapsed, static_cast<uint64_t>(out.tellp()), false);
+    SummaryFrameEvents events;
+    if (i == 0u) {
+      events.added = {{1u, "vehicle.tesla.model3"}, {2u, "vehicle.audi.tt"}};
+    } else if (i == 200u) {
+      events.added = {{3u, "walker.pedestrian.0001"}};
+    } else if (i == 2000u) {
+      events.removed = {2u};
+    }
+    if (((i >= 400u) && (i < 440u)) || (i == 1000u)) {
+      events.collisions = {{1u, 2u}};
+    } else if (i == 1200u) {
+      events.collisions = {{1u, uint32_t(-1)}};
+    }
+    // 1 m/s except from 30 to 75 s.
+    const double moving = std::min(elapsed, 30.0) + std::max(0.0, elapsed - 75.0);
+    events.positions.push_back(Position{1u, {100.0f * static_cast<float>(moving), 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}});
+    if (i < 2000u) {
+      events.positions.push_back(Position{2u, {500.0f, 300.0f, 0.0f}, {0.0f, 0.0f, 0.0f}});
+    }
+    if (i >= 200u) {
+      events.positions.push_back(Position{3u, {0.0f, 150.0f * static_cast<float>(elapsed), 0.0f}, {0.0f, 0.0f, 0.0f}});
+    }
+    for (auto j = 0u; j < parked; ++j) {
+      events.positions.push_back(Position{100u + j, {static_cast<float>(j), -500.0f, 0.0f}, {0.0f, 0.0f, 0.0f}});
+    }
+    WriteSummaryFrame(out, builder, i, elapsed, events);
+  }
+  auto result = builder.Build();
+  if (summary) {
+    result.Write(out);
+  }
+  index.Write(out);
+  return result;
+}
+
+static void ExpectSameSummary(
+    const carla::recorder::RecordingSummary &a,
+    const carla::recorder::RecordingSummary &b) {
+  ASSERT_EQ(a.GetLastFrame(), b.GetLastFrame());
+  ASSERT_DOUBLE_EQ(a.GetDuration(), b.GetDuration());
+  ASSERT_EQ(a.GetActors().size(), b.GetActors().size());
+  for (auto i = 0u; i < a.GetActors().size(); ++i) {
+    ASSERT_EQ(a.GetActors()[i].id, b.GetActors()[i].id);
+    ASSERT_EQ(a.GetActors()[i].type, b.GetActors()[i].type);
+    ASSERT_EQ(a.GetActors()[i].description, b.GetActors()[i].description);
+    ASSERT_DOUBLE_EQ(a.GetActors()[i].begin, b.GetActors()[i].begin);
+    ASSERT_DOUBLE_EQ(a.GetActors()[i].end, b.GetActors()[i].end);
+  }
+  ASSERT_EQ(a.GetCollisions().size(), b.GetCollisions().size());
+  ASSERT_EQ(a.GetTrajectories().size(), b.GetTrajectories().size());
+  ASSERT_EQ(0, std::memcmp(
+      a.GetCollisions().data(),
+      b.GetCollisions().data(),
+      a.GetCollisions().size() * sizeof(carla::recorder::SummaryCollision)));
+  ASSERT_EQ(0, std::memcmp(
+      a.GetTrajectories().data(),
+      b.GetTrajectories().data(),
+      a.GetTrajectories().size() * sizeof(carla::recorder::SummaryPoint)));
+}
+
+TEST(recorder, recording_summary) {
+  using carla::recorder::RecordingSummary;
+  constexpr auto frames = 2400u;
+
+  std::stringstream with_summary;
+  const auto expected = WriteSummaryRecording(with_summary, frames, true);
+
+  ASSERT_EQ(expected.GetLastFrame(), frames - 1u);
+  ASSERT_EQ(expected.GetActors().size(), 3u);
+  ASSERT_DOUBLE_EQ(expected.GetActors()[1].end, 100.0);
+  ASSERT_DOUBLE_EQ(expected.GetActors()[2].begin, 10.0);
+  ASSERT_DOUBLE_EQ(expected.GetActors()[2].end, expected.GetDuration());
+  ASSERT_EQ(expected.FindActor(3u, 50.0)->description, "walker.pedestrian.0001");
+  ASSERT_EQ(expected.FindActor(4u, 50.0), nullptr);
+
+  // only the first frame of each collision.
+  const auto &collisions = expected.GetCollisions();
+  ASSERT_EQ(collisions.size(), 3u);
+  ASSERT_DOUBLE_EQ(collisions[0].elapsed, 20.0);
+  ASSERT_DOUBLE_EQ(collisions[1].elapsed, 50.0);
+  ASSERT_EQ(collisions[2].actor2, uint32_t(-1));
+  ASSERT_EQ(collisions[0].is_actor2_hero, 1u);
+
+  // about one sample per second for the actors moving, one for the parked.
+  ASSERT_LT(expected.GetTrajectories().size(), 2u * 120u + 110u + 10u);
+
+  const auto blocked = expected.FindBlocked(30.0, 10.0);
+  ASSERT_EQ(blocked.size(), 2u);
+  ASSERT_EQ(blocked[0].id, 2u);
+  ASSERT_NEAR(blocked[0].begin, 0.0, 1.5);
+  ASSERT_NEAR(blocked[0].duration, 100.0, 1.5);
+  ASSERT_EQ(blocked[1].id, 1u);
+  ASSERT_NEAR(blocked[1].begin, 30.0, 1.5);
+  ASSERT_NEAR(blocked[1].duration, 45.0, 1.5);
+  ASSERT_EQ(expected.FindBlocked(50.0, 10.0).size(), 1u);
+  // walking at 1.5 m/s is blocked only for a large enough distance.
+  const auto far = expected.FindBlocked(30.0, 5000.0);
+  ASSERT_TRUE(std::any_of(far.begin(), far.end(), [](const auto &actor) { return actor.id == 3u; }));
+
+  // read back from the file.
+  RecordingSummary summary;
+  ASSERT_TRUE(summary.Read(with_summary));
+  ExpectSameSummary(summary, expected);
+  FrameIndex index;
+  ASSERT_TRUE(index.Read(with_summary));
+  ASSERT_EQ(index.size(), frames);
+
+  // files without summary (or index) are scanned to the same result, large
+  // enough to be split.
+  constexpr uint32_t parked = 200u;
+  std::stringstream with_parked;
+  const auto expected_parked = WriteSummaryRecording(with_parked, frames, false, parked);
+  for (auto compressed : {false, true}) {
+    for (auto with_index : {false, true}) {
+      const auto path = boost::filesystem::temp_directory_path() /
+          boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+      {
+        BufferedFileWriter writer;
+        ASSERT_TRUE(writer.Open(path.string(), compressed));
+        std::ostream out(&writer);
+        std::stringstream content;
+        WriteSummaryRecording(content, frames, false, parked);
+        auto data = content.str();
+        if (!with_index) {
+          // drop the index packet at the end.
+          data.resize(data.size() - (5u + 4u + frames * sizeof(carla::recorder::FrameIndexEntry) + 16u));
+        }
+        out << data;
+        ASSERT_TRUE(writer.Close());
+      }
+      {
+        std::ifstream in(path.string(), std::ios::binary);
+        RecordingSummary none;
+        ASSERT_FALSE(none.Read(in));
+      }
+      carla::StopWatch single_watch;
+      RecordingSummary single;
+      ASSERT_TRUE(carla::recorder::ScanRecordingSummary(path.string(), single, 1u));
+      single_watch.Stop();
+      carla::StopWatch parallel_watch;
+      RecordingSummary scanned;
+      ASSERT_TRUE(carla::recorder::ScanRecordingSummary(path.string(), scanned));
+      parallel_watch.Stop();
+      ExpectSameSummary(single, expected_parked);
+      ExpectSameSummary(scanned, expected_parked);
+      carla::logging::log(
+          "scanning", compressed ? "compressed" : "plain", with_index ? "indexed" : "unindexed",
+          "recording of", with_parked.str().size() / 1024u, "KiB for its summary:",
+          single_watch.GetElapsedTime(), "ms on one thread,",
+          parallel_watch.GetElapsedTime(), "ms on", std::thread::hardware_concurrency(), "threads");
+      boost::filesystem::remove(path);
+    }
+  }
+
+  RecordingSummary missing;
+  ASSERT_FALSE(carla::recorder::ScanRecordingSummary("/nonexistent/recording.rec", missing));
+}
+
+/// Write a recording of @a frames frames of @a actors actors with a frame
+/// index, as the recorder does.
+static void WriteActorsRecording(
+    const std::string &path,
+    bool compressed,
+    size_t frames,
+    uint16_t actors) {
+  BufferedFileWriter writer;
+  ASSERT_TRUE(writer.Open(path, compressed));
+  std::ostream out(&writer);
+  FrameIndex index;
+  std::streampos previous_duration = 0;
+  for (auto i = 0u; i < frames; ++i) {
+    const auto offset = out.tellp();
+    index.Add(i / 90.0, static_cast<uint64_t>(offset), (i % 90u) == 0u);
+    WriteActorsFrame(out, i, actors, previous_duration);
+    writer.Flush(static_cast<uint64_t>(offset));
+  }
+  index.Write(out);
+  ASSERT_TRUE(writer.Close());
+}
+
+TEST(recorder, frame_prefetcher) {
+  const auto plain_path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+  const auto compressed_path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec.lz4");
+
+  constexpr auto frames = 600u;
+  WriteActorsRecording(plain_path.string(), false, frames, 300u);
+  WriteActorsRecording(compressed_path.string(), true, frames, 300u);
+  const auto expected = ReadFile(plain_path.string());
+
+  FramePrefetcher prefetcher(8u);
+  ASSERT_FALSE(prefetcher.Open((plain_path.string() + ".missing")));
+
+  for (const auto &path : {plain_path, compressed_path}) {
+    ASSERT_TRUE(prefetcher.Open(path.string()));
+    ASSERT_EQ(prefetcher.GetSize(), expected.size());
+    std::istream in(&prefetcher);
+
+    // sequential read.
+    const std::string content{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    ASSERT_EQ(content, expected);
+    ASSERT_EQ(prefetcher.GetRestarts(), 0u);
+
+    // the frame index is found seeking from the end.
+    in.clear();
+    FrameIndex index;
+    ASSERT_TRUE(index.Read(in));
+    ASSERT_EQ(index.size(), frames);
+
+    // random access to the frames, then read on packet by packet skipping
+    // the content as the replayer does.
+    std::mt19937_64 rng(5u);
+    std::uniform_real_distribution<double> random_time(0.0, frames / 90.0);
+    for (auto i = 0u; i < 200u; ++i) {
+      const auto first = index.FindFrame(random_time(rng));
+      in.clear();
+      in.seekg(static_cast<std::streamoff>(index[first].offset), std::ios::beg);
+      for (auto j = first; j < std::min<size_t>(first + 3u, index.size()); ++j) {
+        ASSERT_EQ(static_cast<uint64_t>(in.tellg()), index[j].offset);
+        char id;
+        uint32_t size;
+        Read(in, id);
+        Read(in, size);
+        ASSERT_EQ(id, FRAME_START);
+        Frame frame;
+        Read(in, frame);
+        ASSERT_DOUBLE_EQ(frame.elapsed, index[j].elapsed);
+        for (auto packet : {POSITION, ANIM_VEHICLE, FRAME_END}) {
+          Read(in, id);
+          Read(in, size);
+          ASSERT_EQ(id, packet);
+          in.seekg(size, std::ios::cur);
+        }
+      }
+    }
+
+    // positions that are not at a packet.
+    for (auto offset : {size_t(0u), size_t(12345u), expected.size() / 2u, expected.size() - 100u}) {
+      in.clear();
+      in.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+      std::string bytes(100u, '\0');
+      in.read(&bytes[0], static_cast<std::streamsize>(bytes.size()));
+      ASSERT_EQ(bytes, expected.substr(offset, bytes.size()));
+    }
+    in.clear();
+    in.seekg(-3, std::ios::end);
+    ASSERT_EQ(static_cast<uint64_t>(in.tellg()), expected.size() - 3u);
+    ASSERT_EQ(in.get(), static_cast<unsigned char>(expected[expected.size() - 3u]));
+    ASSERT_GT(prefetcher.GetRestarts(), 0u);
+    prefetcher.Close();
+  }
+
+  boost::filesystem::remove(plain_path);
+  boost::filesystem::remove(compressed_path);
+}
+
+/// Stream buffer reading through another one as a slow disk would: each read
+/// of @a block_size bytes takes @a read_time, and seeking outside the last
+/// block read takes @a seek_time.
+class SlowDiskBuffer : public std::streambuf {
+public:
+
+  SlowDiskBuffer(
+      std::unique_ptr<std::streambuf> content,
+      size_t block_size,
+      std::chrono::microseconds read_time,
+      std::chrono::microseconds seek_time)
+    : _content(std::move(content)),
+      _block(block_size),
+      _read_time(read_time),
+      _seek_time(seek_time) {}
+
+protected:
+
+  int_type underflow() override {
+    std::this_thread::sleep_for(_read_time);
+    _block_offset += static_cast<uint64_t>(egptr() - eback());
+    const auto count = _content->sgetn(_block.data(), static_cast<std::streamsize>(_block.size()));
+    setg(_block.data(), _block.data(), _block.data() + count);
+    return (count > 0) ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+  }
+
+  pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override {
+    const auto current = static_cast<off_type>(_block_offset) + (gptr() - eback());
+    if (direction == std::ios_base::cur) {
+      offset += current;
+    } else if (direction == std::ios_base::end) {
+      offset += static_cast<off_type>(_content->pubseekoff(0, std::ios_base::end, which));
+    }
+    return seekpos(pos_type(offset), which);
+  }
+
+  pos_type seekpos(pos_type position, std::ios_base::openmode which) override {
+    const auto target = static_cast<uint64_t>(off_type(position));
+    if ((target >= _block_offset) && (target <= _block_offset + static_cast<uint64_t>(egptr() - eback()))) {
+      setg(eback(), eback() + static_cast<std::ptrdiff_t>(target - _block_offset), egptr());
+      return position;
+    }
+    std::this_thread::sleep_for(_seek_time);
+    _block_offset = target;
+    setg(_block.data(), _block.data(), _block.data());
+    return _content->pubseekpos(position, which);
+  }
+
+private:
+
+  std::unique_ptr<std::streambuf> _content;
+
+  std::vector<char> _block;
+
+  uint64_t _block_offset = 0u;
+
+  std::chrono::microseconds _read_time;
+
+  std::chrono::microseconds _seek_time;
+};
+
+TEST(recorder, replay_benchmark) {
+  // Time the replayer spends reading the frames of each tick at 4x speed,
+  // straight from a slow disk versus through the prefetcher, while the rest
+  // of the tick runs.
+  constexpr auto frames = 1200u;
+  constexpr uint16_t actors = 1000u;
+  constexpr double time_factor = 4.0;
+  constexpr double tick = 1.0 / 30.0;
+  constexpr auto game_work = std::chrono::milliseconds(8);
+  const auto path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+  WriteActorsRecording(path.string(), false, frames, actors);
+
+  auto open_slow_disk = [&]() {
+    auto file = std::make_unique<std::filebuf>();
+    file->open(path.string(), std::ios::in | std::ios::binary);
+    // about 128 MB/s and 2 ms per seek.
+    return std::make_unique<SlowDiskBuffer>(
+        std::move(file),
+        64u * 1024u,
+        std::chrono::microseconds(500),
+        std::chrono::microseconds(2000));
+  };
+
+  // Process the packets up to @a time, false at the end of the recording.
+  std::vector<Position> positions;
+  auto process_to_time = [&](std::istream &in, double time) {
+    char id;
+    uint32_t size;
+    while (in) {
+      const auto offset = in.tellg();
+      Read(in, id);
+      Read(in, size);
+      if (!in || (id == FrameIndex::PacketId)) {
+        return false;
+      }
+      if (id == FRAME_START) {
+        Frame frame;
+        Read(in, frame);
+        if (frame.elapsed > time) {
+          in.seekg(offset);
+          return true;
+        }
+      } else if (id == POSITION) {
+        uint16_t count;
+        Read(in, count);
+        positions.resize(count);
+        in.read(reinterpret_cast<char *>(positions.data()), static_cast<std::streamsize>(count * sizeof(Position)));
+      } else {
+        in.seekg(size, std::ios::cur);
+      }
+    }
+    return false;
+  };
+
+  auto replay = [&](std::istream &in, const char *name) {
+    std::vector<double> times;
+    double time = 0.0;
+    bool more = true;
+    while (more) {
+      time += tick * time_factor;
+      carla::StopWatch watch;
+      more = process_to_time(in, time);
+      watch.Stop();
+      times.emplace_back(static_cast<double>(watch.GetElapsedTime<std::chrono::microseconds>()) / 1e3);
+      std::this_thread::sleep_for(game_work);
+    }
+    ASSERT_EQ(positions.size(), actors);
+    const double mean = std::accumulate(times.begin(), times.end(), 0.0) / static_cast<double>(times.size());
+    std::sort(times.begin(), times.end());
+    carla::logging::log(
+        name, "reading per tick: mean", mean, "ms, p99",
+        times[(times.size() * 99u) / 100u], "ms, max", times.back(), "ms over", times.size(), "ticks");
+  };
+
+  carla::logging::log(
+      "replaying", frames, "frames of", actors, "actors at", time_factor, "x,",
+      boost::filesystem::file_size(path) / 1024u, "KiB");
+  {
+    auto disk = open_slow_disk();
+    std::istream in(disk.get());
+    replay(in, "direct:");
+  }
+  {
+    FramePrefetcher prefetcher;
+    ASSERT_TRUE(prefetcher.Open(open_slow_disk()));
+    std::istream in(&prefetcher);
+    replay(in, "prefetched:");
+    carla::logging::log(
+        "  prefetched", prefetcher.GetFramesRead(), "frames, waited",
+        prefetcher.GetWaitMicroseconds(), "us");
+  }
+  boost::filesystem::remove(path);
+}
+
+TEST(recorder, frame_window) {
+  using Window = carla::recorder::FrameWindow<Position>;
+  constexpr double delta = 1.0 / 90.0;
+  constexpr auto actors = 100u;
+  auto make_frame = [&](size_t i, bool has_events) {
+    Window::Frame frame;
+    frame.elapsed = static_cast<double>(i) * delta;
+    frame.duration = delta;
+    frame.has_events = has_events;
+    frame.items.resize(actors);
+    frame.items[0u].location[0] = static_cast<float>(i);
+    frame.packets.resize(16u);
+    return frame;
+  };
+  const size_t frame_bytes = make_frame(0u, false).GetBytes();
+
+  // disabled by default.
+  Window window;
+  window.Add(make_frame(0u, false));
+  ASSERT_TRUE(window.empty());
+
+  // frames read forward, then a few earlier ones after a jump back.
+  window.SetMaxBytes(100u * frame_bytes);
+  for (auto i = 50u; i < 90u; ++i) {
+    window.Add(make_frame(i, i == 70u));
+  }
+  for (auto i = 20u; i < 30u; ++i) {
+    window.Add(make_frame(i, false));
+  }
+  ASSERT_EQ(window.size(), 50u);
+  ASSERT_EQ(window.GetBytes(), 50u * frame_bytes);
+
+  auto frame = window.Find(60.5 * delta);
+  ASSERT_NE(frame, nullptr);
+  ASSERT_EQ(frame->items[0u].location[0], 60.0f);
+  auto previous = window.GetPrevious(*frame);
+  ASSERT_NE(previous, nullptr);
+  ASSERT_EQ(previous->items[0u].location[0], 59.0f);
+  ASSERT_EQ(window.GetPrevious(*window.Find(50.5 * delta)), nullptr);
+  ASSERT_EQ(window.Find(40.0 * delta), nullptr);
+  ASSERT_EQ(window.Find(95.0 * delta), nullptr);
+
+  // playable in both directions up to the frame with events or the gap.
+  ASSERT_TRUE(window.CanPlay(69.5 * delta, 52.5 * delta));
+  ASSERT_TRUE(window.CanPlay(52.5 * delta, 69.5 * delta));
+  ASSERT_TRUE(window.CanPlay(70.5 * delta, 89.5 * delta));
+  ASSERT_FALSE(window.CanPlay(71.5 * delta, 65.5 * delta));
+  ASSERT_FALSE(window.CanPlay(55.5 * delta, 25.5 * delta));
+  ASSERT_FALSE(window.CanPlay(85.5 * delta, 95.5 * delta));
+  ASSERT_TRUE(window.CanPlay(29.5 * delta, 20.0 * delta));
+
+  // adding the same frame again replaces it.
+  window.Add(make_frame(60u, false));
+  ASSERT_EQ(window.size(), 50u);
+  ASSERT_EQ(window.GetBytes(), 50u * frame_bytes);
+
+  // over budget, the frames farthest from the last lookup go first.
+  window.Find(85.0 * delta);
+  window.SetMaxBytes(30u * frame_bytes);
+  ASSERT_LE(window.GetBytes(), window.GetMaxBytes());
+  ASSERT_EQ(window.size(), 30u);
+  ASSERT_EQ(window.Find(20.5 * delta), nullptr);
+  ASSERT_NE(window.Find(89.5 * delta), nullptr);
+  ASSERT_NE(window.Find(60.5 * delta), nullptr);
+  for (auto i = 90u; i < 200u; ++i) {
+    window.Add(make_frame(i, false));
+    window.Find(static_cast<double>(i) * delta);
+    ASSERT_LE(window.GetBytes(), window.GetMaxBytes());
+  }
+  ASSERT_TRUE(window.CanPlay(199.5 * delta, 170.5 * delta));
+  ASSERT_EQ(window.Find(160.5 * delta), nullptr);
+
+  window.Clear();
+  ASSERT_TRUE(window.empty());
+  ASSERT_EQ(window.GetBytes(), 0u);
+}
+
+/// Read a position field by field, as the simulator does.
+static void ReadPosition(std::istream &in, Position &position) {
+  Read(in, position.id);
+  for (auto &value : position.location) {
+    Read(in, value);
+  }
+  for (auto &value : position.rotation) {
+    Read(in, value);
+  }
+}
+
+TEST(recorder, packet_filter) {
+  carla::recorder::PacketFilter filter;
+  for (auto id : {0, 1, 2, 6, 19, 127, 139, 140, 255}) {
+    ASSERT_TRUE(filter.IsPacketWanted(static_cast<char>(id)));
+  }
+  filter.SetPackets({POSITION, 139u});
+  ASSERT_TRUE(filter.IsPacketWanted(FRAME_START));
+  ASSERT_TRUE(filter.IsPacketWanted(FRAME_END));
+  ASSERT_TRUE(filter.IsPacketWanted(POSITION));
+  ASSERT_TRUE(filter.IsPacketWanted(static_cast<char>(139)));
+  ASSERT_FALSE(filter.IsPacketWanted(ANIM_VEHICLE));
+  ASSERT_FALSE(filter.IsPacketWanted(static_cast<char>(140)));
+  filter.SetPacket(ANIM_VEHICLE);
+  ASSERT_TRUE(filter.IsPacketWanted(ANIM_VEHICLE));
+
+  // only the records of the wanted actors are decoded.
+  std::stringstream packet;
+  for (auto i = 0u; i < 100u; ++i) {
+    Write(packet, Position{i, {static_cast<float>(i), 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}});
+  }
+  Write(packet, uint32_t(12345u));
+  std::vector<char> buffer;
+  auto decode_all = [&]() {
+    packet.clear();
+    packet.seekg(0, std::ios::beg);
+    std::vector<Position> decoded;
+    EXPECT_TRUE(filter.ForEachWantedRecord<Position>(packet, 100u, buffer, [&](const Position &position) {
+      decoded.emplace_back(position);
+    }));
+    uint32_t next;
+    Read(packet, next);
+    EXPECT_EQ(next, 12345u);
+    return decoded;
+  };
+  ASSERT_FALSE(filter.HasActorFilter());
+  ASSERT_EQ(decode_all().size(), 100u);
+  filter.SetActors({7u, 42u, 99u, 1000u});
+  ASSERT_TRUE(filter.HasActorFilter());
+  ASSERT_TRUE(filter.IsActorWanted(42u));
+  ASSERT_FALSE(filter.IsActorWanted(43u));
+  const auto decoded = decode_all();
+  ASSERT_EQ(decoded.size(), 3u);
+  ASSERT_EQ(decoded[0u].id, 7u);
+  ASSERT_EQ(decoded[1u].location[0], 42.0f);
+  ASSERT_EQ(decoded[2u].id, 99u);
+  filter.SetActors({});
+  ASSERT_EQ(decode_all().size(), 100u);
+}
+
+TEST(recorder, packet_filter_benchmark) {
+  // Time to go through a recording decoding every packet as the replayer
+  // does, versus only the positions of one actor, versus only reading it.
+  constexpr auto frames = 900u;
+  constexpr uint16_t actors = 2000u;
+  const auto path = boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path("carla-recording-%%%%-%%%%.rec");
+  WriteActorsRecording(path.string(), false, frames, actors);
+  const auto bytes = boost::filesystem::file_size(path);
+
+  auto replay = [&](const carla::recorder::PacketFilter &filter) {
+    std::ifstream in(path.string(), std::ios::binary);
+    size_t decoded = 0u;
+    char id;
+    uint32_t size;
+    Position position;
+    std::vector<char> buffer;
+    while (true) {
+      Read(in, id);
+      Read(in, size);
+      if (!in || (id == FrameIndex::PacketId)) {
+        break;
+      }
+      if (!filter.IsPacketWanted(id)) {
+        in.seekg(size, std::ios::cur);
+        continue;
+      }
+      if (id == FRAME_START) {
+        Frame frame;
+        Read(in, frame);
+      } else if (id == POSITION) {
+        uint16_t count;
+        Read(in, count);
+        if (filter.HasActorFilter()) {
+          filter.ForEachWantedRecord<Position>(in, count, buffer, [&](const Position &) { ++decoded; });
+        } else {
+          // field by field, as the simulator did before.
+          for (auto i = 0u; i < count; ++i) {
+            ReadPosition(in, position);
+            ++decoded;
+          }
+        }
+      } else if (id == ANIM_VEHICLE) {
+        uint16_t count;
+        Read(in, count);
+        for (auto i = 0u; i < count; ++i) {
+          uint32_t actor;
+          float values[3];
+          bool hand_brake;
+          int32_t gear;
+          Read(in, actor);
+          for (auto &value : values) {
+            Read(in, value);
+          }
+          Read(in, hand_brake);
+          Read(in, gear);
+          ++decoded;
+        }
+      } else {
+        in.seekg(size, std::ios::cur);
+      }
+    }
+    return decoded;
+  };
+
+  carla::recorder::PacketFilter all;
+  carla::StopWatch all_watch;
+  ASSERT_EQ(replay(all), 2u * frames * actors);
+  all_watch.Stop();
+
+  carla::recorder::PacketFilter ego;
+  ego.SetPackets({POSITION});
+  ego.SetActors({0u});
+  carla::StopWatch ego_watch;
+  ASSERT_EQ(replay(ego), frames);
+  ego_watch.Stop();
+
+  carla::StopWatch io_watch;
+  {
+    std::ifstream in(path.string(), std::ios::binary);
+    std::vector<char> block(1024u * 1024u);
+    while (in.read(block.data(), static_cast<std::streamsize>(block.size()))) {}
+  }
+  io_watch.Stop();
+
+  auto throughput = [&](const carla::StopWatch &watch) {
+    return static_cast<double>(bytes) / static_cast<double>(std::max<size_t>(1u, watch.GetElapsedTime<std::chrono::microseconds>()));
+  };
+  carla::logging::log(
+      "recording of", frames, "frames with", actors, "actors,", bytes / 1024u, "KiB: decoding all",
+      throughput(all_watch), "MB/s, one actor's positions", throughput(ego_watch),
+      "MB/s, reading only", throughput(io_watch), "MB/s");
+  boost::filesystem::remove(path);
+}
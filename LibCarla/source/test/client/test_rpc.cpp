@@ -7,13 +7,18 @@
 #include "test.h"
 
 #include <carla/MsgPackAdaptors.h>
+#include <carla/StopWatch.h>
 #include <carla/ThreadGroup.h>
+#include <carla/client/detail/Client.h>
 #include <carla/rpc/Actor.h>
 #include <carla/rpc/Client.h>
 #include <carla/rpc/Response.h>
 #include <carla/rpc/Server.h>
 
+#include <atomic>
+#include <future>
 #include <thread>
+#include <vector>
 
 using namespace carla::rpc;
 using namespace std::chrono_literals;
@@ -62,3 +67,160 @@ TEST(rpc, server_bind_sync_run_on_game_thread) {
   std::cout << "game thread: run " << i << " slices.\n";
   ASSERT_TRUE(done);
 }
+
+TEST(rpc, spawn_throughput_benchmark) {
+  const uint16_t port = (TESTING_PORT != 0u ? TESTING_PORT : 2018u);
+
+  // Stand-in for the simulator, spawning runs on the game thread.
+  Server server(port);
+  ActorId next_id = 1u;
+  server.BindSync("spawn_actor", [&](ActorDescription description, carla::geom::Transform) -> Response<Actor> {
+    Actor actor;
+    actor.id = next_id++;
+    actor.description = std::move(description);
+    return actor;
+  });
+  server.AsyncRun(4u);
+
+  constexpr auto number_of_actors = 500u;
+  std::atomic_bool done{false};
+  size_t blocking_us = 0u;
+  size_t async_us = 0u;
+
+  carla::ThreadGroup threads;
+  threads.CreateThread([&]() {
+    carla::client::detail::Client client("localhost", port);
+    ActorDescription description;
+    description.id = "vehicle.stand_in";
+
+    carla::StopWatch stop_watch;
+    for (auto i = 0u; i < number_of_actors; ++i) {
+      EXPECT_GT(client.SpawnActor(description, carla::geom::Transform{}).id, 0u);
+    }
+    stop_watch.Stop();
+    blocking_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+
+    stop_watch.Restart();
+    std::vector<carla::client::detail::CallFuture<Actor>> futures;
+    futures.reserve(number_of_actors);
+    for (auto i = 0u; i < number_of_actors; ++i) {
+      futures.emplace_back(client.SpawnActorAsync(description, carla::geom::Transform{}));
+    }
+    for (auto &future : futures) {
+      EXPECT_GT(future.Get().id, 0u);
+    }
+    stop_watch.Stop();
+    async_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+    done = true;
+  });
+
+  for (auto i = 0u; i < 1'000'000u && !done; ++i) {
+    server.SyncRunFor(2ms);
+  }
+  threads.JoinAll();
+  ASSERT_TRUE(done);
+  ASSERT_EQ(next_id, 2u * number_of_actors + 1u);
+
+  const auto to_actors_per_second = [](size_t elapsed_us) {
+    return elapsed_us > 0u ? 1e6 * number_of_actors / static_cast<double>(elapsed_us) : 0.0;
+  };
+  carla::logging::log(
+      number_of_actors, "actors spawned:",
+      to_actors_per_second(blocking_us), "actors/s blocking,",
+      to_actors_per_second(async_us), "actors/s pipelined");
+}
+
+TEST(rpc, call_future_abandon) {
+  using carla::client::detail::CallFuture;
+  using ObjectHandle = CallFuture<int>::ObjectHandle;
+  auto make_future = [](std::promise<ObjectHandle> &promise) {
+    return CallFuture<int>(
+        promise.get_future(),
+        [](ObjectHandle &) { return 42; },
+        "test",
+        carla::time_duration::seconds(1u));
+  };
+
+  // Taken with Get, the handler does not run.
+  std::atomic_int abandoned{0};
+  {
+    std::promise<ObjectHandle> promise;
+    auto future = make_future(promise)
+        .OnAbandon([&](int value) { abandoned = value; })
+        .Then([](int value) { return value + 1; });
+    promise.set_value(ObjectHandle{});
+    ASSERT_EQ(future.Get(), 43);
+  }
+
+  // Dropped before the response, the handler gets the value of the call
+  // before Then once it arrives.
+  std::promise<ObjectHandle> promise;
+  {
+    auto future = make_future(promise)
+        .OnAbandon([&](int value) { abandoned = value; })
+        .Then([](int value) { return value + 1; });
+    std::vector<CallFuture<int>> moved;
+    moved.emplace_back(std::move(future));
+  }
+  std::this_thread::sleep_for(50ms);
+  ASSERT_EQ(abandoned, 0);
+  promise.set_value(ObjectHandle{});
+  for (auto i = 0u; i < 100u && abandoned == 0; ++i) {
+    std::this_thread::sleep_for(10ms);
+  }
+  ASSERT_EQ(abandoned, 42);
+}
+
+TEST(rpc, server_bind_read_only_benchmark) {
+  const auto main_thread_id = std::this_thread::get_id();
+  const uint16_t port = (TESTING_PORT != 0u ? TESTING_PORT : 2019u);
+
+  struct WorldState {
+    std::vector<int> values;
+  };
+
+  Server server(port);
+  server.BindSync("sync_query", [](int i) {
+    return i % 10;
+  });
+  server.BindReadOnly("read_only_query", [=](const WorldState &state, int i) {
+    EXPECT_NE(std::this_thread::get_id(), main_thread_id);
+    return state.values[static_cast<size_t>(i) % state.values.size()];
+  });
+  server.PublishSnapshot(std::make_shared<const WorldState>(WorldState{{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}}));
+  server.AsyncRun(4u);
+
+  constexpr auto number_of_clients = 4u;
+  constexpr auto number_of_calls = 100;
+
+  // Game loop with 10 ms frames, the server runs a slice of each one.
+  auto benchmark = [&](const std::string &function) {
+    std::atomic_size_t finished{0u};
+    carla::StopWatch stop_watch;
+    carla::ThreadGroup clients;
+    clients.CreateThreads(number_of_clients, [&]() {
+      Client client("localhost", port);
+      for (auto i = 0; i < number_of_calls; ++i) {
+        EXPECT_EQ(client.call(function, i).as<int>(), i % 10);
+      }
+      ++finished;
+    });
+    while (finished < number_of_clients) {
+      server.SyncRunFor(2ms);
+      std::this_thread::sleep_for(8ms);
+    }
+    clients.JoinAll();
+    stop_watch.Stop();
+    return stop_watch.GetElapsedTime<std::chrono::microseconds>();
+  };
+
+  const auto sync_us = benchmark("sync_query");
+  const auto read_only_us = benchmark("read_only_query");
+  const auto to_calls_per_second = [](size_t elapsed_us) {
+    return elapsed_us > 0u ? 1e6 * number_of_clients * number_of_calls / static_cast<double>(elapsed_us) : 0.0;
+  };
+  carla::logging::log(
+      number_of_clients, "clients:",
+      to_calls_per_second(sync_us), "calls/s on the game thread,",
+      to_calls_per_second(read_only_us), "calls/s read-only");
+}
@@ -0,0 +1,265 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "test.h"
+
+#include <carla/ParallelFor.h>
+#include <carla/StopWatch.h>
+#include <carla/sensor/DVSKernel.h>
+#include <carla/sensor/FastMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using carla::sensor::DVSKernel;
+using carla::sensor::FastMath;
+using carla::sensor::data::Color;
+using carla::sensor::data::DVSEvent;
+
+using Frame = std::vector<Color>;
+
+/// Bright vertical bars moving @a speed pixels per frame over a gradient.
+static std::vector<Frame> MakeMovingBars(uint32_t width, uint32_t height, size_t count, float speed) {
+  std::vector<Frame> frames(count, Frame(static_cast<size_t>(width) * height));
+  for (size_t i = 0u; i < count; ++i) {
+    const float shift = speed * static_cast<float>(i);
+    for (uint32_t y = 0u; y < height; ++y) {
+      for (uint32_t x = 0u; x < width; ++x) {
+        const float bars = 0.5f + 0.5f * std::sin((static_cast<float>(x) + shift) / 13.0f);
+        const float gradient = static_cast<float>(y) / static_cast<float>(height);
+        const auto value = static_cast<uint8_t>(20.0f + 200.0f * bars * (0.25f + 0.75f * gradient));
+        frames[i][y * width + x] = Color(value, static_cast<uint8_t>(value / 2u), static_cast<uint8_t>(255u - value));
+      }
+    }
+  }
+  return frames;
+}
+
+static const std::vector<DVSEvent> &Simulate(
+    DVSKernel &kernel,
+    const Frame &frame,
+    int64_t time_ns,
+    size_t threads) {
+  return kernel.Simulate(frame.data(), frame.size(), time_ns, [=](size_t count, auto &&functor) {
+    carla::ParallelFor(count, functor, threads);
+  });
+}
+
+static bool IsSorted(const std::vector<DVSEvent> &events) {
+  return std::is_sorted(events.begin(), events.end(), [](const DVSEvent &lhs, const DVSEvent &rhs) {
+    return lhs.t < rhs.t;
+  });
+}
+
+TEST(dvs, log) {
+  for (float x = 1e-4f; x < 4.0f; x *= 1.01f) {
+    ASSERT_NEAR(FastMath::Log(x), std::log(x), 1e-6f * std::max(1.0f, std::abs(std::log(x)))) << x;
+  }
+  // the log_eps of the camera may be zero.
+  const float min = FastMath::Log(std::numeric_limits<float>::min());
+  ASSERT_TRUE(std::isfinite(min));
+  ASSERT_EQ(FastMath::Log(0.0f), min);
+  ASSERT_EQ(FastMath::Log(1e-40f), min);
+}
+
+TEST(dvs, normal_noise) {
+  constexpr uint32_t count = 1000000u;
+  double sum = 0.0;
+  double squares = 0.0;
+  size_t within_one_sigma = 0u;
+  for (uint32_t pixel = 0u; pixel < count; ++pixel) {
+    const double sample = FastMath::Normal(FastMath::MakeKey(1u, 2u), pixel);
+    sum += sample;
+    squares += sample * sample;
+    within_one_sigma += (std::abs(sample) < 1.0) ? 1u : 0u;
+  }
+  const double mean = sum / count;
+  ASSERT_NEAR(mean, 0.0, 0.005);
+  ASSERT_NEAR(squares / count - mean * mean, 1.0, 0.01);
+  ASSERT_NEAR(static_cast<double>(within_one_sigma) / count, 0.6827, 0.002);
+
+  const auto key = FastMath::MakeKey(1u, 2u);
+  ASSERT_EQ(FastMath::Normal(key, 3u), FastMath::Normal(key, 3u));
+  ASSERT_NE(FastMath::Normal(key, 3u), FastMath::Normal(FastMath::MakeKey(1u, 3u), 3u));
+  ASSERT_NE(FastMath::Normal(key, 3u), FastMath::Normal(FastMath::MakeKey(2u, 2u), 3u));
+}
+
+TEST(dvs, brightness_step) {
+  constexpr uint32_t width = 40u;
+  constexpr uint32_t height = 37u;
+  DVSKernel::Config config;
+  config.use_log = false;
+  config.positive_threshold = 30.0f;
+  DVSKernel kernel(config, width, height);
+  ASSERT_EQ(kernel.GetTileCount(), 3u);
+
+  const Frame dark(width * height, Color(50u, 50u, 50u));
+  const Frame bright(width * height, Color(150u, 150u, 150u));
+  ASSERT_TRUE(Simulate(kernel, dark, 1000000, 1u).empty());
+  const auto &events = Simulate(kernel, bright, 2000000, 1u);
+
+  // three crossings per pixel, at 30%, 60% and 90% of the frame.
+  ASSERT_EQ(events.size(), 3u * width * height);
+  ASSERT_TRUE(IsSorted(events));
+  for (size_t i = 0u; i < events.size(); ++i) {
+    const auto &event = events[i];
+    const auto crossing = static_cast<int64_t>(1u + i / (width * height));
+    ASSERT_TRUE(event.pol);
+    ASSERT_LE(std::abs(event.t - (1000000 + crossing * 300000)), 100);
+    // ties in raster order.
+    const auto pixel = i % (width * height);
+    ASSERT_EQ(event.x, pixel % width);
+    ASSERT_EQ(event.y, pixel / width);
+  }
+  ASSERT_EQ(kernel.GetFrameCount(), 2u);
+
+  // wrong size.
+  ASSERT_TRUE(kernel.Simulate(dark.data(), dark.size() - 1u, 3000000, [](size_t, auto &&) {}).empty());
+  ASSERT_EQ(kernel.GetFrameCount(), 2u);
+}
+
+TEST(dvs, matches_per_pixel_loop) {
+  // The per-pixel loop the camera ran before, on the same intensities.
+  constexpr uint32_t width = 64u;
+  constexpr uint32_t height = 48u;
+  DVSKernel::Config config;
+  config.use_log = false;
+  config.positive_threshold = 7.0f;
+  config.negative_threshold = 5.0f;
+  config.refractory_period_ns = 20000u;
+  const auto frames = MakeMovingBars(width, height, 12u, 3.5f);
+
+  auto gray = [](const Frame &frame) {
+    std::vector<float> image(frame.size());
+    for (size_t i = 0u; i < frame.size(); ++i) {
+      image[i] =
+          0.2989f * static_cast<float>(frame[i].r) +
+          0.587f * static_cast<float>(frame[i].g) +
+          0.114f * static_cast<float>(frame[i].b);
+    }
+    return image;
+  };
+  std::vector<float> prev_image = gray(frames[0u]);
+  std::vector<float> ref_values = prev_image;
+  std::vector<int64_t> last_event(prev_image.size(), 0);
+  int64_t current_time = 0;
+
+  DVSKernel kernel(config, width, height);
+  Simulate(kernel, frames[0u], current_time, 4u);
+  size_t total = 0u;
+  for (size_t frame = 1u; frame < frames.size(); ++frame) {
+    const int64_t time = static_cast<int64_t>(frame) * 33333333;
+    const auto last_image = gray(frames[frame]);
+    const float delta_t_ns = static_cast<float>(time - current_time);
+    std::vector<DVSEvent> expected;
+    for (uint32_t y = 0u; y < height; ++y) {
+      for (uint32_t x = 0u; x < width; ++x) {
+        const uint32_t i = (width * y) + x;
+        const float itdt = last_image[i];
+        const float it = prev_image[i];
+        if (std::fabs(it - itdt) <= 1e-6f) {
+          continue;
+        }
+        const float pol = (itdt >= it) ? +1.0f : -1.0f;
+        const float C = (pol > 0) ? config.positive_threshold : config.negative_threshold;
+        float curr_cross = ref_values[i];
+        for (;;) {
+          curr_cross += pol * C;
+          if (!((pol > 0 && curr_cross > it && curr_cross <= itdt) ||
+                (pol < 0 && curr_cross < it && curr_cross >= itdt))) {
+            break;
+          }
+          const auto edt = static_cast<uint64_t>((curr_cross - it) * delta_t_ns / (itdt - it));
+          const int64_t t = current_time + static_cast<int64_t>(edt);
+          if (t >= last_event[i]) {
+            if (last_event[i] == 0 || static_cast<uint64_t>(t - last_event[i]) >= config.refractory_period_ns) {
+              expected.emplace_back(static_cast<uint16_t>(x), static_cast<uint16_t>(y), t, pol > 0);
+              last_event[i] = t;
+            }
+            ref_values[i] = curr_cross;
+          }
+        }
+      }
+    }
+    std::stable_sort(expected.begin(), expected.end(), [](const DVSEvent &lhs, const DVSEvent &rhs) {
+      return lhs.t < rhs.t;
+    });
+    current_time = time;
+    prev_image = last_image;
+
+    const auto &events = Simulate(kernel, frames[frame], time, 4u);
+    ASSERT_EQ(events, expected) << "frame " << frame;
+    total += events.size();
+  }
+  ASSERT_GT(total, 1000u);
+}
+
+TEST(dvs, deterministic) {
+  // With threshold noise, the events do not depend on the threads used.
+  constexpr uint32_t width = 160u;
+  constexpr uint32_t height = 120u;
+  DVSKernel::Config config;
+  config.sigma_positive_threshold = 0.05f;
+  config.sigma_negative_threshold = 0.05f;
+  config.refractory_period_ns = 1000u;
+  const auto frames = MakeMovingBars(width, height, 8u, 2.0f);
+
+  std::vector<std::vector<DVSEvent>> reference;
+  for (size_t threads : {1u, 2u, 3u, 8u}) {
+    DVSKernel kernel(config, width, height, 42u);
+    for (size_t frame = 0u; frame < frames.size(); ++frame) {
+      const auto time = static_cast<int64_t>(frame + 1u) * 10000000;
+      const auto &events = Simulate(kernel, frames[frame], time, threads);
+      ASSERT_TRUE(IsSorted(events));
+      if (threads == 1u) {
+        reference.emplace_back(events);
+      } else {
+        ASSERT_EQ(events, reference[frame]) << threads << " threads, frame " << frame;
+      }
+    }
+  }
+  ASSERT_FALSE(reference.back().empty());
+
+  // another seed, other noise.
+  DVSKernel kernel(config, width, height, 43u);
+  for (size_t frame = 0u; frame < frames.size() - 1u; ++frame) {
+    Simulate(kernel, frames[frame], static_cast<int64_t>(frame + 1u) * 10000000, 1u);
+  }
+  ASSERT_NE(Simulate(kernel, frames.back(), static_cast<int64_t>(frames.size()) * 10000000, 1u), reference.back());
+}
+
+TEST(dvs, benchmark) {
+  // 1080p frames at 60 FPS, in the calling thread versus all the cores.
+  constexpr uint32_t width = 1920u;
+  constexpr uint32_t height = 1080u;
+  constexpr size_t count = 30u;
+  DVSKernel::Config config;
+  config.sigma_positive_threshold = 0.03f;
+  config.sigma_negative_threshold = 0.03f;
+  const auto frames = MakeMovingBars(width, height, count, 1.5f);
+
+  auto run = [&](size_t threads) {
+    DVSKernel kernel(config, width, height, 7u);
+    size_t events = 0u;
+    carla::StopWatch watch;
+    for (size_t frame = 0u; frame < count; ++frame) {
+      events += Simulate(kernel, frames[frame], static_cast<int64_t>(frame) * 16666667, threads).size();
+    }
+    watch.Stop();
+    carla::logging::log(
+        "dvs", width, 'x', height, "with", threads, "thread(s):",
+        static_cast<double>(watch.GetElapsedTime()) / count, "ms per frame,",
+        events / (count - 1u), "events per frame");
+    return events;
+  };
+
+  const auto serial = run(1u);
+  const auto parallel = run(std::max(1u, std::thread::hardware_concurrency()));
+  ASSERT_EQ(serial, parallel);
+  ASSERT_GT(serial, 0u);
+}
@@ -0,0 +1,384 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "test.h"
+
+#include <carla/Buffer.h>
+#include <carla/ParallelFor.h>
+#include <carla/StopWatch.h>
+#include <carla/geom/Transform.h>
+#include <carla/sensor/FastMath.h>
+#include <carla/sensor/LidarBatch.h>
+#include <carla/sensor/s11n/LidarSerializer.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using carla::Buffer;
+using carla::geom::Location;
+using carla::geom::Rotation;
+using carla::geom::Transform;
+using carla::sensor::FastMath;
+using carla::sensor::LidarBatch;
+using carla::sensor::data::LidarData;
+using carla::sensor::data::LidarDetection;
+using carla::sensor::s11n::LidarSerializer;
+
+/// The serializer does not look at the sensor.
+struct FakeLidar {};
+
+static const Transform SensorTransform{Location{12.0f, -3.0f, 2.5f}, Rotation{4.0f, 35.0f, -2.0f}};
+
+/// World to sensor matrix of SensorTransform for hits in centimetres.
+static LidarBatch::Matrix MakeMatrix(const Transform &transform) {
+  const auto inverse = transform.GetInverseMatrix();
+  LidarBatch::Matrix matrix;
+  for (size_t i = 0u; i < 3u; ++i) {
+    for (size_t j = 0u; j < 3u; ++j) {
+      matrix[4u * i + j] = 1e-2f * inverse[4u * i + j];
+    }
+    matrix[4u * i + 3u] = inverse[4u * i + 3u];
+  }
+  return matrix;
+}
+
+/// Hit in centimetres of the ray @a index of @a channel, at 2 to 60 metres
+/// from the sensor.
+static Location MakeHit(uint32_t channel, uint32_t index, uint32_t points_per_channel) {
+  const float yaw = 2.0f * 3.14159265f * static_cast<float>(index) / static_cast<float>(points_per_channel);
+  const float pitch = -0.4f + 0.005f * static_cast<float>(channel);
+  const float distance = 2.0f + 58.0f * (0.5f + 0.5f * std::sin(0.37f * static_cast<float>(index + channel)));
+  Location point{
+      distance * std::cos(pitch) * std::cos(yaw),
+      distance * std::cos(pitch) * std::sin(yaw),
+      distance * std::sin(pitch)};
+  SensorTransform.TransformPoint(point);
+  return 100.0f * point;
+}
+
+template <typename ParallelForT>
+static void SimulateWith(
+    LidarBatch &batch,
+    uint32_t channels,
+    uint32_t points_per_channel,
+    uint64_t seed,
+    ParallelForT &&parallel_for) {
+  batch.Reset(channels, points_per_channel, seed);
+  parallel_for(channels, [&](size_t channel) {
+    const auto ch = static_cast<uint32_t>(channel);
+    for (uint32_t i = 0u; i < points_per_channel; ++i) {
+      if (batch.IsRayKept(ch, i)) {
+        const auto hit = MakeHit(ch, i, points_per_channel);
+        batch.AddHit(ch, hit.x, hit.y, hit.z);
+      }
+    }
+  });
+  batch.Process(MakeMatrix(SensorTransform), parallel_for);
+}
+
+static void Simulate(LidarBatch &batch, uint32_t channels, uint32_t points_per_channel, uint64_t seed, size_t threads) {
+  SimulateWith(batch, channels, points_per_channel, seed, [=](size_t count, auto &&functor) {
+    carla::ParallelFor(count, functor, threads);
+  });
+}
+
+static std::vector<float> GetPoints(const LidarBatch &batch) {
+  std::vector<float> points(4u * batch.GetTotalPointCount());
+  batch.WritePoints(points.data());
+  return points;
+}
+
+TEST(lidar, exp) {
+  // the range reduction loses a few bits for large arguments.
+  for (float x = -87.0f; x <= 0.0f; x += 0.01f) {
+    ASSERT_NEAR(FastMath::Exp(x), std::exp(x), (4e-7f - 1e-7f * x) * std::exp(x)) << x;
+  }
+  ASSERT_EQ(FastMath::Exp(0.0f), 1.0f);
+  ASSERT_EQ(FastMath::Exp(-1000.0f), FastMath::Exp(-87.0f));
+  ASSERT_GT(FastMath::Exp(-1000.0f), 0.0f);
+}
+
+TEST(lidar, sqrt) {
+  ASSERT_EQ(FastMath::Sqrt(0.0f), 0.0f);
+  for (float x = 1e-4f; x < 1e5f; x *= 1.01f) {
+    ASSERT_NEAR(FastMath::Sqrt(x), std::sqrt(x), 3e-7f * std::sqrt(x)) << x;
+  }
+}
+
+TEST(lidar, detections) {
+  // no drop-off and no noise, the detections the sensor computed per point.
+  constexpr uint32_t channels = 8u;
+  constexpr uint32_t points_per_channel = 500u;
+  LidarBatch::Config config;
+  config.atmosphere_attenuation_rate = 0.004f;
+  config.dropoff_general_rate = 0.0f;
+  config.dropoff_zero_intensity = 0.0f;
+  LidarBatch batch(config);
+  Simulate(batch, channels, points_per_channel, 1u, 3u);
+  ASSERT_EQ(batch.GetTotalPointCount(), channels * points_per_channel);
+
+  const auto points = GetPoints(batch);
+  size_t index = 0u;
+  for (uint32_t channel = 0u; channel < channels; ++channel) {
+    ASSERT_EQ(batch.GetPointCount(channel), points_per_channel);
+    for (uint32_t i = 0u; i < points_per_channel; ++i, index += 4u) {
+      Location expected = 1e-2f * MakeHit(channel, i, points_per_channel);
+      SensorTransform.InverseTransformPoint(expected);
+      const float intensity = std::exp(-config.atmosphere_attenuation_rate * expected.Length());
+      ASSERT_NEAR(points[index + 0u], expected.x, 1e-4f);
+      ASSERT_NEAR(points[index + 1u], expected.y, 1e-4f);
+      ASSERT_NEAR(points[index + 2u], expected.z, 1e-4f);
+      ASSERT_NEAR(points[index + 3u], intensity, 1e-6f);
+    }
+  }
+}
+
+TEST(lidar, dropoff) {
+  constexpr uint32_t channels = 4u;
+  constexpr uint32_t points_per_channel = 50000u;
+  LidarBatch::Config config;
+  config.dropoff_general_rate = 0.45f;
+  LidarBatch batch(config);
+  batch.Reset(channels, points_per_channel, 5u);
+  size_t kept = 0u;
+  for (uint32_t channel = 0u; channel < channels; ++channel) {
+    for (uint32_t i = 0u; i < points_per_channel; ++i) {
+      kept += batch.IsRayKept(channel, i) ? 1u : 0u;
+    }
+  }
+  ASSERT_NEAR(static_cast<double>(kept) / (channels * points_per_channel), 0.55, 0.005);
+
+  // all the hits at an intensity of 0.4, below the limit of 0.8, are kept
+  // with a probability of 0.4 * 0.4 / 0.8 + 0.6; hits above the limit are
+  // always kept.
+  config.dropoff_general_rate = 0.0f;
+  config.atmosphere_attenuation_rate = 0.1f;
+  batch.SetConfig(config);
+  const float near = -std::log(0.4f) / config.atmosphere_attenuation_rate;
+  const float far = -std::log(0.9f) / config.atmosphere_attenuation_rate;
+  const LidarBatch::Matrix identity = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  batch.Reset(2u, points_per_channel, 5u);
+  for (uint32_t i = 0u; i < points_per_channel; ++i) {
+    batch.AddHit(0u, near, 0.0f, 0.0f);
+    batch.AddHit(1u, 0.0f, far, 0.0f);
+  }
+  batch.Process(identity, [](size_t count, auto &&functor) {
+    for (size_t i = 0u; i < count; ++i) {
+      functor(i);
+    }
+  });
+  ASSERT_NEAR(static_cast<double>(batch.GetPointCount(0u)) / points_per_channel, 0.8, 0.01);
+  ASSERT_EQ(batch.GetPointCount(1u), points_per_channel);
+}
+
+TEST(lidar, noise) {
+  // the points move along their ray.
+  constexpr uint32_t count = 200000u;
+  LidarBatch::Config config;
+  config.noise_stddev = 0.1f;
+  config.dropoff_general_rate = 0.0f;
+  config.dropoff_zero_intensity = 0.0f;
+  LidarBatch batch(config);
+  const LidarBatch::Matrix identity = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+  batch.Reset(1u, count, 9u);
+  for (uint32_t i = 0u; i < count; ++i) {
+    batch.AddHit(0u, 6.0f, 0.0f, 8.0f);
+  }
+  batch.AddHit(0u, 0.0f, 0.0f, 0.0f);
+  batch.ProcessChannel(0u, identity);
+  ASSERT_EQ(batch.GetPointCount(0u), count + 1u);
+
+  const auto points = GetPoints(batch);
+  double sum = 0.0;
+  double squares = 0.0;
+  for (uint32_t i = 0u; i < count; ++i) {
+    const float x = points[4u * i];
+    const float z = points[4u * i + 2u];
+    ASSERT_NEAR(x / z, 0.75f, 1e-5f);
+    ASSERT_EQ(points[4u * i + 1u], 0.0f);
+    ASSERT_NEAR(points[4u * i + 3u], std::exp(-config.atmosphere_attenuation_rate * 10.0f), 1e-6f);
+    const double error = std::sqrt(x * x + z * z) - 10.0;
+    sum += error;
+    squares += error * error;
+  }
+  const double mean = sum / count;
+  ASSERT_NEAR(mean, 0.0, 0.001);
+  ASSERT_NEAR(std::sqrt(squares / count - mean * mean), 0.1, 0.001);
+  // a hit at the sensor stays there.
+  ASSERT_EQ(points[4u * count], 0.0f);
+  ASSERT_EQ(points[4u * count + 3u], 1.0f);
+}
+
+TEST(lidar, deterministic) {
+  // the points do not depend on the threads used, but on seed and frame.
+  constexpr uint32_t channels = 32u;
+  constexpr uint32_t points_per_channel = 1000u;
+  LidarBatch::Config config;
+  config.noise_stddev = 0.05f;
+
+  std::vector<std::vector<float>> reference;
+  for (size_t threads : {1u, 2u, 5u, 8u}) {
+    LidarBatch batch(config);
+    for (size_t frame = 0u; frame < 3u; ++frame) {
+      Simulate(batch, channels, points_per_channel, 42u, threads);
+      if (threads == 1u) {
+        reference.emplace_back(GetPoints(batch));
+      } else {
+        ASSERT_EQ(GetPoints(batch), reference[frame]) << threads << " threads, frame " << frame;
+      }
+    }
+  }
+  ASSERT_NE(reference[0u], reference[1u]);
+
+  LidarBatch batch(config);
+  Simulate(batch, channels, points_per_channel, 43u, 1u);
+  ASSERT_NE(GetPoints(batch), reference[0u]);
+}
+
+TEST(lidar, serialize) {
+  constexpr uint32_t channels = 16u;
+  constexpr uint32_t points_per_channel = 300u;
+  LidarBatch::Config config;
+  config.noise_stddev = 0.02f;
+  LidarBatch batch(config);
+  Simulate(batch, channels, points_per_channel, 3u, 2u);
+  std::vector<uint32_t> counts(channels);
+  for (uint32_t channel = 0u; channel < channels; ++channel) {
+    counts[channel] = batch.GetPointCount(channel);
+  }
+  LidarData data(channels);
+  data.WriteChannelCount(counts);
+
+  // the same bytes as the points written one by one.
+  LidarData expected_data(channels);
+  expected_data.ResetMemory(counts);
+  expected_data.WriteChannelCount(counts);
+  const auto points = GetPoints(batch);
+  for (size_t i = 0u; i < points.size(); i += 4u) {
+    LidarDetection detection{points[i], points[i + 1u], points[i + 2u], points[i + 3u]};
+    expected_data.WritePointSync(detection);
+  }
+  const auto expected = LidarSerializer::Serialize(FakeLidar{}, expected_data, Buffer{});
+
+  // reuses the memory of the pooled buffer.
+  Buffer output(expected.size() + 100u);
+  const auto *memory = output.data();
+  const auto buffer = LidarSerializer::Serialize(FakeLidar{}, data, batch, std::move(output));
+  ASSERT_EQ(buffer.data(), memory);
+  ASSERT_EQ(buffer.size(), expected.size());
+  ASSERT_EQ(std::memcmp(buffer.data(), expected.data(), expected.size()), 0);
+  uint32_t header[2u + channels];
+  std::memcpy(header, buffer.data(), sizeof(header));
+  ASSERT_EQ(header[1u], channels);
+  ASSERT_EQ(header[2u + 5u], counts[5u]);
+}
+
+TEST(lidar, benchmark) {
+  // 128 channels at 2.6 million points per second, ticking at 20 Hz, with
+  // about 70% of the rays hitting something. The per-point path is the one
+  // the sensor ran before: hits kept in arrays of structures, the standard
+  // random engines and the points copied through LidarData.
+  constexpr uint32_t channels = 128u;
+  constexpr uint32_t points_per_channel = 2600000u / 20u / channels;
+  constexpr size_t ticks = 40u;
+  LidarBatch::Config config;
+  config.noise_stddev = 0.02f;
+  config.dropoff_general_rate = 0.0f;
+
+  std::vector<std::vector<Location>> hits(channels);
+  for (uint32_t channel = 0u; channel < channels; ++channel) {
+    for (uint32_t i = 0u; i < points_per_channel; ++i) {
+      if (((i * 7u + channel) % 10u) < 7u) {
+        hits[channel].emplace_back(MakeHit(channel, i, points_per_channel));
+      }
+    }
+  }
+  const auto matrix = MakeMatrix(SensorTransform);
+  const float alpha = config.dropoff_zero_intensity / config.dropoff_intensity_limit;
+  const float beta = 1.0f - config.dropoff_zero_intensity;
+
+  size_t per_point_count = 0u;
+  {
+    std::minstd_rand engine(7u);
+    LidarData data(channels);
+    std::vector<uint32_t> counts(channels);
+    Buffer output;
+    carla::StopWatch watch;
+    for (size_t tick = 0u; tick < ticks; ++tick) {
+      std::vector<std::vector<Location>> recorded(channels);
+      for (uint32_t channel = 0u; channel < channels; ++channel) {
+        recorded[channel].reserve(points_per_channel);
+        recorded[channel] = hits[channel];
+        counts[channel] = static_cast<uint32_t>(recorded[channel].size());
+      }
+      data.ResetMemory(counts);
+      for (uint32_t channel = 0u; channel < channels; ++channel) {
+        for (const auto &hit : recorded[channel]) {
+          LidarDetection detection;
+          detection.point = 1e-2f * hit;
+          SensorTransform.InverseTransformPoint(detection.point);
+          detection.intensity = std::exp(-config.atmosphere_attenuation_rate * detection.point.Length());
+          const auto noise = std::normal_distribution<float>(0.0f, config.noise_stddev)(engine);
+          detection.point += detection.point.MakeUnitVector() * noise;
+          if ((detection.intensity > config.dropoff_intensity_limit) ||
+              (std::uniform_real_distribution<float>()(engine) < alpha * detection.intensity + beta)) {
+            data.WritePointSync(detection);
+          } else {
+            --counts[channel];
+          }
+        }
+      }
+      data.WriteChannelCount(counts);
+      output = LidarSerializer::Serialize(FakeLidar{}, data, std::move(output));
+      per_point_count += output.size();
+    }
+    watch.Stop();
+    carla::logging::log(
+        "lidar", channels, "channels, per point:",
+        static_cast<double>(watch.GetElapsedTime()) / ticks, "ms per tick");
+  }
+
+  auto run = [&](size_t threads) {
+    LidarBatch batch(config);
+    LidarData data(channels);
+    std::vector<uint32_t> counts(channels);
+    Buffer output;
+    size_t size = 0u;
+    carla::StopWatch watch;
+    for (size_t tick = 0u; tick < ticks; ++tick) {
+      batch.Reset(channels, points_per_channel, 7u);
+      carla::ParallelFor(channels, [&](size_t channel) {
+        const auto ch = static_cast<uint32_t>(channel);
+        for (const auto &hit : hits[channel]) {
+          batch.AddHit(ch, hit.x, hit.y, hit.z);
+        }
+      }, threads);
+      batch.Process(matrix, [=](size_t count, auto &&functor) {
+        carla::ParallelFor(count, functor, threads);
+      });
+      for (uint32_t channel = 0u; channel < channels; ++channel) {
+        counts[channel] = batch.GetPointCount(channel);
+      }
+      data.WriteChannelCount(counts);
+      output = LidarSerializer::Serialize(FakeLidar{}, data, batch, std::move(output));
+      size += output.size();
+    }
+    watch.Stop();
+    carla::logging::log(
+        "lidar", channels, "channels, batched with", threads, "thread(s):",
+        static_cast<double>(watch.GetElapsedTime()) / ticks, "ms per tick,",
+        batch.GetTotalPointCount(), "points per tick");
+    return size;
+  };
+
+  const auto serial = run(1u);
+  const auto parallel = run(std::max(1u, std::thread::hardware_concurrency()));
+  ASSERT_EQ(serial, parallel);
+  // same drop-off probabilities, different random numbers.
+  ASSERT_NEAR(static_cast<double>(serial) / static_cast<double>(per_point_count), 1.0, 0.01);
+}
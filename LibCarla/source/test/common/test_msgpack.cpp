@@ -6,10 +6,16 @@
 
 #include "test.h"
 
+#include <carla/Functional.h>
 #include <carla/MsgPackAdaptors.h>
+#include <carla/StopWatch.h>
 #include <carla/rpc/Actor.h>
+#include <carla/rpc/Command.h>
+#include <carla/rpc/CommandBatch.h>
 #include <carla/rpc/Response.h>
+#include <carla/rpc/WalkerStateList.h>
 
+#include <cstring>
 #include <thread>
 
 using namespace carla::rpc;
@@ -105,3 +111,239 @@ TEST(msgpack, optional) {
   ASSERT_TRUE(result.has_value());
   ASSERT_EQ(*result, 42.0f);
 }
+
+TEST(msgpack, walker_state_list) {
+  using mp = carla::MsgPack;
+  namespace cg = carla::geom;
+  WalkerStateList list;
+  ASSERT_TRUE(list.empty());
+  list.emplace_back(3u, cg::Transform{cg::Location{1.0f, 2.0f, 3.0f}, cg::Rotation{0.0f, 90.0f, 0.0f}}, 1.5f);
+  list.emplace_back(7u, cg::Transform{cg::Location{-1.0f, 0.0f, 0.5f}}, 0.0f);
+  auto result = mp::UnPack<WalkerStateList>(mp::Pack(list));
+  ASSERT_EQ(result.size(), 2u);
+  const WalkerState first = result[0u];
+  const cg::Transform first_transform = first.transform;
+  ASSERT_EQ(first.actor, 3u);
+  ASSERT_EQ(first_transform.location, (cg::Location{1.0f, 2.0f, 3.0f}));
+  ASSERT_EQ(first_transform.rotation.yaw, 90.0f);
+  ASSERT_EQ(first.speed, 1.5f);
+  const WalkerState second = result[1u];
+  ASSERT_EQ(second.actor, 7u);
+  ASSERT_EQ(second.speed, 0.0f);
+}
+
+TEST(msgpack, walker_state_benchmark) {
+  using mp = carla::MsgPack;
+  namespace cg = carla::geom;
+  constexpr auto number_of_walkers = 5000u;
+  constexpr auto number_of_ticks = 20u;
+
+  std::vector<Command> commands;
+  WalkerStateList list;
+  for (auto i = 0u; i < number_of_walkers; ++i) {
+    const cg::Transform transform{
+        cg::Location{0.5f * static_cast<float>(i), -0.25f * static_cast<float>(i), 1.0f},
+        cg::Rotation{0.0f, static_cast<float>(i % 360u), 0.0f}};
+    commands.emplace_back(Command::ApplyWalkerState{i, transform, 1.4f});
+    list.emplace_back(i, transform, 1.4f);
+  }
+
+  // What the server does on each tick: decode the message and visit every
+  // walker state.
+  double checksum = 0.0;
+  carla::StopWatch stop_watch;
+  for (auto tick = 0u; tick < number_of_ticks; ++tick) {
+    auto result = mp::UnPack<std::vector<Command>>(mp::Pack(commands));
+    for (auto &command : result) {
+      checksum += boost::get<Command::ApplyWalkerState>(command.command).speed;
+    }
+  }
+  stop_watch.Stop();
+  const auto commands_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+
+  stop_watch.Restart();
+  for (auto tick = 0u; tick < number_of_ticks; ++tick) {
+    auto result = mp::UnPack<WalkerStateList>(mp::Pack(list));
+    for (auto i = 0u; i < result.size(); ++i) {
+      checksum -= result[i].speed;
+    }
+  }
+  stop_watch.Stop();
+  const auto list_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+  ASSERT_NEAR(checksum, 0.0, 1e-3);
+
+  const auto commands_size = mp::Pack(commands).size();
+  const auto list_size = mp::Pack(list).size();
+  ASSERT_LT(list_size, commands_size);
+  carla::logging::log(
+      number_of_walkers, "walkers:",
+      commands_size, "bytes and", commands_us / number_of_ticks, "us per tick as commands,",
+      list_size, "bytes and", list_us / number_of_ticks, "us per tick packed");
+}
+
+TEST(msgpack, command_batch) {
+  using mp = carla::MsgPack;
+  std::vector<Command> commands;
+  commands.emplace_back(Command::ApplyVehicleControl{1u, VehicleControl{0.5f, 0.1f, 0.0f, false, false, false, 2}});
+  commands.emplace_back(Command::ApplyVehicleControl{2u, VehicleControl{}});
+  commands.emplace_back(Command::DestroyActor{3u});
+  commands.emplace_back(Command::ApplyVehicleControl{4u, VehicleControl{}});
+  auto result = mp::UnPack<CommandBatch>(mp::Pack(CommandBatch(commands)));
+  ASSERT_EQ(result.size(), commands.size());
+  std::vector<ActorId> visited;
+  result.ForEach(carla::Functional::MakeOverload(
+      [&](const Command::ApplyVehicleControl &command) {
+        visited.emplace_back(command.actor);
+        if (command.actor == 1u) {
+          ASSERT_EQ(command.control.throttle, 0.5f);
+          ASSERT_EQ(command.control.gear, 2);
+        }
+      },
+      [&](const Command::DestroyActor &command) {
+        visited.emplace_back(command.actor + 100u);
+      },
+      [&](const auto &) {
+        FAIL();
+      }));
+  ASSERT_EQ(visited, (std::vector<ActorId>{1u, 2u, 103u, 4u}));
+}
+
+TEST(msgpack, command_batch_packed_records) {
+  using mp = carla::MsgPack;
+  const carla::geom::Vector3D vector{1.0f, -2.0f, 3.5f};
+  const carla::geom::Transform transform{carla::geom::Location{1.0f, 2.0f, 3.0f}, carla::geom::Rotation{4.0f, 5.0f, 6.0f}};
+  std::vector<Command> commands;
+  commands.emplace_back(Command::DestroyActor{1u});
+  commands.emplace_back(Command::ApplyVehicleControl{2u, VehicleControl{0.5f, -0.25f, 0.125f, true, false, true, -1}});
+  commands.emplace_back(Command::ApplyWalkerControl{3u, WalkerControl{vector, 1.5f, true}});
+  commands.emplace_back(Command::ApplyTransform{4u, transform});
+  commands.emplace_back(Command::ApplyWalkerState{5u, transform, 2.5f});
+  commands.emplace_back(Command::ApplyTargetVelocity{6u, vector});
+  commands.emplace_back(Command::ApplyTargetAngularVelocity{7u, vector});
+  commands.emplace_back(Command::ApplyImpulse{8u, vector});
+  commands.emplace_back(Command::ApplyForce{9u, vector});
+  commands.emplace_back(Command::ApplyAngularImpulse{10u, vector});
+  commands.emplace_back(Command::ApplyTorque{11u, vector});
+  commands.emplace_back(Command::SetSimulatePhysics{12u, true});
+  commands.emplace_back(Command::SetEnableGravity{13u, true});
+  commands.emplace_back(Command::SetAutopilot{14u, true, 8000u});
+  auto result = mp::UnPack<CommandBatch>(mp::Pack(CommandBatch(commands)));
+  ASSERT_EQ(result.size(), commands.size());
+  std::vector<ActorId> visited;
+  result.ForEach(
+      carla::Functional::MakeOverload(
+          [&](const Command::ApplyVehicleControl &command) {
+            ASSERT_EQ(command.control, (VehicleControl{0.5f, -0.25f, 0.125f, true, false, true, -1}));
+            visited.emplace_back(command.actor);
+          },
+          [&](const Command::ApplyWalkerControl &command) {
+            ASSERT_EQ(command.control, (WalkerControl{vector, 1.5f, true}));
+            visited.emplace_back(command.actor);
+          },
+          [&](const Command::ApplyTransform &command) {
+            ASSERT_EQ(command.transform, transform);
+            visited.emplace_back(command.actor);
+          },
+          [&](const Command::ApplyWalkerState &command) {
+            ASSERT_EQ(command.transform, transform);
+            ASSERT_EQ(command.speed, 2.5f);
+            visited.emplace_back(command.actor);
+          },
+          [&](const Command::ApplyTargetVelocity &command) {
+            ASSERT_EQ(command.velocity, vector);
+            visited.emplace_back(command.actor);
+          },
+          [&](const Command::ApplyTorque &command) {
+            ASSERT_EQ(command.torque, vector);
+            visited.emplace_back(command.actor);
+          },
+          [&](const Command::SetEnableGravity &command) {
+            ASSERT_TRUE(command.enabled);
+            visited.emplace_back(command.actor);
+          },
+          [](const Command::SpawnActor &) {
+            FAIL();
+          },
+          [&](const auto &command) {
+            visited.emplace_back(command.actor);
+          }),
+      [](size_t) { FAIL(); });
+  ASSERT_EQ(visited, (std::vector<ActorId>{1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u, 10u, 11u, 12u, 13u, 14u}));
+}
+
+namespace {
+
+  /// Same layout as the runs of a CommandBatch on the wire.
+  struct RawRun {
+    uint8_t type;
+    uint32_t count;
+    std::vector<unsigned char> data;
+    std::vector<Command> commands;
+    MSGPACK_DEFINE_ARRAY(type, count, data, commands);
+  };
+
+  struct RawCommandBatch {
+    std::vector<RawRun> runs;
+    size_t size;
+    MSGPACK_DEFINE_ARRAY(runs, size);
+  };
+
+} // namespace
+
+TEST(msgpack, command_batch_invalid_runs) {
+  using mp = carla::MsgPack;
+  const auto destroy_actor = static_cast<uint8_t>(Command::CommandType(Command::DestroyActor{0u}).which());
+  RawCommandBatch raw;
+  raw.runs.push_back(RawRun{200u, 2u, {}, {}});
+  raw.runs.push_back(RawRun{destroy_actor, 1u, {1u, 2u, 3u}, {}});
+  raw.runs.push_back(RawRun{destroy_actor, 1u, std::vector<unsigned char>(sizeof(ActorId)), {}});
+  const ActorId actor = 7u;
+  std::memcpy(raw.runs.back().data.data(), &actor, sizeof(ActorId));
+  raw.size = 4u;
+  auto result = mp::UnPack<CommandBatch>(mp::Pack(raw));
+  std::vector<ActorId> visited;
+  std::vector<size_t> invalid_runs;
+  result.ForEach(
+      carla::Functional::MakeOverload(
+          [&](const Command::DestroyActor &command) { visited.emplace_back(command.actor); },
+          [](const auto &) { FAIL(); }),
+      [&](size_t count) { invalid_runs.emplace_back(count); });
+  ASSERT_EQ(invalid_runs, (std::vector<size_t>{2u, 1u}));
+  ASSERT_EQ(visited, (std::vector<ActorId>{7u}));
+}
+
+TEST(msgpack, command_batch_benchmark) {
+  using mp = carla::MsgPack;
+  for (auto number_of_commands : {1000u, 5000u, 10000u}) {
+    std::vector<Command> commands;
+    commands.reserve(number_of_commands);
+    for (auto i = 0u; i < number_of_commands; ++i) {
+      commands.emplace_back(Command::ApplyVehicleControl{i, VehicleControl{0.7f, 0.05f, 0.0f, false, false, false, 1}});
+    }
+
+    double checksum = 0.0;
+    carla::StopWatch stop_watch;
+    const auto variant_buffer = mp::Pack(commands);
+    const auto variant_encode_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+    stop_watch.Restart();
+    for (auto &command : mp::UnPack<std::vector<Command>>(variant_buffer)) {
+      checksum += boost::get<Command::ApplyVehicleControl>(command.command).control.throttle;
+    }
+    const auto variant_decode_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+
+    stop_watch.Restart();
+    const auto batch_buffer = mp::Pack(CommandBatch(commands));
+    const auto batch_encode_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+    stop_watch.Restart();
+    mp::UnPack<CommandBatch>(batch_buffer).ForEach(carla::Functional::MakeOverload(
+        [&](const Command::ApplyVehicleControl &command) { checksum -= command.control.throttle; },
+        [](const auto &) {}));
+    const auto batch_decode_us = stop_watch.GetElapsedTime<std::chrono::microseconds>();
+    ASSERT_NEAR(checksum, 0.0, 1e-3);
+
+    carla::logging::log(
+        number_of_commands, "commands: variants",
+        variant_buffer.size(), "bytes, encode", variant_encode_us, "us, decode", variant_decode_us, "us;",
+        "batch", batch_buffer.size(), "bytes, encode", batch_encode_us, "us, decode", batch_decode_us, "us");
+  }
+}
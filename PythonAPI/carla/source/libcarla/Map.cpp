@@ -52,6 +52,34 @@ static auto GetTopology(const carla::client::Map &self) {
   return result;
 }
 
+static void BuildRoutingGraph(
+    const carla::client::Map &self,
+    double lane_change_cost,
+    bool contraction_hierarchy) {
+  carla::PythonUtil::ReleaseGIL unlock;
+  carla::road::RoutingParameters parameters;
+  parameters.lane_change_cost = lane_change_cost;
+  parameters.contraction_hierarchy = contraction_hierarchy;
+  self.BuildRoutingGraph(parameters);
+}
+
+static auto ComputeRoute(
+    const carla::client::Map &self,
+    const carla::client::Waypoint &origin,
+    const carla::client::Waypoint &destination) {
+  namespace py = boost::python;
+  std::vector<carla::SharedPtr<carla::client::Waypoint>> route;
+  {
+    carla::PythonUtil::ReleaseGIL unlock;
+    route = self.ComputeRoute(origin, destination);
+  }
+  py::list result;
+  for (auto &&waypoint : route) {
+    result.append(waypoint);
+  }
+  return result;
+}
+
 static auto GetJunctionWaypoints(const carla::client::Junction &self, const carla::road::Lane::LaneType lane_type) {
   namespace py = boost::python;
   auto topology = self.GetWaypoints(lane_type);
@@ -171,6 +199,8 @@ void export_map() {
     .def("get_all_landmarks_of_type", CALL_RETURNING_LIST_1(cc::Map, GetAllLandmarksOfType, std::string), (args("type")))
     .def("get_landmark_group", CALL_RETURNING_LIST_1(cc::Map, GetLandmarkGroup, cc::Landmark), args("landmark"))
     .def("cook_in_memory_map", &cc::Map::CookInMemoryMap, (arg("path")=""))
+    .def("build_routing_graph", &BuildRoutingGraph, (arg("lane_change_cost")=10.0, arg("contraction_hierarchy")=false))
+    .def("compute_route", &ComputeRoute, (arg("origin"), arg("destination")))
     .def(self_ns::str(self_ns::self))
   ;
 
@@ -11,8 +11,13 @@
 #include <carla/rpc/EnvironmentObject.h>
 #include <carla/rpc/ObjectLabel.h>
 
+#include <boost/make_shared.hpp>
 #include <boost/python/suite/indexing/vector_indexing_suite.hpp>
 
+#include <atomic>
+#include <exception>
+#include <mutex>
+
 namespace carla {
 namespace client {
 
@@ -40,7 +45,8 @@ namespace rpc {
         << ",max_substep_delta_time=" << settings.max_substep_delta_time
         << ",max_substeps=" << settings.max_substeps
         << ",max_culling_distance=" << settings.max_culling_distance
-        << ",deterministic_ragdolls=" << BoolToStr(settings.deterministic_ragdolls) << ')';
+        << ",deterministic_ragdolls=" << BoolToStr(settings.deterministic_ragdolls)
+        << ",delta_snapshots=" << BoolToStr(settings.delta_snapshots) << ')';
     return out;
   }
 
@@ -82,6 +88,87 @@ static auto GetActorsById(carla::client::World &self, const boost::python::list
   return self.GetActors(ids);
 }
 
+/// Python side of World.spawn_actor_async. Keeps the result so it can be
+/// queried more than once, and implements the awaitable protocol. While the
+/// response is pending, awaiting it waits for the result in the default
+/// executor of the event loop, whose future completes the await from that
+/// thread, so the loop does not poll.
+class ActorFuture {
+public:
+
+  explicit ActorFuture(carla::client::detail::CallFuture<carla::SharedPtr<carla::client::Actor>> future)
+    : _future(std::move(future)) {}
+
+  bool Done() const {
+    if (_received) {
+      return true;
+    }
+    // Result may be waiting on the future in the executor thread.
+    std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+    return lock.owns_lock() && (_received || _future.IsReady());
+  }
+
+  carla::SharedPtr<carla::client::Actor> Result() {
+    if (!_received) {
+      carla::PythonUtil::ReleaseGIL unlock;
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_received) {
+        try {
+          _actor = _future.Get();
+        } catch (...) {
+          _error = std::current_exception();
+        }
+        _received = true;
+      }
+    }
+    if (_error != nullptr) {
+      std::rethrow_exception(_error);
+    }
+    return _actor;
+  }
+
+  /// Awaitable protocol, only reached once the response arrived (see
+  /// Await). Blocks in Result otherwise.
+  boost::python::object Next() {
+    boost::python::object actor(Result());
+    PyErr_SetObject(PyExc_StopIteration, boost::python::make_tuple(actor).ptr());
+    boost::python::throw_error_already_set();
+    return actor;
+  }
+
+  static boost::python::object Await(boost::python::object self) {
+    const ActorFuture &future = boost::python::extract<const ActorFuture &>(self);
+    if (future.Done()) {
+      return self;
+    }
+    namespace py = boost::python;
+    py::object loop = py::import("asyncio").attr("get_event_loop")();
+    py::object result = py::object(self.attr("result"));
+    py::object pending = loop.attr("run_in_executor")(py::object(), result);
+    return pending.attr("__await__")();
+  }
+
+private:
+
+  carla::client::detail::CallFuture<carla::SharedPtr<carla::client::Actor>> _future;
+
+  mutable std::mutex _mutex;
+
+  std::atomic_bool _received{false};
+
+  carla::SharedPtr<carla::client::Actor> _actor;
+
+  std::exception_ptr _error;
+};
+
+static auto SpawnActorAsync(
+    carla::client::World &self,
+    const carla::client::ActorBlueprint &blueprint,
+    const carla::geom::Transform &transform) {
+  carla::PythonUtil::ReleaseGIL unlock;
+  return boost::make_shared<ActorFuture>(self.SpawnActorAsync(blueprint, transform));
+}
+
 static auto GetVehiclesLightStates(carla::client::World &self) {
   boost::python::dict dict;
   auto list = self.GetVehiclesLightStates();
@@ -153,7 +240,7 @@ void export_world() {
   ;
 
   class_<cr::EpisodeSettings>("WorldSettings")
-    .def(init<bool, bool, double, bool, double, int, float, bool, float, float>(
+    .def(init<bool, bool, double, bool, double, int, float, bool, float, float, bool>(
         (arg("synchronous_mode")=false,
          arg("no_rendering_mode")=false,
          arg("fixed_delta_seconds")=0.0,
@@ -163,7 +250,8 @@ void export_world() {
          arg("max_culling_distance")=0.0f,
          arg("deterministic_ragdolls")=false,
          arg("tile_stream_distance")=3000.f,
-         arg("actor_active_distance")=2000.f)))
+         arg("actor_active_distance")=2000.f,
+         arg("delta_snapshots")=false)))
     .def_readwrite("synchronous_mode", &cr::EpisodeSettings::synchronous_mode)
     .def_readwrite("no_rendering_mode", &cr::EpisodeSettings::no_rendering_mode)
     .def_readwrite("substepping", &cr::EpisodeSettings::substepping)
@@ -181,6 +269,7 @@ void export_world() {
         })
     .def_readwrite("tile_stream_distance", &cr::EpisodeSettings::tile_stream_distance)
     .def_readwrite("actor_active_distance", &cr::EpisodeSettings::actor_active_distance)
+    .def_readwrite("delta_snapshots", &cr::EpisodeSettings::delta_snapshots)
     .def("__eq__", &cr::EpisodeSettings::operator==)
     .def("__ne__", &cr::EpisodeSettings::operator!=)
     .def(self_ns::str(self_ns::self))
@@ -294,6 +383,14 @@ void export_world() {
       arg("attach_to")=carla::SharedPtr<cc::Actor>(), \
       arg("attachment_type")=cr::AttachmentType::Rigid)
 
+  class_<ActorFuture, boost::noncopyable, boost::shared_ptr<ActorFuture>>("ActorFuture", no_init)
+    .def("done", &ActorFuture::Done)
+    .def("result", &ActorFuture::Result)
+    .def("__await__", &ActorFuture::Await)
+    .def("__iter__", +[](boost::python::object self) { return self; })
+    .def("__next__", &ActorFuture::Next)
+  ;
+
   class_<cc::World>("World", no_init)
     .add_property("id", &cc::World::GetId)
     .add_property("debug", &cc::World::MakeDebugHelper)
@@ -314,6 +411,7 @@ void export_world() {
     .def("get_actors", &GetActorsById, (arg("actor_ids")))
     .def("spawn_actor", SPAWN_ACTOR_WITHOUT_GIL(SpawnActor))
     .def("try_spawn_actor", SPAWN_ACTOR_WITHOUT_GIL(TrySpawnActor))
+    .def("spawn_actor_async", &SpawnActorAsync, (arg("blueprint"), arg("transform")))
     .def("wait_for_tick", &WaitForTick, (arg("seconds")=0.0))
     .def("on_tick", &OnTick, (arg("callback")))
     .def("remove_on_tick", &cc::World::RemoveOnTick, (arg("callback_id")))
@@ -54,6 +54,7 @@ FCarlaEngine::~FCarlaEngine()
     FWorldDelegates::OnWorldTickStart.Remove(OnPreTickHandle);
     FWorldDelegates::OnWorldPostActorTick.Remove(OnPostTickHandle);
     FCarlaStaticDelegates::OnEpisodeSettingsChange.Remove(OnEpisodeSettingsChangeHandle);
+    FCarlaStaticDelegates::OnEpisodeKeyframeRequest.Remove(OnEpisodeKeyframeRequestHandle);
   }
 }
 
@@ -77,6 +78,9 @@ void FCarlaEngine::NotifyInitGame(const UCarlaSettings &Settings)
     OnEpisodeSettingsChangeHandle = FCarlaStaticDelegates::OnEpisodeSettingsChange.AddRaw(
         this,
         &FCarlaEngine::OnEpisodeSettingsChanged);
+    OnEpisodeKeyframeRequestHandle = FCarlaStaticDelegates::OnEpisodeKeyframeRequest.AddRaw(
+        &WorldObserver,
+        &FWorldObserver::RequestKeyframe);
 
     bIsRunning = true;
   }
@@ -93,4 +93,6 @@ private:
   FDelegateHandle OnPostTickHandle;
 
   FDelegateHandle OnEpisodeSettingsChangeHandle;
+
+  FDelegateHandle OnEpisodeKeyframeRequestHandle;
 };
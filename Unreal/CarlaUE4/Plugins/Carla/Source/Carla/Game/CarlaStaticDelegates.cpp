@@ -8,3 +8,4 @@
 #include "Carla/Game/CarlaStaticDelegates.h"
 
 FCarlaStaticDelegates::FOnEpisodeSettingsChange FCarlaStaticDelegates::OnEpisodeSettingsChange;
+FCarlaStaticDelegates::FOnEpisodeKeyframeRequest FCarlaStaticDelegates::OnEpisodeKeyframeRequest;
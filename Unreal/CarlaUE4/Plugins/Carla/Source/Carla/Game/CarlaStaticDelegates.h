@@ -14,4 +14,9 @@ public:
 
   DECLARE_MULTICAST_DELEGATE_OneParam(FOnEpisodeSettingsChange, const FEpisodeSettings &);
   static FOnEpisodeSettingsChange OnEpisodeSettingsChange;
+
+  /// A client could not apply a delta of the episode state stream and asks
+  /// for a keyframe.
+  DECLARE_MULTICAST_DELEGATE(FOnEpisodeKeyframeRequest);
+  static FOnEpisodeKeyframeRequest OnEpisodeKeyframeRequest;
 };
@@ -27,6 +27,13 @@
 #include <ctime>
 #include <sstream>
 
+static_assert(
+    static_cast<char>(CarlaRecorderPacketId::FrameIndex) == carla::recorder::FrameIndex::PacketId,
+    "Frame index packet id must match the one in LibCarla");
+static_assert(
+    static_cast<char>(CarlaRecorderPacketId::Summary) == carla::recorder::RecordingSummary::PacketId,
+    "Summary packet id must match the one in LibCarla");
+
 ACarlaRecorder::ACarlaRecorder(void)
 {
   PrimaryActorTick.TickGroup = TG_PrePhysics;
@@ -364,12 +371,13 @@ std::string ACarlaRecorder::Start(std::string Name, FString MapName, bool Additi
   // get the final path + filename
   std::string Filename = GetRecorderFilename(Name);
 
-  // binary file
-  File.open(Filename, std::ios::binary);
-  if (!File.is_open())
+  // binary file, packets are encoded in memory on this thread and written
+  // to disk by the writer thread (block compressed if the name ends in .lz4)
+  if (!Writer.Open(Filename, IsCompressedRecorderFilename(Filename)))
   {
     return "";
   }
+  static_cast<std::ostream &>(File).rdbuf(&Writer);
 
   // save info
   Info.Version = 1;
@@ -382,6 +390,9 @@ std::string ACarlaRecorder::Start(std::string Name, FString MapName, bool Additi
 
   Frames.Reset();
   PlatformTime.SetStartTime();
+  Index.clear();
+  Summary.Clear();
+  LastKeyFrameTime = 0.0;
 
   Enable();
 
@@ -400,10 +411,26 @@ void ACarlaRecorder::Stop(void)
 {
   Disable();
 
-  if (File)
+  if (Writer.IsOpen())
   {
-    File.close();
+    // the summary is found from the index, which goes last so it can be
+    // found from the end of the file
+    Summary.Build().Write(File);
+    Index.Write(File);
+    if (!Writer.Close())
+    {
+      UE_LOG(LogCarla, Error, TEXT("Recorder: failed to write the whole file"));
+    }
+    UE_LOG(LogCarla, Log,
+        TEXT("Recorder: %llu bytes written, up to %d frames waiting for disk, blocked %llu us"),
+        static_cast<unsigned long long>(Writer.GetBytesWritten()),
+        static_cast<int>(Writer.GetMaxQueueSize()),
+        static_cast<unsigned long long>(Writer.GetBlockedMicroseconds()));
+    // back to the stream's own (closed) file buffer
+    static_cast<std::ostream &>(File).rdbuf(File.rdbuf());
   }
+  Index.clear();
+  Summary.Clear();
 
   Clear();
 }
@@ -434,10 +461,26 @@ void ACarlaRecorder::Write(double DeltaSeconds)
 {
   // update this frame data
   Frames.SetFrame(DeltaSeconds);
+  const double Elapsed = Frames.GetFrame().Elapsed;
+  const bool bKeyFrame = Index.empty() || (Elapsed - LastKeyFrameTime >= KeyFrameInterval);
+  const uint64_t FrameOffset = static_cast<uint64_t>(File.tellp());
+  Index.Add(Elapsed, FrameOffset, bKeyFrame);
+  Summary.FinishFrame(Frames.GetFrame().Id, Elapsed);
 
   // start
   Frames.WriteStart(File);
 
+  // the previous frame is complete now that its duration has been patched,
+  // hand it to the writer thread
+  Writer.Flush(FrameOffset);
+
+  // whole state every few seconds, to be able to seek
+  if (bKeyFrame)
+  {
+    WriteKeyFrame();
+    LastKeyFrameTime = Elapsed;
+  }
+
   // events
   EventsAdd.Write(File);
   EventsDel.Write(File);
@@ -484,6 +527,7 @@ void ACarlaRecorder::AddPosition(const CarlaRecorderPosition &Position)
   if (Enabled)
   {
     Positions.Add(Position);
+    Summary.AddPosition(Position.DatabaseId, Position.Location.X, Position.Location.Y, Position.Location.Z);
   }
 }
 
@@ -491,6 +535,7 @@ void ACarlaRecorder::AddEvent(const CarlaRecorderEventAdd &Event)
 {
   if (Enabled)
   {
+    Summary.AddActor(Event.DatabaseId, Event.Type, TCHAR_TO_UTF8(*Event.Description.Id));
     EventsAdd.Add(std::move(Event));
   }
 }
@@ -499,6 +544,7 @@ void ACarlaRecorder::AddEvent(const CarlaRecorderEventDel &Event)
 {
   if (Enabled)
   {
+    Summary.RemoveActor(Event.DatabaseId);
     EventsDel.Add(std::move(Event));
   }
 }
@@ -552,6 +598,11 @@ void ACarlaRecorder::AddCollision(AActor *Actor1, AActor *Actor2)
       Collision.DatabaseId2 = uint32_t(-1); // actor2 is not a registered Carla actor
     }
 
+    Summary.AddCollision(
+        Collision.DatabaseId1,
+        Collision.DatabaseId2,
+        Collision.IsActor1Hero,
+        Collision.IsActor2Hero);
     Collisions.Add(std::move(Collision));
   }
 }
@@ -662,11 +713,69 @@ void ACarlaRecorder::AddStartingWeather(void)
   }
 }
 
-void ACarlaRecorder::CreateRecorderEventAdd(
+void ACarlaRecorder::WriteKeyFrame(void)
+{
+  KeyFrame.Clear();
+
+  // actors alive and their attachments
+  const FActorRegistry &Registry = Episode->GetActorRegistry();
+  for (auto It = Registry.begin(); It != Registry.end(); ++It)
+  {
+    const FCarlaActor* CarlaActor = It.Value().Get();
+    if (CarlaActor == nullptr || CarlaActor->GetActorInfo() == nullptr)
+      continue;
+
+    KeyFrame.AddActor(MakeRecorderEventAdd(
+        CarlaActor->GetActorId(),
+        static_cast<uint8_t>(CarlaActor->GetActorType()),
+        CarlaActor->GetActorGlobalTransform(),
+        CarlaActor->GetActorInfo()->Description));
+    if (CarlaActor->GetParent() != 0)
+    {
+      KeyFrame.AddParent(CarlaRecorderEventParent
+      {
+        CarlaActor->GetActorId(),
+        CarlaActor->GetParent()
+      });
+    }
+  }
+
+  // scene lights
+  UWorld *World = GetWorld();
+  if (World)
+  {
+    UCarlaLightSubsystem* CarlaLightSubsystem = World->GetSubsystem<UCarlaLightSubsystem>();
+    for (const auto& LightPair : CarlaLightSubsystem->GetLights())
+    {
+      const UCarlaLight* Light = LightPair.Value;
+      KeyFrame.AddLightScene(CarlaRecorderLightScene
+      {
+        Light->GetId(),
+        Light->GetLightIntensity(),
+        Light->GetLightColor(),
+        Light->GetLightOn(),
+        static_cast<uint8>(Light->GetLightType())
+      });
+    }
+  }
+
+  // weather
+  AWeather *Weather = AWeather::FindWeatherInstance(Episode->GetWorld());
+  if (Weather)
+  {
+    CarlaRecorderWeather WeatherState;
+    WeatherState.Params = Weather->GetCurrentWeather();
+    KeyFrame.AddWeather(WeatherState);
+  }
+
+  KeyFrame.Write(File);
+}
+
+CarlaRecorderEventAdd ACarlaRecorder::MakeRecorderEventAdd(
     uint32_t DatabaseId,
     uint8_t Type,
     const FTransform &Transform,
-    FActorDescription ActorDescription)
+    const FActorDescription &ActorDescription) const
 {
   CarlaRecorderActorDescription Description;
   Description.UId = ActorDescription.UId;
@@ -688,7 +797,7 @@ void ACarlaRecorder::CreateRecorderEventAdd(
   }
 
   // recorder event
-  CarlaRecorderEventAdd RecEvent
+  return CarlaRecorderEventAdd
   {
     DatabaseId,
     Type,
@@ -696,7 +805,15 @@ void ACarlaRecorder::CreateRecorderEventAdd(
     Transform.GetRotation().Euler(),
     std::move(Description)
   };
-  AddEvent(std::move(RecEvent));
+}
+
+void ACarlaRecorder::CreateRecorderEventAdd(
+    uint32_t DatabaseId,
+    uint8_t Type,
+    const FTransform &Transform,
+    FActorDescription ActorDescription)
+{
+  AddEvent(MakeRecorderEventAdd(DatabaseId, Type, Transform, ActorDescription));
 
   FCarlaActor* CarlaActor = Episode->FindCarlaActor(DatabaseId);
   // Other events related to spawning actors
@@ -727,6 +844,12 @@ void ACarlaRecorder::CreateRecorderEventAdd(
 }
 
 // DReyeVR replayer functions
+void ACarlaRecorder::SetReaderPacketFilter(const carla::recorder::PacketFilter &Filter)
+{
+  Replayer.SetPacketFilter(Filter);
+  Query.SetPacketFilter(Filter);
+}
+
 void ACarlaRecorder::RecPlayPause()
 {
   Replayer.PlayPause();
@@ -26,12 +26,19 @@
 #include "CarlaRecorderEventParent.h"
 #include "CarlaRecorderFrames.h"
 #include "CarlaRecorderInfo.h"
+#include "CarlaRecorderKeyFrame.h"
 #include "CarlaRecorderPosition.h"
 #include "CarlaRecorderQuery.h"
 #include "CarlaRecorderState.h"
 #include "CarlaRecorderWeather.h"
 #include "CarlaReplayer.h"
 
+#include <compiler/disable-ue4-macros.h>
+#include <carla/recorder/BufferedFileWriter.h>
+#include <carla/recorder/FrameIndex.h>
+#include <carla/recorder/RecordingSummary.h>
+#include <compiler/enable-ue4-macros.h>
+
 // DReyeVR includes
 #include "DReyeVRRecorder.h"
 #include "Carla/Sensor/DReyeVRData.h"
@@ -69,6 +76,9 @@ enum class CarlaRecorderPacketId : uint8_t
   TrafficLightTime,
   TriggerVolume,
   Weather,
+  KeyFrame,
+  FrameIndex,
+  Summary,
   // "We suggest to use id over 100 for user custom packets, because this list will keep growing in the future"
   DReyeVR = DREYEVR_PACKET_ID,                        // our custom DReyeVR packet (for raw sensor data)
   DReyeVRCustomActor = DREYEVR_CUSTOM_ACTOR_PACKET_ID // custom DReyeVR actors (not raw sensor data)
@@ -165,6 +175,8 @@ public:
       uint32_t FollowId, bool ReplaySensors);
   void SetReplayerTimeFactor(double TimeFactor);
   void SetReplayerIgnoreHero(bool IgnoreHero);
+  // packets and actors decoded by the replayer and the queries
+  void SetReaderPacketFilter(const carla::recorder::PacketFilter &Filter);
   void StopReplayer(bool KeepActors = false);
 
   void Ticking(float DeltaSeconds);
@@ -185,7 +197,8 @@ private:
 
   uint32_t NextCollisionId = 0;
 
-  // files
+  // files (the stream writes to memory, the writer thread to disk)
+  carla::recorder::BufferedFileWriter Writer;
   std::ofstream File;
 
   UCarlaEpisode *Episode = nullptr;
@@ -213,6 +226,17 @@ private:
   DReyeVRDataRecorders<DReyeVR::AggregateData, DREYEVR_PACKET_ID> DReyeVRAggData;
   DReyeVRDataRecorders<DReyeVR::CustomActorData, DREYEVR_CUSTOM_ACTOR_PACKET_ID> DReyeVRCustomActorData;
 
+  // seconds between key frames
+  static constexpr double KeyFrameInterval = 5.0;
+  CarlaRecorderKeyFrame KeyFrame;
+  double LastKeyFrameTime = 0.0;
+
+  // offsets and times of the frames written, saved at the end of the file
+  carla::recorder::FrameIndex Index;
+
+  // actor lifetimes, collisions and trajectories, saved before the index
+  carla::recorder::RecordingSummaryBuilder Summary;
+
   // replayer
   CarlaReplayer Replayer;
 
@@ -229,4 +253,10 @@ private:
   void AddActorKinematics(FCarlaActor *CarlaActor);
   void AddActorBoundingBox(FCarlaActor *CarlaActor);
   void AddDReyeVRData();
+  void WriteKeyFrame(void);
+  CarlaRecorderEventAdd MakeRecorderEventAdd(
+      uint32_t DatabaseId,
+      uint8_t Type,
+      const FTransform &Transform,
+      const FActorDescription &ActorDescription) const;
 };
@@ -32,6 +32,11 @@ public:
 
   void SetFrame(double DeltaSeconds);
 
+  const CarlaRecorderFrame &GetFrame(void) const
+  {
+    return Frame;
+  }
+
   void WriteStart(std::ofstream &OutFile);
   void WriteEnd(std::ofstream &OutFile);
 
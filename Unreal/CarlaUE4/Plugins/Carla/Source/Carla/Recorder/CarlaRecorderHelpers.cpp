@@ -29,6 +29,65 @@ std::string GetRecorderFilename(std::string Filename)
   return Filename2;
 }
 
+bool IsCompressedRecorderFilename(const std::string &Filename)
+{
+  static const std::string Extension = ".lz4";
+  return Filename.size() > Extension.size() &&
+      Filename.compare(Filename.size() - Extension.size(), Extension.size(), Extension) == 0;
+}
+
+bool OpenRecorderFile(std::ifstream &InFile, carla::recorder::BlockFileReader &Reader, const std::string &Filename)
+{
+  CloseRecorderFile(InFile, Reader);
+
+  // block compressed files are read through the reader, which decompresses
+  // only the blocks touched
+  if (Reader.Open(Filename))
+  {
+    static_cast<std::istream &>(InFile).rdbuf(&Reader);
+    return true;
+  }
+
+  InFile.open(Filename, std::ios::binary);
+  return InFile.is_open();
+}
+
+void CloseRecorderFile(std::ifstream &InFile, carla::recorder::BlockFileReader &Reader)
+{
+  if (Reader.IsOpen())
+  {
+    // back to the stream's own file buffer
+    static_cast<std::istream &>(InFile).rdbuf(InFile.rdbuf());
+    Reader.Close();
+  }
+  InFile.close();
+  InFile.clear();
+}
+
+bool OpenRecorderFile(std::ifstream &InFile, carla::recorder::FramePrefetcher &Prefetcher, const std::string &Filename)
+{
+  CloseRecorderFile(InFile, Prefetcher);
+
+  if (!Prefetcher.Open(Filename))
+  {
+    return false;
+  }
+  static_cast<std::istream &>(InFile).rdbuf(&Prefetcher);
+  return true;
+}
+
+void CloseRecorderFile(std::ifstream &InFile, carla::recorder::FramePrefetcher &Prefetcher)
+{
+  if (Prefetcher.IsOpen())
+  {
+    // back to the stream's own file buffer
+    static_cast<std::istream &>(InFile).rdbuf(InFile.rdbuf());
+    Prefetcher.Close();
+  }
+  InFile.close();
+  InFile.clear();
+}
+
 // ------
 // write
 // ------
@@ -9,9 +9,31 @@
 #include <fstream>
 #include <vector>
 
+#include <compiler/disable-ue4-macros.h>
+#include <carla/recorder/BlockFile.h>
+#include <carla/recorder/FramePrefetcher.h>
+#include <compiler/enable-ue4-macros.h>
+
 // get the final path + filename
 std::string GetRecorderFilename(std::string Filename);
 
+// whether a recording with this name is written block compressed
+bool IsCompressedRecorderFilename(const std::string &Filename);
+
+// open a recorder file for reading, plain or block compressed (reads go
+// through Reader then), returns false if it cannot be opened
+bool OpenRecorderFile(std::ifstream &InFile, carla::recorder::BlockFileReader &Reader, const std::string &Filename);
+
+// close a file opened with OpenRecorderFile
+void CloseRecorderFile(std::ifstream &InFile, carla::recorder::BlockFileReader &Reader);
+
+// open a recorder file for reading through a prefetch thread, which reads
+// (and decompresses) the next frames ahead of the reads from InFile
+bool OpenRecorderFile(std::ifstream &InFile, carla::recorder::FramePrefetcher &Prefetcher, const std::string &Filename);
+
+// close a file opened with OpenRecorderFile
+void CloseRecorderFile(std::ifstream &InFile, carla::recorder::FramePrefetcher &Prefetcher);
+
 // ---------
 // recorder
 // ---------
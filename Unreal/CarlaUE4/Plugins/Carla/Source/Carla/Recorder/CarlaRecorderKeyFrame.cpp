@@ -0,0 +1,118 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#include "CarlaRecorderKeyFrame.h"
+#include "CarlaRecorder.h"
+#include "CarlaRecorderHelpers.h"
+
+void CarlaRecorderKeyFrame::AddActor(const CarlaRecorderEventAdd &Actor)
+{
+  Actors.push_back(Actor);
+}
+
+void CarlaRecorderKeyFrame::AddParent(const CarlaRecorderEventParent &Parent)
+{
+  Parents.push_back(Parent);
+}
+
+void CarlaRecorderKeyFrame::AddLightScene(const CarlaRecorderLightScene &LightScene)
+{
+  LightScenes.push_back(LightScene);
+}
+
+void CarlaRecorderKeyFrame::AddWeather(const CarlaRecorderWeather &Weather)
+{
+  Weathers.push_back(Weather);
+}
+
+void CarlaRecorderKeyFrame::Clear(void)
+{
+  Actors.clear();
+  Parents.clear();
+  LightScenes.clear();
+  Weathers.clear();
+}
+
+void CarlaRecorderKeyFrame::Write(std::ofstream &OutFile)
+{
+  // write the packet id
+  WriteValue<char>(OutFile, static_cast<char>(CarlaRecorderPacketId::KeyFrame));
+
+  std::streampos PosStart = OutFile.tellp();
+
+  // write a dummy packet size
+  uint32_t Total = 0;
+  WriteValue<uint32_t>(OutFile, Total);
+
+  // actors alive
+  WriteValue<uint16_t>(OutFile, Actors.size());
+  for (const auto &Actor : Actors)
+  {
+    Actor.Write(OutFile);
+  }
+
+  // attachments
+  WriteValue<uint16_t>(OutFile, Parents.size());
+  for (const auto &Parent : Parents)
+  {
+    Parent.Write(OutFile);
+  }
+
+  // scene lights
+  WriteValue<uint16_t>(OutFile, LightScenes.size());
+  for (auto &LightScene : LightScenes)
+  {
+    LightScene.Write(OutFile);
+  }
+
+  // weather
+  WriteValue<uint16_t>(OutFile, Weathers.size());
+  for (auto &Weather : Weathers)
+  {
+    Weather.Write(OutFile);
+  }
+
+  // write the real packet size
+  std::streampos PosEnd = OutFile.tellp();
+  Total = PosEnd - PosStart - sizeof(uint32_t);
+  OutFile.seekp(PosStart, std::ios::beg);
+  WriteValue<uint32_t>(OutFile, Total);
+  OutFile.seekp(PosEnd, std::ios::beg);
+}
+
+void CarlaRecorderKeyFrame::Read(std::ifstream &InFile)
+{
+  uint16_t Total;
+  Clear();
+
+  ReadValue<uint16_t>(InFile, Total);
+  Actors.resize(Total);
+  for (auto &Actor : Actors)
+  {
+    Actor.Read(InFile);
+  }
+
+  ReadValue<uint16_t>(InFile, Total);
+  Parents.resize(Total);
+  for (auto &Parent : Parents)
+  {
+    Parent.Read(InFile);
+  }
+
+  ReadValue<uint16_t>(InFile, Total);
+  LightScenes.resize(Total);
+  for (auto &LightScene : LightScenes)
+  {
+    LightScene.Read(InFile);
+  }
+
+  ReadValue<uint16_t>(InFile, Total);
+  Weathers.resize(Total);
+  for (auto &Weather : Weathers)
+  {
+    Weather.Read(InFile);
+  }
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2022 Computer Vision Center (CVC) at the Universitat Autonoma
+// de Barcelona (UAB).
+//
+// This work is licensed under the terms of the MIT license.
+// For a copy, see <https://opensource.org/licenses/MIT>.
+
+#pragma once
+
+#include <fstream>
+#include <vector>
+
+#include "CarlaRecorderEventAdd.h"
+#include "CarlaRecorderEventParent.h"
+#include "CarlaRecorderLightScene.h"
+#include "CarlaRecorderWeather.h"
+
+// whole state of the episode at the start of a frame, so the replayer can
+// start from here without processing the previous frames
+class CarlaRecorderKeyFrame
+{
+
+public:
+
+  void AddActor(const CarlaRecorderEventAdd &Actor);
+
+  void AddParent(const CarlaRecorderEventParent &Parent);
+
+  void AddLightScene(const CarlaRecorderLightScene &LightScene);
+
+  void AddWeather(const CarlaRecorderWeather &Weather);
+
+  void Clear(void);
+
+  void Write(std::ofstream &OutFile);
+
+  void Read(std::ifstream &InFile);
+
+  const std::vector<CarlaRecorderEventAdd> &GetActors(void) const
+  {
+    return Actors;
+  }
+
+  const std::vector<CarlaRecorderEventParent> &GetParents(void) const
+  {
+    return Parents;
+  }
+
+  std::vector<CarlaRecorderLightScene> &GetLightScenes(void)
+  {
+    return LightScenes;
+  }
+
+  std::vector<CarlaRecorderWeather> &GetWeathers(void)
+  {
+    return Weathers;
+  }
+
+private:
+
+  std::vector<CarlaRecorderEventAdd> Actors;
+  std::vector<CarlaRecorderEventParent> Parents;
+  std::vector<CarlaRecorderLightScene> LightScenes;
+  std::vector<CarlaRecorderWeather> Weathers;
+};
@@ -64,8 +64,7 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
   std::string Filename2 = GetRecorderFilename(Filename);
 
   // try to open
-  File.open(Filename2, std::ios::binary);
-  if (!File.is_open())
+  if (!OpenRecorderFile(File, BlockReader, Filename2))
   {
     Info << "File " << Filename2 << " not found on server\n";
     return Info.str();
@@ -93,6 +92,13 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
       break;
     }
 
+    // packets filtered out are not even decoded
+    if (!Filter.IsPacketWanted(Header.Id))
+    {
+      SkipPacket();
+      continue;
+    }
+
     // check for a frame packet
     switch (Header.Id)
     {
@@ -194,11 +200,11 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
             bFramePrinted = true;
           }
           Info << " Positions: " << Total << std::endl;
-          for (i = 0; i < Total; ++i)
+          // only the actors shown are decoded
+          Filter.ForEachWantedRecord<CarlaRecorderPosition>(File, Total, RecordBuffer, [&](const CarlaRecorderPosition &Pos)
           {
-            Position.Read(File);
-            Info << "  Id: " << Position.DatabaseId << " Location: (" << Position.Location.X << ", " << Position.Location.Y << ", " << Position.Location.Z << ") Rotation (" <<  Position.Rotation.X << ", " << Position.Rotation.Y << ", " << Position.Rotation.Z << ")" << std::endl;
-          }
+            Info << "  Id: " << Pos.DatabaseId << " Location: (" << Pos.Location.X << ", " << Pos.Location.Y << ", " << Pos.Location.Z << ") Rotation (" <<  Pos.Rotation.X << ", " << Pos.Rotation.Y << ", " << Pos.Rotation.Z << ")" << std::endl;
+          });
         }
         else
           SkipPacket();
@@ -618,11 +624,19 @@ std::string CarlaRecorderQuery::QueryInfo(std::string Filename, bool bShowAll)
   Info << "\nFrames: " << Frame.Id << "\n";
   Info << "Duration: " << Frame.Elapsed << " seconds\n";
 
-  File.close();
+  CloseRecorderFile(File, BlockReader);
 
   return Info.str();
 }
 
+bool CarlaRecorderQuery::ReadSummary(const std::string &Filename, carla::recorder::RecordingSummary &Summary)
+{
+  // recordings written before the summary existed are scanned in parallel
+  const bool bRead = Summary.Read(File) || carla::recorder::ScanRecordingSummary(Filename, Summary);
+  CloseRecorderFile(File, BlockReader);
+  return bRead;
+}
+
 std::string CarlaRecorderQuery::QueryCollisions(std::string Filename, char Category1, char Category2)
 {
   std::stringstream Info;
@@ -631,8 +645,7 @@ std::string CarlaRecorderQuery::QueryCollisions(std::string Filename, char Categ
   std::string Filename2 = GetRecorderFilename(Filename);
 
   // try to open
-  File.open(Filename2, std::ios::binary);
-  if (!File.is_open())
+  if (!OpenRecorderFile(File, BlockReader, Filename2))
   {
     Info << "File " << Filename2 << " not found on server\n";
     return Info.str();
@@ -641,26 +654,15 @@ std::string CarlaRecorderQuery::QueryCollisions(std::string Filename, char Categ
   if (!CheckFileInfo(Info))
     return Info.str();
 
+  carla::recorder::RecordingSummary Summary;
+  if (!ReadSummary(Filename2, Summary))
+  {
+    Info << "File " << Filename2 << " could not be read\n";
+    return Info.str();
+  }
+
   // other, vehicle, walkers, trafficLight, hero, any
   char Categories[] = { 'o', 'v', 'w', 't', 'h', 'a' };
-  uint16_t i, Total;
-  struct ReplayerActorInfo
-  {
-    uint8_t Type;
-    FString Id;
-  };
-  std::unordered_map<uint32_t, ReplayerActorInfo> Actors;
-  struct PairHash
-  {
-    std::size_t operator()(const std::pair<uint32_t, uint32_t>& P) const
-    {
-        std::size_t hash = P.first;
-        hash <<= 32;
-        hash += P.second;
-        return hash;
-    }
-  };
-  std::unordered_set<std::pair<uint32_t, uint32_t>, PairHash > oldCollisions, newCollisions;
 
   // header
   Info << std::setw(8) << "Time";
@@ -671,134 +673,56 @@ std::string CarlaRecorderQuery::QueryCollisions(std::string Filename, char Categ
   Info << " " << std::setw(35) << std::left << "Actor 2";
   Info << std::endl;
 
-  // parse only frames
-  while (File)
+  // the summary only has the first frame of each collision
+  for (const auto &Collision : Summary.GetCollisions())
   {
-
-    // get header
-    if (!ReadHeader())
+    int Valid = 0;
+
+    // get categories for both actors
+    const auto *Actor1 = Summary.FindActor(Collision.actor1, Collision.elapsed);
+    const auto *Actor2 = Summary.FindActor(Collision.actor2, Collision.elapsed);
+    uint8_t Type1, Type2;
+    if (Collision.actor1 != uint32_t(-1))
+      Type1 = Categories[Actor1 != nullptr ? Actor1->type : 0];
+    else
+      Type1 = 'o'; // other non-actor object
+
+    if (Collision.actor2 != uint32_t(-1))
+      Type2 = Categories[Actor2 != nullptr ? Actor2->type : 0];
+    else
+      Type2 = 'o'; // other non-actor object
+
+    // filter actor 1
+    if (Category1 == 'a')
+      ++Valid;
+    else if (Category1 == Type1)
+      ++Valid;
+    else if (Category1 == 'h' && Collision.is_actor1_hero)
+      ++Valid;
+
+    // filter actor 2
+    if (Category2 == 'a')
+      ++Valid;
+    else if (Category2 == Type2)
+      ++Valid;
+    else if (Category2 == 'h' && Collision.is_actor2_hero)
+      ++Valid;
+
+    // only show if both actors has passed the filter
+    if (Valid == 2)
     {
-      break;
-    }
-
-    // check for a frame packet
-    switch (Header.Id)
-    {
-      // frame
-      case static_cast<char>(CarlaRecorderPacketId::FrameStart):
-        Frame.Read(File);
-        // exchange sets of collisions (to know when a collision is new or continue from previous frame)
-        oldCollisions = std::move(newCollisions);
-        newCollisions.clear();
-        break;
-
-      // events add
-      case static_cast<char>(CarlaRecorderPacketId::EventAdd):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
-        {
-          // add
-          EventAdd.Read(File);
-          Actors[EventAdd.DatabaseId] = ReplayerActorInfo { EventAdd.Type, EventAdd.Description.Id };
-        }
-        break;
-
-      // events del
-      case static_cast<char>(CarlaRecorderPacketId::EventDel):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
-        {
-          EventDel.Read(File);
-          Actors.erase(EventAdd.DatabaseId);
-        }
-        break;
-
-      // events parenting
-      case static_cast<char>(CarlaRecorderPacketId::EventParent):
-        SkipPacket();
-        break;
-
-      // collisions
-      case static_cast<char>(CarlaRecorderPacketId::Collision):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
-        {
-          Collision.Read(File);
-
-          int Valid = 0;
-
-          // get categories for both actors
-          uint8_t Type1, Type2;
-          if (Collision.DatabaseId1 != uint32_t(-1))
-            Type1 = Categories[Actors[Collision.DatabaseId1].Type];
-          else
-            Type1 = 'o'; // other non-actor object
-          
-          if (Collision.DatabaseId2 != uint32_t(-1))
-            Type2 = Categories[Actors[Collision.DatabaseId2].Type];
-          else
-            Type2 = 'o'; // other non-actor object
-
-          // filter actor 1
-          if (Category1 == 'a')
-            ++Valid;
-          else if (Category1 == Type1)
-            ++Valid;
-          else if (Category1 == 'h' && Collision.IsActor1Hero)
-            ++Valid;
-
-          // filter actor 2
-          if (Category2 == 'a')
-            ++Valid;
-          else if (Category2 == Type2)
-            ++Valid;
-          else if (Category2 == 'h' && Collision.IsActor2Hero)
-            ++Valid;
-
-          // only show if both actors has passed the filter
-          if (Valid == 2)
-          {
-            // check if we need to show as a starting collision or it is a continuation one
-            auto collisionPair = std::make_pair(Collision.DatabaseId1, Collision.DatabaseId2);
-            if (oldCollisions.count(collisionPair) == 0)
-            {
-              Info << std::setw(8) << std::setprecision(0) << std::right << std::fixed << Frame.Elapsed;
-              Info << " " << "  " << Type1 << " " << Type2 << " ";
-              Info << " " << std::setw(6) << std::right << Collision.DatabaseId1;
-              Info << " " << std::setw(35) << std::left << TCHAR_TO_UTF8(*Actors[Collision.DatabaseId1].Id);
-              Info << " " << std::setw(6) << std::right << Collision.DatabaseId2;
-              Info << " " << std::setw(35) << std::left << TCHAR_TO_UTF8(*Actors[Collision.DatabaseId2].Id);
-              Info << std::endl;
-            }
-            // save current collision
-            newCollisions.insert(collisionPair);
-          }
-        }
-        break;
-
-      case static_cast<char>(CarlaRecorderPacketId::Position):
-        SkipPacket();
-        break;
-
-      case static_cast<char>(CarlaRecorderPacketId::State):
-        SkipPacket();
-        break;
-
-      // frame end
-      case static_cast<char>(CarlaRecorderPacketId::FrameEnd):
-        // do nothing, it is empty
-        break;
-
-      default:
-        SkipPacket();
-        break;
+      Info << std::setw(8) << std::setprecision(0) << std::right << std::fixed << Collision.elapsed;
+      Info << " " << "  " << Type1 << " " << Type2 << " ";
+      Info << " " << std::setw(6) << std::right << Collision.actor1;
+      Info << " " << std::setw(35) << std::left << (Actor1 != nullptr ? Actor1->description : "");
+      Info << " " << std::setw(6) << std::right << Collision.actor2;
+      Info << " " << std::setw(35) << std::left << (Actor2 != nullptr ? Actor2->description : "");
+      Info << std::endl;
     }
   }
 
-  Info << "\nFrames: " << Frame.Id << "\n";
-  Info << "Duration: " << Frame.Elapsed << " seconds\n";
-
-  File.close();
+  Info << "\nFrames: " << Summary.GetLastFrame() << "\n";
+  Info << "Duration: " << Summary.GetDuration() << " seconds\n";
 
   return Info.str();
 }
@@ -811,8 +735,7 @@ std::string CarlaRecorderQuery::QueryBlocked(std::string Filename, double MinTim
   std::string Filename2 = GetRecorderFilename(Filename);
 
   // try to open
-  File.open(Filename2, std::ios::binary);
-  if (!File.is_open())
+  if (!OpenRecorderFile(File, BlockReader, Filename2))
   {
     Info << "File " << Filename2 << " not found on server\n";
     return Info.str();
@@ -821,19 +744,12 @@ std::string CarlaRecorderQuery::QueryBlocked(std::string Filename, double MinTim
   if (!CheckFileInfo(Info))
     return Info.str();
 
-  // other, vehicle, walkers, trafficLight, hero, any
-  uint16_t i, Total;
-  struct ReplayerActorInfo
+  carla::recorder::RecordingSummary Summary;
+  if (!ReadSummary(Filename2, Summary))
   {
-    uint8_t Type;
-    FString Id;
-    FVector LastPosition;
-    double Time;
-    double Duration;
-  };
-  std::unordered_map<uint32_t, ReplayerActorInfo> Actors;
-  // to be able to sort the results by the duration of each actor (decreasing order)
-  std::multimap<double, std::string, std::greater<double>> Results;
+    Info << "File " << Filename2 << " could not be read\n";
+    return Info.str();
+  }
 
   // header
   Info << std::setw(8) << "Time";
@@ -842,132 +758,20 @@ std::string CarlaRecorderQuery::QueryBlocked(std::string Filename, double MinTim
   Info << " " << std::setw(10) << std::right << "Duration";
   Info << std::endl;
 
-  // parse only frames
-  while (File)
-  {
-
-    // get header
-    if (!ReadHeader())
-    {
-      break;
-    }
-
-    // check for a frame packet
-    switch (Header.Id)
-    {
-      // frame
-      case static_cast<char>(CarlaRecorderPacketId::FrameStart):
-        Frame.Read(File);
-        break;
-
-      // events add
-      case static_cast<char>(CarlaRecorderPacketId::EventAdd):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
-        {
-          // add
-          EventAdd.Read(File);
-          Actors[EventAdd.DatabaseId] = ReplayerActorInfo { EventAdd.Type, EventAdd.Description.Id, FVector(0, 0, 0), 0.0, 0.0 };
-        }
-        break;
-
-      // events del
-      case static_cast<char>(CarlaRecorderPacketId::EventDel):
-        ReadValue<uint16_t>(File, Total);
-        for (i = 0; i < Total; ++i)
-        {
-          EventDel.Read(File);
-          Actors.erase(EventAdd.DatabaseId);
-        }
-        break;
-
-      // events parenting
-      case static_cast<char>(CarlaRecorderPacketId::EventParent):
-        SkipPacket();
-        break;
-
-      // collisions
-      case static_cast<char>(CarlaRecorderPacketId::Collision):
-        SkipPacket();
-        break;
-
-      // positions
-      case static_cast<char>(CarlaRecorderPacketId::Position):
-        // read all positions
-        ReadValue<uint16_t>(File, Total);
-        for (i=0; i<Total; ++i)
-        {
-          Position.Read(File);
-          // check if actor moved less than a distance
-          if (FVector::Distance(Actors[Position.DatabaseId].LastPosition, Position.Location) < MinDistance)
-          {
-            // actor stopped
-            if (Actors[Position.DatabaseId].Duration == 0)
-              Actors[Position.DatabaseId].Time = Frame.Elapsed;
-            Actors[Position.DatabaseId].Duration += Frame.DurationThis;
-          }
-          else
-          {
-            // check to show info
-            if (Actors[Position.DatabaseId].Duration >= MinTime)
-            {
-              std::stringstream Result;
-              Result << std::setw(8) << std::setprecision(0) << std::fixed << Actors[Position.DatabaseId].Time;
-              Result << " " << std::setw(6) << Position.DatabaseId;
-              Result << " " << std::setw(35) << std::left << TCHAR_TO_UTF8(*Actors[Position.DatabaseId].Id);
-              Result << " " << std::setw(10) << std::setprecision(0) << std::fixed << std::right << Actors[Position.DatabaseId].Duration;
-              Result << std::endl;
-              Results.insert(std::make_pair(Actors[Position.DatabaseId].Duration, Result.str()));
-            }
-            // actor moving
-            Actors[Position.DatabaseId].Duration = 0;
-            Actors[Position.DatabaseId].LastPosition = Position.Location;
-          }
-        }
-        break;
-
-      // traffic light
-      case static_cast<char>(CarlaRecorderPacketId::State):
-        SkipPacket();
-        break;
-
-      // frame end
-      case static_cast<char>(CarlaRecorderPacketId::FrameEnd):
-        // do nothing, it is empty
-        break;
-
-      default:
-        SkipPacket();
-        break;
-    }
-  }
-
-  // show actors stopped that were not moving again
-  for (auto &Actor : Actors)
+  // already sorted by the duration of each actor (decreasing order), from the
+  // coarse trajectories in the summary
+  for (const auto &Blocked : Summary.FindBlocked(MinTime, MinDistance))
   {
-    // check to show info
-    if (Actor.second.Duration >= MinTime)
-    {
-      std::stringstream Result;
-      Result << std::setw(8) << std::setprecision(0) << std::fixed << Actor.second.Time;
-      Result << " " << std::setw(6) << Actor.first;
-      Result << " " << std::setw(35) << std::left << TCHAR_TO_UTF8(*Actor.second.Id);
-      Result << " " << std::setw(10) << std::setprecision(0) << std::fixed << std::right << Actor.second.Duration;
-      Result << std::endl;
-      Results.insert(std::make_pair(Actor.second.Duration, Result.str()));
-    }
+    const auto *Actor = Summary.FindActor(Blocked.id, Blocked.begin);
+    Info << std::setw(8) << std::setprecision(0) << std::fixed << Blocked.begin;
+    Info << " " << std::setw(6) << Blocked.id;
+    Info << " " << std::setw(35) << std::left << (Actor != nullptr ? Actor->description : "");
+    Info << " " << std::setw(10) << std::setprecision(0) << std::fixed << std::right << Blocked.duration;
+    Info << std::endl;
   }
 
-  // show the result
-  for (auto &Result : Results)
-  {
-    Info << Result.second;
-  }
-
-  Info << "\nFrames: " << Frame.Id << "\n";
-  Info << "Duration: " << Frame.Elapsed << " seconds\n";
-
-  File.close();
+  Info << "\nFrames: " << Summary.GetLastFrame() << "\n";
+  Info << "Duration: " << Summary.GetDuration() << " seconds\n";
 
   return Info.str();
 }
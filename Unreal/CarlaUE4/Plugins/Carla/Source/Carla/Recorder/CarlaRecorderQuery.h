@@ -17,6 +17,7 @@
 #include "CarlaRecorderLightVehicle.h"
 #include "CarlaRecorderAnimWalker.h"
 #include "CarlaRecorderCollision.h"
+#include "CarlaRecorderHelpers.h"
 #include "CarlaRecorderEventAdd.h"
 #include "CarlaRecorderEventDel.h"
 #include "CarlaRecorderEventParent.h"
@@ -27,6 +28,11 @@
 #include "CarlaRecorderWeather.h"
 #include "DReyeVRRecorder.h"
 
+#include <compiler/disable-ue4-macros.h>
+#include <carla/recorder/PacketFilter.h>
+#include <carla/recorder/RecordingSummary.h>
+#include <compiler/enable-ue4-macros.h>
+
 class CarlaRecorderQuery
 {
 
@@ -47,9 +53,16 @@ public:
   // get info about blocked actors
   std::string QueryBlocked(std::string Filename, double MinTime = 30, double MinDistance = 10);
 
+  // packets and actors shown by QueryInfo, the rest of the file is skipped
+  void SetPacketFilter(const carla::recorder::PacketFilter &InFilter)
+  {
+    Filter = InFilter;
+  }
+
 private:
 
   std::ifstream File;
+  carla::recorder::BlockFileReader BlockReader;
   Header Header;
   CarlaRecorderInfo RecInfo;
   CarlaRecorderFrame Frame;
@@ -72,6 +85,10 @@ private:
   // custom DReyeVR packets
   DReyeVRDataRecorder<DReyeVR::AggregateData> DReyeVRAggDataInstance;
   DReyeVRDataRecorder<DReyeVR::CustomActorData> DReyeVRCustomActorDataInstance;
+  // packets and actors shown
+  carla::recorder::PacketFilter Filter;
+  // per-actor records read at once
+  std::vector<char> RecordBuffer;
 
   // read next header packet
   bool ReadHeader(void);
@@ -81,4 +98,8 @@ private:
 
   // read the start info structure and check the magic string
   bool CheckFileInfo(std::stringstream &Info);
+
+  // load the summary of the open file, building it if the file has none,
+  // and close the file
+  bool ReadSummary(const std::string &Filename, carla::recorder::RecordingSummary &Summary);
 };
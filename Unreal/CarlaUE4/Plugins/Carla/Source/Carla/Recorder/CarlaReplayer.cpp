@@ -12,12 +12,20 @@
 #include "Carla/Actor/DReyeVRCustomActor.h" // ADReyeVRCustomActor::ActiveCustomActors
 #include "Carla/Sensor/DReyeVRSensor.h"     // ADReyeVRSensor
 
+#include <cmath>
+#include <cstring>
 #include <ctime>
 #include <sstream>
 
 // structure to save replaying info when need to load a new map (static member by now)
 CarlaReplayer::PlayAfterLoadMap CarlaReplayer::Autoplay { false, "", "", 0.0, 0.0, 0, 1.0, false };
 
+// fastest playback, either direction
+static constexpr double MaxTimeFactor = 64.0;
+
+// above this playback jumps between key frames instead of reading every frame
+static constexpr double MaxSequentialTimeFactor = 4.0;
+
 void CarlaReplayer::Stop(bool bKeepActors)
 {
   if (Enabled)
@@ -34,7 +42,12 @@ void CarlaReplayer::Stop(bool bKeepActors)
     Helper.ProcessReplayerFinish(bKeepActors, IgnoreHero, IsHeroMap);
   }
 
-  File.close();
+  if (Prefetcher.IsOpen())
+  {
+    UE_LOG(LogCarla, Log, TEXT("Replayer read %llu frames ahead, waited %llu us for them, %llu seeks restarted the prefetching"),
+        Prefetcher.GetFramesRead(), Prefetcher.GetWaitMicroseconds(), Prefetcher.GetRestarts());
+  }
+  CloseRecorderFile(File, Prefetcher);
 }
 
 bool CarlaReplayer::ReadHeader()
@@ -71,13 +84,162 @@ void CarlaReplayer::Rewind(void)
   MappedId.clear();
   IsHeroMap.clear();
 
+  // frames of another recording
+  Window.Clear();
+  WindowFrame = FrameWindow::Frame{};
+
   // read geneal Info
   RecInfo.Read(File);
+
+  ReadIndex();
+}
+
+bool CarlaReplayer::ReadIndex(void)
+{
+  std::streampos Current = File.tellg();
+  const bool bFound = Index.Read(File);
+  File.clear();
+  File.seekg(Current, std::ios::beg);
+  return bFound;
+}
+
+bool CarlaReplayer::SeekToTime(double Time)
+{
+  const size_t KeyFrameIndex = Index.FindKeyFrame(Time);
+  if (KeyFrameIndex >= Index.size())
+  {
+    return false;
+  }
+  const double KeyFrameTime = Index[KeyFrameIndex].elapsed;
+
+  File.clear();
+  File.seekg(static_cast<std::streamoff>(Index[KeyFrameIndex].offset), std::ios::beg);
+
+  // mark as header as invalid to force reload a new one next time
+  Frame.Elapsed = -1.0f;
+  Frame.DurationThis = 0.0f;
+  CurrentTime = KeyFrameTime;
+  PrevPos.clear();
+  CurrPos.clear();
+
+  // the key frame restores the actors, then process until the time
+  bPendingKeyFrame = true;
+  ProcessToTime(Time - KeyFrameTime, true);
+  bPendingKeyFrame = false;
+  return true;
+}
+
+bool CarlaReplayer::SeekForwardToTime(double Time)
+{
+  // jump to the last key frame before the target when it is ahead of us
+  const size_t KeyFrameIndex = Index.FindKeyFrame(Time);
+  return KeyFrameIndex < Index.size() && Index[KeyFrameIndex].elapsed > CurrentTime && SeekToTime(Time);
+}
+
+bool CarlaReplayer::ProcessFromWindow(double Time, double DeltaTime)
+{
+  if (!Window.CanPlay(CurrentTime, Time))
+  {
+    return false;
+  }
+  const FrameWindow::Frame *Current = Window.Find(Time);
+  const FrameWindow::Frame *Previous = Window.GetPrevious(*Current);
+  const double Per = (Time - Current->elapsed) / Current->duration;
+
+  // interpolate between the frame and the one before, as when reading forward
+  MapPositions(Current->items, CurrPos);
+  if (Previous != nullptr)
+  {
+    MapPositions(Previous->items, PrevPos);
+  }
+  else
+  {
+    PrevPos.clear();
+  }
+  ProcessWindowPackets(Current->packets, Per, DeltaTime);
+  if (Enabled)
+  {
+    UpdatePositions(Per, DeltaTime);
+  }
+  CurrentTime = Time;
+  return true;
+}
+
+void CarlaReplayer::CapturePacket(void)
+{
+  if (Window.GetMaxBytes() == 0u)
+  {
+    return;
+  }
+  // copy the packet with its header and go back to its content
+  auto &Packets = WindowFrame.packets;
+  const size_t Begin = Packets.size();
+  Packets.resize(Begin + sizeof(Header) + Header.Size);
+  std::memcpy(Packets.data() + Begin, &Header, sizeof(Header));
+  File.read(Packets.data() + Begin + sizeof(Header), Header.Size);
+  File.seekg(-static_cast<std::streamoff>(Header.Size), std::ios::cur);
+}
+
+void CarlaReplayer::ProcessWindowPackets(const std::vector<char> &Packets, double Per, double DeltaTime)
+{
+  // read the packets from memory through File, as they were read from disk
+  struct MemoryBuffer : public std::streambuf
+  {
+    explicit MemoryBuffer(const std::vector<char> &Data)
+    {
+      char *Begin = const_cast<char *>(Data.data());
+      setg(Begin, Begin, Begin + Data.size());
+    }
+  };
+  MemoryBuffer Buffer(Packets);
+  const std::ios::iostate State = File.rdstate();
+  std::streambuf *Previous = static_cast<std::istream &>(File).rdbuf(&Buffer);
+
+  bool bKnownPacket = true;
+  while (bKnownPacket && Buffer.in_avail() >= static_cast<std::streamsize>(sizeof(Header)) && ReadHeader())
+  {
+    switch (Header.Id)
+    {
+      case static_cast<char>(CarlaRecorderPacketId::State):
+        ProcessStates();
+        break;
+      case static_cast<char>(CarlaRecorderPacketId::AnimVehicle):
+        ProcessAnimVehicle();
+        break;
+      case static_cast<char>(CarlaRecorderPacketId::AnimWalker):
+        ProcessAnimWalker();
+        break;
+      case static_cast<char>(CarlaRecorderPacketId::VehicleLight):
+        ProcessLightVehicle();
+        break;
+      case static_cast<char>(CarlaRecorderPacketId::SceneLight):
+        ProcessLightScene();
+        break;
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVR):
+        ProcessDReyeVRData<DReyeVRDataRecorder<DReyeVR::AggregateData>>(Per, DeltaTime, true);
+        break;
+      case static_cast<char>(CarlaRecorderPacketId::DReyeVRCustomActor):
+        ProcessDReyeVRData<DReyeVRDataRecorder<DReyeVR::CustomActorData>>(Per, DeltaTime, false);
+        break;
+      default:
+        // only the packets above are kept
+        bKnownPacket = false;
+        break;
+    }
+  }
+
+  static_cast<std::istream &>(File).rdbuf(Previous);
+  File.clear(State);
 }
 
 // read last frame in File and return the Total time recorded
 double CarlaReplayer::GetTotalTime(void)
 {
+  if (!Index.empty())
+  {
+    return Index.back().elapsed;
+  }
+
   std::streampos Current = File.tellg();
 
   // parse only frames
@@ -109,6 +271,16 @@ double CarlaReplayer::GetTotalTime(void)
 // Read all the frames and collect their start times
 void CarlaReplayer::GetFrameStartTimes()
 {
+  if (!Index.empty())
+  {
+    FrameStartTimes.reserve(Index.size());
+    for (size_t i = 0; i < Index.size(); ++i)
+    {
+      FrameStartTimes.push_back(Index[i].elapsed);
+    }
+    return;
+  }
+
   std::streampos Current = File.tellg();
 
   while (File)
@@ -158,8 +330,7 @@ std::string CarlaReplayer::ReplayFile(std::string Filename, double TimeStart, do
   Info << "Replaying File: " << Filename2 << std::endl;
 
   // try to open
-  File.open(Filename2, std::ios::binary);
-  if (!File.is_open())
+  if (!OpenRecorderFile(File, Prefetcher, Filename2))
   {
     Info << "File " << Filename2 << " not found on server\n";
     Stop();
@@ -221,8 +392,11 @@ std::string CarlaReplayer::ReplayFile(std::string Filename, double TimeStart, do
   if (!Autoplay.Enabled)
   {
     Helper.RemoveStaticProps();
-    // process all events until the time
-    ProcessToTime(TimeStart, true);
+    // process all events until the time (or jump near it if we can)
+    if (TimeStart <= 0.0 || !SeekToTime(TimeStart))
+    {
+      ProcessToTime(TimeStart, true);
+    }
     // mark as enabled
     Enabled = true;
   }
@@ -247,8 +421,7 @@ void CarlaReplayer::CheckPlayAfterMapLoaded(void)
   }
 
   // try to open
-  File.open(Autoplay.Filename, std::ios::binary);
-  if (!File.is_open())
+  if (!OpenRecorderFile(File, Prefetcher, Autoplay.Filename))
   {
     return;
   }
@@ -284,8 +457,11 @@ void CarlaReplayer::CheckPlayAfterMapLoaded(void)
 
   Helper.RemoveStaticProps();
 
-  // process all events until the time
-  ProcessToTime(TimeStart, true);
+  // process all events until the time (or jump near it if we can)
+  if (TimeStart <= 0.0 || !SeekToTime(TimeStart))
+  {
+    ProcessToTime(TimeStart, true);
+  }
 
   // mark as enabled
   Enabled = true;
@@ -306,6 +482,15 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
     bFrameFound = true;
     bExitLoop = true;
   }
+  // behind the last frame read (played backwards), use the frames already
+  // read or go back to the key frame before
+  else if (NewTime < Frame.Elapsed)
+  {
+    if (ProcessFromWindow(NewTime, std::abs(Time)) || SeekToTime(NewTime))
+    {
+      return;
+    }
+  }
 
   // process all frames until time we want or end
   while (!File.eof() && !bExitLoop)
@@ -313,6 +498,13 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
     // get header
     ReadHeader();
 
+    // packets filtered out are not even decoded
+    if (!Filter.IsPacketWanted(Header.Id))
+    {
+      SkipPacket();
+      continue;
+    }
+
     // check for a frame packet
     switch (Header.Id)
     {
@@ -320,6 +512,11 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
       case static_cast<char>(CarlaRecorderPacketId::FrameStart):
         // only read if we are not in the right frame
         Frame.Read(File);
+        WindowFrame.elapsed = Frame.Elapsed;
+        WindowFrame.duration = Frame.DurationThis;
+        WindowFrame.has_events = false;
+        WindowFrame.items.clear();
+        WindowFrame.packets.clear();
         // check if target time is in this frame
         if (NewTime < Frame.Elapsed + Frame.DurationThis)
         {
@@ -330,16 +527,19 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
 
       // events add
       case static_cast<char>(CarlaRecorderPacketId::EventAdd):
+        WindowFrame.has_events = true;
         ProcessEventsAdd();
         break;
 
       // events del
       case static_cast<char>(CarlaRecorderPacketId::EventDel):
+        WindowFrame.has_events = true;
         ProcessEventsDel();
         break;
 
       // events parent
       case static_cast<char>(CarlaRecorderPacketId::EventParent):
+        WindowFrame.has_events = true;
         ProcessEventsParent();
         break;
 
@@ -352,12 +552,15 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
       case static_cast<char>(CarlaRecorderPacketId::Position):
         if (bFrameFound)
           ProcessPositions(IsFirstTime);
+        else if (Window.GetMaxBytes() > 0u)
+          ReadPositions(WindowFrame.items);
         else
           SkipPacket();
         break;
 
       // states
       case static_cast<char>(CarlaRecorderPacketId::State):
+        CapturePacket();
         if (bFrameFound)
           ProcessStates();
         else
@@ -366,6 +569,7 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
 
       // vehicle animation
       case static_cast<char>(CarlaRecorderPacketId::AnimVehicle):
+        CapturePacket();
         if (bFrameFound)
           ProcessAnimVehicle();
         else
@@ -374,6 +578,7 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
 
       // walker animation
       case static_cast<char>(CarlaRecorderPacketId::AnimWalker):
+        CapturePacket();
         if (bFrameFound)
           ProcessAnimWalker();
         else
@@ -382,6 +587,7 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
 
       // vehicle light animation
       case static_cast<char>(CarlaRecorderPacketId::VehicleLight):
+        CapturePacket();
         if (bFrameFound)
           ProcessLightVehicle();
         else
@@ -390,6 +596,7 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
 
       // scene lights animation
       case static_cast<char>(CarlaRecorderPacketId::SceneLight):
+        CapturePacket();
         if (bFrameFound)
           ProcessLightScene();
         else
@@ -398,11 +605,24 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
 
       // weather state
       case static_cast<char>(CarlaRecorderPacketId::Weather):
+        WindowFrame.has_events = true;
         ProcessWeather();
         break;
 
+      // whole state, only needed when jumping to this frame
+      case static_cast<char>(CarlaRecorderPacketId::KeyFrame):
+        if (bPendingKeyFrame)
+        {
+          ProcessKeyFrame();
+          bPendingKeyFrame = false;
+        }
+        else
+          SkipPacket();
+        break;
+
       // DReyeVR eye logging data
       case static_cast<char>(CarlaRecorderPacketId::DReyeVR):
+        CapturePacket();
         if (bFrameFound)
           ProcessDReyeVRData<DReyeVRDataRecorder<DReyeVR::AggregateData>>(Per, Time, true);
         else
@@ -411,6 +631,7 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
 
       // DReyeVR eye logging data
       case static_cast<char>(CarlaRecorderPacketId::DReyeVRCustomActor):
+        CapturePacket();
         if (bFrameFound)
           ProcessDReyeVRData<DReyeVRDataRecorder<DReyeVR::CustomActorData>>(Per, Time, false);
         else
@@ -419,6 +640,11 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
 
       // frame end
       case static_cast<char>(CarlaRecorderPacketId::FrameEnd):
+        if (Window.GetMaxBytes() > 0u && WindowFrame.duration > 0.0)
+        {
+          Window.Add(std::move(WindowFrame));
+          WindowFrame = FrameWindow::Frame{};
+        }
         if (bFrameFound)
           bExitLoop = true;
         break;
@@ -435,7 +661,7 @@ void CarlaReplayer::ProcessToTime(double Time, bool IsFirstTime)
   // update all positions
   if (Enabled && bFrameFound)
   {
-    UpdatePositions(Per, Time);
+    UpdatePositions(Per, std::abs(Time));
   }
 
   // save current time
@@ -459,49 +685,66 @@ void CarlaReplayer::ProcessEventsAdd(void)
   for (i = 0; i < Total; ++i)
   {
     EventAdd.Read(File);
+    ProcessEventAdd(EventAdd);
+  }
+}
 
-    // auto Result = CallbackEventAdd(
-    auto Result = Helper.ProcessReplayerEventAdd(
-        EventAdd.Location,
-        EventAdd.Rotation,
-        EventAdd.Description,
-        EventAdd.DatabaseId,
-        IgnoreHero,
-        bReplaySensors);
+void CarlaReplayer::ProcessEventAdd(const CarlaRecorderEventAdd &EventAdd)
+{
+  // actors filtered out are not spawned
+  if (!Filter.IsActorWanted(EventAdd.DatabaseId))
+  {
+    return;
+  }
 
-    switch (Result.first)
-    {
-      // actor not created
-      case 0:
-        UE_LOG(LogCarla, Log, TEXT("actor could not be created"));
-        break;
+  // already spawned (i.e. by a key frame)
+  auto Mapped = MappedId.find(EventAdd.DatabaseId);
+  if (Mapped != MappedId.end() && Episode->FindCarlaActor(Mapped->second) != nullptr)
+  {
+    return;
+  }
 
-      // actor created but with different id
-      case 1:
-        // mapping id (recorded Id is a new Id in replayer)
-        MappedId[EventAdd.DatabaseId] = Result.second;
-        break;
+  // auto Result = CallbackEventAdd(
+  auto Result = Helper.ProcessReplayerEventAdd(
+      EventAdd.Location,
+      EventAdd.Rotation,
+      EventAdd.Description,
+      EventAdd.DatabaseId,
+      IgnoreHero,
+      bReplaySensors);
 
-      // actor reused from existing
-      case 2:
-        // mapping id (say desired Id is mapped to what)
-        MappedId[EventAdd.DatabaseId] = Result.second;
-        break;
-    }
+  switch (Result.first)
+  {
+    // actor not created
+    case 0:
+      UE_LOG(LogCarla, Log, TEXT("actor could not be created"));
+      break;
 
-    // check to mark if actor is a hero vehicle or not
-    if (Result.first > 0)
+    // actor created but with different id
+    case 1:
+      // mapping id (recorded Id is a new Id in replayer)
+      MappedId[EventAdd.DatabaseId] = Result.second;
+      break;
+
+    // actor reused from existing
+    case 2:
+      // mapping id (say desired Id is mapped to what)
+      MappedId[EventAdd.DatabaseId] = Result.second;
+      break;
+  }
+
+  // check to mark if actor is a hero vehicle or not
+  if (Result.first > 0)
+  {
+    // init
+    IsHeroMap[Result.second] = false;
+    for (const auto &Item : EventAdd.Description.Attributes)
     {
-      // init
-      IsHeroMap[Result.second] = false;
-      for (const auto &Item : EventAdd.Description.Attributes)
+      if (Item.Id == "role_name" && Item.Value == "hero")
       {
-        if (Item.Id == "role_name" && Item.Value == "hero")
-        {
-          // mark as hero
-          IsHeroMap[Result.second] = true;
-          break;
-        }
+        // mark as hero
+        IsHeroMap[Result.second] = true;
+        break;
       }
     }
   }
@@ -517,8 +760,14 @@ void CarlaReplayer::ProcessEventsDel(void)
   for (i = 0; i < Total; ++i)
   {
     EventDel.Read(File);
-    Helper.ProcessReplayerEventDel(MappedId[EventDel.DatabaseId]);
-    MappedId.erase(EventDel.DatabaseId);
+    // not spawned (i.e. jumped over its creation)
+    auto Mapped = MappedId.find(EventDel.DatabaseId);
+    if (Mapped == MappedId.end())
+    {
+      continue;
+    }
+    Helper.ProcessReplayerEventDel(Mapped->second);
+    MappedId.erase(Mapped);
   }
 }
 
@@ -562,61 +811,56 @@ void CarlaReplayer::ProcessStates(void)
 
 void CarlaReplayer::ProcessAnimVehicle(void)
 {
-  uint16_t i, Total;
-  CarlaRecorderAnimVehicle Vehicle;
-  std::stringstream Info;
+  static_assert(sizeof(CarlaRecorderAnimVehicle) == 21u, "Animations are read as recorded.");
+  uint16_t Total;
 
-  // read Total Vehicles
+  // read Total Vehicles, decoding only the actors replayed
   ReadValue<uint16_t>(File, Total);
-  for (i = 0; i < Total; ++i)
+  Filter.ForEachWantedRecord<CarlaRecorderAnimVehicle>(File, Total, RecordBuffer, [&](CarlaRecorderAnimVehicle Vehicle)
   {
-    Vehicle.Read(File);
     Vehicle.DatabaseId = MappedId[Vehicle.DatabaseId];
     // check if ignore this actor
     if (!(IgnoreHero && IsHeroMap[Vehicle.DatabaseId]))
     {
       Helper.ProcessReplayerAnimVehicle(Vehicle);
     }
-  }
+  });
 }
 
 void CarlaReplayer::ProcessAnimWalker(void)
 {
-  uint16_t i, Total;
-  CarlaRecorderAnimWalker Walker;
-  std::stringstream Info;
+  static_assert(sizeof(CarlaRecorderAnimWalker) == 8u, "Animations are read as recorded.");
+  uint16_t Total;
 
-  // read Total walkers
+  // read Total walkers, decoding only the actors replayed
   ReadValue<uint16_t>(File, Total);
-  for (i = 0; i < Total; ++i)
+  Filter.ForEachWantedRecord<CarlaRecorderAnimWalker>(File, Total, RecordBuffer, [&](CarlaRecorderAnimWalker Walker)
   {
-    Walker.Read(File);
     Walker.DatabaseId = MappedId[Walker.DatabaseId];
     // check if ignore this actor
     if (!(IgnoreHero && IsHeroMap[Walker.DatabaseId]))
     {
       Helper.ProcessReplayerAnimWalker(Walker);
     }
-  }
+  });
 }
 
 void CarlaReplayer::ProcessLightVehicle(void)
 {
+  static_assert(sizeof(CarlaRecorderLightVehicle) == 8u, "Lights are read as recorded.");
   uint16_t Total;
-  CarlaRecorderLightVehicle LightVehicle;
 
-  // read Total walkers
+  // read Total walkers, decoding only the actors replayed
   ReadValue<uint16_t>(File, Total);
-  for (uint16_t i = 0; i < Total; ++i)
+  Filter.ForEachWantedRecord<CarlaRecorderLightVehicle>(File, Total, RecordBuffer, [&](CarlaRecorderLightVehicle LightVehicle)
   {
-    LightVehicle.Read(File);
     LightVehicle.DatabaseId = MappedId[LightVehicle.DatabaseId];
     // check if ignore this actor
     if (!(IgnoreHero && IsHeroMap[LightVehicle.DatabaseId]))
     {
       Helper.ProcessReplayerLightVehicle(LightVehicle);
     }
-  }
+  });
 }
 
 void CarlaReplayer::ProcessLightScene(void)
@@ -647,6 +891,58 @@ void CarlaReplayer::ProcessWeather(void)
   }
 }
 
+void CarlaReplayer::ProcessKeyFrame(void)
+{
+  CarlaRecorderKeyFrame KeyFrame;
+  KeyFrame.Read(File);
+
+  // destroy the actors that are not alive at this frame
+  std::unordered_set<uint32_t> Alive;
+  for (const auto &EventAdd : KeyFrame.GetActors())
+  {
+    Alive.insert(EventAdd.DatabaseId);
+  }
+  for (auto It = MappedId.begin(); It != MappedId.end();)
+  {
+    if (Alive.find(It->first) == Alive.end())
+    {
+      Helper.ProcessReplayerEventDel(It->second);
+      It = MappedId.erase(It);
+    }
+    else
+    {
+      ++It;
+    }
+  }
+
+  // spawn the missing ones
+  for (const auto &EventAdd : KeyFrame.GetActors())
+  {
+    ProcessEventAdd(EventAdd);
+  }
+
+  // attachments
+  for (const auto &EventParent : KeyFrame.GetParents())
+  {
+    auto Child = MappedId.find(EventParent.DatabaseId);
+    auto Parent = MappedId.find(EventParent.DatabaseIdParent);
+    if (Child != MappedId.end() && Parent != MappedId.end())
+    {
+      Helper.ProcessReplayerEventParent(Child->second, Parent->second);
+    }
+  }
+
+  // scene lights and weather
+  for (const auto &LightScene : KeyFrame.GetLightScenes())
+  {
+    Helper.ProcessReplayerLightScene(LightScene);
+  }
+  for (const auto &Weather : KeyFrame.GetWeathers())
+  {
+    Helper.ProcessReplayerWeather(Weather);
+  }
+}
+
 template <typename T> void CarlaReplayer::ProcessDReyeVRData(double Per, double DeltaTime, bool bShouldBeOnlyOne)
 {
   uint16_t Total;
@@ -692,19 +988,41 @@ template <typename T> void CarlaReplayer::ProcessDReyeVRData(double Per, double
 
 void CarlaReplayer::ProcessPositions(bool IsFirstTime)
 {
-  uint16_t i, Total;
-
   // save current as previous
   PrevPos = std::move(CurrPos);
 
-  // read all positions
+  // read all positions (kept with their recorded ids for the window)
+  ReadPositions(WindowFrame.items);
+  MapPositions(WindowFrame.items, CurrPos);
+
+  // check to copy positions the first time
+  if (IsFirstTime)
+  {
+    PrevPos.clear();
+  }
+}
+
+void CarlaReplayer::ReadPositions(std::vector<CarlaRecorderPosition> &Positions)
+{
+  static_assert(sizeof(CarlaRecorderPosition) == 28u, "Positions are read as recorded.");
+  uint16_t Total;
+
   ReadValue<uint16_t>(File, Total);
-  CurrPos.clear();
-  CurrPos.reserve(Total);
-  for (i = 0; i < Total; ++i)
+  Positions.clear();
+  Positions.reserve(Total);
+  Filter.ForEachWantedRecord<CarlaRecorderPosition>(File, Total, RecordBuffer, [&](const CarlaRecorderPosition &Pos)
+  {
+    Positions.push_back(Pos);
+  });
+}
+
+void CarlaReplayer::MapPositions(const std::vector<CarlaRecorderPosition> &Recorded, std::vector<CarlaRecorderPosition> &Mapped)
+{
+  Mapped.clear();
+  Mapped.reserve(Recorded.size());
+  for (const auto &Item : Recorded)
   {
-    CarlaRecorderPosition Pos;
-    Pos.Read(File);
+    CarlaRecorderPosition Pos = Item;
     // assign mapped Id
     auto NewId = MappedId.find(Pos.DatabaseId);
     if (NewId != MappedId.end())
@@ -713,13 +1031,7 @@ void CarlaReplayer::ProcessPositions(bool IsFirstTime)
     }
     else
       UE_LOG(LogCarla, Log, TEXT("Actor not found when trying to move from replayer (id. %d)"), Pos.DatabaseId);
-    CurrPos.push_back(std::move(Pos));
-  }
-
-  // check to copy positions the first time
-  if (IsFirstTime)
-  {
-    PrevPos.clear();
+    Mapped.push_back(std::move(Pos));
   }
 }
 
@@ -756,7 +1068,7 @@ void CarlaReplayer::UpdatePositions(double Per, double DeltaTime)
       if (Result != TempMap.end())
       {
         // check if time factor is high
-        if (TimeFactor >= 2.0)
+        if (std::abs(TimeFactor) >= 2.0)
           // assign first position
           InterpolatePosition(PrevPos[Result->second], Pos, 0.0, DeltaTime);
         else
@@ -801,8 +1113,18 @@ void CarlaReplayer::Tick(float Delta)
     {
       ProcessFrameByFrame();
     }
+    else if (TimeFactor < 0.0)
+    {
+      // backwards, stopping at the start
+      Advance(std::max(Delta * TimeFactor, -CurrentTime));
+    }
     else // typical usage (replay as fast as possible with interpolation)
     {
+      // scrubbing fast, jump between key frames instead of reading all
+      if (TimeFactor > MaxSequentialTimeFactor && SeekForwardToTime(CurrentTime + Delta * TimeFactor))
+      {
+        return;
+      }
       ProcessToTime(Delta * TimeFactor, false);
     }
   }
@@ -865,13 +1187,25 @@ void CarlaReplayer::Advance(const float Amnt)
   // forward in time (easy)
   else if (Amnt > 0) 
   {
-    /// TODO: verify that this correctly places all actors
-    // else can use the Restart+ProcessToTime hack similar to backwards
+    if (SeekForwardToTime(DesiredTime))
+    {
+      return;
+    }
     ProcessToTime(Amnt, false);
   }
   // backwards in time (harder)
   else
   {
+    // within the frame read last, or from the frames already read
+    if (DesiredTime >= Frame.Elapsed)
+    {
+      ProcessToTime(Amnt, false);
+      return;
+    }
+    if (ProcessFromWindow(DesiredTime, -Amnt))
+    {
+      return;
+    }
     // // amnt is unit of time (timestep) for replay
     // UE_LOG(LogTemp, Log, TEXT("Want to go back to: %.4f from"), DesiredTime, CurrentTime);
     // int NumAmnts = ((CurrentTime - Frame.Elapsed) / (-Amnt)) + 1;
@@ -885,6 +1219,10 @@ void CarlaReplayer::Advance(const float Amnt)
     // UE_LOG(LogTemp, Log, TEXT("Now the time is: %.3f"), Frame.Elapsed);
     // // back to negative
     // ProcessToTime(Amnt, false);
+    if (SeekToTime(DesiredTime))
+    {
+      return;
+    }
     Stop(true); // stops the replaying while keeping actors (dosen't destroy & respawn)
     Restart();
     ProcessToTime(DesiredTime, true);
@@ -893,7 +1231,9 @@ void CarlaReplayer::Advance(const float Amnt)
 
 void CarlaReplayer::IncrTimeFactor(const float Amnt_s)
 {
-  double NewTimeFactor = FMath::Clamp(TimeFactor + Amnt_s, 0.0, 4.0); // min of paused, max of 4x
+  // steps grow with the speed to reach the fastest scrubbing, negative plays backwards
+  const double Step = Amnt_s * std::max(1.0, std::abs(TimeFactor));
+  double NewTimeFactor = FMath::Clamp(TimeFactor + Step, -MaxTimeFactor, MaxTimeFactor);
   UE_LOG(LogTemp, Log, TEXT("Time factor: %.3fx -> %.3fx"), TimeFactor, NewTimeFactor);
   SetTimeFactor(NewTimeFactor);
 }
\ No newline at end of file
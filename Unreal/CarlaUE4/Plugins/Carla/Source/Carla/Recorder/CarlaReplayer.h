@@ -22,8 +22,15 @@
 #include "CarlaRecorderPosition.h"
 #include "CarlaRecorderState.h"
 #include "CarlaRecorderHelpers.h"
+#include "CarlaRecorderKeyFrame.h"
 #include "CarlaReplayerHelper.h"
 
+#include <compiler/disable-ue4-macros.h>
+#include <carla/recorder/FrameIndex.h>
+#include <carla/recorder/FrameWindow.h>
+#include <carla/recorder/PacketFilter.h>
+#include <compiler/enable-ue4-macros.h>
+
 class UCarlaEpisode;
 
 class CarlaReplayer
@@ -100,6 +107,19 @@ public:
   void Advance(const float Amnt);
   void IncrTimeFactor(const float Amnt_s);
 
+  // packets and actors to replay, the rest of the recording is skipped
+  void SetPacketFilter(const carla::recorder::PacketFilter &InFilter)
+  {
+    Filter = InFilter;
+  }
+
+  // memory for the decoded frames kept to play backwards and scrub, zero
+  // to read everything from the file
+  void SetWindowSize(size_t MaxBytes)
+  {
+    Window.SetMaxBytes(MaxBytes);
+  }
+
   void SetSyncMode(bool bSyncModeIn)
   {
     bReplaySync = bSyncModeIn;
@@ -115,6 +135,8 @@ private:
   UCarlaEpisode *Episode = nullptr;
   // binary file reader
   std::ifstream File;
+  // reads the file ahead of File in a background thread
+  carla::recorder::FramePrefetcher Prefetcher;
   Header Header;
   CarlaRecorderInfo RecInfo;
   CarlaRecorderFrame Frame;
@@ -136,6 +158,19 @@ private:
   // ignore hero vehicles
   bool IgnoreHero { false };
   std::unordered_map<uint32_t, bool> IsHeroMap;
+  // frame index of the file (empty for files recorded without it)
+  carla::recorder::FrameIndex Index;
+  // whether the next key frame found has to be applied
+  bool bPendingKeyFrame = false;
+  // decoded frames already read, positions with their recorded ids
+  using FrameWindow = carla::recorder::FrameWindow<CarlaRecorderPosition>;
+  FrameWindow Window { 256u * 1024u * 1024u };
+  // frame being read from the file, added to the window at its end
+  FrameWindow::Frame WindowFrame;
+  // packets and actors replayed
+  carla::recorder::PacketFilter Filter;
+  // per-actor records read at once
+  std::vector<char> RecordBuffer;
 
   // utils
   bool ReadHeader();
@@ -146,14 +181,38 @@ private:
 
   void Rewind(void);
 
+  // load the frame index at the end of the file, if any
+  bool ReadIndex(void);
+
+  // jump to the key frame before Time and process from there, false if the
+  // file has no key frame before Time
+  bool SeekToTime(double Time);
+
+  // jump forward to the key frame before Time if it is ahead of the current
+  // time and process from there
+  bool SeekForwardToTime(double Time);
+
+  // set the state at Time from the window of decoded frames, false if the
+  // window cannot take the replay there from the current time
+  bool ProcessFromWindow(double Time, double DeltaTime);
+
+  // keep a copy of the packet in the frame added to the window
+  void CapturePacket(void);
+
+  // process the packets kept with a frame of the window
+  void ProcessWindowPackets(const std::vector<char> &Packets, double Per, double DeltaTime);
+
   // processing packets
   void ProcessToTime(double Time, bool IsFirstTime = false);
 
   void ProcessEventsAdd(void);
+  void ProcessEventAdd(const CarlaRecorderEventAdd &EventAdd);
   void ProcessEventsDel(void);
   void ProcessEventsParent(void);
 
   void ProcessPositions(bool IsFirstTime = false);
+  void ReadPositions(std::vector<CarlaRecorderPosition> &Positions);
+  void MapPositions(const std::vector<CarlaRecorderPosition> &Recorded, std::vector<CarlaRecorderPosition> &Mapped);
 
   void ProcessStates(void);
 
@@ -165,6 +224,8 @@ private:
 
   void ProcessWeather(void);
 
+  void ProcessKeyFrame(void);
+
   // DReyeVR recordings
   template <typename T> void ProcessDReyeVRData(double Per, double DeltaTime, bool bShouldBeOnlyOne);
   std::unordered_set<std::string> Visited = {};
@@ -5,18 +5,13 @@
 // For a copy, see <https://opensource.org/licenses/MIT>.
 
 
-#include <random>
-#include <cmath>
-#include <algorithm>
-
 #include "Carla.h"
 #include "Carla/Util/RandomEngine.h"
 #include "Carla/Sensor/DVSCamera.h"
 
-static float FColorToGrayScaleFloat(FColor Color)
-{
-  return 0.2989 * Color.R + 0.587 * Color.G + 0.114 * Color.B;
-}
+#include "Runtime/Core/Public/Async/ParallelFor.h"
+
+static_assert(sizeof(FColor) == sizeof(::carla::sensor::data::Color), "FColor and Color differ in size");
 
 ADVSCamera::ADVSCamera(const FObjectInitializer &ObjectInitializer)
   : Super(ObjectInitializer)
@@ -84,22 +79,22 @@ void ADVSCamera::Set(const FActorDescription &Description)
 {
   Super::Set(Description);
 
-  this->config.Cp = UActorBlueprintFunctionLibrary::RetrieveActorAttributeToFloat(
+  this->config.positive_threshold = UActorBlueprintFunctionLibrary::RetrieveActorAttributeToFloat(
       "positive_threshold",
       Description.Variations,
       0.5f);
 
-  this->config.Cm = UActorBlueprintFunctionLibrary::RetrieveActorAttributeToFloat(
+  this->config.negative_threshold = UActorBlueprintFunctionLibrary::RetrieveActorAttributeToFloat(
       "negative_threshold",
       Description.Variations,
       0.5f);
 
-  this->config.sigma_Cp = UActorBlueprintFunctionLibrary::RetrieveActorAttributeToFloat(
+  this->config.sigma_positive_threshold = UActorBlueprintFunctionLibrary::RetrieveActorAttributeToFloat(
       "sigma_positive_threshold",
       Description.Variations,
       0.0f);
 
-  this->config.sigma_Cm = UActorBlueprintFunctionLibrary::RetrieveActorAttributeToFloat(
+  this->config.sigma_negative_threshold = UActorBlueprintFunctionLibrary::RetrieveActorAttributeToFloat(
       "sigma_negative_threshold",
       Description.Variations,
       0.0f);
@@ -118,6 +113,9 @@ void ADVSCamera::Set(const FActorDescription &Description)
       "log_eps",
       Description.Variations,
       1e-03);
+
+  /** Start over with the new configuration **/
+  this->kernel.reset();
 }
 
 void ADVSCamera::PostPhysTick(UWorld *World, ELevelTick TickType, float DeltaTime)
@@ -138,18 +136,8 @@ void ADVSCamera::PostPhysTick(UWorld *World, ELevelTick TickType, float DeltaTim
   TArray<FColor> RawImage;
   this->ReadPixels(RawImage);
 
-  /** Convert image to gray scale **/
-  if (this->config.use_log)
-  {
-    this->ImageToLogGray(RawImage);
-  }
-  else
-  {
-    this->ImageToGray(RawImage);
-  }
-
   /** DVS Simulator **/
-  ADVSCamera::DVSEventArray events = this->Simulation(DeltaTime);
+  const ADVSCamera::DVSEventArray &events = this->Simulation(RawImage);
 
   if (events.size() > 0)
   {
@@ -161,139 +149,28 @@ void ADVSCamera::PostPhysTick(UWorld *World, ELevelTick TickType, float DeltaTim
   }
 }
 
-void ADVSCamera::ImageToGray(const TArray<FColor> &image)
+const ADVSCamera::DVSEventArray &ADVSCamera::Simulation(const TArray<FColor> &image)
 {
-  /** Sanity check **/
-  if (image.Num() != (this->GetImageHeight() * this->GetImageWidth()))
-    return;
-
-  /** Reserve HxW elements **/
-  last_image.SetNumUninitialized(image.Num());
-
-  /** Convert image to gray raw image values **/
-  for (size_t i = 0; i < image.Num(); ++i)
+  TRACE_CPUPROFILER_EVENT_SCOPE(ADVSCamera::Simulation);
+  const uint32 Width = this->GetImageWidth();
+  const uint32 Height = this->GetImageHeight();
+  if (this->kernel == nullptr || this->kernel->GetWidth() != Width || this->kernel->GetHeight() != Height)
   {
-    last_image[i] = FColorToGrayScaleFloat(image[i]);
+    const uint32 Seed = static_cast<uint32>(RandomEngine->GenerateSeed());
+    this->kernel = std::make_unique<::carla::sensor::DVSKernel>(this->config, Width, Height, Seed);
   }
-}
-
-void ADVSCamera::ImageToLogGray(const TArray<FColor> &image)
-{
-  /** Sanity check **/
-  if (image.Num() != (this->GetImageHeight() * this->GetImageWidth()))
-    return;
-
-  /** Reserve HxW elements **/
-  last_image.SetNumUninitialized(image.Num());
 
-  /** Convert image to gray raw image values **/
-  for (size_t i = 0; i < image.Num(); ++i)
-  {
-    last_image[i] = std::log(this->config.log_eps + (FColorToGrayScaleFloat(image[i]) / 255.0));
-  }
-}
-
-ADVSCamera::DVSEventArray ADVSCamera::Simulation (float DeltaTime)
-{
-  /** Array of events **/
-  ADVSCamera::DVSEventArray events;
-
-  /** Sanity check **/
-  if (this->last_image.Num() != (this->GetImageHeight() * this->GetImageWidth()))
-    return events;
-
-  /** Check initialization **/
-  if(this->prev_image.Num() == 0)
-  {
-    /** Set the first rendered image **/
-    this->ref_values = this->last_image;
-    this->prev_image = this->last_image;
-
-    /** Resizes array to given number of elements. New elements will be zeroed.**/
-    this->last_event_timestamp.SetNumZeroed(this->last_image.Num());
-
-    /** Reset current time **/
-    this->current_time = dvs::secToNanosec(this->GetEpisode().GetElapsedGameTime());
-
-    return events;
-  }
-
-  static constexpr float tolerance = 1e-6;
-
-  /** delta time in nanoseconds **/
-  const std::uint64_t delta_t_ns = dvs::secToNanosec(
-      this->GetEpisode().GetElapsedGameTime()) - this->current_time;
-
-  /** Loop along the image size **/
-  for (uint32 y = 0; y < this->GetImageHeight(); ++y)
-  {
-    for (uint32 x = 0; x < this->GetImageWidth(); ++x)
-    {
-      const uint32 i = (this->GetImageWidth() * y) + x;
-      const float itdt = this->last_image[i];
-      const float it = this->prev_image[i];
-      const float prev_cross = this->ref_values[i];
-
-      if (std::fabs (it - itdt) > tolerance)
+  /** Convert to gray scale and trigger the events of each tile in parallel **/
+  return this->kernel->Simulate(
+      reinterpret_cast<const ::carla::sensor::data::Color *>(image.GetData()),
+      static_cast<size_t>(image.Num()),
+      dvs::secToNanosec(this->GetEpisode().GetElapsedGameTime()),
+      [](size_t Count, auto &&ProcessTile)
       {
-        const float pol = (itdt >= it) ? +1.0 : -1.0;
-        float C = (pol > 0) ? this->config.Cp : this->config.Cm;
-        const float sigma_C = (pol > 0) ? this->config.sigma_Cp : this->config.sigma_Cm;
-
-        if(sigma_C > 0)
-        {
-          C += RandomEngine->GetNormalDistribution(0, sigma_C);
-          constexpr float minimum_contrast_threshold = 0.01;
-          C = std::max(minimum_contrast_threshold, C);
-        }
-        float curr_cross = prev_cross;
-        bool all_crossings = false;
-
-        do
+        ParallelFor(static_cast<int32>(Count), [&](int32 Tile)
         {
-          curr_cross += pol * C;
-
-          if ((pol > 0 && curr_cross > it && curr_cross <= itdt)
-              || (pol < 0 && curr_cross < it && curr_cross >= itdt))
-          {
-            const std::uint64_t edt = (curr_cross - it) * delta_t_ns / (itdt - it);
-            const std::int64_t t = this->current_time + edt;
-
-            // check that pixel (x,y) is not currently in a "refractory" state
-            // i.e. |t-that last_timestamp(x,y)| >= refractory_period
-            const std::int64_t last_stamp_at_xy = dvs::secToNanosec(this->last_event_timestamp[i]);
-            if (t >= last_stamp_at_xy)
-            {
-              const std::uint64_t dt = t - last_stamp_at_xy;
-              if(this->last_event_timestamp[i] == 0 || dt >= this->config.refractory_period_ns)
-              {
-                events.push_back(::carla::sensor::data::DVSEvent(x, y, t, pol > 0));
-                this->last_event_timestamp[i] = dvs::nanosecToSecTrunc(t);
-              }
-              else
-              {
-                /** Dropping event because time since last event < refractory_period_ns **/
-              }
-              this->ref_values[i] = curr_cross;
-            }
-          }
-          else
-          {
-            all_crossings = true;
-          }
-        } while (!all_crossings);
-      } // end tolerance
-    } // end for each pixel
-  }
-
-  /** Update current time **/
-  this->current_time = dvs::secToNanosec(this->GetEpisode().GetElapsedGameTime());
-
-  this->prev_image = this->last_image;
-
-  // Sort the events by increasing timestamps, since this is what
-  // most event processing algorithms expect
-  std::sort(events.begin(), events.end(), [](const ::carla::sensor::data::DVSEvent& it1, const ::carla::sensor::data::DVSEvent& it2){return it1.t < it2.t;});
-
-  return events;
+          TRACE_CPUPROFILER_EVENT_SCOPE(ParallelForTask);
+          ProcessTile(static_cast<size_t>(Tile));
+        });
+      });
 }
@@ -7,23 +7,20 @@
 #pragma once
 
 #include "Carla/Sensor/SceneCaptureSensor.h"
+
+#include <compiler/disable-ue4-macros.h>
+#include <carla/sensor/DVSKernel.h>
 #include <carla/sensor/data/DVSEvent.h>
+#include <compiler/enable-ue4-macros.h>
+
+#include <memory>
 
 #include "DVSCamera.generated.h"
 
 namespace dvs
 {
   /// DVS Configuration structure
-  struct Config
-  {
-    float Cp;
-    float Cm;
-    float sigma_Cp;
-    float sigma_Cm;
-    std::uint64_t refractory_period_ns;
-    bool use_log;
-    float log_eps;
-  };
+  using Config = ::carla::sensor::DVSKernel::Config;
 
   inline constexpr std::int64_t secToNanosec(double seconds)
   {
@@ -51,22 +48,11 @@ public:
 
 protected:
   virtual void PostPhysTick(UWorld *World, ELevelTick TickType, float DeltaTime) override;
-  void ImageToGray(const TArray<FColor> &image);
-  void ImageToLogGray(const TArray<FColor> &image);
-  ADVSCamera::DVSEventArray Simulation (float DeltaTime);
+  const ADVSCamera::DVSEventArray &Simulation(const TArray<FColor> &image);
 
 private:
-  /// Images containing last (current) and previous image
-  TArray<float> last_image, prev_image;
-
-  /// Image containing the last reference value to trigger event
-  TArray<float> ref_values;
-
-  /// Image containing time of last event in seconds
-  TArray<double> last_event_timestamp;
-
-  /// Current time in nanoseconds
-  std::int64_t current_time;
+  /// Event simulation, created with the first image of each size
+  std::unique_ptr<::carla::sensor::DVSKernel> kernel;
 
   /// DVS simulation configuration
   dvs::Config config;
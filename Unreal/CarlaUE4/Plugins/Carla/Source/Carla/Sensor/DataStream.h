@@ -50,6 +50,14 @@ public:
     return (*Stream).token();
   }
 
+  /// Return the number of clients that have subscribed to this stream so
+  /// far.
+  uint64_t GetNumberOfSubscriptions() const
+  {
+    check(Stream.has_value());
+    return (*Stream).GetNumberOfSubscriptions();
+  }
+
 private:
 
   boost::optional<StreamType> Stream;
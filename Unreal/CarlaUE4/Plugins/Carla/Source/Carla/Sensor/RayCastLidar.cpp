@@ -19,6 +19,7 @@
 #include "DrawDebugHelpers.h"
 #include "Engine/CollisionProfile.h"
 #include "Runtime/Engine/Classes/Kismet/KismetMathLibrary.h"
+#include "Runtime/Core/Public/Async/ParallelFor.h"
 
 FActorDefinition ARayCastLidar::GetSensorDefinition()
 {
@@ -48,9 +49,13 @@ void ARayCastLidar::Set(const FLidarDescription &LidarDescription)
   CreateLasers();
   PointsPerChannel.resize(Description.Channels);
 
-  // Compute drop off model parameters
-  DropOffBeta = 1.0f - Description.DropOffAtZeroIntensity;
-  DropOffAlpha = Description.DropOffAtZeroIntensity / Description.DropOffIntensityLimit;
+  FLidarBatch::Config Config;
+  Config.atmosphere_attenuation_rate = Description.AtmospAttenRate;
+  Config.noise_stddev = Description.NoiseStdDev;
+  Config.dropoff_general_rate = Description.DropOffGenRate;
+  Config.dropoff_intensity_limit = Description.DropOffIntensityLimit;
+  Config.dropoff_zero_intensity = Description.DropOffAtZeroIntensity;
+  Batch.SetConfig(Config);
   DropOffGenActive = Description.DropOffGenRate > std::numeric_limits<float>::epsilon();
 }
 
@@ -62,81 +67,57 @@ void ARayCastLidar::PostPhysTick(UWorld *World, ELevelTick TickType, float Delta
   {
     TRACE_CPUPROFILER_EVENT_SCOPE_STR("Send Stream");
     auto DataStream = GetDataStream(*this);
-    DataStream.Send(*this, LidarData, DataStream.PopBufferFromPool());
+    DataStream.Send(*this, LidarData, Batch, DataStream.PopBufferFromPool());
   }
 }
 
-float ARayCastLidar::ComputeIntensity(const FSemanticDetection& RawDetection) const
+void ARayCastLidar::ResetRecordedHits(uint32_t Channels, uint32_t MaxPointsPerChannel)
 {
-  const carla::geom::Location HitPoint = RawDetection.point;
-  const float Distance = HitPoint.Length();
-
-  const float AttenAtm = Description.AtmospAttenRate;
-  const float AbsAtm = exp(-AttenAtm * Distance);
-
-  const float IntRec = AbsAtm;
-
-  return IntRec;
+  Batch.Reset(Channels, MaxPointsPerChannel, static_cast<uint32_t>(GetSeed()));
 }
 
-ARayCastLidar::FDetection ARayCastLidar::ComputeDetection(const FHitResult& HitInfo, const FTransform& SensorTransf) const
+void ARayCastLidar::PreprocessRays(uint32_t Channels, uint32_t MaxPointsPerChannel)
 {
-  FDetection Detection;
-  const FVector HitPoint = HitInfo.ImpactPoint;
-  Detection.point = SensorTransf.Inverse().TransformPosition(HitPoint);
-
-  const float Distance = Detection.point.Length();
-
-  const float AttenAtm = Description.AtmospAttenRate;
-  const float AbsAtm = exp(-AttenAtm * Distance);
-
-  const float IntRec = AbsAtm;
-
-  Detection.intensity = IntRec;
+  Super::PreprocessRays(Channels, MaxPointsPerChannel);
+  if (!DropOffGenActive)
+  {
+    return;
+  }
 
-  return Detection;
+  ParallelFor(Channels, [&](int32 idxChannel) {
+    TRACE_CPUPROFILER_EVENT_SCOPE(ParallelForTask);
+    auto &Conditions = RayPreprocessCondition[idxChannel];
+    for (auto p = 0u; p < MaxPointsPerChannel; p++) {
+      Conditions[p] = Batch.IsRayKept(idxChannel, p);
+    }
+  });
 }
 
-  void ARayCastLidar::PreprocessRays(uint32_t Channels, uint32_t MaxPointsPerChannel) {
-    Super::PreprocessRays(Channels, MaxPointsPerChannel);
-
-    for (auto ch = 0u; ch < Channels; ch++) {
-      for (auto p = 0u; p < MaxPointsPerChannel; p++) {
-        RayPreprocessCondition[ch][p] = !(DropOffGenActive && RandomEngine->GetUniformFloat() < Description.DropOffGenRate);
-      }
-    }
-  }
+void ARayCastLidar::WritePointAsync(uint32_t Channel, FHitResult &Detection)
+{
+  const FVector &HitPoint = Detection.ImpactPoint;
+  Batch.AddHit(Channel, HitPoint.X, HitPoint.Y, HitPoint.Z);
+}
 
-  bool ARayCastLidar::PostprocessDetection(FDetection& Detection) const
-  {
-    if (Description.NoiseStdDev > std::numeric_limits<float>::epsilon()) {
-      const auto ForwardVector = Detection.point.MakeUnitVector();
-      const auto Noise = ForwardVector * RandomEngine->GetNormalDistribution(0.0f, Description.NoiseStdDev);
-      Detection.point += Noise;
+void ARayCastLidar::ComputeAndSaveDetections(const FTransform& SensorTransform)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE_STR(__FUNCTION__);
+  // FMatrix transforms row vectors, and the points go from cm to m.
+  const FMatrix WorldToSensor = SensorTransform.ToInverseMatrixWithScale();
+  FLidarBatch::Matrix Matrix;
+  for (auto i = 0u; i < 3u; ++i) {
+    for (auto j = 0u; j < 4u; ++j) {
+      Matrix[4u * i + j] = 1e-2f * WorldToSensor.M[j][i];
     }
-
-    const float Intensity = Detection.intensity;
-    if(Intensity > Description.DropOffIntensityLimit)
-      return true;
-    else
-      return RandomEngine->GetUniformFloat() < DropOffAlpha * Intensity + DropOffBeta;
   }
 
-  void ARayCastLidar::ComputeAndSaveDetections(const FTransform& SensorTransform) {
-    for (auto idxChannel = 0u; idxChannel < Description.Channels; ++idxChannel)
-      PointsPerChannel[idxChannel] = RecordedHits[idxChannel].size();
-
-    LidarData.ResetMemory(PointsPerChannel);
+  ParallelFor(Description.Channels, [&](int32 idxChannel) {
+    TRACE_CPUPROFILER_EVENT_SCOPE(ParallelForTask);
+    Batch.ProcessChannel(idxChannel, Matrix);
+  });
 
-    for (auto idxChannel = 0u; idxChannel < Description.Channels; ++idxChannel) {
-      for (auto& hit : RecordedHits[idxChannel]) {
-        FDetection Detection = ComputeDetection(hit, SensorTransform);
-        if (PostprocessDetection(Detection))
-          LidarData.WritePointSync(Detection);
-        else
-          PointsPerChannel[idxChannel]--;
-      }
-    }
+  for (auto idxChannel = 0u; idxChannel < Description.Channels; ++idxChannel)
+    PointsPerChannel[idxChannel] = Batch.GetPointCount(idxChannel);
 
-    LidarData.WriteChannelCount(PointsPerChannel);
-  }
+  LidarData.WriteChannelCount(PointsPerChannel);
+}
@@ -14,6 +14,7 @@
 #include "Carla/Actor/ActorBlueprintFunctionLibrary.h"
 
 #include <compiler/disable-ue4-macros.h>
+#include <carla/sensor/LidarBatch.h>
 #include <carla/sensor/data/LidarData.h>
 #include <compiler/enable-ue4-macros.h>
 
@@ -26,7 +27,7 @@ class CARLA_API ARayCastLidar : public ARayCastSemanticLidar
   GENERATED_BODY()
 
   using FLidarData = carla::sensor::data::LidarData;
-  using FDetection = carla::sensor::data::LidarDetection;
+  using FLidarBatch = carla::sensor::LidarBatch;
 
 public:
   static FActorDefinition GetSensorDefinition();
@@ -38,25 +39,22 @@ public:
   virtual void PostPhysTick(UWorld *World, ELevelTick TickType, float DeltaTime);
 
 private:
-  /// Compute the received intensity of the point
-  float ComputeIntensity(const FSemanticDetection& RawDetection) const;
-  FDetection ComputeDetection(const FHitResult& HitInfo, const FTransform& SensorTransf) const;
+  void ResetRecordedHits(uint32_t Channels, uint32_t MaxPointsPerChannel) override;
 
   void PreprocessRays(uint32_t Channels, uint32_t MaxPointsPerChannel) override;
-  bool PostprocessDetection(FDetection& Detection) const;
 
+  /// Only the impact point is kept, in the batch.
+  void WritePointAsync(uint32_t Channel, FHitResult &Detection) override;
+
+  /// Transform, attenuate, add noise and drop the hits of every channel in
+  /// parallel.
   void ComputeAndSaveDetections(const FTransform& SensorTransform) override;
 
   FLidarData LidarData;
 
+  /// Hits of the frame, which are serialized straight from it.
+  FLidarBatch Batch;
+
   /// Enable/Disable general dropoff of lidar points
   bool DropOffGenActive;
-
-  /// Slope for the intensity dropoff of lidar points, it is calculated
-  /// throught the dropoff limit and the dropoff at zero intensity
-  /// The points is kept with a probality alpha*Intensity + beta where
-  /// alpha = (1 - dropoff_zero_intensity) / droppoff_limit
-  /// beta = (1 - dropoff_zero_intensity)
-  float DropOffAlpha;
-  float DropOffBeta;
 };
@@ -58,10 +58,10 @@ protected:
   void ComputeRawDetection(const FHitResult &HitInfo, const FTransform &SensorTransf, FSemanticDetection &Detection) const;
 
   /// Saving the hits the raycast returns per channel
-  void WritePointAsync(uint32_t Channel, FHitResult &Detection);
+  virtual void WritePointAsync(uint32_t Channel, FHitResult &Detection);
 
   /// Clear the recorded data structure
-  void ResetRecordedHits(uint32_t Channels, uint32_t MaxPointsPerChannel);
+  virtual void ResetRecordedHits(uint32_t Channels, uint32_t MaxPointsPerChannel);
 
   /// This method uses all the saved FHitResults, compute the
   /// RawDetections and then send it to the LidarData structure.
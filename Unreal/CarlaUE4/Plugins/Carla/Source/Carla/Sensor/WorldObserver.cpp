@@ -7,6 +7,7 @@
 #include "Carla.h"
 #include "Carla/Sensor/WorldObserver.h"
 #include "Carla/Actor/ActorData.h"
+#include "Carla/Game/CarlaEngine.h"
 
 #include "Carla/Traffic/TrafficLightBase.h"
 #include "Carla/Traffic/TrafficLightComponent.h"
@@ -259,6 +260,76 @@ static carla::geom::Vector3D FWorldObserver_GetAcceleration(
   return {Acceleration.X, Acceleration.Y, Acceleration.Z};
 }
 
+static carla::sensor::data::ActorDynamicState FWorldObserver_GetActorDynamicState(
+    const FCarlaActor &View,
+    const FActorRegistry &Registry,
+    float DeltaSeconds)
+{
+  using ActorDynamicState = carla::sensor::data::ActorDynamicState;
+
+  constexpr float TO_METERS = 1e-2;
+
+  FTransform ActorTransform;
+  FVector Velocity(0.0f);
+  carla::geom::Vector3D AngularVelocity(0.0f, 0.0f, 0.0f);
+  carla::geom::Vector3D Acceleration(0.0f, 0.0f, 0.0f);
+  ActorDynamicState::TypeDependentState State{};
+
+  if(View.IsDormant())
+  {
+    const FActorData* ActorData = View.GetActorData();
+    Velocity = TO_METERS * ActorData->Velocity;
+    AngularVelocity = carla::geom::Vector3D
+                      {ActorData->AngularVelocity.X,
+                       ActorData->AngularVelocity.Y,
+                       ActorData->AngularVelocity.Z};
+    Acceleration = FWorldObserver_GetAcceleration(View, Velocity, DeltaSeconds);
+    State = FWorldObserver_GetDormantActorState(View, Registry);
+  }
+  else
+  {
+    Velocity = TO_METERS * View.GetActor()->GetVelocity();
+    AngularVelocity = FWorldObserver_GetAngularVelocity(*View.GetActor());
+    Acceleration = FWorldObserver_GetAcceleration(View, Velocity, DeltaSeconds);
+    State = FWorldObserver_GetActorState(View, Registry);
+  }
+  ActorTransform = View.GetActorGlobalTransform();
+
+  return ActorDynamicState{
+    View.GetActorId(),
+    View.GetActorState(),
+    carla::geom::Transform(ActorTransform),
+    carla::geom::Vector3D(Velocity.X, Velocity.Y, Velocity.Z),
+    AngularVelocity,
+    Acceleration,
+    State,
+  };
+}
+
+static carla::sensor::s11n::EpisodeStateSerializer::Header FWorldObserver_GetHeader(
+    const UCarlaEpisode &Episode,
+    float DeltaSeconds,
+    bool MapChange,
+    bool PendingLightUpdates)
+{
+  using Serializer = carla::sensor::s11n::EpisodeStateSerializer;
+  using SimulationState = carla::sensor::s11n::EpisodeStateSerializer::SimulationState;
+
+  Serializer::Header header;
+  header.episode_id = Episode.GetId();
+  header.platform_timestamp = FPlatformTime::Seconds();
+  header.delta_seconds = DeltaSeconds;
+  FIntVector MapOrigin = Episode.GetCurrentMapOrigin();
+  FIntVector MapOriginInMeters = MapOrigin / 100;
+  header.map_origin = carla::geom::Vector3DInt{ MapOriginInMeters.X, MapOriginInMeters.Y, MapOriginInMeters.Z };
+
+  uint8_t simulation_state = (SimulationState::MapChange * MapChange);
+  simulation_state |= (SimulationState::PendingLightUpdate * PendingLightUpdates);
+
+  header.simulation_state = static_cast<SimulationState>(simulation_state);
+  return header;
+}
+
 static carla::Buffer FWorldObserver_Serialize(
     carla::Buffer &&buffer,
     const UCarlaEpisode &Episode,
@@ -268,7 +339,6 @@ static carla::Buffer FWorldObserver_Serialize(
 {
   TRACE_CPUPROFILER_EVENT_SCOPE_STR(__FUNCTION__);
   using Serializer = carla::sensor::s11n::EpisodeStateSerializer;
-  using SimulationState = carla::sensor::s11n::EpisodeStateSerializer::SimulationState;
   using ActorDynamicState = carla::sensor::data::ActorDynamicState;
 
 
@@ -285,69 +355,15 @@ static carla::Buffer FWorldObserver_Serialize(
     current_size += sizeof(data);
   };
 
-  constexpr float TO_METERS = 1e-2;
-
   // Write header.
-  Serializer::Header header;
-  header.episode_id = Episode.GetId();
-  header.platform_timestamp = FPlatformTime::Seconds();
-  header.delta_seconds = DeltaSeconds;
-  FIntVector MapOrigin = Episode.GetCurrentMapOrigin();
-  FIntVector MapOriginInMeters = MapOrigin / 100;
-  header.map_origin = carla::geom::Vector3DInt{ MapOriginInMeters.X, MapOriginInMeters.Y, MapOriginInMeters.Z };
-
-  uint8_t simulation_state = (SimulationState::MapChange * MapChange);
-  simulation_state |= (SimulationState::PendingLightUpdate * PendingLightUpdates);
-
-  header.simulation_state = static_cast<SimulationState>(simulation_state);
-
-  write_data(header);
+  write_data(FWorldObserver_GetHeader(Episode, DeltaSeconds, MapChange, PendingLightUpdates));
 
   // Write every actor.
   for (auto& It : Registry)
   {
     const FCarlaActor* View = It.Value.Get();
-    const FActorInfo* ActorInfo = View->GetActorInfo();
-
-    FTransform ActorTransform;
-    FVector Velocity(0.0f);
-    carla::geom::Vector3D AngularVelocity(0.0f, 0.0f, 0.0f);
-    carla::geom::Vector3D Acceleration(0.0f, 0.0f, 0.0f);
-    carla::sensor::data::ActorDynamicState::TypeDependentState State{};
-
-
     check(View);
-
-    if(View->IsDormant())
-    {
-      const FActorData* ActorData = View->GetActorData();
-      Velocity = TO_METERS * ActorData->Velocity;
-      AngularVelocity = carla::geom::Vector3D
-                        {ActorData->AngularVelocity.X,
-                         ActorData->AngularVelocity.Y,
-                         ActorData->AngularVelocity.Z};
-      Acceleration = FWorldObserver_GetAcceleration(*View, Velocity, DeltaSeconds);
-      State = FWorldObserver_GetDormantActorState(*View, Registry);
-    }
-    else
-    {
-      Velocity = TO_METERS * View->GetActor()->GetVelocity();
-      AngularVelocity = FWorldObserver_GetAngularVelocity(*View->GetActor());
-      Acceleration = FWorldObserver_GetAcceleration(*View, Velocity, DeltaSeconds);
-      State = FWorldObserver_GetActorState(*View, Registry);
-    }
-    ActorTransform = View->GetActorGlobalTransform();
-
-    ActorDynamicState info = {
-      View->GetActorId(),
-      View->GetActorState(),
-      carla::geom::Transform(ActorTransform),
-      carla::geom::Vector3D(Velocity.X, Velocity.Y, Velocity.Z),
-      AngularVelocity,
-      Acceleration,
-      State,
-    };
-    write_data(info);
+    write_data(FWorldObserver_GetActorDynamicState(*View, Registry, DeltaSeconds));
   }
 
   // Shrink buffer
@@ -358,6 +374,35 @@ static carla::Buffer FWorldObserver_Serialize(
   return std::move(buffer);
 }
 
+static carla::Buffer FWorldObserver_SerializeDelta(
+    carla::Buffer &&buffer,
+    carla::sensor::s11n::EpisodeStateDeltaEncoder &Encoder,
+    std::vector<carla::sensor::data::ActorDynamicState> &ActorStates,
+    const UCarlaEpisode &Episode,
+    float DeltaSeconds,
+    bool MapChange,
+    bool PendingLightUpdates)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE_STR(__FUNCTION__);
+
+  const FActorRegistry &Registry = Episode.GetActorRegistry();
+
+  ActorStates.clear();
+  ActorStates.reserve(Registry.Num());
+  for (auto& It : Registry)
+  {
+    const FCarlaActor* View = It.Value.Get();
+    check(View);
+    ActorStates.emplace_back(FWorldObserver_GetActorDynamicState(*View, Registry, DeltaSeconds));
+  }
+
+  return Encoder.Encode(
+      FCarlaEngine::GetFrameCounter(),
+      FWorldObserver_GetHeader(Episode, DeltaSeconds, MapChange, PendingLightUpdates),
+      ActorStates,
+      std::move(buffer));
+}
+
 void FWorldObserver::BroadcastTick(
     const UCarlaEpisode &Episode,
     float DeltaSecond,
@@ -367,12 +412,31 @@ void FWorldObserver::BroadcastTick(
   TRACE_CPUPROFILER_EVENT_SCOPE_STR(__FUNCTION__);
   auto AsyncStream = Stream.MakeAsyncDataStream(*this, Episode.GetElapsedGameTime());
 
-  carla::Buffer buffer = FWorldObserver_Serialize(
-      AsyncStream.PopBufferFromPool(),
-      Episode,
-      DeltaSecond,
-      MapChange,
-      PendingLightUpdates);
+  carla::Buffer buffer;
+  if (Episode.GetSettings().bDeltaSnapshots)
+  {
+    // New clients start from a keyframe.
+    DeltaEncoder.UpdateSubscriptions(Stream.GetNumberOfSubscriptions());
+    buffer = FWorldObserver_SerializeDelta(
+        AsyncStream.PopBufferFromPool(),
+        DeltaEncoder,
+        ActorStates,
+        Episode,
+        DeltaSecond,
+        MapChange,
+        PendingLightUpdates);
+  }
+  else
+  {
+    // Start with a keyframe if delta snapshots are enabled again.
+    DeltaEncoder.Reset();
+    buffer = FWorldObserver_Serialize(
+        AsyncStream.PopBufferFromPool(),
+        Episode,
+        DeltaSecond,
+        MapChange,
+        PendingLightUpdates);
+  }
 
   AsyncStream.Send(*this, std::move(buffer));
 }
@@ -8,6 +8,13 @@
 
 #include "Carla/Sensor/DataStream.h"
 
+#include <compiler/disable-ue4-macros.h>
+#include <carla/sensor/data/ActorDynamicState.h>
+#include <carla/sensor/s11n/EpisodeStateDeltaEncoder.h>
+#include <compiler/enable-ue4-macros.h>
+
+#include <vector>
+
 class UCarlaEpisode;
 
 /// Serializes and sends all the actors in the current UCarlaEpisode.
@@ -38,6 +45,12 @@ public:
     bool MapChange,
     bool PendingLightUpdate);
 
+  /// Send a keyframe on the next tick if delta snapshots are enabled.
+  void RequestKeyframe()
+  {
+    DeltaEncoder.RequestKeyframe();
+  }
+
   /// Dummy. Required for compatibility with other sensors only.
   FTransform GetActorTransform() const
   {
@@ -47,4 +60,10 @@ public:
 private:
 
   FDataMultiStream Stream;
+
+  /// Used when the episode settings enable delta snapshots.
+  carla::sensor::s11n::EpisodeStateDeltaEncoder DeltaEncoder;
+
+  /// Reused every tick when encoding deltas.
+  std::vector<carla::sensor::data::ActorDynamicState> ActorStates;
 };
@@ -6,6 +6,7 @@
 
 #include "Carla.h"
 #include "Carla/Server/CarlaServer.h"
+#include "Carla/Game/CarlaStaticDelegates.h"
 #include "Carla/Traffic/TrafficLightGroup.h"
 #include "EngineUtils.h"
 
@@ -25,6 +26,8 @@
 #include "CarlaServerResponse.h"
 #include "Carla/Util/BoundingBoxCalculator.h"
 #include "Misc/FileHelper.h"
+#include "HAL/PlatformFilesystem.h"
+#include "HAL/PlatformFileManager.h"
 
 #include <compiler/disable-ue4-macros.h>
 #include <carla/Functional.h>
@@ -34,11 +37,13 @@
 #include <carla/rpc/ActorDescription.h>
 #include <carla/rpc/BoneTransformDataIn.h>
 #include <carla/rpc/Command.h>
+#include <carla/rpc/CommandBatch.h>
 #include <carla/rpc/CommandResponse.h>
 #include <carla/rpc/DebugShape.h>
 #include <carla/rpc/EnvironmentObject.h>
 #include <carla/rpc/EpisodeInfo.h>
 #include <carla/rpc/EpisodeSettings.h>
+#include <carla/rpc/FileInfo.h>
 #include "carla/rpc/LabelledPoint.h"
 #include <carla/rpc/LightState.h>
 #include <carla/rpc/MapInfo.h>
@@ -57,6 +62,7 @@
 #include <carla/rpc/WalkerBoneControlIn.h>
 #include <carla/rpc/WalkerBoneControlOut.h>
 #include <carla/rpc/WalkerControl.h>
+#include <carla/rpc/WalkerStateList.h>
 #include <carla/rpc/VehicleWheels.h>
 #include <carla/rpc/WeatherParameters.h>
 #include <carla/streaming/Server.h>
@@ -66,6 +72,7 @@
 
 #include <vector>
 #include <map>
+#include <mutex>
 #include <tuple>
 
 template <typename T>
@@ -81,6 +88,21 @@ static std::vector<T> MakeVectorFromTArray(const TArray<Other> &Array)
   return {Array.GetData(), Array.GetData() + Array.Num()};
 }
 
+// =============================================================================
+// -- FServerSnapshot ----------------------------------------------------------
+// =============================================================================
+
+/// Immutable copy of the episode data served by the read-only calls from the
+/// RPC worker threads. Rebuilt on the game thread when it changes.
+struct FServerSnapshot
+{
+  bool bEpisodeReady = false;
+
+  carla::rpc::EpisodeInfo EpisodeInfo;
+
+  std::vector<carla::rpc::ActorDefinition> ActorDefinitions;
+};
+
 // =============================================================================
 // -- FCarlaServer::FPimpl -----------------------------------------------
 // =============================================================================
@@ -110,9 +132,25 @@ public:
 
   size_t TickCuesReceived = 0u;
 
+  /// Publish a new FServerSnapshot if the episode or its actor definitions
+  /// changed since the last one.
+  void UpdateSnapshot();
+
 private:
 
   void BindActions();
+
+  /// Size and hash of the file at @a Name, relative to the content folder.
+  /// Cached until the file is modified. Thread-safe.
+  carla::rpc::FileInfo GetFileInfo(const std::string &Name);
+
+  std::mutex FileInfoMutex;
+
+  std::map<std::string, std::pair<FDateTime, carla::rpc::FileInfo>> FileInfoCache;
+
+  UCarlaEpisode *SnapshotEpisode = nullptr;
+
+  int32 SnapshotDefinitions = -1;
 };
 
 // =============================================================================
@@ -188,8 +226,31 @@ private:
   bool _sync;
 };
 
+class ReadOnlyServerBinder
+{
+public:
+
+  constexpr ReadOnlyServerBinder(const char *name, carla::rpc::Server &srv)
+    : _name(name),
+      _server(srv) {}
+
+  template <typename FuncT>
+  auto operator<<(FuncT func)
+  {
+    _server.BindReadOnly(_name, func);
+    return func;
+  }
+
+private:
+
+  const char *_name;
+
+  carla::rpc::Server &_server;
+};
+
 #define BIND_SYNC(name)   auto name = ServerBinder(# name, Server, true)
 #define BIND_ASYNC(name)  auto name = ServerBinder(# name, Server, false)
+#define BIND_READ_ONLY(name)  auto name = ReadOnlyServerBinder(# name, Server)
 
 // =============================================================================
 // -- Bind Actions -------------------------------------------------------------
@@ -430,10 +491,10 @@ void FCarlaServer::FPimpl::BindActions()
 
   // ~~ Episode settings and info ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-  BIND_SYNC(get_episode_info) << [this]() -> R<cr::EpisodeInfo>
+  BIND_READ_ONLY(get_episode_info) << [](const FServerSnapshot &Snapshot) -> R<cr::EpisodeInfo>
   {
-    REQUIRE_CARLA_EPISODE();
-    return cr::EpisodeInfo{Episode->GetId(), BroadcastStream.token()};
+    if (!Snapshot.bEpisodeReady) { RESPOND_ERROR("episode not ready"); }
+    return Snapshot.EpisodeInfo;
   };
 
   BIND_SYNC(get_map_info) << [this]() -> R<cr::MapInfo>
@@ -494,6 +555,39 @@ void FCarlaServer::FPimpl::BindActions()
 
     return result;
   };
+  BIND_ASYNC(get_file_info) << [this](std::string name) -> R<cr::FileInfo>
+  {
+    return GetFileInfo(name);
+  };
+
+  BIND_ASYNC(request_file_chunk) << [](
+      std::string name,
+      uint64_t offset,
+      uint64_t size) -> R<std::vector<uint8_t>>
+  {
+    TRACE_CPUPROFILER_EVENT_SCOPE(RequestFileChunk);
+    FString Path(FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir()));
+    Path.Append(name.c_str());
+
+    TUniquePtr<IFileHandle> File(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path));
+    if (!File)
+    {
+      RESPOND_ERROR("unable to open file");
+    }
+    const int64 FileSize = File->Size();
+    if (offset > static_cast<uint64_t>(FileSize))
+    {
+      RESPOND_ERROR("offset out of range");
+    }
+    std::vector<uint8_t> Result(std::min(size, static_cast<uint64_t>(FileSize) - offset));
+    if (!File->Seek(static_cast<int64>(offset)) ||
+        !File->Read(Result.data(), static_cast<int64>(Result.size())))
+    {
+      RESPOND_ERROR("unable to read file");
+    }
+    return Result;
+  };
+
   BIND_SYNC(request_file) << [this](std::string name) -> R<std::vector<uint8_t>>
   {
     REQUIRE_CARLA_EPISODE();
@@ -526,10 +620,17 @@ void FCarlaServer::FPimpl::BindActions()
     return FCarlaEngine::GetFrameCounter();
   };
 
-  BIND_SYNC(get_actor_definitions) << [this]() -> R<std::vector<cr::ActorDefinition>>
+  BIND_SYNC(request_episode_keyframe) << [this]() -> R<void>
   {
     REQUIRE_CARLA_EPISODE();
-    return MakeVectorFromTArray<cr::ActorDefinition>(Episode->GetActorDefinitions());
+    FCarlaStaticDelegates::OnEpisodeKeyframeRequest.Broadcast();
+    return R<void>::Success();
+  };
+
+  BIND_READ_ONLY(get_actor_definitions) << [](const FServerSnapshot &Snapshot) -> R<std::vector<cr::ActorDefinition>>
+  {
+    if (!Snapshot.bEpisodeReady) { RESPOND_ERROR("episode not ready"); }
+    return Snapshot.ActorDefinitions;
   };
 
   BIND_SYNC(get_spectator) << [this]() -> R<cr::Actor>
@@ -2088,6 +2189,52 @@ void FCarlaServer::FPimpl::BindActions()
     return result;
   };
 
+  // Same as apply_batch, but visiting each run of commands of the same type
+  // without dispatching on the variant for every command.
+  BIND_SYNC(apply_command_batch) << [=](
+      const cr::CommandBatch &commands,
+      bool do_tick_cue)
+  {
+    TRACE_CPUPROFILER_EVENT_SCOPE(ApplyCommandBatch);
+    std::vector<CR> result;
+    result.reserve(commands.size());
+    commands.ForEach(
+        [&](const auto &command) {
+          result.emplace_back(command_visitor(command));
+        },
+        [&](size_t count) {
+          // keep one response per command sent
+          result.insert(result.end(), count, CR{cr::ResponseError("command could not be decoded")});
+        });
+    if (do_tick_cue)
+    {
+      tick_cue();
+    }
+    return result;
+  };
+
+  BIND_SYNC(apply_walker_states) << [this](
+      const cr::WalkerStateList &States) -> R<void>
+  {
+    TRACE_CPUPROFILER_EVENT_SCOPE(ApplyWalkerStates);
+    REQUIRE_CARLA_EPISODE();
+    for (size_t i = 0u; i < States.size(); ++i)
+    {
+      const cr::WalkerState State = States[i];
+      FCarlaActor* CarlaActor = Episode->FindCarlaActor(State.actor);
+      // the walker may have been destroyed since the client sent its state
+      if (CarlaActor)
+      {
+        const cr::Transform Transform = State.transform;
+        CarlaActor->SetWalkerState(
+            Transform,
+            cr::WalkerControl(
+              Transform.GetForwardVector(), State.speed, false));
+      }
+    }
+    return R<void>::Success();
+  };
+
   // ~~ Light Subsystem ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
   BIND_SYNC(query_lights_state) << [this](std::string client) -> R<std::vector<cr::LightState>>
@@ -2159,6 +2306,7 @@ void FCarlaServer::FPimpl::BindActions()
 // -- Undef helper macros ------------------------------------------------------
 // =============================================================================
 
+#undef BIND_READ_ONLY
 #undef BIND_ASYNC
 #undef BIND_SYNC
 #undef REQUIRE_CARLA_EPISODE
@@ -2166,6 +2314,77 @@ void FCarlaServer::FPimpl::BindActions()
 #undef RESPOND_ERROR
 #undef CARLA_ENSURE_GAME_THREAD
 
+carla::rpc::FileInfo FCarlaServer::FPimpl::GetFileInfo(const std::string &Name)
+{
+  TRACE_CPUPROFILER_EVENT_SCOPE_STR(__FUNCTION__);
+  FString Path(FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir()));
+  Path.Append(Name.c_str());
+
+  IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+  const FDateTime TimeStamp = PlatformFile.GetTimeStamp(*Path);
+  if (TimeStamp == FDateTime::MinValue())
+  {
+    // Missing file.
+    return carla::rpc::FileInfo{};
+  }
+  {
+    std::lock_guard<std::mutex> Lock(FileInfoMutex);
+    auto It = FileInfoCache.find(Name);
+    if ((It != FileInfoCache.end()) && (It->second.first == TimeStamp))
+    {
+      return It->second.second;
+    }
+  }
+
+  // Hash the file in blocks, it may be too big to load it at once.
+  carla::rpc::FileInfo Info;
+  TUniquePtr<IFileHandle> File(PlatformFile.OpenRead(*Path));
+  if (!File)
+  {
+    return Info;
+  }
+  constexpr int64 BlockSize = 8 * 1024 * 1024;
+  TArray<uint8> Block;
+  Block.SetNumUninitialized(BlockSize);
+  int64 Remaining = File->Size();
+  while (Remaining > 0)
+  {
+    const int64 Size = FMath::Min(Remaining, BlockSize);
+    if (!File->Read(Block.GetData(), Size))
+    {
+      return carla::rpc::FileInfo{};
+    }
+    Info.hash = carla::rpc::FileInfo::Hash(Block.GetData(), static_cast<size_t>(Size), Info.hash);
+    Info.size += static_cast<uint64_t>(Size);
+    Remaining -= Size;
+  }
+
+  std::lock_guard<std::mutex> Lock(FileInfoMutex);
+  FileInfoCache[Name] = std::make_pair(TimeStamp, Info);
+  return Info;
+}
+
+void FCarlaServer::FPimpl::UpdateSnapshot()
+{
+  const int32 NumberOfDefinitions =
+      Episode != nullptr ? Episode->GetActorDefinitions().Num() : -1;
+  if ((Episode == SnapshotEpisode) && (NumberOfDefinitions == SnapshotDefinitions))
+  {
+    return;
+  }
+  auto Snapshot = std::make_shared<FServerSnapshot>();
+  if (Episode != nullptr)
+  {
+    Snapshot->bEpisodeReady = true;
+    Snapshot->EpisodeInfo = carla::rpc::EpisodeInfo{Episode->GetId(), BroadcastStream.token()};
+    Snapshot->ActorDefinitions =
+        MakeVectorFromTArray<carla::rpc::ActorDefinition>(Episode->GetActorDefinitions());
+  }
+  Server.PublishSnapshot<FServerSnapshot>(std::move(Snapshot));
+  SnapshotEpisode = Episode;
+  SnapshotDefinitions = NumberOfDefinitions;
+}
+
 // =============================================================================
 // -- FCarlaServer -------------------------------------------------------
 // =============================================================================
@@ -2192,12 +2411,14 @@ void FCarlaServer::NotifyBeginEpisode(UCarlaEpisode &Episode)
   check(Pimpl != nullptr);
   UE_LOG(LogCarlaServer, Log, TEXT("New episode '%s' started"), *Episode.GetMapName());
   Pimpl->Episode = &Episode;
+  Pimpl->UpdateSnapshot();
 }
 
 void FCarlaServer::NotifyEndEpisode()
 {
   check(Pimpl != nullptr);
   Pimpl->Episode = nullptr;
+  Pimpl->UpdateSnapshot();
 }
 
 void FCarlaServer::AsyncRun(uint32 NumberOfWorkerThreads)
@@ -2229,6 +2450,7 @@ void FCarlaServer::AsyncRun(uint32 NumberOfWorkerThreads)
 void FCarlaServer::RunSome(uint32 Milliseconds)
 {
   TRACE_CPUPROFILER_EVENT_SCOPE_STR(__FUNCTION__);
+  Pimpl->UpdateSnapshot();
   Pimpl->Server.SyncRunFor(carla::time_duration::milliseconds(Milliseconds));
 }
 
@@ -37,4 +37,8 @@ struct CARLA_API FEpisodeSettings
 
   float ActorActiveDistance = 200000.f; // 3km
 
+  /// Send the episode state as keyframes plus deltas.
+  UPROPERTY(EditAnywhere, BlueprintReadWrite)
+  bool bDeltaSnapshots = false;
+
 };
@@ -21,6 +21,7 @@ ADReyeVRLevel::ADReyeVRLevel(FObjectInitializer const &FO) : Super(FO)
 
     // Recorder/replayer
     ReadConfigValue("Replayer", "RunSyncReplay", bReplaySync);
+    ReadConfigValue("Replayer", "WindowMB", ReplayWindowMB);
 }
 
 void ADReyeVRLevel::BeginPlay()
@@ -262,6 +263,8 @@ void ADReyeVRLevel::SetupReplayer()
     if (UCarlaStatics::GetRecorder(GetWorld()) && UCarlaStatics::GetRecorder(GetWorld())->GetReplayer())
     {
         UCarlaStatics::GetRecorder(GetWorld())->GetReplayer()->SetSyncMode(bReplaySync);
+        UCarlaStatics::GetRecorder(GetWorld())->GetReplayer()->SetWindowSize(
+            static_cast<size_t>(FMath::Max(ReplayWindowMB, 0)) * 1024u * 1024u);
         bRecorderInitiated = true;
     }
 }
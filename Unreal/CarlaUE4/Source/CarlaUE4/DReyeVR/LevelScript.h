@@ -78,5 +78,6 @@ class ADReyeVRLevel : public ALevelScriptActor
 
     // for recorder/replayer params
     bool bReplaySync = false;        // false allows for interpolation
+    int ReplayWindowMB = 256;        // decoded frames kept for reverse playback and scrubbing
     bool bRecorderInitiated = false; // allows tick-wise checking for replayer/recorder
 };
\ No newline at end of file